@@ -14,6 +14,11 @@
 #include <boost/signals2.hpp>
 
 static const int DEFAULT_LISTVIEW_HOVER_TIME = 500;
+static const int DEFAULT_PARALLEL_SORT_THRESHOLD = 20000;
+
+/* Each thumbnail takes up a little over 56KB (for 120x120
+thumbnails), so the cache file is around 56MB by default. */
+static const int DEFAULT_THUMBNAIL_CACHE_SIZE = 1024;
 
 enum StartupMode_t
 {
@@ -98,6 +103,8 @@ struct Config
 		showTabBarAtBottom = FALSE;
 		alwaysOpenNewTab = FALSE;
 		openNewTabNextToCurrent = FALSE;
+		loadTabsOnDemand = TRUE;
+		thumbnailCacheSize = DEFAULT_THUMBNAIL_CACHE_SIZE;
 		lockToolbars = TRUE;
 		treeViewDelayEnabled = FALSE;
 		treeViewAutoExpandSelected = FALSE;
@@ -150,6 +157,8 @@ struct Config
 		globalFolderSettings.sizeDisplayFormat = SIZE_FORMAT_BYTES;
 		globalFolderSettings.oneClickActivate = FALSE;
 		globalFolderSettings.oneClickActivateHoverTime = DEFAULT_LISTVIEW_HOVER_TIME;
+		globalFolderSettings.parallelSortThreshold = DEFAULT_PARALLEL_SORT_THRESHOLD;
+		globalFolderSettings.virtualListView = FALSE;
 
 		globalFolderSettings.folderColumns.realFolderColumns = std::vector<Column_t>(std::begin(REAL_FOLDER_DEFAULT_COLUMNS), std::end(REAL_FOLDER_DEFAULT_COLUMNS));
 		globalFolderSettings.folderColumns.myComputerColumns = std::vector<Column_t>(std::begin(MY_COMPUTER_DEFAULT_COLUMNS), std::end(MY_COMPUTER_DEFAULT_COLUMNS));
@@ -186,6 +195,7 @@ struct Config
 	BOOL showTabBarAtBottom;
 	BOOL alwaysOpenNewTab;
 	BOOL openNewTabNextToCurrent;
+	BOOL loadTabsOnDemand;
 	BOOL lockToolbars;
 	BOOL treeViewDelayEnabled;
 	BOOL treeViewAutoExpandSelected;
@@ -206,6 +216,10 @@ struct Config
 	LONG displayWindowHeight;
 	unsigned int treeViewWidth;
 
+	/* The number of thumbnails kept in the persistent
+	thumbnail cache. 0 disables the cache. */
+	unsigned int thumbnailCacheSize;
+
 	NDefaultFileManager::ReplaceExplorerModes_t replaceExplorerMode;
 
 	BOOL showInfoTips;
@@ -18,8 +18,13 @@ enum MousewheelSource_t
 };
 
 class CShellBrowser;
+class FolderSizeService;
+class IconCache;
+class ItemTaskScheduler;
+class MetadataCache;
 __interface IDirectoryMonitor;
 class TabContainer;
+class ThumbnailCache;
 
 /* Basic interface between Explorerplusplus
 and some of the other components (such as the
@@ -35,6 +40,11 @@ __interface IExplorerplusplus
 
 	TabContainer	*GetTabContainer() const;
 	IDirectoryMonitor	*GetDirectoryMonitor() const;
+	FolderSizeService	*GetFolderSizeService() const;
+	ThumbnailCache		*GetThumbnailCache() const;
+	IconCache			*GetIconCache() const;
+	MetadataCache		*GetMetadataCache() const;
+	ItemTaskScheduler	*GetItemTaskScheduler() const;
 
 	HWND			GetTreeView() const;
 
@@ -6,6 +6,7 @@
 #include "DestroyFilesDialog.h"
 #include "Explorer++_internal.h"
 #include "MainResource.h"
+#include "../Helper/Controls.h"
 #include "../Helper/Helper.h"
 #include "../Helper/Macros.h"
 #include "../Helper/RegistrySettings.h"
@@ -15,6 +16,7 @@
 const TCHAR CDestroyFilesDialogPersistentSettings::SETTINGS_KEY[] = _T("DestroyFiles");
 
 const TCHAR CDestroyFilesDialogPersistentSettings::SETTING_OVERWRITE_METHOD[] = _T("OverwriteMethod");
+const TCHAR CDestroyFilesDialogPersistentSettings::SETTING_VERIFY[] = _T("Verify");
 
 CDestroyFilesDialog::CDestroyFilesDialog(HINSTANCE hInstance,
 	int iResource,HWND hParent,std::list<std::wstring> FullFilenameList,
@@ -132,6 +134,8 @@ INT_PTR CDestroyFilesDialog::OnInitDialog()
 		break;
 	}
 
+	lCheckDlgButton(m_hDlg,IDC_DESTROYFILES_CHECK_VERIFY,m_pdfdps->m_bVerify);
+
 	m_pdfdps->RestoreDialogPosition(m_hDlg,true);
 
 	return 0;
@@ -169,6 +173,11 @@ void CDestroyFilesDialog::GetResizableControlInformation(CBaseDialog::DialogSize
 	Control.Constraint = CResizableDialog::CONSTRAINT_Y;
 	ControlList.push_back(Control);
 
+	Control.iID = IDC_DESTROYFILES_CHECK_VERIFY;
+	Control.Type = CResizableDialog::TYPE_MOVE;
+	Control.Constraint = CResizableDialog::CONSTRAINT_Y;
+	ControlList.push_back(Control);
+
 	Control.iID = IDC_DESTROYFILES_STATIC_WARNING_MESSAGE;
 	Control.Type = CResizableDialog::TYPE_MOVE;
 	Control.Constraint = CResizableDialog::CONSTRAINT_Y;
@@ -251,6 +260,9 @@ void CDestroyFilesDialog::SaveState()
 		m_pdfdps->m_uOverwriteMethod = NFileOperations::OVERWRITE_THREEPASS;
 	}
 
+	m_pdfdps->m_bVerify = IsDlgButtonChecked(m_hDlg,
+		IDC_DESTROYFILES_CHECK_VERIFY) == BST_CHECKED;
+
 	m_pdfdps->m_bStateSaved = TRUE;
 }
 
@@ -295,19 +307,80 @@ void CDestroyFilesDialog::OnConfirmDestroy()
 		OverwriteMethod = NFileOperations::OVERWRITE_THREEPASS;
 	}
 
+	bool bVerify = IsDlgButtonChecked(m_hDlg,IDC_DESTROYFILES_CHECK_VERIFY) == BST_CHECKED;
+
 	/* TODO: Perform in background thread. */
-	for(const auto &strFullFilename : m_FullFilenameList)
+	std::vector<std::wstring> filenames(m_FullFilenameList.begin(),m_FullFilenameList.end());
+	std::vector<FileShredder::Status> statuses = NFileOperations::DeleteFilesSecurely(filenames,OverwriteMethod,bVerify);
+
+	ShowFailedFiles(filenames,statuses);
+
+	EndDialog(m_hDlg,1);
+}
+
+/* Lists each file that wasn't destroyed, along with the
+reason. Nothing is shown if every file was destroyed. */
+void CDestroyFilesDialog::ShowFailedFiles(const std::vector<std::wstring> &filenames,
+	const std::vector<FileShredder::Status> &statuses)
+{
+	std::wstring failedFiles;
+
+	for(size_t i = 0;i < statuses.size();i++)
 	{
-		DeleteFileSecurely(strFullFilename,OverwriteMethod);
+		UINT uReasonId;
+
+		switch(statuses[i])
+		{
+			case FileShredder::Status::Succeeded:
+				continue;
+
+			case FileShredder::Status::NotAFile:
+				uReasonId = IDS_DESTROY_FILES_NOTAFILE;
+				break;
+
+			case FileShredder::Status::OpenFailed:
+				uReasonId = IDS_DESTROY_FILES_OPENFAILED;
+				break;
+
+			case FileShredder::Status::WriteFailed:
+				uReasonId = IDS_DESTROY_FILES_WRITEFAILED;
+				break;
+
+			case FileShredder::Status::VerifyFailed:
+				uReasonId = IDS_DESTROY_FILES_VERIFYFAILED;
+				break;
+
+			default:
+				uReasonId = IDS_DESTROY_FILES_DELETEFAILED;
+				break;
+		}
+
+		TCHAR szReason[256];
+		LoadString(GetInstance(),uReasonId,szReason,SIZEOF_ARRAY(szReason));
+
+		failedFiles += filenames[i] + _T(" - ") + szReason + _T("\n");
 	}
 
-	EndDialog(m_hDlg,1);
+	if(failedFiles.empty())
+	{
+		return;
+	}
+
+	TCHAR szFailed[128];
+	LoadString(GetInstance(),IDS_DESTROY_FILES_FAILED,
+		szFailed,SIZEOF_ARRAY(szFailed));
+
+	std::wstring message = std::wstring(szFailed) + _T("\n\n") + failedFiles;
+
+	MessageBox(m_hDlg,message.c_str(),NExplorerplusplus::APP_NAME,
+		MB_ICONWARNING|MB_SETFOREGROUND|MB_OK);
 }
 
 CDestroyFilesDialogPersistentSettings::CDestroyFilesDialogPersistentSettings() :
 CDialogSettings(SETTINGS_KEY)
 {
 	m_uOverwriteMethod = NFileOperations::OVERWRITE_ONEPASS;
+	m_bVerify = FALSE;
 }
 
 CDestroyFilesDialogPersistentSettings::~CDestroyFilesDialogPersistentSettings()
@@ -324,17 +397,20 @@ CDestroyFilesDialogPersistentSettings& CDestroyFilesDialogPersistentSettings::Ge
 void CDestroyFilesDialogPersistentSettings::SaveExtraRegistrySettings(HKEY hKey)
 {
 	NRegistrySettings::SaveDwordToRegistry(hKey, SETTING_OVERWRITE_METHOD, m_uOverwriteMethod);
+	NRegistrySettings::SaveDwordToRegistry(hKey, SETTING_VERIFY, m_bVerify);
 }
 
 void CDestroyFilesDialogPersistentSettings::LoadExtraRegistrySettings(HKEY hKey)
 {
 	NRegistrySettings::ReadDwordFromRegistry(hKey, SETTING_OVERWRITE_METHOD, reinterpret_cast<LPDWORD>(&m_uOverwriteMethod));
+	NRegistrySettings::ReadDwordFromRegistry(hKey, SETTING_VERIFY, reinterpret_cast<LPDWORD>(&m_bVerify));
 }
 
 void CDestroyFilesDialogPersistentSettings::SaveExtraXMLSettings(IXMLDOMDocument *pXMLDom,
 	IXMLDOMElement *pParentNode)
 {
 	NXMLSettings::AddAttributeToNode(pXMLDom, pParentNode, SETTING_OVERWRITE_METHOD, NXMLSettings::EncodeIntValue(m_uOverwriteMethod));
+	NXMLSettings::AddAttributeToNode(pXMLDom, pParentNode, SETTING_VERIFY, NXMLSettings::EncodeBoolValue(m_bVerify));
 }
 
 void CDestroyFilesDialogPersistentSettings::LoadExtraXMLSettings(BSTR bstrName,BSTR bstrValue)
@@ -343,4 +419,8 @@ void CDestroyFilesDialogPersistentSettings::LoadExtraXMLSettings(BSTR bstrName,B
 	{
 		m_uOverwriteMethod = static_cast<NFileOperations::OverwriteMethod_t>(NXMLSettings::DecodeIntValue(bstrValue));
 	}
+	else if(lstrcmpi(bstrName, SETTING_VERIFY) == 0)
+	{
+		m_bVerify = NXMLSettings::DecodeBoolValue(bstrValue);
+	}
 }
\ No newline at end of file
@@ -26,6 +26,7 @@ private:
 	static const TCHAR SETTINGS_KEY[];
 
 	static const TCHAR SETTING_OVERWRITE_METHOD[];
+	static const TCHAR SETTING_VERIFY[];
 
 	CDestroyFilesDialogPersistentSettings();
 
@@ -39,6 +40,7 @@ private:
 	void LoadExtraXMLSettings(BSTR bstrName, BSTR bstrValue);
 
 	NFileOperations::OverwriteMethod_t	m_uOverwriteMethod;
+	BOOL	m_bVerify;
 };
 
 class CDestroyFilesDialog : public CBaseDialog
@@ -64,6 +66,7 @@ private:
 	void	OnOk();
 	void	OnCancel();
 	void	OnConfirmDestroy();
+	void	ShowFailedFiles(const std::vector<std::wstring> &filenames,const std::vector<FileShredder::Status> &statuses);
 
 	std::list<std::wstring>	m_FullFilenameList;
 
@@ -7,7 +7,6 @@
 #include "Config.h"
 #include "MainResource.h"
 #include "../DisplayWindow/DisplayWindow.h"
-#include "../Helper/FolderSize.h"
 #include "../Helper/ShellHelper.h"
 
 void Explorerplusplus::UpdateDisplayWindow(void)
@@ -122,54 +121,55 @@ void Explorerplusplus::UpdateDisplayWindowForOneFile(void)
 			if (((dwAttributes & FILE_ATTRIBUTE_DIRECTORY) ==
 				FILE_ATTRIBUTE_DIRECTORY) && m_config->globalFolderSettings.showFolderSizes)
 			{
-				FolderSize_t	*pfs = NULL;
-				FolderSizeExtraInfo_t	*pfsei = NULL;
 				DWFolderSize_t	DWFolderSize;
 				TCHAR			szDisplayText[256];
 				TCHAR			szTotalSize[64];
 				TCHAR			szCalculating[64];
-				DWORD			ThreadId;
 
-				pfs = (FolderSize_t *)malloc(sizeof(FolderSize_t));
-
-				if (pfs != NULL)
-				{
-					pfsei = (FolderSizeExtraInfo_t *)malloc(sizeof(FolderSizeExtraInfo_t));
-
-					if (pfsei != NULL)
+				LoadString(m_hLanguageModule, IDS_GENERAL_TOTALSIZE,
+					szTotalSize, SIZEOF_ARRAY(szTotalSize));
+				LoadString(m_hLanguageModule, IDS_GENERAL_CALCULATING,
+					szCalculating, SIZEOF_ARRAY(szCalculating));
+				StringCchPrintf(szDisplayText, SIZEOF_ARRAY(szDisplayText),
+					_T("%s: %s"), szTotalSize, szCalculating);
+				DisplayWindow_BufferText(m_hDisplayWindow, szDisplayText);
+
+				/* Maintain a global list of folder size operations. */
+				DWFolderSize.uId = m_iDWFolderSizeUniqueId;
+				DWFolderSize.iTabId = m_tabContainer->GetSelectedTab().GetId();
+				DWFolderSize.bValid = TRUE;
+				m_DWFolderSizes.push_back(DWFolderSize);
+
+				/* Running totals are posted back while the
+				calculation is in progress, so that the size
+				shown grows as the folder is enumerated. It's
+				up to the main thread to determine whether
+				each result should actually be shown. */
+				HWND hContainer = m_hContainer;
+				int uId = m_iDWFolderSizeUniqueId;
+
+				m_folderSizeService->CalculateFolderSizeAsync(szFullItemName,
+					[hContainer, uId] (const FolderSizeService::FolderSize &folderSize, bool complete) {
+					DWFolderSizeCompletion_t *pDWFolderSizeCompletion =
+						(DWFolderSizeCompletion_t *)malloc(sizeof(DWFolderSizeCompletion_t));
+
+					if (pDWFolderSizeCompletion == NULL)
 					{
-						pfsei->pContainer = (void *)this;
-						pfsei->uId = m_iDWFolderSizeUniqueId;
-						pfs->pData = (LPVOID)pfsei;
-
-						pfs->pfnCallback = FolderSizeCallbackStub;
-
-						StringCchCopy(pfs->szPath, SIZEOF_ARRAY(pfs->szPath), szFullItemName);
-
-						LoadString(m_hLanguageModule, IDS_GENERAL_TOTALSIZE,
-							szTotalSize, SIZEOF_ARRAY(szTotalSize));
-						LoadString(m_hLanguageModule, IDS_GENERAL_CALCULATING,
-							szCalculating, SIZEOF_ARRAY(szCalculating));
-						StringCchPrintf(szDisplayText, SIZEOF_ARRAY(szDisplayText),
-							_T("%s: %s"), szTotalSize, szCalculating);
-						DisplayWindow_BufferText(m_hDisplayWindow, szDisplayText);
-
-						/* Maintain a global list of folder size operations. */
-						DWFolderSize.uId = m_iDWFolderSizeUniqueId;
-						DWFolderSize.iTabId = m_tabContainer->GetSelectedTab().GetId();
-						DWFolderSize.bValid = TRUE;
-						m_DWFolderSizes.push_back(DWFolderSize);
+						return;
+					}
 
-						HANDLE hThread = CreateThread(NULL, 0, Thread_CalculateFolderSize, (LPVOID)pfs, 0, &ThreadId);
-						CloseHandle(hThread);
+					pDWFolderSizeCompletion->liFolderSize.QuadPart = folderSize.size;
+					pDWFolderSizeCompletion->uId = uId;
+					pDWFolderSizeCompletion->bComplete = complete;
 
-						m_iDWFolderSizeUniqueId++;
-					}
-					else
+					if (!PostMessage(hContainer, WM_APP_FOLDERSIZECOMPLETED,
+						(WPARAM)pDWFolderSizeCompletion, 0))
 					{
-						free(pfs);
+						free(pDWFolderSizeCompletion);
 					}
-				}
+				});
+
+				m_iDWFolderSizeUniqueId++;
 			}
 			else
 			{
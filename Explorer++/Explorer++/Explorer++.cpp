@@ -14,6 +14,7 @@
 #include "PluginManager.h"
 #include "ShellBrowser/ViewModes.h"
 #include "../Helper/iDirectoryMonitor.h"
+#include "../Helper/Logging.h"
 #include "../Helper/ShellHelper.h"
 
 /* These entries correspond to shell
@@ -101,5 +102,24 @@ Explorerplusplus::~Explorerplusplus()
 	/* Bookmarks teardown. */
 	delete m_pBookmarksToolbar;
 
+	/* Stops any folder size calculations that are still
+	running, before the directory monitor is released. */
+	m_folderSizeService.reset();
+
+	/* The item tasks use the caches below, so any that are still
+	running need to finish first. */
+	if (m_itemTaskScheduler)
+	{
+		auto stats = m_itemTaskScheduler->GetStats();
+		LOG(info) << _T("Item tasks - Workers: ") << stats.numWorkers
+			<< _T(", tasks run: ") << stats.numTasksRun
+			<< _T(", peak queue depth: ") << stats.peakQueuedTasks;
+
+		m_itemTaskScheduler.reset();
+	}
+
+	m_thumbnailCache.reset();
+	m_thumbnailCacheFile.reset();
+
 	m_pDirMon->Release();
 }
\ No newline at end of file
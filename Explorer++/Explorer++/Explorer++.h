@@ -8,6 +8,7 @@
 #include "PluginCommandManager.h"
 #include "PluginInterface.h"
 #include "PluginMenuManager.h"
+#include "ShellBrowser/IconCache.h"
 #include "ShellBrowser/iShellView.h"
 #include "ShellBrowser/SortModes.h"
 #include "ShellBrowser/ViewModes.h"
@@ -17,9 +18,16 @@
 #include "UiTheming.h"
 #include "../Helper/FileActionHandler.h"
 #include "../Helper/FileContextMenuManager.h"
+#include "../Helper/FolderSizeService.h"
 #include "../Helper/ImageWrappers.h"
+#include "../Helper/ItemTaskScheduler.h"
+#include "../Helper/MemoryMappedFile.h"
+#include "../Helper/MetadataCache.h"
+#include "../Helper/ThumbnailCache.h"
+#include "../Helper/WildcardMatcher.h"
 #include <boost/optional.hpp>
 #include <boost/signals2.hpp>
+#include <map>
 #include <unordered_map>
 
 /* Sent when a folder size calculation has finished. */
@@ -72,8 +80,6 @@ class Explorerplusplus : public IExplorerplusplus, public TabContainerInterface,
 
 	friend LRESULT CALLBACK WndProcStub(HWND hwnd,UINT Msg,WPARAM wParam,LPARAM lParam);
 
-	friend void FolderSizeCallbackStub(int nFolders,int nFiles,PULARGE_INTEGER lTotalFolderSize,LPVOID pData);
-
 public:
 
 	Explorerplusplus(HWND);
@@ -144,6 +150,7 @@ private:
 		ULARGE_INTEGER	liFolderSize;
 		int				uId;
 		int				iTabId;
+		BOOL			bComplete;
 	};
 
 	struct DWFolderSize_t
@@ -153,12 +160,6 @@ private:
 		BOOL bValid;
 	};
 
-	struct FolderSizeExtraInfo_t
-	{
-		void	*pContainer;
-		int		uId;
-	};
-
 	LRESULT CALLBACK		WindowProcedure(HWND hwnd,UINT Msg,WPARAM wParam,LPARAM lParam);
 
 	/* Internal private functions. */
@@ -203,6 +204,7 @@ private:
 	void					OnNdwRClick(POINT *pt);
 	void					OnNdwIconRClick(POINT *pt);
 	LRESULT					OnCustomDraw(LPARAM lParam);
+	const WildcardMatcher	&GetColorRuleMatcher(const NColorRuleHelper::ColorRule_t &colorRule);
 	void					OnSortBy(SortMode sortMode);
 	void					OnGroupBy(SortMode sortMode);
 	void					OnSelectTabByIndex(int iTab);
@@ -482,6 +484,11 @@ private:
 	TabContainer			*GetTabContainer() const;
 	HWND					GetTreeView() const;
 	IDirectoryMonitor		*GetDirectoryMonitor() const;
+	FolderSizeService		*GetFolderSizeService() const;
+	ThumbnailCache			*GetThumbnailCache() const;
+	IconCache				*GetIconCache() const;
+	MetadataCache			*GetMetadataCache() const;
+	ItemTaskScheduler		*GetItemTaskScheduler() const;
 
 	/* Helpers. */
 	HANDLE					CreateWorkerThread();
@@ -495,6 +502,9 @@ private:
 	/* Miscellaneous. */
 	void					CreateStatusBar(void);
 	void					InitializeDisplayWindow();
+	void					InitializeThumbnailCache();
+	void					InitializeIconCache();
+	void					InitializeMetadataCache();
 	void					SetGoMenuName(HMENU hMenu,UINT uMenuID,UINT csidl);
 	int						CreateDriveFreeSpaceString(const TCHAR *szPath, TCHAR *szBuffer, int nBuffer);
 	BOOL					AnyItemsSelected(void);
@@ -503,7 +513,6 @@ private:
 	void					CycleViewState(BOOL bCycleForward);
 	HMENU					CreateRebarHistoryMenu(BOOL bBack);
 	CStatusBar				*GetStatusBar();
-	void					FolderSizeCallback(FolderSizeExtraInfo_t *pfsei,int nFolders,int nFiles,PULARGE_INTEGER lTotalFolderSize);
 
 	/* ------ Internal state. ------ */
 
@@ -519,6 +528,26 @@ private:
 	HWND					m_hBookmarksToolbar;
 
 	IDirectoryMonitor *		m_pDirMon;
+	std::unique_ptr<FolderSizeService>	m_folderSizeService;
+
+	/* Thumbnails are kept in a file alongside the executable,
+	so that they're available in later sessions. The cache is
+	declared after the file, so that it's destroyed first. */
+	std::unique_ptr<MemoryMappedFile>	m_thumbnailCacheFile;
+	std::unique_ptr<ThumbnailCache>		m_thumbnailCache;
+
+	/* Shared between all tabs. Saved when the application
+	closes. */
+	std::unique_ptr<IconCache>	m_iconCache;
+
+	/* Column values (owner, version information, media tags,
+	etc.) shared between all tabs. The slowest of these are
+	saved when the application closes. */
+	std::unique_ptr<MetadataCache>	m_metadataCache;
+
+	/* Runs the column, icon, thumbnail and infotip tasks for
+	every tab. Tasks for the selected tab are run first. */
+	std::unique_ptr<ItemTaskScheduler>	m_itemTaskScheduler;
 	CMyTreeView *			m_pMyTreeView;
 	CStatusBar *			m_pStatusBar;
 	HANDLE					m_hTreeViewIconThread;
@@ -588,6 +617,7 @@ private:
 
 	/* Customize colors. */
 	std::vector<NColorRuleHelper::ColorRule_t>	m_ColorRules;
+	std::map<std::pair<std::wstring, bool>, WildcardMatcher>	m_colorRuleMatchers;
 
 	/* Undo support. */
 	CFileActionHandler		m_FileActionHandler;
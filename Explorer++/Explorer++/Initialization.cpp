@@ -20,10 +20,30 @@
 #include "../Helper/FileOperations.h"
 #include "../Helper/Helper.h"
 #include "../Helper/iDirectoryMonitor.h"
+#include "../Helper/Logging.h"
 #include "../Helper/Macros.h"
+#include "../Helper/ProcessHelper.h"
+#include <algorithm>
+#include <chrono>
 #include <list>
 #include <map>
+#include <thread>
 
+namespace
+{
+	const TCHAR THUMBNAIL_CACHE_FILENAME[] = _T("thumbnails.dat");
+
+	const TCHAR ICON_CACHE_FILENAME[] = _T("icons.dat");
+
+	/* Only icons that differ from file to file (e.g. those
+	for executables and shortcuts) are cached by path. */
+	const size_t ICON_CACHE_MAX_PATH_ENTRIES = 10000;
+
+	const TCHAR METADATA_CACHE_FILENAME[] = _T("metadata.dat");
+
+	/* Each entry is a single column value for a single item. */
+	const size_t METADATA_CACHE_MAX_ENTRIES = 100000;
+}
 
 DWORD WINAPI WorkerThreadProc(LPVOID pParam);
 void CALLBACK InitializeCOMAPC(ULONG_PTR dwParam);
@@ -116,6 +136,18 @@ void CALLBACK InitializeCOMAPC(ULONG_PTR dwParam)
 */
 void Explorerplusplus::OnCreate(void)
 {
+	/* The time taken by each phase of startup is logged,
+	so that slow startups can be diagnosed. */
+	auto startTime = std::chrono::steady_clock::now();
+	auto phaseStartTime = startTime;
+
+	auto logStartupPhase = [&phaseStartTime] (const TCHAR *phase) {
+		auto now = std::chrono::steady_clock::now();
+		LOG(info) << _T("Startup - ") << phase << _T(": ")
+			<< std::chrono::duration_cast<std::chrono::milliseconds>(now - phaseStartTime).count() << _T(" ms");
+		phaseStartTime = now;
+	};
+
 	InitializeMainToolbars();
 	InitializeBookmarks();
 
@@ -123,6 +155,8 @@ void Explorerplusplus::OnCreate(void)
 	LoadAllSettings(&pLoadSave);
 	ApplyToolbarSettings();
 
+	logStartupPhase(_T("Loading settings"));
+
 	SetLanguageModule();
 
 	m_navigation = new Navigation(m_config, this);
@@ -150,6 +184,23 @@ void Explorerplusplus::OnCreate(void)
 
 	CreateDirectoryMonitor(&m_pDirMon);
 
+	/* Folder sizes are calculated by a pool of workers, shared
+	between all tabs (as well as the display window). */
+	m_folderSizeService = std::make_unique<FolderSizeService>(
+		static_cast<int>((std::max)(2u, std::thread::hardware_concurrency())), m_pDirMon);
+
+	/* Likewise, a single set of workers (one per core) looks up
+	column text, icons, thumbnails and infotips for every tab. */
+	m_itemTaskScheduler = std::make_unique<ItemTaskScheduler>(0, [] {
+		CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+	}, [] {
+		CoUninitialize();
+	});
+
+	InitializeThumbnailCache();
+	InitializeIconCache();
+	InitializeMetadataCache();
+
 	CreateStatusBar();
 	CreateMainControls();
 	InitializeDisplayWindow();
@@ -172,9 +223,25 @@ void Explorerplusplus::OnCreate(void)
 
 	m_taskbarThumbnails = TaskbarThumbnails::Create(this, m_tabContainer, m_navigation, m_hLanguageModule, m_config);
 
+	logStartupPhase(_T("Creating windows"));
+
 	RestoreTabs(pLoadSave);
 	delete pLoadSave;
 
+	int numLoadedTabs = 0;
+
+	for (const auto &item : m_tabContainer->GetAllTabs())
+	{
+		if (item.second.IsLoaded())
+		{
+			numLoadedTabs++;
+		}
+	}
+
+	LOG(info) << _T("Startup - Restored ") << m_tabContainer->GetNumTabs() << _T(" tabs (")
+		<< numLoadedTabs << _T(" loaded)");
+	logStartupPhase(_T("Restoring tabs"));
+
 	SHChangeNotifyEntry shcne;
 
 	/* Don't need to specify any file for this notification. */
@@ -203,6 +270,11 @@ void Explorerplusplus::OnCreate(void)
 
 	SetTimer(m_hContainer, AUTOSAVE_TIMER_ID, AUTOSAVE_TIMEOUT, nullptr);
 
+	logStartupPhase(_T("Remaining initialization"));
+
+	LOG(info) << _T("Startup - Total: ")
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count() << _T(" ms");
+
 	m_InitializationFinished = true;
 }
 
@@ -258,6 +330,70 @@ void Explorerplusplus::InitializeDisplayWindow()
 	m_hDisplayWindow = CreateDisplayWindow(m_hContainer,&InitialSettings);
 }
 
+void Explorerplusplus::InitializeThumbnailCache()
+{
+	if (m_config->thumbnailCacheSize == 0)
+	{
+		return;
+	}
+
+	TCHAR cacheFile[MAX_PATH];
+	GetProcessImageName(GetCurrentProcessId(), cacheFile, SIZEOF_ARRAY(cacheFile));
+	PathRemoveFileSpec(cacheFile);
+	PathAppend(cacheFile, THUMBNAIL_CACHE_FILENAME);
+
+	size_t storageSize = ThumbnailCache::GetStorageSize(CShellBrowser::THUMBNAIL_ITEM_WIDTH,
+		CShellBrowser::THUMBNAIL_ITEM_HEIGHT, m_config->thumbnailCacheSize);
+
+	// If the file can't be opened (e.g. because the directory
+	// isn't writable, another instance is using it, or the
+	// cache is too large to be mapped), thumbnails simply won't
+	// be cached. Changing the size of the cache discards its
+	// existing contents.
+	m_thumbnailCacheFile = MemoryMappedFile::Open(cacheFile, storageSize);
+
+	if (!m_thumbnailCacheFile)
+	{
+		return;
+	}
+
+	m_thumbnailCache = std::make_unique<ThumbnailCache>(m_thumbnailCacheFile->GetData(),
+		m_thumbnailCacheFile->GetSize(), CShellBrowser::THUMBNAIL_ITEM_WIDTH,
+		CShellBrowser::THUMBNAIL_ITEM_HEIGHT);
+}
+
+void Explorerplusplus::InitializeIconCache()
+{
+	TCHAR cacheFile[MAX_PATH];
+	GetProcessImageName(GetCurrentProcessId(), cacheFile, SIZEOF_ARRAY(cacheFile));
+	PathRemoveFileSpec(cacheFile);
+	PathAppend(cacheFile, ICON_CACHE_FILENAME);
+
+	// The cache file itself is only read the first time an icon
+	// is looked up.
+	m_iconCache = std::make_unique<IconCache>(cacheFile, ICON_CACHE_MAX_PATH_ENTRIES,
+		[] (const IconLocation &location) -> boost::optional<int> {
+		int iconIndex = Shell_GetCachedImageIndex(location.file.c_str(), location.index, 0);
+
+		if (iconIndex == -1)
+		{
+			return boost::none;
+		}
+
+		return iconIndex;
+	});
+}
+
+void Explorerplusplus::InitializeMetadataCache()
+{
+	TCHAR cacheFile[MAX_PATH];
+	GetProcessImageName(GetCurrentProcessId(), cacheFile, SIZEOF_ARRAY(cacheFile));
+	PathRemoveFileSpec(cacheFile);
+	PathAppend(cacheFile, METADATA_CACHE_FILENAME);
+
+	m_metadataCache = std::make_unique<MetadataCache>(cacheFile, METADATA_CACHE_MAX_ENTRIES);
+}
+
 void Explorerplusplus::InitializeMenus(void)
 {
 	HMENU hMenu = GetMenu(m_hContainer);
@@ -64,7 +64,17 @@ LRESULT CALLBACK ListViewProcStub(HWND hwnd,UINT uMsg,WPARAM wParam,LPARAM lPara
 
 HWND Explorerplusplus::CreateMainListView(HWND hParent)
 {
-	HWND hListView = CreateListView(hParent, MAIN_LISTVIEW_STYLES);
+	DWORD style = MAIN_LISTVIEW_STYLES;
+
+	/* LVS_OWNERDATA can only be set when the listview
+	is created, so changes to this setting only apply to
+	tabs opened afterwards. */
+	if(m_config->globalFolderSettings.virtualListView)
+	{
+		style |= LVS_OWNERDATA;
+	}
+
+	HWND hListView = CreateListView(hParent, style);
 
 	if(hListView == NULL)
 	{
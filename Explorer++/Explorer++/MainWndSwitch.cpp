@@ -170,7 +170,9 @@ LRESULT CALLBACK Explorerplusplus::WindowProcedure(HWND hwnd,UINT Msg,WPARAM wPa
 			/* First, make sure we should still display the
 			results (we won't if the listview selection has
 			changed, or this folder size was calculated for
-			a tab other than the current one). */
+			a tab other than the current one). Partial results
+			may arrive before the final one, so the operation
+			is only removed once it's complete. */
 			for(itr = m_DWFolderSizes.begin();itr != m_DWFolderSizes.end();itr++)
 			{
 				if(itr->uId == pDWFolderSizeCompletion->uId)
@@ -180,7 +182,10 @@ LRESULT CALLBACK Explorerplusplus::WindowProcedure(HWND hwnd,UINT Msg,WPARAM wPa
 						bValid = itr->bValid;
 					}
 
-					m_DWFolderSizes.erase(itr);
+					if(pDWFolderSizeCompletion->bComplete)
+					{
+						m_DWFolderSizes.erase(itr);
+					}
 
 					break;
 				}
@@ -6,13 +6,18 @@
 #include "MergeFilesDialog.h"
 #include "Explorer++_internal.h"
 #include "MainResource.h"
+#include "../Helper/ChecksumManifest.h"
+#include "../Helper/ChunkedFileCopier.h"
 #include "../Helper/FileOperations.h"
+#include "../Helper/FileWrappers.h"
 #include "../Helper/Helper.h"
 #include "../Helper/ListViewHelper.h"
 #include "../Helper/Macros.h"
 #include "../Helper/ShellHelper.h"
 #include "../Helper/StringHelper.h"
 #include <boost/scope_exit.hpp>
+#include <algorithm>
+#include <iterator>
 #include <regex>
 
 #pragma warning(disable:4459) // declaration of 'boost_scope_exit_aux_args' hides global declaration
@@ -23,6 +28,10 @@ namespace NMergeFilesDialog
 	const int WM_APP_SETCURRENTMERGECOUNT	= WM_APP + 2;
 	const int WM_APP_MERGINGFINISHED		= WM_APP + 3;
 	const int WM_APP_OUTPUTFILEINVALID		= WM_APP + 4;
+	const int WM_APP_MERGEFAILED			= WM_APP + 5;
+
+	/* Written by the split file dialog. */
+	const TCHAR MANIFEST_EXTENSION[] = _T(".sfv");
 
 	DWORD WINAPI	MergeFilesThread(LPVOID pParam);
 }
@@ -91,6 +100,11 @@ INT_PTR CMergeFilesDialog::OnInitDialog()
 		rxPattern.assign(_T("[\\.]?part[0-9]+"),std::regex_constants::icase);
 		strOutputFilename = std::regex_replace(m_FullFilenameList.front(),
 			rxPattern,std::wstring(_T("")));
+
+		/* If the files were split by this program, a manifest
+		will have been written alongside them, named after
+		the original file. */
+		m_strManifestFilename = strOutputFilename + NMergeFilesDialog::MANIFEST_EXTENSION;
 	}
 	else
 	{
@@ -317,8 +331,6 @@ INT_PTR CMergeFilesDialog::OnDestroy()
 
 INT_PTR CMergeFilesDialog::OnPrivateMessage(UINT uMsg,WPARAM wParam,LPARAM lParam)
 {
-	UNREFERENCED_PARAMETER(lParam);
-
 	switch(uMsg)
 	{
 	case NMergeFilesDialog::WM_APP_SETTOTALMERGECOUNT:
@@ -330,7 +342,11 @@ INT_PTR CMergeFilesDialog::OnPrivateMessage(UINT uMsg,WPARAM wParam,LPARAM lPara
 		break;
 
 	case NMergeFilesDialog::WM_APP_MERGINGFINISHED:
-		OnFinished();
+		OnFinished(wParam != FALSE);
+		break;
+
+	case NMergeFilesDialog::WM_APP_MERGEFAILED:
+		OnMergeFailed(static_cast<int>(wParam),static_cast<UINT>(lParam));
 		break;
 
 	case NMergeFilesDialog::WM_APP_OUTPUTFILEINVALID:
@@ -382,7 +398,7 @@ void CMergeFilesDialog::OnOk()
 		TCHAR szOutputFileName[MAX_PATH];
 		GetWindowText(hOutputFileName,szOutputFileName,SIZEOF_ARRAY(szOutputFileName));
 
-		m_pMergeFiles = new CMergeFiles(m_hDlg,szOutputFileName,m_FullFilenameList);
+		m_pMergeFiles = new CMergeFiles(m_hDlg,szOutputFileName,m_FullFilenameList,m_strManifestFilename);
 
 		SendDlgItemMessage(m_hDlg,IDC_MERGE_PROGRESS,PBM_SETPOS,0,0);
 
@@ -487,7 +503,29 @@ void CMergeFilesDialog::OnMove(bool bUp)
 	}
 }
 
-void CMergeFilesDialog::OnFinished()
+/* The merge will already have been stopped (and the output
+file deleted) at this point. The message is formatted with
+the name of the part that was being merged. */
+void CMergeFilesDialog::OnMergeFailed(int iPart,UINT uMessageId)
+{
+	if(iPart < 0 || iPart >= static_cast<int>(m_FullFilenameList.size()))
+	{
+		return;
+	}
+
+	auto itr = std::next(m_FullFilenameList.begin(),iPart);
+
+	TCHAR szTemp[128];
+	LoadString(GetInstance(),uMessageId,
+		szTemp,SIZEOF_ARRAY(szTemp));
+
+	TCHAR szMessage[128 + MAX_PATH];
+	StringCchPrintf(szMessage,SIZEOF_ARRAY(szMessage),szTemp,
+		PathFindFileName(itr->c_str()));
+	MessageBox(m_hDlg,szMessage,NExplorerplusplus::APP_NAME,MB_ICONWARNING|MB_OK);
+}
+
+void CMergeFilesDialog::OnFinished(bool bSucceeded)
 {
 	assert(m_pMergeFiles != NULL);
 
@@ -497,9 +535,12 @@ void CMergeFilesDialog::OnFinished()
 	m_bMergingFiles = false;
 	m_bStopMerging = false;
 
-	/* Set the progress bar position to the end. */
-	int iHighLimit = static_cast<int>(SendDlgItemMessage(m_hDlg,IDC_MERGE_PROGRESS,PBM_GETRANGE,FALSE,0));
-	SendDlgItemMessage(m_hDlg,IDC_MERGE_PROGRESS,PBM_SETPOS,iHighLimit,0);
+	if(bSucceeded)
+	{
+		/* Set the progress bar position to the end. */
+		int iHighLimit = static_cast<int>(SendDlgItemMessage(m_hDlg,IDC_MERGE_PROGRESS,PBM_GETRANGE,FALSE,0));
+		SendDlgItemMessage(m_hDlg,IDC_MERGE_PROGRESS,PBM_SETPOS,iHighLimit,0);
+	}
 
 	SetDlgItemText(m_hDlg,IDOK,m_szOk);
 }
@@ -514,11 +555,13 @@ DWORD WINAPI NMergeFilesDialog::MergeFilesThread(LPVOID pParam)
 	return 0;
 }
 
-CMergeFiles::CMergeFiles(HWND hDlg,std::wstring strOutputFilename,std::list<std::wstring> FullFilenameList)
+CMergeFiles::CMergeFiles(HWND hDlg,std::wstring strOutputFilename,std::list<std::wstring> FullFilenameList,
+	std::wstring strManifestFilename)
 {
-	m_hDlg				= hDlg;
-	m_strOutputFilename	= strOutputFilename;
-	m_FullFilenameList	= FullFilenameList;
+	m_hDlg					= hDlg;
+	m_strOutputFilename		= strOutputFilename;
+	m_FullFilenameList		= FullFilenameList;
+	m_strManifestFilename	= strManifestFilename;
 
 	m_bstopMerging		= false;
 
@@ -530,69 +573,148 @@ CMergeFiles::~CMergeFiles()
 	DeleteCriticalSection(&m_csStop);
 }
 
+/* Each part is streamed into the output file in fixed-size
+chunks, so the memory used doesn't depend on the size of the
+parts. The merge stops at the first part that can't be
+merged, in which case the output file is deleted. */
 void CMergeFiles::StartMerging()
 {
-	LARGE_INTEGER lMergeFileSize;
-	int nFilesMerged = 1;
-	bool bStop = false;
-
-	HANDLE hOutputFile = CreateFile(m_strOutputFilename.c_str(),GENERIC_WRITE,
-		0,NULL,CREATE_NEW,FILE_ATTRIBUTE_NORMAL,NULL);
+	HFilePtr outputFile = CreateFilePtr(m_strOutputFilename.c_str(),GENERIC_WRITE,
+		0,NULL,CREATE_NEW,FILE_ATTRIBUTE_NORMAL|FILE_FLAG_OVERLAPPED,NULL);
 
-	if(hOutputFile == INVALID_HANDLE_VALUE)
+	if(!outputFile)
 	{
 		PostMessage(m_hDlg,NMergeFilesDialog::WM_APP_OUTPUTFILEINVALID,0,0);
 		return;
 	}
 
-	PostMessage(m_hDlg,NMergeFilesDialog::WM_APP_SETTOTALMERGECOUNT,
-		static_cast<WPARAM>(m_FullFilenameList.size()),0);
+	/* Progress is shown in terms of the number of bytes
+	merged, so the total size is needed up-front. */
+	std::uint64_t totalSize = 0;
 
 	for(const auto &strFullFilename : m_FullFilenameList)
 	{
-		if(bStop)
+		WIN32_FILE_ATTRIBUTE_DATA fileAttributes;
+
+		if(GetFileAttributesEx(strFullFilename.c_str(),GetFileExInfoStandard,&fileAttributes))
 		{
-			break;
+			ULARGE_INTEGER fileSize = {fileAttributes.nFileSizeLow,fileAttributes.nFileSizeHigh};
+			totalSize += fileSize.QuadPart;
 		}
+	}
+
+	PostMessage(m_hDlg,NMergeFilesDialog::WM_APP_SETTOTALMERGECOUNT,PROGRESS_RANGE,0);
+
+	boost::optional<ChecksumManifest> manifest;
+
+	if(!m_strManifestFilename.empty())
+	{
+		manifest = LoadChecksumManifest(m_strManifestFilename);
+	}
 
-		HANDLE hInputFile = CreateFile(strFullFilename.c_str(),GENERIC_READ,FILE_SHARE_READ,
-			NULL,OPEN_EXISTING,0,NULL);
+	ChunkedFileCopier copier;
+	std::uint64_t outputOffset = 0;
+	int currentProgress = 0;
+	int iPart = 0;
+	bool bSucceeded = true;
 
-		if(hInputFile != INVALID_HANDLE_VALUE)
+	auto progressCallback = [this,totalSize,&outputOffset,&currentProgress] (std::uint64_t bytesCopied) {
+		if(totalSize > 0)
 		{
-			GetFileSizeEx(hInputFile,&lMergeFileSize);
+			std::uint64_t bytesMerged = (std::min)(outputOffset + bytesCopied,totalSize);
+			int progress = static_cast<int>(bytesMerged * PROGRESS_RANGE / totalSize);
 
-			if(lMergeFileSize.QuadPart != 0)
+			if(progress != currentProgress)
 			{
-				auto buffer = std::make_unique<char[]>(lMergeFileSize.LowPart);
+				PostMessage(m_hDlg,NMergeFilesDialog::WM_APP_SETCURRENTMERGECOUNT,progress,0);
+				currentProgress = progress;
+			}
+		}
+
+		EnterCriticalSection(&m_csStop);
+		bool bStop = m_bstopMerging;
+		LeaveCriticalSection(&m_csStop);
+
+		return !bStop;
+	};
+
+	for(const auto &strFullFilename : m_FullFilenameList)
+	{
+		int iCurrentPart = iPart++;
 
-				DWORD dwNumberOfBytesRead;
-				ReadFile(hInputFile,reinterpret_cast<LPVOID>(buffer.get()),static_cast<DWORD>(lMergeFileSize.LowPart),
-					&dwNumberOfBytesRead,NULL);
+		HFilePtr inputFile = CreateFilePtr(strFullFilename.c_str(),GENERIC_READ,FILE_SHARE_READ,
+			NULL,OPEN_EXISTING,FILE_FLAG_OVERLAPPED|FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+
+		if(!inputFile)
+		{
+			PostMessage(m_hDlg,NMergeFilesDialog::WM_APP_MERGEFAILED,iCurrentPart,IDS_MERGE_FILES_PARTOPENFAILED);
+			bSucceeded = false;
+			break;
+		}
+
+		ChunkedFileCopier::Options options;
+
+		if(manifest)
+		{
+			auto checksum = FindChecksum(*manifest,PathFindFileName(strFullFilename.c_str()));
 
-				DWORD dwNumberOfBytesWritten;
-				WriteFile(hOutputFile,reinterpret_cast<LPCVOID>(buffer.get()),dwNumberOfBytesRead,
-					&dwNumberOfBytesWritten,NULL);
+			if(checksum)
+			{
+				options.computeChecksum = true;
+				options.verifyChecksum = true;
+				options.expectedChecksum = *checksum;
 			}
+		}
+
+		auto result = copier.Copy(inputFile.get(),0,UINT64_MAX,outputFile.get(),outputOffset,
+			options,progressCallback);
+
+		outputOffset += result.bytesCopied;
+
+		if(result.status != ChunkedFileCopier::Status::Succeeded)
+		{
+			UINT uMessageId = 0;
+
+			switch(result.status)
+			{
+			case ChunkedFileCopier::Status::ReadFailed:
+				uMessageId = IDS_MERGE_FILES_PARTREADFAILED;
+				break;
 
-			CloseHandle(hInputFile);
+			case ChunkedFileCopier::Status::WriteFailed:
+				uMessageId = IDS_MERGE_FILES_WRITEFAILED;
+				break;
 
-			PostMessage(m_hDlg,NMergeFilesDialog::WM_APP_SETCURRENTMERGECOUNT,nFilesMerged,0);
+			case ChunkedFileCopier::Status::ChecksumMismatch:
+				uMessageId = IDS_MERGE_FILES_CHECKSUMMISMATCH;
+				break;
 
-			nFilesMerged++;
+			default:
+				break;
+			}
 
-			EnterCriticalSection(&m_csStop);
-			if(m_bstopMerging)
+			/* There's nothing to report if the merge was
+			cancelled. */
+			if(uMessageId != 0)
 			{
-				bStop = true;
+				PostMessage(m_hDlg,NMergeFilesDialog::WM_APP_MERGEFAILED,iCurrentPart,uMessageId);
 			}
-			LeaveCriticalSection(&m_csStop);
+
+			bSucceeded = false;
+			break;
 		}
 	}
 
-	CloseHandle(hOutputFile);
+	outputFile.reset();
+
+	if(!bSucceeded)
+	{
+		/* The output would be incomplete (or corrupt), so
+		there's no point keeping it. */
+		DeleteFile(m_strOutputFilename.c_str());
+	}
 
-	SendMessage(m_hDlg,NMergeFilesDialog::WM_APP_MERGINGFINISHED,0,0);
+	SendMessage(m_hDlg,NMergeFilesDialog::WM_APP_MERGINGFINISHED,bSucceeded,0);
 }
 
 void CMergeFiles::StopMerging()
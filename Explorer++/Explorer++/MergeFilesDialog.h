@@ -35,7 +35,10 @@ class CMergeFiles : public CReferenceCount
 {
 public:
 	
-	CMergeFiles(HWND hDlg,std::wstring strOutputFilename,std::list<std::wstring> FullFilenameList);
+	/* If a manifest filename is given, and the manifest
+	exists, each part it lists is verified against its
+	checksum as it's merged. */
+	CMergeFiles(HWND hDlg,std::wstring strOutputFilename,std::list<std::wstring> FullFilenameList,std::wstring strManifestFilename);
 	~CMergeFiles();
 
 	void					StartMerging();
@@ -43,10 +46,15 @@ public:
 
 private:
 
+	/* The progress bar range. Progress is reported as a
+	fraction of the total number of bytes to be merged. */
+	static const int		PROGRESS_RANGE = 1000;
+
 	HWND					m_hDlg;
 
 	std::wstring			m_strOutputFilename;
 	std::list<std::wstring>	m_FullFilenameList;
+	std::wstring			m_strManifestFilename;
 
 	CRITICAL_SECTION		m_csStop;
 	bool					m_bstopMerging;
@@ -77,10 +85,12 @@ private:
 	void	OnCancel();
 	void	OnChangeOutputDirectory();
 	void	OnMove(bool bUp);
-	void	OnFinished();
+	void	OnFinished(bool bSucceeded);
+	void	OnMergeFailed(int iPart,UINT uMessageId);
 
 	std::wstring			m_strOutputDirectory;
 	std::list<std::wstring>	m_FullFilenameList;
+	std::wstring			m_strManifestFilename;
 	BOOL					m_bShowFriendlyDates;
 
 	CMergeFiles				*m_pMergeFiles;
@@ -261,6 +261,11 @@ LRESULT Explorerplusplus::OnDeviceChange(WPARAM wParam,LPARAM lParam)
 	update its contents). */
 	for (auto &tab : m_tabContainer->GetAllTabs() | boost::adaptors::map_values)
 	{
+		if (!tab.IsLoaded())
+		{
+			continue;
+		}
+
 		tab.GetShellBrowser()->OnDeviceChange(wParam,lParam);
 	}
 
@@ -320,34 +325,6 @@ void *pData)
 	}
 }
 
-void FolderSizeCallbackStub(int nFolders,int nFiles,PULARGE_INTEGER lTotalFolderSize,LPVOID pData)
-{
-	Explorerplusplus::FolderSizeExtraInfo_t *pfsei = reinterpret_cast<Explorerplusplus::FolderSizeExtraInfo_t *>(pData);
-	reinterpret_cast<Explorerplusplus *>(pfsei->pContainer)->FolderSizeCallback(pfsei,nFolders,nFiles,lTotalFolderSize);
-	free(pfsei);
-}
-
-void Explorerplusplus::FolderSizeCallback(FolderSizeExtraInfo_t *pfsei,
-int nFolders,int nFiles,PULARGE_INTEGER lTotalFolderSize)
-{
-	UNREFERENCED_PARAMETER(nFolders);
-	UNREFERENCED_PARAMETER(nFiles);
-
-	DWFolderSizeCompletion_t *pDWFolderSizeCompletion = NULL;
-
-	pDWFolderSizeCompletion = (DWFolderSizeCompletion_t *)malloc(sizeof(DWFolderSizeCompletion_t));
-
-	pDWFolderSizeCompletion->liFolderSize = *lTotalFolderSize;
-	pDWFolderSizeCompletion->uId = pfsei->uId;
-
-	/* Queue the result back to the main thread, so that
-	the folder size can be displayed. It is up to the main
-	thread to determine whether the folder size should actually
-	be shown. */
-	PostMessage(m_hContainer,WM_APP_FOLDERSIZECOMPLETED,
-		(WPARAM)pDWFolderSizeCompletion,0);
-}
-
 int Explorerplusplus::CreateDriveFreeSpaceString(const TCHAR *szPath, TCHAR *szBuffer, int nBuffer)
 {
 	ULARGE_INTEGER	TotalNumberOfBytes;
@@ -23,6 +23,7 @@
 #include "../Helper/ProcessHelper.h"
 #include "../Helper/RegistrySettings.h"
 #include "../Helper/ShellHelper.h"
+#include "../Helper/WildcardMatcher.h"
 #include "../Helper/WindowHelper.h"
 #include "../MyTreeView/MyTreeView.h"
 #include <boost/range/adaptor/map.hpp>
@@ -480,6 +481,11 @@ BOOL Explorerplusplus::OnSize(int MainWindowWidth,int MainWindowHeight)
 
 	for (auto &tab : m_tabContainer->GetAllTabs() | boost::adaptors::map_values)
 	{
+		if (!tab.IsLoaded())
+		{
+			continue;
+		}
+
 		uFlags = SWP_NOZORDER;
 
 		if (m_tabContainer->IsTabSelected(tab))
@@ -582,6 +588,9 @@ int Explorerplusplus::OnClose(void)
 
 	SaveAllSettings();
 
+	m_iconCache->Save();
+	m_metadataCache->Save();
+
 	DestroyWindow(m_hContainer);
 
 	return 0;
@@ -1265,6 +1274,11 @@ void Explorerplusplus::OnAssocChanged(void)
 	/* Now, go through each tab, and refresh each icon. */
 	for (auto &tab : m_tabContainer->GetAllTabs() | boost::adaptors::map_values)
 	{
+		if (!tab.IsLoaded())
+		{
+			continue;
+		}
+
 		tab.GetShellBrowser()->Refresh();
 	}
 
@@ -1344,6 +1358,23 @@ void Explorerplusplus::OnNdwRClick(POINT *pt)
 	}
 }
 
+/* Every item is checked against each color rule
+whenever it's drawn, so the pattern for each rule is
+only compiled the first time it's used. */
+const WildcardMatcher &Explorerplusplus::GetColorRuleMatcher(const NColorRuleHelper::ColorRule_t &colorRule)
+{
+	bool caseSensitive = !colorRule.caseInsensitive;
+	auto key = std::make_pair(colorRule.strFilterPattern, caseSensitive);
+	auto itr = m_colorRuleMatchers.find(key);
+
+	if(itr == m_colorRuleMatchers.end())
+	{
+		itr = m_colorRuleMatchers.insert({key, WildcardMatcher(colorRule.strFilterPattern, caseSensitive)}).first;
+	}
+
+	return itr->second;
+}
+
 LRESULT Explorerplusplus::OnCustomDraw(LPARAM lParam)
 {
 	NMLVCUSTOMDRAW *pnmlvcd = NULL;
@@ -1379,7 +1410,7 @@ LRESULT Explorerplusplus::OnCustomDraw(LPARAM lParam)
 					/* Only match against the filename if it's not empty. */
 					if(ColorRule.strFilterPattern.size() > 0)
 					{
-						if(CheckWildcardMatch(ColorRule.strFilterPattern.c_str(),szFileName,!ColorRule.caseInsensitive) == 1)
+						if(GetColorRuleMatcher(ColorRule).Matches(szFileName))
 						{
 							bMatchFileName = TRUE;
 						}
@@ -1507,6 +1538,31 @@ IDirectoryMonitor *Explorerplusplus::GetDirectoryMonitor() const
 	return m_pDirMon;
 }
 
+FolderSizeService *Explorerplusplus::GetFolderSizeService() const
+{
+	return m_folderSizeService.get();
+}
+
+ThumbnailCache *Explorerplusplus::GetThumbnailCache() const
+{
+	return m_thumbnailCache.get();
+}
+
+IconCache *Explorerplusplus::GetIconCache() const
+{
+	return m_iconCache.get();
+}
+
+MetadataCache *Explorerplusplus::GetMetadataCache() const
+{
+	return m_metadataCache.get();
+}
+
+ItemTaskScheduler *Explorerplusplus::GetItemTaskScheduler() const
+{
+	return m_itemTaskScheduler.get();
+}
+
 void Explorerplusplus::OnShowHiddenFiles(void)
 {
 	m_pActiveShellBrowser->SetShowHidden(!m_pActiveShellBrowser->GetShowHidden());
@@ -16,6 +16,7 @@ Navigation::Navigation(std::shared_ptr<Config> config, IExplorerplusplus *expp)
 	m_expp->AddTabsInitializedObserver([this] {
 		m_tabContainer = m_expp->GetTabContainer();
 		m_tabContainer->tabCreatedSignal.AddObserver(boost::bind(&Navigation::OnTabCreated, this, _1, _2), boost::signals2::at_front);
+		m_tabContainer->tabLoadedSignal.AddObserver(boost::bind(&Navigation::OnTabLoaded, this, _1), boost::signals2::at_front);
 	});
 }
 
@@ -29,6 +30,19 @@ void Navigation::OnTabCreated(int tabId, BOOL switchToNewTab)
 	UNREFERENCED_PARAMETER(switchToNewTab);
 
 	const Tab &tab = m_tabContainer->GetTab(tabId);
+
+	/* Tabs that are loaded on demand won't have navigated
+	anywhere yet. */
+	if (!tab.IsLoaded())
+	{
+		return;
+	}
+
+	navigationCompletedSignal.m_signal(tab);
+}
+
+void Navigation::OnTabLoaded(const Tab &tab)
+{
 	navigationCompletedSignal.m_signal(tab);
 }
 
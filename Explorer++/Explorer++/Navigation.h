@@ -35,6 +35,7 @@ public:
 private:
 
 	void OnTabCreated(int tabId, BOOL switchToNewTab);
+	void OnTabLoaded(const Tab &tab);
 
 	std::shared_ptr<Config> m_config;
 	IExplorerplusplus *m_expp;
@@ -670,6 +670,11 @@ INT_PTR CALLBACK Explorerplusplus::FilesFoldersProc(HWND hDlg,UINT uMsg,WPARAM w
 
 						for (auto &tab : m_tabContainer->GetAllTabs() | boost::adaptors::map_values)
 						{
+							if (!tab.IsLoaded())
+							{
+								continue;
+							}
+
 							RefreshTab(tab);
 
 							NListView::ListView_ActivateOneClickSelect(tab.listView, m_config->globalFolderSettings.oneClickActivate,
@@ -826,6 +831,11 @@ INT_PTR CALLBACK Explorerplusplus::WindowProc(HWND hDlg,UINT uMsg,WPARAM wParam,
 					{
 						for (auto &tab : m_tabContainer->GetAllTabs() | boost::adaptors::map_values)
 						{
+							if (!tab.IsLoaded())
+							{
+								continue;
+							}
+
 							DWORD dwExtendedStyle = ListView_GetExtendedListViewStyle(tab.listView);
 
 							if(bCheckBoxSelection)
@@ -860,6 +870,13 @@ INT_PTR CALLBACK Explorerplusplus::WindowProc(HWND hDlg,UINT uMsg,WPARAM wParam,
 
 					for (auto &tab : m_tabContainer->GetAllTabs() | boost::adaptors::map_values)
 					{
+						/* Tabs that haven't been loaded will pick up
+						the new settings when they're created. */
+						if (!tab.IsLoaded())
+						{
+							continue;
+						}
+
 						/* TODO: The tab should monitor for settings
 						changes itself. */
 						tab.GetShellBrowser()->OnGridlinesSettingChanged();
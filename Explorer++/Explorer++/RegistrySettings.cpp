@@ -130,6 +130,10 @@ LONG Explorerplusplus::SaveSettings(void)
 		NRegistrySettings::SaveDwordToRegistry(hSettingsKey,_T("DoubleClickTabClose"),m_config->doubleClickTabClose);
 		NRegistrySettings::SaveDwordToRegistry(hSettingsKey,_T("HandleZipFiles"),m_config->handleZipFiles);
 		NRegistrySettings::SaveDwordToRegistry(hSettingsKey,_T("InsertSorted"),m_config->globalFolderSettings.insertSorted);
+		NRegistrySettings::SaveDwordToRegistry(hSettingsKey,_T("ParallelSortThreshold"),m_config->globalFolderSettings.parallelSortThreshold);
+		NRegistrySettings::SaveDwordToRegistry(hSettingsKey,_T("VirtualListView"),m_config->globalFolderSettings.virtualListView);
+		NRegistrySettings::SaveDwordToRegistry(hSettingsKey,_T("LoadTabsOnDemand"),m_config->loadTabsOnDemand);
+		NRegistrySettings::SaveDwordToRegistry(hSettingsKey,_T("ThumbnailCacheSize"),m_config->thumbnailCacheSize);
 		NRegistrySettings::SaveDwordToRegistry(hSettingsKey,_T("ShowPrivilegeLevelInTitleBar"),m_config->showPrivilegeLevelInTitleBar.get());
 		NRegistrySettings::SaveDwordToRegistry(hSettingsKey,_T("AlwaysShowTabBar"),m_config->alwaysShowTabBar.get());
 		NRegistrySettings::SaveDwordToRegistry(hSettingsKey,_T("CheckBoxSelection"),m_config->checkBoxSelection);
@@ -266,6 +270,10 @@ LONG Explorerplusplus::LoadSettings()
 		NRegistrySettings::ReadDwordFromRegistry(hSettingsKey,_T("DoubleClickTabClose"),(LPDWORD)&m_config->doubleClickTabClose);
 		NRegistrySettings::ReadDwordFromRegistry(hSettingsKey,_T("HandleZipFiles"),(LPDWORD)&m_config->handleZipFiles);
 		NRegistrySettings::ReadDwordFromRegistry(hSettingsKey,_T("InsertSorted"),(LPDWORD)&m_config->globalFolderSettings.insertSorted);
+		NRegistrySettings::ReadDwordFromRegistry(hSettingsKey,_T("ParallelSortThreshold"),(LPDWORD)&m_config->globalFolderSettings.parallelSortThreshold);
+		NRegistrySettings::ReadDwordFromRegistry(hSettingsKey,_T("VirtualListView"),(LPDWORD)&m_config->globalFolderSettings.virtualListView);
+		NRegistrySettings::ReadDwordFromRegistry(hSettingsKey,_T("LoadTabsOnDemand"),(LPDWORD)&m_config->loadTabsOnDemand);
+		NRegistrySettings::ReadDwordFromRegistry(hSettingsKey,_T("ThumbnailCacheSize"),(LPDWORD)&m_config->thumbnailCacheSize);
 		NRegistrySettings::ReadDwordFromRegistry(hSettingsKey,_T("CheckBoxSelection"),(LPDWORD)&m_config->checkBoxSelection);
 		NRegistrySettings::ReadDwordFromRegistry(hSettingsKey,_T("ForceSize"),(LPDWORD)&m_config->globalFolderSettings.forceSize);
 		NRegistrySettings::ReadDwordFromRegistry(hSettingsKey,_T("SizeDisplayFormat"),(LPDWORD)&m_config->globalFolderSettings.sizeDisplayFormat);
@@ -439,7 +447,6 @@ void Explorerplusplus::SaveTabSettingsToRegistry(void)
 	HKEY	hTabKey;
 	HKEY	hColumnsKey;
 	TCHAR	szItemKey[128];
-	LPITEMIDLIST	pidlDirectory = NULL;
 	UINT	ViewMode;
 	UINT	SortMode;
 	DWORD	Disposition;
@@ -472,29 +479,29 @@ void Explorerplusplus::SaveTabSettingsToRegistry(void)
 
 			if(ReturnValue == ERROR_SUCCESS)
 			{
-				pidlDirectory = tab.GetShellBrowser()->QueryCurrentDirectoryIdl();
+				/* Tabs that haven't been loaded yet don't have a shell
+				browser, so everything here is retrieved through the tab. */
+				PIDLPointer pidlDirectory = tab.GetDirectory();
 				RegSetValueEx(hTabKey,_T("Directory"),0,REG_BINARY,
-					(LPBYTE)pidlDirectory,ILGetSize(pidlDirectory));
-				CoTaskMemFree((LPVOID)pidlDirectory);
+					(LPBYTE)pidlDirectory.get(),ILGetSize(pidlDirectory.get()));
 
-				ViewMode = tab.GetShellBrowser()->GetViewMode();
+				FolderSettings folderSettings = tab.GetFolderSettings();
+
+				ViewMode = folderSettings.viewMode;
 
 				NRegistrySettings::SaveDwordToRegistry(hTabKey,_T("ViewMode"),ViewMode);
 
-				SortMode = tab.GetShellBrowser()->GetSortMode();
+				SortMode = folderSettings.sortMode;
 				NRegistrySettings::SaveDwordToRegistry(hTabKey,_T("SortMode"),SortMode);
 
-				NRegistrySettings::SaveDwordToRegistry(hTabKey,_T("SortAscending"), tab.GetShellBrowser()->GetSortAscending());
-				NRegistrySettings::SaveDwordToRegistry(hTabKey,_T("ShowInGroups"), tab.GetShellBrowser()->GetShowInGroups());
-				NRegistrySettings::SaveDwordToRegistry(hTabKey,_T("ApplyFilter"), tab.GetShellBrowser()->GetFilterStatus());
-				NRegistrySettings::SaveDwordToRegistry(hTabKey,_T("FilterCaseSensitive"), tab.GetShellBrowser()->GetFilterCaseSensitive());
-				NRegistrySettings::SaveDwordToRegistry(hTabKey,_T("ShowHidden"), tab.GetShellBrowser()->GetShowHidden());
-				NRegistrySettings::SaveDwordToRegistry(hTabKey,_T("AutoArrange"), tab.GetShellBrowser()->GetAutoArrange());
-
-				TCHAR szFilter[512];
+				NRegistrySettings::SaveDwordToRegistry(hTabKey,_T("SortAscending"), folderSettings.sortAscending);
+				NRegistrySettings::SaveDwordToRegistry(hTabKey,_T("ShowInGroups"), folderSettings.showInGroups);
+				NRegistrySettings::SaveDwordToRegistry(hTabKey,_T("ApplyFilter"), folderSettings.applyFilter);
+				NRegistrySettings::SaveDwordToRegistry(hTabKey,_T("FilterCaseSensitive"), folderSettings.filterCaseSensitive);
+				NRegistrySettings::SaveDwordToRegistry(hTabKey,_T("ShowHidden"), folderSettings.showHidden);
+				NRegistrySettings::SaveDwordToRegistry(hTabKey,_T("AutoArrange"), folderSettings.autoArrange);
 
-				tab.GetShellBrowser()->GetFilter(szFilter,SIZEOF_ARRAY(szFilter));
-				NRegistrySettings::SaveStringToRegistry(hTabKey,_T("Filter"),szFilter);
+				NRegistrySettings::SaveStringToRegistry(hTabKey,_T("Filter"),folderSettings.filter.c_str());
 
 				/* Now save the tabs columns. */
 				ReturnValue = RegCreateKeyEx(hTabKey,_T("Columns"),
@@ -503,7 +510,7 @@ void Explorerplusplus::SaveTabSettingsToRegistry(void)
 
 				if(ReturnValue == ERROR_SUCCESS)
 				{
-					FolderColumns folderColumns = tab.GetShellBrowser()->ExportAllColumns();
+					FolderColumns folderColumns = tab.GetFolderColumns();
 
 					SaveColumnToRegistry(hColumnsKey,_T("ControlPanelColumns"),&folderColumns.controlPanelColumns);
 					SaveColumnToRegistry(hColumnsKey,_T("MyComputerColumns"),&folderColumns.myComputerColumns);
@@ -652,7 +659,9 @@ int Explorerplusplus::LoadTabSettingsFromRegistry()
 
 			TabSettings tabSettings;
 
-			tabSettings.selected = true;
+			/* When tabs are loaded on demand, only the tab that's
+			eventually selected will be loaded. */
+			tabSettings.selected = !m_config->loadTabsOnDemand;
 
 			NRegistrySettings::ReadDwordFromRegistry(hTabKey,_T("Locked"),&value);
 			tabSettings.locked = value;
@@ -1030,6 +1030,8 @@ CSearch::CSearch(HWND hDlg,TCHAR *szBaseDirectory,
 	StringCchCopy(m_szSearchPattern,SIZEOF_ARRAY(m_szSearchPattern),
 		szPattern);
 
+	m_wildcardMatcher = WildcardMatcher(m_szSearchPattern, !m_bCaseInsensitive);
+
 	InitializeCriticalSection(&m_csStop);
 	m_bStopSearching = FALSE;
 }
@@ -1145,7 +1147,7 @@ void CSearch::SearchDirectoryInternal(const TCHAR *szSearchDirectory,
 					}
 					else
 					{
-						if(CheckWildcardMatch(m_szSearchPattern,wfd.cFileName,!m_bCaseInsensitive))
+						if(m_wildcardMatcher.Matches(wfd.cFileName))
 						{
 							bMatchFileName = TRUE;
 						}
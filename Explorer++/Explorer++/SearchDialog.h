@@ -10,6 +10,7 @@
 #include "../Helper/DialogSettings.h"
 #include "../Helper/FileContextMenuManager.h"
 #include "../Helper/ReferenceCount.h"
+#include "../Helper/WildcardMatcher.h"
 #include <boost/circular_buffer.hpp>
 #include <MsXml2.h>
 #include <objbase.h>
@@ -126,6 +127,7 @@ private:
 	BOOL				m_bSearchSubFolders;
 
 	std::wregex			m_rxPattern;
+	WildcardMatcher		m_wildcardMatcher;
 
 	CRITICAL_SECTION	m_csStop;
 	BOOL				m_bStopSearching;
@@ -55,17 +55,24 @@ HRESULT CShellBrowser::BrowseFolder(LPCITEMIDLIST pidlDirectory,UINT wFlags)
 		return E_FAIL;
 	}
 
+	/* The current folder can only be kept for later if all of its
+	items have been read. The find data read for a folder that's
+	being reconciled isn't needed, however, since the snapshot will
+	be reconciled again if it's restored. There's no point keeping
+	the folder if it's simply being refreshed. */
+	bool snapshotCurrentFolder = m_bFolderVisited && !m_bVirtualFolder
+		&& (!m_directoryEnumeration || m_directoryEnumeration->reconcile)
+		&& !CompareIdls(pidl,m_pidlDirectory);
+
 	/* TODO: Wait for any background threads to finish processing. */
 
-	m_columnThreadPool.clear_queue();
-	m_columnResults.clear();
+	m_itemTaskScheduler->CancelAllTasks(m_ID);
 
-	m_itemImageThreadPool.clear_queue();
-	m_iconResults.clear();
-	m_thumbnailResults.clear();
+	/* Any results that are still to arrive are for the
+	previous folder. */
+	m_itemResultGeneration++;
 
-	m_infoTipsThreadPool.clear_queue();
-	m_infoTipResults.clear();
+	CancelDirectoryEnumeration();
 
 	EnterCriticalSection(&m_csDirectoryAltered);
 	m_FilesAdded.clear();
@@ -85,12 +92,18 @@ HRESULT CShellBrowser::BrowseFolder(LPCITEMIDLIST pidlDirectory,UINT wFlags)
 		m_pathManager.StoreIdl(pidl);
 	}
 
+	if(snapshotCurrentFolder)
+	{
+		SaveFolderSnapshot();
+	}
+
 	/* Stop the list view from redrawing itself each time is inserted.
 	Redrawing will be allowed once all items have being inserted.
 	(reduces lag when a large number of items are going to be inserted). */
 	SendMessage(m_hListView, WM_SETREDRAW, FALSE, NULL);
 
 	ListView_DeleteAllItems(m_hListView);
+	m_itemRows.clear();
 
 	if(m_bFolderVisited)
 	{
@@ -101,10 +114,24 @@ HRESULT CShellBrowser::BrowseFolder(LPCITEMIDLIST pidlDirectory,UINT wFlags)
 	m_iFileIcon = GetDefaultFileIconIndex();
 
 	m_nTotalItems = 0;
+	m_nAwaitingAdd = 0;
 
-	BrowseVirtualFolder(pidl);
+	DetermineFolderVirtual(pidl);
+	m_pidlDirectory = ILClone(pidl);
 
-	CoTaskMemFree(pidl);
+	/* Any snapshot of the folder is out of date once the folder
+	is shown, so it's always removed. It's only restored when moving
+	through the history (either one step at a time, or by picking an
+	entry from the history menu). Only filesystem folders are
+	restored, since they're the only folders that can be reconciled
+	cheaply afterwards. */
+	std::unique_ptr<FolderSnapshot_t> snapshot = TakeFolderSnapshot(pidl);
+
+	if(m_bVirtualFolder ||
+		(wFlags & (SBSP_NAVIGATEBACK|SBSP_NAVIGATEFORWARD|SBSP_WRITENOHISTORY)) == 0)
+	{
+		snapshot.reset();
+	}
 
 	/* Window updates needs these to be set. */
 	m_NumFilesSelected		= 0;
@@ -116,19 +143,38 @@ HRESULT CShellBrowser::BrowseFolder(LPCITEMIDLIST pidlDirectory,UINT wFlags)
 	SetActiveColumnSet();
 	SetViewModeInternal(m_folderSettings.viewMode);
 
-	InsertAwaitingItems(FALSE);
-
 	VerifySortMode();
 	SortFolder(m_folderSettings.sortMode);
 
-	ListView_EnsureVisible(m_hListView,0,FALSE);
+	/* The folder empty image (if any) belongs to the previous
+	folder. Whether or not it's needed for this folder will only
+	be known once enumeration has finished. */
+	if(!m_folderSettings.applyFilter)
+	{
+		ApplyFolderEmptyBackgroundImage(false);
+	}
+
+	if(snapshot)
+	{
+		/* The folder is shown as it was, then checked for any
+		changes made since it was last visited. */
+		RestoreFolderSnapshot(std::move(snapshot));
+		StartDirectoryEnumeration(pidl,true);
+		m_directoryEnumeration->snapshotRestored = true;
+	}
+	else
+	{
+		/* Items are read on a background thread and inserted as they
+		arrive (see ProcessEnumerationResults()), so that large or slow
+		folders don't block the UI. */
+		StartDirectoryEnumeration(pidl,false);
+	}
+
+	CoTaskMemFree(pidl);
 
 	/* Allow the listview to redraw itself once again. */
 	SendMessage(m_hListView,WM_SETREDRAW,TRUE,NULL);
 
-	/* Set the focus back to the first item. */
-	ListView_SetItemState(m_hListView, 0, LVIS_FOCUSED, LVIS_FOCUSED);
-
 	m_bFolderVisited = TRUE;
 
 	SetCursor(LoadCursor(NULL,IDC_ARROW));
@@ -166,6 +212,12 @@ void CShellBrowser::InsertAwaitingItems(BOOL bInsertIntoGroup)
 		ApplyFolderEmptyBackgroundImage(false);
 	}
 
+	if(m_ownerDataListView)
+	{
+		InsertAwaitingItemsOwnerData();
+		return;
+	}
+
 	/* Make the listview allocate space (for internal data structures)
 	for all the items at once, rather than individually.
 	Acts as a speed optimization. */
@@ -204,6 +256,8 @@ void CShellBrowser::InsertAwaitingItems(BOOL bInsertIntoGroup)
 
 			/* Insert the item into the list view control. */
 			iItemIndex = ListView_InsertItem(m_hListView,&lv);
+			m_itemRows.insertItem(iItemIndex,itr->iItemInternal);
+			m_itemFilter.setItemVisible(itr->iItemInternal,true);
 
 			if(itr->bPosition && m_folderSettings.viewMode != +ViewMode::Details)
 			{
@@ -230,14 +284,14 @@ void CShellBrowser::InsertAwaitingItems(BOOL bInsertIntoGroup)
 
 			if(m_bNewItemCreated)
 			{
-				if(CompareIdls(m_itemInfoMap.at((int)itr->iItemInternal).pidlComplete.get(),m_pidlNewItem))
+				if(CompareIdls(m_itemStore.getPidlComplete((int)itr->iItemInternal),m_pidlNewItem))
 					m_bNewItemCreated = FALSE;
 
 				m_iIndexNewItem = iItemIndex;
 			}
 
 			/* If the file is marked as hidden, ghost it out. */
-			if(m_itemInfoMap.at(itr->iItemInternal).wfd.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN)
+			if(m_itemStore.getAttributes(itr->iItemInternal) & FILE_ATTRIBUTE_HIDDEN)
 			{
 				ListView_SetItemState(m_hListView,iItemIndex,LVIS_CUT,LVIS_CUT);
 			}
@@ -245,8 +299,7 @@ void CShellBrowser::InsertAwaitingItems(BOOL bInsertIntoGroup)
 			/* Add the current file's size to the running size of the current directory. */
 			/* A folder may or may not have 0 in its high file size member.
 			It should either be zeroed, or never counted. */
-			ulFileSize.LowPart = m_itemInfoMap.at(itr->iItemInternal).wfd.nFileSizeLow;
-			ulFileSize.HighPart = m_itemInfoMap.at(itr->iItemInternal).wfd.nFileSizeHigh;
+			ulFileSize.QuadPart = m_itemStore.getSize(itr->iItemInternal);
 
 			m_ulTotalDirSize.QuadPart += ulFileSize.QuadPart;
 
@@ -254,13 +307,16 @@ void CShellBrowser::InsertAwaitingItems(BOOL bInsertIntoGroup)
 		}
 		else
 		{
-			m_FilteredItemsList.push_back(itr->iItemInternal);
+			m_itemFilter.setItemVisible(itr->iItemInternal,false);
 		}
 	}
 
 	if(m_folderSettings.autoArrange)
 		NListView::ListView_SetAutoArrange(m_hListView,TRUE);
 
+	if(bInsertIntoGroup)
+		UpdateGroupHeaders();
+
 	m_nTotalItems = nPrevItems + nAdded;
 
 	PositionDroppedItems();
@@ -299,14 +355,14 @@ BOOL CShellBrowser::IsFileFiltered(int iItemInternal) const
 	BOOL bFilenameFiltered	= FALSE;
 
 	if(m_folderSettings.applyFilter &&
-		((m_itemInfoMap.at(iItemInternal).wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != FILE_ATTRIBUTE_DIRECTORY))
+		((m_itemStore.getAttributes(iItemInternal) & FILE_ATTRIBUTE_DIRECTORY) != FILE_ATTRIBUTE_DIRECTORY))
 	{
-		bFilenameFiltered = IsFilenameFiltered(m_itemInfoMap.at(iItemInternal).szDisplayName);
+		bFilenameFiltered = IsFilenameFiltered(m_itemStore.getDisplayName(iItemInternal));
 	}
 
 	if(m_config->globalFolderSettings.hideSystemFiles)
 	{
-		bHideSystemFile = (m_itemInfoMap.at(iItemInternal).wfd.dwFileAttributes & FILE_ATTRIBUTE_SYSTEM)
+		bHideSystemFile = (m_itemStore.getAttributes(iItemInternal) & FILE_ATTRIBUTE_SYSTEM)
 			== FILE_ATTRIBUTE_SYSTEM;
 	}
 
@@ -316,40 +372,38 @@ BOOL CShellBrowser::IsFileFiltered(int iItemInternal) const
 void CShellBrowser::RemoveItem(int iItemInternal)
 {
 	ULARGE_INTEGER	ulFileSize;
-	LVFINDINFO		lvfi;
 	BOOL			bFolder;
-	int				iItem;
 	int				nItems;
 
 	if(iItemInternal == -1)
 		return;
 
 	/* Is this item a folder? */
-	bFolder = (m_itemInfoMap.at(iItemInternal).wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ==
+	bFolder = (m_itemStore.getAttributes(iItemInternal) & FILE_ATTRIBUTE_DIRECTORY) ==
 	FILE_ATTRIBUTE_DIRECTORY;
 
 	/* Take the file size of the removed file away from the total
 	directory size. */
-	ulFileSize.LowPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeLow;
-	ulFileSize.HighPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeHigh;
+	ulFileSize.QuadPart = m_itemStore.getSize(iItemInternal);
 
 	m_ulTotalDirSize.QuadPart -= ulFileSize.QuadPart;
 
-	/* Locate the item within the listview.
-	Could use filename, providing removed
-	items are always deleted before new
-	items are inserted. */
-	lvfi.flags	= LVFI_PARAM;
-	lvfi.lParam	= iItemInternal;
-	iItem = ListView_FindItem(m_hListView,-1,&lvfi);
+	/* Locate the item within the listview. */
+	auto iItem = LocateItemByInternalIndex(iItemInternal);
 	
-	if(iItem != -1)
+	if(iItem)
 	{
 		/* Remove the item from the listview. */
-		ListView_DeleteItem(m_hListView,iItem);
+		ListView_DeleteItem(m_hListView,*iItem);
+		m_itemRows.removeRow(*iItem);
 	}
 
-	m_itemInfoMap.erase(iItemInternal);
+	CancelItemTasks(iItemInternal);
+	RemoveItemFromNameIndex(iItemInternal);
+	m_ownerDataItems.erase(iItemInternal);
+	m_itemFilter.removeItem(iItemInternal);
+	InvalidateItemGroup(iItemInternal);
+	m_itemStore.removeItem(iItemInternal);
 
 	nItems = ListView_GetItemCount(m_hListView);
 
@@ -433,61 +487,165 @@ BOOL *bStoreHistory)
 	return S_OK;
 }
 
-void CShellBrowser::BrowseVirtualFolder(LPITEMIDLIST pidlDirectory)
+void CShellBrowser::StartDirectoryEnumeration(LPCITEMIDLIST pidlDirectory, bool reconcile)
 {
-	IShellFolder	*pShellFolder = NULL;
-	IEnumIDList		*pEnumIDList = NULL;
-	LPITEMIDLIST	rgelt = NULL;
-	STRRET			str;
-	SHCONTF			EnumFlags;
-	TCHAR			szFileName[MAX_PATH];
-	ULONG			uFetched;
-	HRESULT			hr;
+	auto enumeration = std::make_shared<DirectoryEnumeration_t>();
+	enumeration->id = m_enumerationIDCounter++;
+	enumeration->pidlDirectory.reset(ILClone(pidlDirectory));
+	enumeration->enumFlags = SHCONTF_FOLDERS|SHCONTF_NONFOLDERS;
+	enumeration->virtualFolder = m_bVirtualFolder;
+	enumeration->reconcile = reconcile;
 
-	DetermineFolderVirtual(pidlDirectory);
+	if(m_folderSettings.showHidden)
+		enumeration->enumFlags |= SHCONTF_INCLUDEHIDDEN;
 
-	hr = BindToIdl(pidlDirectory, IID_PPV_ARGS(&pShellFolder));
+	m_directoryEnumeration = enumeration;
 
-	if(SUCCEEDED(hr))
+	// Only the window handles and the shared enumeration state are passed
+	// to the worker, so that it never has to touch this object.
+	m_enumerationThreadPool.push([listView = m_hListView, owner = m_hOwner, enumeration](int id) {
+		UNREFERENCED_PARAMETER(id);
+
+		EnumerateDirectoryAsync(listView, owner, enumeration);
+	});
+}
+
+void CShellBrowser::CancelDirectoryEnumeration()
+{
+	if(!m_directoryEnumeration)
 	{
-		m_pidlDirectory = ILClone(pidlDirectory);
+		return;
+	}
+
+	// The worker checks this flag between calls to IEnumIDList::Next(),
+	// and any results that have already been posted will be ignored,
+	// since their ID will no longer match.
+	m_directoryEnumeration->cancelled = true;
+	m_directoryEnumeration.reset();
+}
+
+void CShellBrowser::EnumerateDirectoryAsync(HWND listView, HWND owner, std::shared_ptr<DirectoryEnumeration_t> enumeration)
+{
+	if(enumeration->cancelled)
+	{
+		return;
+	}
+
+	if(enumeration->reconcile)
+	{
+		boost::optional<FindDataMap_t> findData = ReadDirectoryFindData(enumeration->pidlDirectory.get(), enumeration->cancelled);
+
+		{
+			std::lock_guard<std::mutex> lock(enumeration->mutex);
+			enumeration->findData = std::move(findData);
+			enumeration->finished = true;
+		}
 
-		EnumFlags = SHCONTF_FOLDERS|SHCONTF_NONFOLDERS;
+		PostMessage(listView, WM_APP_ENUMERATION_RESULTS_READY, enumeration->id, 0);
 
-		if(m_folderSettings.showHidden)
-			EnumFlags |= SHCONTF_INCLUDEHIDDEN;
+		return;
+	}
+
+	std::vector<ItemInfo_t> batch;
+
+	auto handOverItems = [listView, &enumeration, &batch](bool finished) {
+		{
+			std::lock_guard<std::mutex> lock(enumeration->mutex);
+
+			if(!batch.empty())
+			{
+				enumeration->pendingBatches.push_back(std::move(batch));
+				batch.clear();
+			}
+
+			enumeration->finished = finished;
+		}
+
+		PostMessage(listView, WM_APP_ENUMERATION_RESULTS_READY, enumeration->id, 0);
+	};
+
+	// For filesystem folders, the find data for each item is read
+	// through a single search handle as the items are enumerated,
+	// rather than up-front, so that the first items can be handed
+	// over straight away. Virtual folders (and any items the reader
+	// doesn't return) fall back to looking up each item individually.
+	std::unique_ptr<DirectoryFindDataReader> findDataReader;
+	TCHAR szDirectory[MAX_PATH];
 
-		hr = pShellFolder->EnumObjects(m_hOwner,EnumFlags,&pEnumIDList);
+	if(!enumeration->virtualFolder && SHGetPathFromIDList(enumeration->pidlDirectory.get(), szDirectory))
+	{
+		findDataReader = std::make_unique<DirectoryFindDataReader>(szDirectory);
+	}
+
+	IShellFolder *pShellFolder = NULL;
+	HRESULT hr = BindToIdl(enumeration->pidlDirectory.get(), IID_PPV_ARGS(&pShellFolder));
+
+	if(SUCCEEDED(hr))
+	{
+		IEnumIDList *pEnumIDList = NULL;
+		hr = pShellFolder->EnumObjects(owner, enumeration->enumFlags, &pEnumIDList);
 
 		if(SUCCEEDED(hr) && pEnumIDList != NULL)
 		{
-			uFetched = 1;
-			while(pEnumIDList->Next(1,&rgelt,&uFetched) == S_OK && (uFetched == 1))
+			LPITEMIDLIST rgelt[ENUMERATION_FETCH_COUNT];
+			ULONG fetchCount = ENUMERATION_FETCH_COUNT;
+			DWORD lastHandOverTime = GetTickCount();
+
+			while(!enumeration->cancelled)
 			{
-				ULONG uAttributes = SFGAO_FOLDER;
-
-				pShellFolder->GetAttributesOf(1,(LPCITEMIDLIST *)&rgelt,&uAttributes);
-
-				/* If this is a virtual folder, only use SHGDN_INFOLDER. If this is
-				a real folder, combine SHGDN_INFOLDER with SHGDN_FORPARSING. This is
-				so that items in real folders can still be shown with extensions, even
-				if the global, Explorer option is disabled.
-				Also use only SHGDN_INFOLDER if this item is a folder. This is to ensure
-				that specific folders in Windows 7 (those under C:\Users\Username) appear
-				correctly. */
-				if(m_bVirtualFolder || (uAttributes & SFGAO_FOLDER))
-					hr = pShellFolder->GetDisplayNameOf(rgelt,SHGDN_INFOLDER,&str);
-				else
-					hr = pShellFolder->GetDisplayNameOf(rgelt,SHGDN_INFOLDER|SHGDN_FORPARSING,&str);
+				ULONG uFetched = 0;
+				HRESULT hrNext = pEnumIDList->Next(fetchCount, rgelt, &uFetched);
 
-				if(SUCCEEDED(hr))
+				// Not every enumerator supports returning more than one
+				// item per call.
+				if(FAILED(hrNext) && fetchCount > 1)
 				{
-					StrRetToBuf(&str, rgelt, szFileName, SIZEOF_ARRAY(szFileName));
+					fetchCount = 1;
+					continue;
+				}
 
-					AddItemInternal(pidlDirectory,rgelt,szFileName,-1,FALSE);
+				for(ULONG i = 0;i < uFetched;i++)
+				{
+					ULONG uAttributes = SFGAO_FOLDER;
+					pShellFolder->GetAttributesOf(1, (LPCITEMIDLIST *)&rgelt[i], &uAttributes);
+
+					/* If this is a virtual folder, only use SHGDN_INFOLDER. If this is
+					a real folder, combine SHGDN_INFOLDER with SHGDN_FORPARSING. This is
+					so that items in real folders can still be shown with extensions, even
+					if the global, Explorer option is disabled.
+					Also use only SHGDN_INFOLDER if this item is a folder. This is to ensure
+					that specific folders in Windows 7 (those under C:\Users\Username) appear
+					correctly. */
+					STRRET str;
+
+					if(enumeration->virtualFolder || (uAttributes & SFGAO_FOLDER))
+						hr = pShellFolder->GetDisplayNameOf(rgelt[i], SHGDN_INFOLDER, &str);
+					else
+						hr = pShellFolder->GetDisplayNameOf(rgelt[i], SHGDN_INFOLDER|SHGDN_FORPARSING, &str);
+
+					if(SUCCEEDED(hr))
+					{
+						TCHAR szFileName[MAX_PATH];
+						StrRetToBuf(&str, rgelt[i], szFileName, SIZEOF_ARRAY(szFileName));
+
+						batch.push_back(GetItemInformation(enumeration->pidlDirectory.get(), rgelt[i], szFileName,
+							findDataReader.get()));
+					}
+
+					CoTaskMemFree(rgelt[i]);
 				}
 
-				CoTaskMemFree((LPVOID)rgelt);
+				if(hrNext != S_OK || uFetched == 0)
+				{
+					break;
+				}
+
+				if(batch.size() >= ENUMERATION_BATCH_SIZE
+					|| (!batch.empty() && (GetTickCount() - lastHandOverTime) >= ENUMERATION_BATCH_INTERVAL))
+				{
+					handOverItems(false);
+					lastHandOverTime = GetTickCount();
+				}
 			}
 
 			pEnumIDList->Release();
@@ -495,6 +653,131 @@ void CShellBrowser::BrowseVirtualFolder(LPITEMIDLIST pidlDirectory)
 
 		pShellFolder->Release();
 	}
+
+	handOverItems(true);
+}
+
+void CShellBrowser::ProcessEnumerationResults(int enumerationId)
+{
+	if(!m_directoryEnumeration || m_directoryEnumeration->id != enumerationId)
+	{
+		return;
+	}
+
+	std::list<std::vector<ItemInfo_t>> batches;
+	boost::optional<FindDataMap_t> findData;
+	bool finished;
+
+	{
+		std::lock_guard<std::mutex> lock(m_directoryEnumeration->mutex);
+		batches.swap(m_directoryEnumeration->pendingBatches);
+		findData.swap(m_directoryEnumeration->findData);
+		finished = m_directoryEnumeration->finished;
+	}
+
+	if(m_directoryEnumeration->reconcile)
+	{
+		if(!finished)
+		{
+			return;
+		}
+
+		bool snapshotRestored = m_directoryEnumeration->snapshotRestored;
+		m_directoryEnumeration.reset();
+
+		if(findData)
+		{
+			SendMessage(m_hListView,WM_SETREDRAW,FALSE,NULL);
+			ReconcileItems(std::move(*findData));
+			SendMessage(m_hListView,WM_SETREDRAW,TRUE,NULL);
+		}
+		else if(snapshotRestored)
+		{
+			/* The snapshot may be arbitrarily out of date, so it
+			isn't left in place. The folder is enumerated in full
+			instead (which doesn't rely on reading the find data
+			for the directory). */
+			LOG(info) << _T("ShellBrowser - Unable to read \"") << m_CurDir << _T("\", discarding restored snapshot");
+			Refresh();
+			return;
+		}
+		else
+		{
+			/* Nothing is known about the contents of the directory,
+			so the items are left as they are. */
+			LOG(info) << _T("ShellBrowser - Unable to read \"") << m_CurDir << _T("\", items not reconciled");
+		}
+
+		/* As below, any changes that arrived in the meantime are
+		applied now. */
+		DirectoryAltered();
+
+		return;
+	}
+
+	if(batches.empty() && !finished)
+	{
+		return;
+	}
+
+	if(finished)
+	{
+		m_directoryEnumeration.reset();
+	}
+
+	bool firstItems = m_itemStore.empty();
+
+	SendMessage(m_hListView,WM_SETREDRAW,FALSE,NULL);
+
+	for(auto &batch : batches)
+	{
+		for(auto &itemInfo : batch)
+		{
+			int itemId = GenerateUniqueItemId();
+			StoreItem(itemId, itemInfo);
+			AddItemToNameIndex(itemId);
+
+			m_nAwaitingAdd++;
+			AddItemInternal(-1,itemId,FALSE);
+		}
+	}
+
+	InsertAwaitingItems(m_folderSettings.showInGroups);
+
+	// The listview is only sorted when the first items arrive and once
+	// enumeration has finished. Items that arrive in between are simply
+	// appended, as re-sorting the whole folder for every batch would be
+	// expensive in large folders.
+	if((firstItems && !m_itemStore.empty()) || finished)
+	{
+		SortFolder(m_folderSettings.sortMode);
+	}
+
+	if(firstItems && !m_itemStore.empty())
+	{
+		ListView_EnsureVisible(m_hListView,0,FALSE);
+	}
+
+	/* Set the focus back to the first item (unless the
+	user has already selected something). */
+	if((firstItems || finished) && ListView_GetSelectedCount(m_hListView) == 0)
+	{
+		ListView_SetItemState(m_hListView,0,LVIS_FOCUSED,LVIS_FOCUSED);
+	}
+
+	SendMessage(m_hListView,WM_SETREDRAW,TRUE,NULL);
+
+	if(finished)
+	{
+		/* Changes to the directory that were made during enumeration
+		have been held back until now. This will also select any items
+		queued for selection and update the owner. */
+		DirectoryAltered();
+	}
+	else
+	{
+		SendMessage(m_hOwner,WM_USER_DIRECTORYMODIFIED,m_ID,0);
+	}
 }
 
 HRESULT CShellBrowser::AddItemInternal(LPITEMIDLIST pidlDirectory,
@@ -528,22 +811,50 @@ HRESULT CShellBrowser::AddItemInternal(int iItemIndex,int iItemId,BOOL bPosition
 int CShellBrowser::SetItemInformation(LPITEMIDLIST pidlDirectory,
 LPITEMIDLIST pidlRelative,const TCHAR *szFileName)
 {
-	LPITEMIDLIST	pidlItem = NULL;
-	HANDLE			hFirstFile;
-	TCHAR			szPath[MAX_PATH];
-	int				uItemId;
+	int uItemId;
 
 	m_nAwaitingAdd++;
 
 	uItemId = GenerateUniqueItemId();
 
+	StoreItem(uItemId, GetItemInformation(pidlDirectory, pidlRelative, szFileName, NULL));
+	AddItemToNameIndex(uItemId);
+
+	return uItemId;
+}
+
+/* Copies the information gathered for an item
+into the item store. */
+void CShellBrowser::StoreItem(int itemId, const ItemInfo_t &itemInfo)
+{
+	m_itemStore.addItem(itemId, itemInfo.wfd, itemInfo.szDisplayName,
+		itemInfo.pidlComplete.get(), itemInfo.pridl.get());
+
+	if(itemInfo.bDrive)
+	{
+		m_itemStore.setDrive(itemId, itemInfo.szDrive);
+	}
+}
+
+/* Doesn't touch any member data, so is safe to
+call from the enumeration thread. If findDataReader
+is supplied, the item's find data will be taken from
+there when possible. */
+CShellBrowser::ItemInfo_t CShellBrowser::GetItemInformation(LPCITEMIDLIST pidlDirectory,
+	LPCITEMIDLIST pidlRelative, const TCHAR *szFileName, DirectoryFindDataReader *findDataReader)
+{
+	LPITEMIDLIST	pidlItem = NULL;
+	HANDLE			hFirstFile;
+	TCHAR			szPath[MAX_PATH];
+
+	ItemInfo_t itemInfo = ItemInfo_t();
+
 	pidlItem = ILCombine(pidlDirectory, pidlRelative);
 
-	m_itemInfoMap[uItemId].pidlComplete.reset(ILClone(pidlItem));
-	m_itemInfoMap[uItemId].pridl.reset(ILClone(pidlRelative));
-	m_itemInfoMap[uItemId].bIconRetrieved = FALSE;
-	StringCchCopy(m_itemInfoMap[uItemId].szDisplayName,
-		SIZEOF_ARRAY(m_itemInfoMap[uItemId].szDisplayName), szFileName);
+	itemInfo.pidlComplete.reset(ILClone(pidlItem));
+	itemInfo.pridl.reset(ILClone(pidlRelative));
+	StringCchCopy(itemInfo.szDisplayName,
+		SIZEOF_ARRAY(itemInfo.szDisplayName), szFileName);
 
 	SHGetPathFromIDList(pidlItem,szPath);
 
@@ -554,18 +865,29 @@ LPITEMIDLIST pidlRelative,const TCHAR *szFileName)
 	few seconds. */
 	if(!PathIsRoot(szPath))
 	{
-		m_itemInfoMap[uItemId].bDrive = FALSE;
+		itemInfo.bDrive = FALSE;
+
+		if(findDataReader != NULL)
+		{
+			auto findData = findDataReader->TakeFindData(PathFindFileName(szPath));
+
+			if(findData)
+			{
+				itemInfo.wfd = *findData;
+				return itemInfo;
+			}
+		}
 
 		WIN32_FIND_DATA wfd;
 		hFirstFile = FindFirstFile(szPath,&wfd);
 
-		m_itemInfoMap[uItemId].wfd = wfd;
+		itemInfo.wfd = wfd;
 	}
 	else
 	{
-		m_itemInfoMap[uItemId].bDrive = TRUE;
-		StringCchCopy(m_itemInfoMap[uItemId].szDrive,
-			SIZEOF_ARRAY(m_itemInfoMap[uItemId].szDrive),
+		itemInfo.bDrive = TRUE;
+		StringCchCopy(itemInfo.szDrive,
+			SIZEOF_ARRAY(itemInfo.szDrive),
 			szPath);
 
 		hFirstFile = INVALID_HANDLE_VALUE;
@@ -579,15 +901,73 @@ LPITEMIDLIST pidlRelative,const TCHAR *szFileName)
 	}
 	else
 	{
-		WIN32_FIND_DATA wfd;
+		WIN32_FIND_DATA wfd = {};
 
 		StringCchCopy(wfd.cFileName, SIZEOF_ARRAY(wfd.cFileName), szFileName);
 		wfd.nFileSizeLow			= 0;
 		wfd.nFileSizeHigh			= 0;
 		wfd.dwFileAttributes		= FILE_ATTRIBUTE_DIRECTORY;
 
-		m_itemInfoMap[uItemId].wfd = wfd;
+		itemInfo.wfd = wfd;
 	}
 
-	return uItemId;
-}
\ No newline at end of file
+	return itemInfo;
+}
+
+/* Reads the find data for every item in a filesystem
+directory using a single search handle (with large
+fetches). On network shares in particular, this is far
+cheaper than calling FindFirstFile() once per item.
+Returns nothing if the directory couldn't be read in
+full, so that callers can tell that apart from a directory
+that's empty. */
+boost::optional<CShellBrowser::FindDataMap_t> CShellBrowser::ReadDirectoryFindData(LPCITEMIDLIST pidlDirectory,
+	const std::atomic<bool> &cancelled)
+{
+	FindDataMap_t findData;
+	TCHAR szSearchPath[MAX_PATH];
+
+	if(!SHGetPathFromIDList(pidlDirectory,szSearchPath)
+		|| !PathAppend(szSearchPath,_T("*")))
+	{
+		return boost::none;
+	}
+
+	WIN32_FIND_DATA wfd;
+	HANDLE hFindFile = FindFirstFileEx(szSearchPath,FindExInfoStandard,&wfd,
+		FindExSearchNameMatch,NULL,FIND_FIRST_EX_LARGE_FETCH);
+
+	if(hFindFile == INVALID_HANDLE_VALUE)
+	{
+		/* The root of an empty drive has no entries at all
+		(not even "." and ".."). */
+		if(GetLastError() == ERROR_FILE_NOT_FOUND)
+		{
+			return findData;
+		}
+
+		return boost::none;
+	}
+
+	do
+	{
+		if(lstrcmp(wfd.cFileName,_T(".")) == 0 ||
+			lstrcmp(wfd.cFileName,_T("..")) == 0)
+		{
+			continue;
+		}
+
+		findData.emplace(wfd.cFileName,wfd);
+	} while(!cancelled && FindNextFile(hFindFile,&wfd));
+
+	DWORD lastError = GetLastError();
+
+	FindClose(hFindFile);
+
+	if(cancelled || lastError != ERROR_NO_MORE_FILES)
+	{
+		return boost::none;
+	}
+
+	return findData;
+}
@@ -7,15 +7,22 @@
 #include "Columns.h"
 #include "../Helper/DriveInfo.h"
 #include "../Helper/FileOperations.h"
-#include "../Helper/FolderSize.h"
 #include "../Helper/Helper.h"
 #include "../Helper/Macros.h"
+#include "../Helper/MetadataCache.h"
 #include "../Helper/StringHelper.h"
 #include <boost\date_time\posix_time\posix_time.hpp>
 #include <IPHlpApi.h>
 #include <propkey.h>
 
 BOOL GetPrinterStatusDescription(DWORD dwStatus, TCHAR *szStatus, size_t cchMax);
+boost::optional<VersionInfoType_t> GetVersionInfoTypeForColumn(UINT ColumnID);
+boost::optional<MediaMetadataType_t> GetMediaMetadataTypeForColumn(UINT ColumnID);
+std::wstring FormatMediaMetadata(MediaMetadataType_t MediaMetaDataType, const std::vector<BYTE> &Data);
+std::wstring FormatHardLinks(DWORD NumHardLinks);
+boost::optional<MetadataCache::FileKey> GetMetadataCacheKey(const BasicItemInfo_t &itemInfo);
+boost::optional<std::wstring> LookupCachedColumnText(MetadataCache *metadataCache, const MetadataCache::FileKey &cacheKey, UINT ColumnID);
+bool ShouldPersistColumn(UINT ColumnID);
 
 std::wstring GetColumnText(UINT ColumnID, const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings)
 {
@@ -239,6 +246,300 @@ std::wstring GetColumnText(UINT ColumnID, const BasicItemInfo_t &basicItemInfo,
 	return EMPTY_STRING;
 }
 
+/* Columns whose text is read from the same place (e.g. the version
+information block of a file) are grouped into bundles, so that the
+text for all of them can be retrieved at once. */
+ColumnBundle_t GetColumnBundle(UINT ColumnID)
+{
+	if (GetVersionInfoTypeForColumn(ColumnID))
+	{
+		return COLUMN_BUNDLE_VERSION_INFO;
+	}
+
+	if (GetMediaMetadataTypeForColumn(ColumnID))
+	{
+		return COLUMN_BUNDLE_MEDIA_METADATA;
+	}
+
+	return COLUMN_BUNDLE_NONE;
+}
+
+/* Each of the columns must be in the same bundle. The file is only
+opened once, regardless of the number of columns. */
+std::vector<std::wstring> GetColumnBundleText(const std::vector<UINT> &ColumnIDs, const BasicItemInfo_t &basicItemInfo)
+{
+	if (ColumnIDs.empty())
+	{
+		return {};
+	}
+
+	switch (GetColumnBundle(ColumnIDs[0]))
+	{
+	case COLUMN_BUNDLE_VERSION_INFO:
+	{
+		std::vector<VersionInfoType_t> VersionInfoTypes;
+
+		for (UINT ColumnID : ColumnIDs)
+		{
+			VersionInfoTypes.push_back(*GetVersionInfoTypeForColumn(ColumnID));
+		}
+
+		return GetVersionColumnTexts(basicItemInfo, VersionInfoTypes);
+	}
+	break;
+
+	case COLUMN_BUNDLE_MEDIA_METADATA:
+	{
+		std::vector<MediaMetadataType_t> MediaMetadataTypes;
+
+		for (UINT ColumnID : ColumnIDs)
+		{
+			MediaMetadataTypes.push_back(*GetMediaMetadataTypeForColumn(ColumnID));
+		}
+
+		return GetMediaMetadataColumnTexts(basicItemInfo, MediaMetadataTypes);
+	}
+	break;
+
+	default:
+		assert(false);
+		break;
+	}
+
+	return std::vector<std::wstring>(ColumnIDs.size());
+}
+
+/* Columns whose values have to be read from the file itself
+(rather than from the information retrieved when the folder
+was enumerated) are kept in the metadata cache. */
+bool IsColumnCacheable(UINT ColumnID)
+{
+	switch (ColumnID)
+	{
+	case CM_OWNER:
+	case CM_HARDLINKS:
+	case CM_CAMERAMODEL:
+	case CM_DATETAKEN:
+	case CM_WIDTH:
+	case CM_HEIGHT:
+		return true;
+	}
+
+	return GetColumnBundle(ColumnID) != COLUMN_BUNDLE_NONE;
+}
+
+/* Version information and media metadata are the slowest to
+retrieve (each requires the file to be opened and parsed), so
+they're the only values saved between sessions. */
+bool ShouldPersistColumn(UINT ColumnID)
+{
+	return GetColumnBundle(ColumnID) != COLUMN_BUNDLE_NONE;
+}
+
+/* As above, except that the text for cacheable columns is taken
+from the cache where possible. The cache may be null. */
+std::wstring GetColumnText(UINT ColumnID, const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings, MetadataCache *metadataCache)
+{
+	if (metadataCache == nullptr || !IsColumnCacheable(ColumnID))
+	{
+		return GetColumnText(ColumnID, basicItemInfo, globalFolderSettings);
+	}
+
+	if (ColumnID == CM_HARDLINKS)
+	{
+		return FormatHardLinks(GetHardLinksColumnRawData(basicItemInfo, metadataCache));
+	}
+
+	auto cacheKey = GetMetadataCacheKey(basicItemInfo);
+
+	if (!cacheKey)
+	{
+		return GetColumnText(ColumnID, basicItemInfo, globalFolderSettings);
+	}
+
+	auto cachedText = LookupCachedColumnText(metadataCache, *cacheKey, ColumnID);
+
+	if (cachedText)
+	{
+		return *cachedText;
+	}
+
+	std::wstring columnText = GetColumnText(ColumnID, basicItemInfo, globalFolderSettings);
+	metadataCache->Insert(*cacheKey, ColumnID, columnText, ShouldPersistColumn(ColumnID));
+
+	return columnText;
+}
+
+/* Only the columns that aren't already cached are retrieved
+from the file. If every column is cached, the file isn't
+opened at all. */
+std::vector<std::wstring> GetColumnBundleText(const std::vector<UINT> &ColumnIDs, const BasicItemInfo_t &basicItemInfo, MetadataCache *metadataCache)
+{
+	boost::optional<MetadataCache::FileKey> cacheKey;
+
+	if (metadataCache != nullptr)
+	{
+		cacheKey = GetMetadataCacheKey(basicItemInfo);
+	}
+
+	if (!cacheKey)
+	{
+		return GetColumnBundleText(ColumnIDs, basicItemInfo);
+	}
+
+	std::vector<std::wstring> columnTexts(ColumnIDs.size());
+	std::vector<UINT> uncachedColumnIDs;
+	std::vector<size_t> uncachedIndexes;
+
+	for (size_t i = 0; i < ColumnIDs.size(); i++)
+	{
+		auto cachedText = LookupCachedColumnText(metadataCache, *cacheKey, ColumnIDs[i]);
+
+		if (cachedText)
+		{
+			columnTexts[i] = *cachedText;
+		}
+		else
+		{
+			uncachedColumnIDs.push_back(ColumnIDs[i]);
+			uncachedIndexes.push_back(i);
+		}
+	}
+
+	if (uncachedColumnIDs.empty())
+	{
+		return columnTexts;
+	}
+
+	std::vector<std::wstring> retrievedTexts = GetColumnBundleText(uncachedColumnIDs, basicItemInfo);
+
+	for (size_t i = 0; i < uncachedColumnIDs.size(); i++)
+	{
+		metadataCache->Insert(*cacheKey, uncachedColumnIDs[i], retrievedTexts[i], ShouldPersistColumn(uncachedColumnIDs[i]));
+		columnTexts[uncachedIndexes[i]] = std::move(retrievedTexts[i]);
+	}
+
+	return columnTexts;
+}
+
+/* Only items in the filesystem have a size and modification time
+that can be used to tell whether a cached value is still valid. */
+boost::optional<MetadataCache::FileKey> GetMetadataCacheKey(const BasicItemInfo_t &itemInfo)
+{
+	TCHAR path[MAX_PATH];
+	BOOL res = SHGetPathFromIDList(itemInfo.pidlComplete.get(), path);
+
+	if (!res)
+	{
+		return boost::none;
+	}
+
+	ULARGE_INTEGER fileSize;
+	fileSize.LowPart = itemInfo.wfd.nFileSizeLow;
+	fileSize.HighPart = itemInfo.wfd.nFileSizeHigh;
+
+	ULARGE_INTEGER lastWriteTime;
+	lastWriteTime.LowPart = itemInfo.wfd.ftLastWriteTime.dwLowDateTime;
+	lastWriteTime.HighPart = itemInfo.wfd.ftLastWriteTime.dwHighDateTime;
+
+	return MetadataCache::FileKey{ path, fileSize.QuadPart, lastWriteTime.QuadPart };
+}
+
+boost::optional<std::wstring> LookupCachedColumnText(MetadataCache *metadataCache, const MetadataCache::FileKey &cacheKey, UINT ColumnID)
+{
+	auto cachedValue = metadataCache->Lookup(cacheKey, ColumnID);
+
+	if (!cachedValue)
+	{
+		return boost::none;
+	}
+
+	const std::wstring *text = boost::get<std::wstring>(&*cachedValue);
+
+	if (text == nullptr)
+	{
+		return boost::none;
+	}
+
+	return *text;
+}
+
+boost::optional<VersionInfoType_t> GetVersionInfoTypeForColumn(UINT ColumnID)
+{
+	switch (ColumnID)
+	{
+	case CM_PRODUCTNAME:
+		return VERSION_INFO_PRODUCT_NAME;
+	case CM_COMPANY:
+		return VERSION_INFO_COMPANY;
+	case CM_DESCRIPTION:
+		return VERSION_INFO_DESCRIPTION;
+	case CM_FILEVERSION:
+		return VERSION_INFO_FILE_VERSION;
+	case CM_PRODUCTVERSION:
+		return VERSION_INFO_PRODUCT_VERSION;
+	}
+
+	return boost::none;
+}
+
+boost::optional<MediaMetadataType_t> GetMediaMetadataTypeForColumn(UINT ColumnID)
+{
+	switch (ColumnID)
+	{
+	case CM_MEDIA_BITRATE:
+		return MEDIAMETADATA_TYPE_BITRATE;
+	case CM_MEDIA_COPYRIGHT:
+		return MEDIAMETADATA_TYPE_COPYRIGHT;
+	case CM_MEDIA_DURATION:
+		return MEDIAMETADATA_TYPE_DURATION;
+	case CM_MEDIA_PROTECTED:
+		return MEDIAMETADATA_TYPE_PROTECTED;
+	case CM_MEDIA_RATING:
+		return MEDIAMETADATA_TYPE_RATING;
+	case CM_MEDIA_ALBUMARTIST:
+		return MEDIAMETADATA_TYPE_ALBUM_ARTIST;
+	case CM_MEDIA_ALBUM:
+		return MEDIAMETADATA_TYPE_ALBUM_TITLE;
+	case CM_MEDIA_BEATSPERMINUTE:
+		return MEDIAMETADATA_TYPE_BEATS_PER_MINUTE;
+	case CM_MEDIA_COMPOSER:
+		return MEDIAMETADATA_TYPE_COMPOSER;
+	case CM_MEDIA_CONDUCTOR:
+		return MEDIAMETADATA_TYPE_CONDUCTOR;
+	case CM_MEDIA_DIRECTOR:
+		return MEDIAMETADATA_TYPE_DIRECTOR;
+	case CM_MEDIA_GENRE:
+		return MEDIAMETADATA_TYPE_GENRE;
+	case CM_MEDIA_LANGUAGE:
+		return MEDIAMETADATA_TYPE_LANGUAGE;
+	case CM_MEDIA_BROADCASTDATE:
+		return MEDIAMETADATA_TYPE_BROADCASTDATE;
+	case CM_MEDIA_CHANNEL:
+		return MEDIAMETADATA_TYPE_CHANNEL;
+	case CM_MEDIA_STATIONNAME:
+		return MEDIAMETADATA_TYPE_STATIONNAME;
+	case CM_MEDIA_MOOD:
+		return MEDIAMETADATA_TYPE_MOOD;
+	case CM_MEDIA_PARENTALRATING:
+		return MEDIAMETADATA_TYPE_PARENTALRATING;
+	case CM_MEDIA_PARENTALRATINGREASON:
+		return MEDIAMETADATA_TYPE_PARENTALRATINGREASON;
+	case CM_MEDIA_PERIOD:
+		return MEDIAMETADATA_TYPE_PERIOD;
+	case CM_MEDIA_PRODUCER:
+		return MEDIAMETADATA_TYPE_PRODUCER;
+	case CM_MEDIA_PUBLISHER:
+		return MEDIAMETADATA_TYPE_PUBLISHER;
+	case CM_MEDIA_WRITER:
+		return MEDIAMETADATA_TYPE_WRITER;
+	case CM_MEDIA_YEAR:
+		return MEDIAMETADATA_TYPE_YEAR;
+	}
+
+	return boost::none;
+}
+
 std::wstring GetNameColumnText(const BasicItemInfo_t &itemInfo, const GlobalFolderSettings &globalFolderSettings)
 {
 	return ProcessItemFileName(itemInfo, globalFolderSettings);
@@ -301,30 +602,13 @@ std::wstring GetTypeColumnText(const BasicItemInfo_t &itemInfo)
 	return shfi.szTypeName;
 }
 
+/* Folder sizes aren't retrieved here. When they're shown, they're
+calculated separately (see ShouldShowFolderSize()). */
 std::wstring GetSizeColumnText(const BasicItemInfo_t &itemInfo, const GlobalFolderSettings &globalFolderSettings)
 {
 	if ((itemInfo.wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY)
 	{
-		TCHAR drive[MAX_PATH];
-		StringCchCopy(drive, SIZEOF_ARRAY(drive), itemInfo.getFullPath().c_str());
-		PathStripToRoot(drive);
-
-		bool bNetworkRemovable = false;
-
-		if (GetDriveType(drive) == DRIVE_REMOVABLE ||
-			GetDriveType(drive) == DRIVE_REMOTE)
-		{
-			bNetworkRemovable = true;
-		}
-
-		if (globalFolderSettings.showFolderSizes && !(globalFolderSettings.disableFolderSizesNetworkRemovable && bNetworkRemovable))
-		{
-			return GetFolderSizeColumnText(itemInfo, globalFolderSettings);
-		}
-		else
-		{
-			return EMPTY_STRING;
-		}
+		return EMPTY_STRING;
 	}
 
 	ULARGE_INTEGER FileSize = { itemInfo.wfd.nFileSizeLow,itemInfo.wfd.nFileSizeHigh };
@@ -335,18 +619,33 @@ std::wstring GetSizeColumnText(const BasicItemInfo_t &itemInfo, const GlobalFold
 	return FileSizeText;
 }
 
-std::wstring GetFolderSizeColumnText(const BasicItemInfo_t &itemInfo, const GlobalFolderSettings &globalFolderSettings)
+bool ShouldShowFolderSize(const BasicItemInfo_t &itemInfo, const GlobalFolderSettings &globalFolderSettings)
 {
-	int numFolders;
-	int numFiles;
-	ULARGE_INTEGER totalFolderSize;
-	CalculateFolderSize(itemInfo.getFullPath().c_str(), &numFolders, &numFiles, &totalFolderSize);
+	if ((itemInfo.wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != FILE_ATTRIBUTE_DIRECTORY
+		|| !globalFolderSettings.showFolderSizes)
+	{
+		return false;
+	}
+
+	TCHAR drive[MAX_PATH];
+	StringCchCopy(drive, SIZEOF_ARRAY(drive), itemInfo.getFullPath().c_str());
+	PathStripToRoot(drive);
 
-	/* TODO: This should
-	be done some other way.
-	Shouldn't depend on
-	the internal index. */
-	//m_cachedFolderSizes.insert({internalIndex, totalFolderSize.QuadPart});
+	bool bNetworkRemovable = false;
+
+	if (GetDriveType(drive) == DRIVE_REMOVABLE ||
+		GetDriveType(drive) == DRIVE_REMOTE)
+	{
+		bNetworkRemovable = true;
+	}
+
+	return !(globalFolderSettings.disableFolderSizesNetworkRemovable && bNetworkRemovable);
+}
+
+std::wstring GetFolderSizeColumnText(ULONGLONG folderSize, const GlobalFolderSettings &globalFolderSettings)
+{
+	ULARGE_INTEGER totalFolderSize;
+	totalFolderSize.QuadPart = folderSize;
 
 	TCHAR fileSizeText[64];
 	FormatSizeString(totalFolderSize, fileSizeText, SIZEOF_ARRAY(fileSizeText),
@@ -512,28 +811,53 @@ HRESULT GetItemDetailsRawData(const BasicItemInfo_t &itemInfo, const SHCOLUMNID
 
 std::wstring GetVersionColumnText(const BasicItemInfo_t &itemInfo, VersionInfoType_t VersioninfoType)
 {
-	std::wstring VersionInfoName;
+	return GetVersionColumnTexts(itemInfo, { VersioninfoType })[0];
+}
+
+std::vector<std::wstring> GetVersionColumnTexts(const BasicItemInfo_t &itemInfo, const std::vector<VersionInfoType_t> &VersionInfoTypes)
+{
+	std::vector<const TCHAR *> VersionInfoNames;
+
+	for (VersionInfoType_t VersionInfoType : VersionInfoTypes)
+	{
+		VersionInfoNames.push_back(GetVersionInfoName(VersionInfoType));
+	}
+
+	std::vector<boost::optional<std::wstring>> VersionInfo;
+	GetVersionInfoStrings(itemInfo.getFullPath().c_str(), VersionInfoNames, VersionInfo);
+
+	std::vector<std::wstring> ColumnTexts;
 
-	switch (VersioninfoType)
+	for (const auto &Value : VersionInfo)
+	{
+		ColumnTexts.push_back(Value ? *Value : EMPTY_STRING);
+	}
+
+	return ColumnTexts;
+}
+
+const TCHAR *GetVersionInfoName(VersionInfoType_t VersionInfoType)
+{
+	switch (VersionInfoType)
 	{
 	case VERSION_INFO_PRODUCT_NAME:
-		VersionInfoName = L"ProductName";
+		return L"ProductName";
 		break;
 
 	case VERSION_INFO_COMPANY:
-		VersionInfoName = L"CompanyName";
+		return L"CompanyName";
 		break;
 
 	case VERSION_INFO_DESCRIPTION:
-		VersionInfoName = L"FileDescription";
+		return L"FileDescription";
 		break;
 
 	case VERSION_INFO_FILE_VERSION:
-		VersionInfoName = L"FileVersion";
+		return L"FileVersion";
 		break;
 
 	case VERSION_INFO_PRODUCT_VERSION:
-		VersionInfoName = L"ProductVersion";
+		return L"ProductVersion";
 		break;
 
 	default:
@@ -541,16 +865,7 @@ std::wstring GetVersionColumnText(const BasicItemInfo_t &itemInfo, VersionInfoTy
 		break;
 	}
 
-	TCHAR VersionInfo[512];
-	BOOL VersionInfoObtained = GetVersionInfoString(itemInfo.getFullPath().c_str(), VersionInfoName.c_str(),
-		VersionInfo, SIZEOF_ARRAY(VersionInfo));
-
-	if (!VersionInfoObtained)
-	{
-		return EMPTY_STRING;
-	}
-
-	return VersionInfo;
+	return L"";
 }
 
 std::wstring GetShortcutToColumnText(const BasicItemInfo_t &itemInfo)
@@ -569,8 +884,11 @@ std::wstring GetShortcutToColumnText(const BasicItemInfo_t &itemInfo)
 
 std::wstring GetHardLinksColumnText(const BasicItemInfo_t &itemInfo)
 {
-	DWORD NumHardLinks = GetHardLinksColumnRawData(itemInfo);
+	return FormatHardLinks(GetHardLinksColumnRawData(itemInfo));
+}
 
+std::wstring FormatHardLinks(DWORD NumHardLinks)
+{
 	if (NumHardLinks == -1)
 	{
 		return EMPTY_STRING;
@@ -587,6 +905,38 @@ DWORD GetHardLinksColumnRawData(const BasicItemInfo_t &itemInfo)
 	return GetNumFileHardLinks(itemInfo.getFullPath().c_str());
 }
 
+/* The count is cached as a number, so that it can be used for
+sorting directly. */
+DWORD GetHardLinksColumnRawData(const BasicItemInfo_t &itemInfo, MetadataCache *metadataCache)
+{
+	boost::optional<MetadataCache::FileKey> cacheKey;
+
+	if (metadataCache != nullptr)
+	{
+		cacheKey = GetMetadataCacheKey(itemInfo);
+	}
+
+	if (!cacheKey)
+	{
+		return GetHardLinksColumnRawData(itemInfo);
+	}
+
+	auto cachedValue = metadataCache->Lookup(*cacheKey, CM_HARDLINKS);
+
+	if (cachedValue)
+	{
+		if (const std::uint64_t *numHardLinks = boost::get<std::uint64_t>(&*cachedValue))
+		{
+			return static_cast<DWORD>(*numHardLinks);
+		}
+	}
+
+	DWORD NumHardLinks = GetHardLinksColumnRawData(itemInfo);
+	metadataCache->Insert(*cacheKey, CM_HARDLINKS, static_cast<std::uint64_t>(NumHardLinks), false);
+
+	return NumHardLinks;
+}
+
 std::wstring GetExtensionColumnText(const BasicItemInfo_t &itemInfo)
 {
 	if ((itemInfo.wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY)
@@ -827,12 +1177,60 @@ std::wstring GetNetworkAdapterColumnText(const BasicItemInfo_t &itemInfo)
 
 std::wstring GetMediaMetadataColumnText(const BasicItemInfo_t &itemInfo, MediaMetadataType_t MediaMetaDataType)
 {
-	const TCHAR *AttributeName = GetMediaMetadataAttributeName(MediaMetaDataType);
+	return GetMediaMetadataColumnTexts(itemInfo, { MediaMetaDataType })[0];
+}
 
-	BYTE *TempBuffer = NULL;
-	HRESULT hr = GetMediaMetadata(itemInfo.getFullPath().c_str(), AttributeName, &TempBuffer);
+std::vector<std::wstring> GetMediaMetadataColumnTexts(const BasicItemInfo_t &itemInfo, const std::vector<MediaMetadataType_t> &MediaMetadataTypes)
+{
+	std::vector<const TCHAR *> AttributeNames;
 
-	if (!SUCCEEDED(hr))
+	for (MediaMetadataType_t MediaMetadataType : MediaMetadataTypes)
+	{
+		AttributeNames.push_back(GetMediaMetadataAttributeName(MediaMetadataType));
+	}
+
+	std::vector<boost::optional<std::vector<BYTE>>> Metadata;
+	GetMediaMetadata(itemInfo.getFullPath().c_str(), AttributeNames, Metadata);
+
+	std::vector<std::wstring> ColumnTexts;
+
+	for (size_t i = 0; i < MediaMetadataTypes.size(); i++)
+	{
+		if (!Metadata[i])
+		{
+			ColumnTexts.push_back(EMPTY_STRING);
+			continue;
+		}
+
+		ColumnTexts.push_back(FormatMediaMetadata(MediaMetadataTypes[i], *Metadata[i]));
+	}
+
+	return ColumnTexts;
+}
+
+std::wstring FormatMediaMetadata(MediaMetadataType_t MediaMetaDataType, const std::vector<BYTE> &Data)
+{
+	size_t RequiredSize = 0;
+
+	switch (MediaMetaDataType)
+	{
+	case MEDIAMETADATA_TYPE_BITRATE:
+		RequiredSize = sizeof(DWORD);
+		break;
+
+	case MEDIAMETADATA_TYPE_DURATION:
+		RequiredSize = sizeof(QWORD);
+		break;
+
+	case MEDIAMETADATA_TYPE_PROTECTED:
+		RequiredSize = sizeof(BOOL);
+		break;
+
+	default:
+		break;
+	}
+
+	if (Data.empty() || Data.size() < RequiredSize)
 	{
 		return EMPTY_STRING;
 	}
@@ -843,7 +1241,7 @@ std::wstring GetMediaMetadataColumnText(const BasicItemInfo_t &itemInfo, MediaMe
 	{
 	case MEDIAMETADATA_TYPE_BITRATE:
 	{
-		DWORD BitRate = *(reinterpret_cast<DWORD *>(TempBuffer));
+		DWORD BitRate = *(reinterpret_cast<const DWORD *>(Data.data()));
 
 		if (BitRate > 1000)
 		{
@@ -866,7 +1264,7 @@ std::wstring GetMediaMetadataColumnText(const BasicItemInfo_t &itemInfo, MediaMe
 
 		/* Note that the duration itself is in 100-nanosecond units
 		(see http://msdn.microsoft.com/en-us/library/windows/desktop/dd798053(v=vs.85).aspx). */
-		boost::posix_time::time_duration Duration = boost::posix_time::microseconds(*(reinterpret_cast<QWORD *>(TempBuffer)) / 10);
+		boost::posix_time::time_duration Duration = boost::posix_time::microseconds(*(reinterpret_cast<const QWORD *>(Data.data())) / 10);
 		DateStream << Duration;
 
 		StringCchCopy(szOutput, SIZEOF_ARRAY(szOutput), DateStream.str().c_str());
@@ -874,7 +1272,7 @@ std::wstring GetMediaMetadataColumnText(const BasicItemInfo_t &itemInfo, MediaMe
 	break;
 
 	case MEDIAMETADATA_TYPE_PROTECTED:
-		if (*(reinterpret_cast<BOOL *>(TempBuffer)))
+		if (*(reinterpret_cast<const BOOL *>(Data.data())))
 		{
 			StringCchCopy(szOutput, SIZEOF_ARRAY(szOutput), L"Yes");
 		}
@@ -906,11 +1304,13 @@ std::wstring GetMediaMetadataColumnText(const BasicItemInfo_t &itemInfo, MediaMe
 	case MEDIAMETADATA_TYPE_WRITER:
 	case MEDIAMETADATA_TYPE_YEAR:
 	default:
-		StringCchCopy(szOutput, SIZEOF_ARRAY(szOutput), reinterpret_cast<TCHAR *>(TempBuffer));
-		break;
+	{
+		/* Strings aren't necessarily null-terminated. */
+		std::wstring Text(reinterpret_cast<const TCHAR *>(Data.data()), Data.size() / sizeof(TCHAR));
+		StringCchCopy(szOutput, SIZEOF_ARRAY(szOutput), Text.c_str());
+	}
+	break;
 	}
-
-	free(TempBuffer);
 
 	return szOutput;
 }
@@ -7,6 +7,9 @@
 #include "FolderSettings.h"
 #include "ItemData.h"
 #include <string>
+#include <vector>
+
+class MetadataCache;
 
 enum TimeType_t
 {
@@ -33,6 +36,13 @@ enum PrinterInformationType_t
 	PRINTER_INFORMATION_TYPE_MODEL
 };
 
+enum ColumnBundle_t
+{
+	COLUMN_BUNDLE_NONE,
+	COLUMN_BUNDLE_VERSION_INFO,
+	COLUMN_BUNDLE_MEDIA_METADATA
+};
+
 enum MediaMetadataType_t
 {
 	MEDIAMETADATA_TYPE_BITRATE,
@@ -62,6 +72,11 @@ enum MediaMetadataType_t
 };
 
 std::wstring GetColumnText(UINT ColumnID, const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings);
+ColumnBundle_t GetColumnBundle(UINT ColumnID);
+std::vector<std::wstring> GetColumnBundleText(const std::vector<UINT> &ColumnIDs, const BasicItemInfo_t &basicItemInfo);
+bool IsColumnCacheable(UINT ColumnID);
+std::wstring GetColumnText(UINT ColumnID, const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings, MetadataCache *metadataCache);
+std::vector<std::wstring> GetColumnBundleText(const std::vector<UINT> &ColumnIDs, const BasicItemInfo_t &basicItemInfo, MetadataCache *metadataCache);
 std::wstring GetNameColumnText(const BasicItemInfo_t &itemInfo, const GlobalFolderSettings &globalFolderSettings);
 std::wstring ProcessItemFileName(const BasicItemInfo_t &itemInfo, const GlobalFolderSettings &globalFolderSettings);
 std::wstring GetTypeColumnText(const BasicItemInfo_t &itemInfo);
@@ -75,9 +90,12 @@ std::wstring GetItemDetailsColumnText(const BasicItemInfo_t &itemInfo, const SHC
 HRESULT GetItemDetails(const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid, TCHAR *szDetail, size_t cchMax, const GlobalFolderSettings &globalFolderSettings);
 HRESULT GetItemDetailsRawData(const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid, VARIANT *vt);
 std::wstring GetVersionColumnText(const BasicItemInfo_t &itemInfo, VersionInfoType_t VersioninfoType);
+std::vector<std::wstring> GetVersionColumnTexts(const BasicItemInfo_t &itemInfo, const std::vector<VersionInfoType_t> &VersionInfoTypes);
+const TCHAR *GetVersionInfoName(VersionInfoType_t VersionInfoType);
 std::wstring GetShortcutToColumnText(const BasicItemInfo_t &itemInfo);
 std::wstring GetHardLinksColumnText(const BasicItemInfo_t &itemInfo);
 DWORD GetHardLinksColumnRawData(const BasicItemInfo_t &itemInfo);
+DWORD GetHardLinksColumnRawData(const BasicItemInfo_t &itemInfo, MetadataCache *metadataCache);
 std::wstring GetExtensionColumnText(const BasicItemInfo_t &itemInfo);
 std::wstring GetImageColumnText(const BasicItemInfo_t &itemInfo, PROPID PropertyID);
 std::wstring GetFileSystemColumnText(const BasicItemInfo_t &itemInfo);
@@ -85,8 +103,10 @@ std::wstring GetControlPanelCommentsColumnText(const BasicItemInfo_t &itemInfo);
 std::wstring GetPrinterColumnText(const BasicItemInfo_t &itemInfo, PrinterInformationType_t PrinterInformationType);
 std::wstring GetNetworkAdapterColumnText(const BasicItemInfo_t &itemInfo);
 std::wstring GetMediaMetadataColumnText(const BasicItemInfo_t &itemInfo, MediaMetadataType_t MediaMetaDataType);
+std::vector<std::wstring> GetMediaMetadataColumnTexts(const BasicItemInfo_t &itemInfo, const std::vector<MediaMetadataType_t> &MediaMetadataTypes);
 const TCHAR *GetMediaMetadataAttributeName(MediaMetadataType_t MediaMetaDataType);
 std::wstring GetDriveSpaceColumnText(const BasicItemInfo_t &itemInfo, bool TotalSize, const GlobalFolderSettings &globalFolderSettings);
 BOOL GetDriveSpaceColumnRawData(const BasicItemInfo_t &itemInfo, bool TotalSize, ULARGE_INTEGER &DriveSpace);
 std::wstring GetSizeColumnText(const BasicItemInfo_t &itemInfo, const GlobalFolderSettings &globalFolderSettings);
-std::wstring GetFolderSizeColumnText(const BasicItemInfo_t &itemInfo, const GlobalFolderSettings &globalFolderSettings);
\ No newline at end of file
+bool ShouldShowFolderSize(const BasicItemInfo_t &itemInfo, const GlobalFolderSettings &globalFolderSettings);
+std::wstring GetFolderSizeColumnText(ULONGLONG folderSize, const GlobalFolderSettings &globalFolderSettings);
\ No newline at end of file
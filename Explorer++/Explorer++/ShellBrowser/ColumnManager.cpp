@@ -11,6 +11,7 @@
 #include "MainResource.h"
 #include "SortModes.h"
 #include "ViewModes.h"
+#include "../Helper/FolderSizeService.h"
 #include "../Helper/Helper.h"
 #include "../Helper/Macros.h"
 #include "../Helper/ShellHelper.h"
@@ -26,33 +27,43 @@ void CShellBrowser::QueueColumnTask(int itemInternalIndex, int columnIndex)
 		return;
 	}
 
-	int columnResultID = m_columnResultIDCounter++;
-
 	BasicItemInfo_t basicItemInfo = getBasicItemInfo(itemInternalIndex);
 	GlobalFolderSettings globalFolderSettings = m_config->globalFolderSettings;
 
-	auto result = m_columnThreadPool.push([this, columnResultID, columnID, itemInternalIndex, basicItemInfo, globalFolderSettings](int id) {
-		UNREFERENCED_PARAMETER(id);
+	if (*columnID == CM_SIZE && m_folderSizeService != nullptr
+		&& ShouldShowFolderSize(basicItemInfo, globalFolderSettings))
+	{
+		QueueFolderSizeTask(itemInternalIndex, basicItemInfo.getFullPath());
+		return;
+	}
+
+	ColumnBundle_t bundle = GetColumnBundle(*columnID);
 
-		return GetColumnTextAsync(m_hListView, columnResultID, *columnID, itemInternalIndex, basicItemInfo, globalFolderSettings);
-	});
+	if (bundle != COLUMN_BUNDLE_NONE)
+	{
+		QueueColumnBundleTask(itemInternalIndex, bundle, basicItemInfo);
+		return;
+	}
 
-	// The function call above might finish before this line runs,
-	// but that doesn't matter, as the results won't be processed
-	// until a message posted to the main thread has been handled
-	// (which can only occur after this function has returned).
-	m_columnResults.insert({ columnResultID, std::move(result) });
+	HWND listView = m_hListView;
+	auto itemResults = m_itemResults;
+	MetadataCache *metadataCache = m_metadataCache;
+	int generation = m_itemResultGeneration;
+
+	// Nothing will be queued if the text for this cell has
+	// already been requested.
+	m_itemTaskScheduler->QueueTask(m_ID, { itemInternalIndex, static_cast<int>(*columnID) },
+		[listView, itemResults, metadataCache, generation, columnID, itemInternalIndex, basicItemInfo, globalFolderSettings] {
+		ColumnResult_t result = GetColumnTextAsync(*columnID, itemInternalIndex, basicItemInfo, globalFolderSettings, metadataCache);
+		result.generation = generation;
+		itemResults->Add(listView, itemResults->columnResults, std::move(result));
+	});
 }
 
-CShellBrowser::ColumnResult_t CShellBrowser::GetColumnTextAsync(HWND listView, int columnResultId, unsigned int ColumnID,
-	int InternalIndex, const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings)
+CShellBrowser::ColumnResult_t CShellBrowser::GetColumnTextAsync(unsigned int ColumnID, int InternalIndex,
+	const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings, MetadataCache *metadataCache)
 {
-	std::wstring columnText = GetColumnText(ColumnID, basicItemInfo, globalFolderSettings);
-
-	// This message may be delivered before this function has returned.
-	// That doesn't actually matter, since the message handler will
-	// simply wait for the result to be returned.
-	PostMessage(listView, WM_APP_COLUMN_RESULT_READY, columnResultId, 0);
+	std::wstring columnText = GetColumnText(ColumnID, basicItemInfo, globalFolderSettings, metadataCache);
 
 	ColumnResult_t result;
 	result.itemInternalIndex = InternalIndex;
@@ -62,44 +73,202 @@ CShellBrowser::ColumnResult_t CShellBrowser::GetColumnTextAsync(HWND listView, i
 	return result;
 }
 
-void CShellBrowser::ProcessColumnResult(int columnResultId)
+/* Used when sorting and grouping, so that values already
+retrieved for the column text (in this tab or any other) don't
+have to be read from the file again. */
+std::wstring CShellBrowser::GetCachedColumnText(unsigned int ColumnID, const BasicItemInfo_t &basicItemInfo) const
+{
+	return GetColumnText(ColumnID, basicItemInfo, m_config->globalFolderSettings, m_metadataCache);
+}
+
+/* The text for every column in a bundle (e.g. each of the media
+metadata columns) is read from the same file header, so all of
+the columns in the bundle that are currently shown are retrieved
+by a single task. That way, the file is only opened once per
+item, rather than once per column. Requests for the other columns
+in the bundle are ignored while the task is queued or running. */
+void CShellBrowser::QueueColumnBundleTask(int itemInternalIndex, ColumnBundle_t bundle,
+	const BasicItemInfo_t &basicItemInfo)
+{
+	HWND listView = m_hListView;
+	auto itemResults = m_itemResults;
+	MetadataCache *metadataCache = m_metadataCache;
+	int generation = m_itemResultGeneration;
+
+	// Since the listview has asked for text in one of these
+	// columns, there'll be at least one visible column in the
+	// bundle.
+	std::vector<unsigned int> columnIDs = GetColumnIdsInBundle(bundle);
+
+	m_itemTaskScheduler->QueueTask(m_ID, { itemInternalIndex, GetColumnBundleTaskType(bundle) },
+		[listView, itemResults, metadataCache, generation, columnIDs, itemInternalIndex, basicItemInfo] {
+		std::vector<std::wstring> columnTexts = GetColumnBundleText(columnIDs, basicItemInfo, metadataCache);
+
+		for (size_t i = 0; i < columnIDs.size(); i++)
+		{
+			ColumnResult_t result;
+			result.itemInternalIndex = itemInternalIndex;
+			result.columnID = columnIDs[i];
+			result.columnText = columnTexts[i];
+			result.generation = generation;
+			itemResults->Add(listView, itemResults->columnResults, std::move(result));
+		}
+	});
+}
+
+/* Returns the columns currently shown that are part of the
+specified bundle. */
+std::vector<unsigned int> CShellBrowser::GetColumnIdsInBundle(ColumnBundle_t bundle) const
 {
-	auto itr = m_columnResults.find(columnResultId);
+	std::vector<unsigned int> columnIDs;
 
-	if (itr == m_columnResults.end())
+	int numColumns = Header_GetItemCount(ListView_GetHeader(m_hListView));
+
+	for (int i = 0; i < numColumns; i++)
 	{
-		// This result is for a previous folder. It can be ignored.
-		return;
+		auto columnID = GetColumnIdByIndex(i);
+
+		if (columnID && GetColumnBundle(*columnID) == bundle)
+		{
+			columnIDs.push_back(*columnID);
+		}
+	}
+
+	return columnIDs;
+}
+
+int CShellBrowser::GetColumnBundleTaskType(ColumnBundle_t bundle)
+{
+	switch (bundle)
+	{
+	case COLUMN_BUNDLE_VERSION_INFO:
+		return ITEM_TASK_VERSION_INFO_COLUMNS;
+
+	case COLUMN_BUNDLE_MEDIA_METADATA:
+		return ITEM_TASK_MEDIA_METADATA_COLUMNS;
+
+	default:
+		assert(false);
+		break;
 	}
 
+	return ITEM_TASK_MEDIA_METADATA_COLUMNS;
+}
+
+/* Returns the row that was updated (if any). */
+boost::optional<int> CShellBrowser::ProcessColumnResult(const ColumnResult_t &result, const ColumnIndexMap_t &columnIndexes)
+{
 	if (m_folderSettings.viewMode != +ViewMode::Details)
 	{
-		return;
+		return boost::none;
+	}
+
+	return SetColumnTextForItem(result.itemInternalIndex, result.columnID, result.columnText, columnIndexes);
+}
+
+/* The size of the folder is calculated by the shared
+FolderSizeService. Running totals are shown while the
+calculation is in progress, so that the column fills in
+gradually for large folders. */
+void CShellBrowser::QueueFolderSizeTask(int itemInternalIndex, const std::wstring &path)
+{
+	// The callback may run after this browser has been destroyed,
+	// so it only holds on to the result queues (and the listview
+	// handle, which is simply ignored if it's no longer valid).
+	HWND listView = m_hListView;
+	auto itemResults = m_itemResults;
+	int generation = m_itemResultGeneration;
+
+	// If the size is already cached, the callback will run before
+	// this call returns. The result won't be processed until the
+	// message posted to the listview has been handled.
+	m_folderSizeService->CalculateFolderSizeAsync(path,
+		[listView, itemResults, generation, itemInternalIndex] (const FolderSizeService::FolderSize &folderSize, bool complete) {
+		FolderSizeResult_t result;
+		result.generation = generation;
+		result.itemInternalIndex = itemInternalIndex;
+		result.size = folderSize.size;
+		result.complete = complete;
+		itemResults->Add(listView, itemResults->folderSizeResults, result);
+	});
+}
+
+/* Returns the row that was updated (if any). */
+boost::optional<int> CShellBrowser::ProcessFolderSizeResult(const FolderSizeResult_t &result, const ColumnIndexMap_t &columnIndexes)
+{
+	if (result.complete)
+	{
+		m_cachedFolderSizes[result.itemInternalIndex] = result.size;
+		InvalidateItemGroup(result.itemInternalIndex);
 	}
 
-	auto result = itr->second.get();
+	if (m_folderSettings.viewMode != +ViewMode::Details)
+	{
+		return boost::none;
+	}
+
+	return SetColumnTextForItem(result.itemInternalIndex, CM_SIZE,
+		GetFolderSizeColumnText(result.size, m_config->globalFolderSettings), columnIndexes);
+}
 
-	auto index = LocateItemByInternalIndex(result.itemInternalIndex);
+/* In owner data mode, the item isn't redrawn here. The caller
+is expected to redraw the returned row. */
+boost::optional<int> CShellBrowser::SetColumnTextForItem(int itemInternalIndex, unsigned int columnID,
+	const std::wstring &columnText, const ColumnIndexMap_t &columnIndexes)
+{
+	auto index = LocateItemByInternalIndex(itemInternalIndex);
 
 	if (!index)
 	{
 		// This is a valid state. The item may simply have been deleted.
-		return;
+		return boost::none;
 	}
 
-	auto columnIndex = GetColumnIndexById(result.columnID);
+	auto columnIndex = columnIndexes.find(columnID);
 
-	if (!columnIndex)
+	if (columnIndex == columnIndexes.end())
 	{
 		// This is also a valid state. The column may have been removed.
-		return;
+		return boost::none;
 	}
 
-	auto columnText = std::make_unique<TCHAR[]>(result.columnText.size() + 1);
-	StringCchCopy(columnText.get(), result.columnText.size() + 1, result.columnText.c_str());
-	ListView_SetItemText(m_hListView, *index, *columnIndex, columnText.get());
+	if (m_ownerDataListView)
+	{
+		GetOwnerDataItem(itemInternalIndex).columnText[columnID] = columnText;
+	}
+	else
+	{
+		auto columnTextCopy = std::make_unique<TCHAR[]>(columnText.size() + 1);
+		StringCchCopy(columnTextCopy.get(), columnText.size() + 1, columnText.c_str());
+		ListView_SetItemText(m_hListView, *index, columnIndex->second, columnTextCopy.get());
+	}
+
+	return index;
+}
+
+/* Maps the ID of each column currently shown to its index. */
+CShellBrowser::ColumnIndexMap_t CShellBrowser::GetColumnIndexMap() const
+{
+	ColumnIndexMap_t columnIndexes;
+
+	HWND header = ListView_GetHeader(m_hListView);
+	int numItems = Header_GetItemCount(header);
+
+	for (int i = 0; i < numItems; i++)
+	{
+		HDITEM hdItem;
+		hdItem.mask = HDI_LPARAM;
+		BOOL res = Header_GetItem(header, i, &hdItem);
+
+		if (!res)
+		{
+			continue;
+		}
+
+		columnIndexes.insert({ static_cast<unsigned int>(hdItem.lParam), i });
+	}
 
-	m_columnResults.erase(itr);
+	return columnIndexes;
 }
 
 boost::optional<int> CShellBrowser::GetColumnIndexById(unsigned int id) const
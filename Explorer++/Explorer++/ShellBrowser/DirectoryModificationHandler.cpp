@@ -8,12 +8,14 @@
 #include "iShellBrowser_internal.h"
 #include "ViewModes.h"
 #include "../Helper/Controls.h"
+#include "../Helper/iDirectoryMonitor.h"
 #include "../Helper/FileOperations.h"
 #include "../Helper/FolderSize.h"
 #include "../Helper/Helper.h"
 #include "../Helper/ListViewHelper.h"
 #include "../Helper/Logging.h"
 #include "../Helper/Macros.h"
+#include "../Helper/MetadataCache.h"
 #include "../Helper/ShellHelper.h"
 #include <list>
 
@@ -24,7 +26,23 @@ void CShellBrowser::DirectoryAltered(void)
 {
 	BOOL bNewItemCreated;
 
+	/* Changes made while the directory is still being
+	enumerated are held back until the enumeration has
+	finished (at which point this method will be called
+	again). Processing them now could result in items
+	being added twice. */
+	if(m_directoryEnumeration)
+	{
+		return;
+	}
+
+	/* Take the current batch of changes. The lock isn't held
+	while the changes are applied, so that new notifications
+	can continue to be recorded in the meantime. */
 	EnterCriticalSection(&m_csDirectoryAltered);
+	DirectoryChangeSet changeSet = m_directoryChanges.TakeChanges();
+	int changesFolderIndex = m_directoryChangesFolderIndex;
+	LeaveCriticalSection(&m_csDirectoryAltered);
 
 	bNewItemCreated = m_bNewItemCreated;
 
@@ -49,39 +67,62 @@ void CShellBrowser::DirectoryAltered(void)
 	other actions for the file will take place before the addition,
 	which will again result in an incorrect state.
 	*/
-	for(const auto &af : m_AlteredList)
+	/* Only undertake the modifications if the unique folder
+	index on the modified items and current folder match up
+	(i.e. ensure the directory has not changed since these
+	files were modified). */
+	if(changesFolderIndex == m_iUniqueFolderIndex)
 	{
-		/* Only undertake the modification if the unique folder
-		index on the modified item and current folder match up
-		(i.e. ensure the directory has not changed since these
-		files were modified). */
-		if(af.iFolderIndex == m_iUniqueFolderIndex)
+		if(changeSet.rescanRequired)
 		{
-			switch(af.dwAction)
+			/* The directory is read again on a background thread
+			and the items are reconciled against it once it's been
+			read (see ProcessEnumerationResults()). Changes that
+			arrive in the meantime are held back until then. */
+			LOG(debug) << _T("ShellBrowser - Change notifications lost, rescanning \"") << m_CurDir << _T("\"");
+			StartDirectoryEnumeration(m_pidlDirectory,true);
+		}
+
+		for(const auto &change : changeSet.changes)
+		{
+			const TCHAR *szFileName = change.fileName.c_str();
+
+			/* Some cached values (e.g. the owner) can change without
+			the size or modification time of the file changing, so
+			anything cached for the file is discarded. */
+			if(m_metadataCache != nullptr)
+			{
+				TCHAR szFullFileName[MAX_PATH];
+				StringCchCopy(szFullFileName,SIZEOF_ARRAY(szFullFileName),m_CurDir);
+				PathAppend(szFullFileName,szFileName);
+				m_metadataCache->Invalidate(szFullFileName);
+			}
+
+			switch(change.action)
 			{
 			case FILE_ACTION_ADDED:
-				LOG(debug) << _T("ShellBrowser - Adding \"") << af.szFileName << _T("\"");
-				OnFileActionAdded(af.szFileName);
+				LOG(debug) << _T("ShellBrowser - Adding \"") << szFileName << _T("\"");
+				OnFileActionAdded(szFileName);
 				break;
 
 			case FILE_ACTION_MODIFIED:
-				LOG(debug) << _T("ShellBrowser - Modifying \"") << af.szFileName << _T("\"");
-				ModifyItemInternal(af.szFileName);
+				LOG(debug) << _T("ShellBrowser - Modifying \"") << szFileName << _T("\"");
+				ModifyItemInternal(szFileName);
 				break;
 
 			case FILE_ACTION_REMOVED:
-				LOG(debug) << _T("ShellBrowser - Removing \"") << af.szFileName << _T("\"");
-				RemoveItemInternal(af.szFileName);
+				LOG(debug) << _T("ShellBrowser - Removing \"") << szFileName << _T("\"");
+				RemoveItemInternal(szFileName);
 				break;
 
 			case FILE_ACTION_RENAMED_OLD_NAME:
-				LOG(debug) << _T("ShellBrowser - Old name received \"") << af.szFileName << _T("\"");
-				OnFileActionRenamedOldName(af.szFileName);
+				LOG(debug) << _T("ShellBrowser - Old name received \"") << szFileName << _T("\"");
+				OnFileActionRenamedOldName(szFileName);
 				break;
 
 			case FILE_ACTION_RENAMED_NEW_NAME:
-				LOG(debug) << _T("ShellBrowser - New name received \"") << af.szFileName << _T("\"");
-				OnFileActionRenamedNewName(af.szFileName);
+				LOG(debug) << _T("ShellBrowser - New name received \"") << szFileName << _T("\"");
+				OnFileActionRenamedNewName(szFileName);
 				break;
 			}
 		}
@@ -105,7 +146,7 @@ void CShellBrowser::DirectoryAltered(void)
 	if(bNewItemCreated && !m_bNewItemCreated)
 		SendMessage(m_hOwner,WM_USER_NEWITEMINSERTED,0,m_iIndexNewItem);
 
-	m_AlteredList.clear();
+	EnterCriticalSection(&m_csDirectoryAltered);
 
 	BOOL bFocusSet = FALSE;
 	int iIndex;
@@ -157,15 +198,40 @@ int EventId,int iFolderIndex)
 {
 	EnterCriticalSection(&m_csDirectoryAltered);
 
-	SetTimer(m_hOwner,EventId,200,TimerProc);
+	/* Notifications for the previous folder may still arrive
+	after the folder has changed. Since folder indices only
+	ever increase, they can be told apart from notifications
+	for the current folder. */
+	if(!m_directoryChanges.IsEmpty() && iFolderIndex != m_directoryChangesFolderIndex)
+	{
+		if(iFolderIndex < m_directoryChangesFolderIndex)
+		{
+			LeaveCriticalSection(&m_csDirectoryAltered);
+			return;
+		}
 
-	AlteredFile_t af;
+		m_directoryChanges.Clear();
+	}
 
-	StringCchCopy(af.szFileName,SIZEOF_ARRAY(af.szFileName),FileName);
-	af.dwAction = Action;
-	af.iFolderIndex = iFolderIndex;
+	/* The timer is only set when the first change in a batch
+	arrives. Resetting it on every change would mean that a
+	steady stream of changes would hold back the update
+	indefinitely. */
+	if(m_directoryChanges.IsEmpty())
+	{
+		SetTimer(m_hOwner,EventId,DIRECTORY_CHANGE_BATCH_INTERVAL,TimerProc);
+	}
 
-	m_AlteredList.push_back(af);
+	m_directoryChangesFolderIndex = iFolderIndex;
+
+	if(Action == DIRECTORY_MONITOR_ACTION_RESCAN)
+	{
+		m_directoryChanges.SetRescanRequired();
+	}
+	else
+	{
+		m_directoryChanges.AddChange(FileName,Action);
+	}
 
 	LeaveCriticalSection(&m_csDirectoryAltered);
 }
@@ -182,6 +248,13 @@ void CShellBrowser::OnFileActionAdded(const TCHAR *szFileName)
 	BOOL			bFileAdded = FALSE;
 	HRESULT hr;
 
+	/* The item may have been created after enumeration started, but
+	before it finished, in which case it will already be present. */
+	if(LocateFileItemInternalIndex(szFileName) != -1)
+	{
+		return;
+	}
+
 	StringCchCopy(FullFileName,SIZEOF_ARRAY(FullFileName),m_CurDir);
 	PathAppend(FullFileName,szFileName);
 
@@ -299,6 +372,7 @@ void CShellBrowser::RemoveItemInternal(const TCHAR *szFileName)
 void CShellBrowser::ModifyItemInternal(const TCHAR *FileName)
 {
 	HANDLE			hFirstFile;
+	WIN32_FIND_DATA	wfd;
 	ULARGE_INTEGER	ulFileSize;
 	LVITEM			lvItem;
 	TCHAR			FullFileName[MAX_PATH];
@@ -334,7 +408,7 @@ void CShellBrowser::ModifyItemInternal(const TCHAR *FileName)
 
 		for(itr = m_AwaitingAddList.begin();itr!= m_AwaitingAddList.end();itr++)
 		{
-			if(lstrcmp(m_itemInfoMap.at(itr->iItemInternal).wfd.cFileName,FileName) == 0)
+			if(lstrcmp(m_itemStore.getFileName(itr->iItemInternal),FileName) == 0)
 			{
 				iItemInternal = itr->iItemInternal;
 				break;
@@ -379,19 +453,17 @@ void CShellBrowser::ModifyItemInternal(const TCHAR *FileName)
 	if(iItemInternal != -1)
 	{
 		/* Is this item a folder? */
-		bFolder = (m_itemInfoMap.at(iItemInternal).wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ==
+		bFolder = (m_itemStore.getAttributes(iItemInternal) & FILE_ATTRIBUTE_DIRECTORY) ==
 			FILE_ATTRIBUTE_DIRECTORY;
 
-		ulFileSize.LowPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeLow;
-		ulFileSize.HighPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeHigh;
+		ulFileSize.QuadPart = m_itemStore.getSize(iItemInternal);
 
 		m_ulTotalDirSize.QuadPart -= ulFileSize.QuadPart;
 
 		if(ListView_GetItemState(m_hListView,iItem,LVIS_SELECTED)
 		== LVIS_SELECTED)
 		{
-			ulFileSize.LowPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeLow;
-			ulFileSize.HighPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeHigh;
+			ulFileSize.QuadPart = m_itemStore.getSize(iItemInternal);
 
 			m_ulFileSelectionSize.QuadPart -= ulFileSize.QuadPart;
 		}
@@ -399,25 +471,40 @@ void CShellBrowser::ModifyItemInternal(const TCHAR *FileName)
 		StringCchCopy(FullFileName,SIZEOF_ARRAY(FullFileName),m_CurDir);
 		PathAppend(FullFileName,FileName);
 
-		hFirstFile = FindFirstFile(FullFileName,&m_itemInfoMap.at(iItemInternal).wfd);
+		hFirstFile = FindFirstFile(FullFileName,&wfd);
 
 		if(hFirstFile != INVALID_HANDLE_VALUE)
 		{
-			ulFileSize.LowPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeLow;
-			ulFileSize.HighPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeHigh;
+			/* The item's names are re-read here, so the name
+			index will need to be updated. */
+			RemoveItemFromNameIndex(iItemInternal);
+			m_itemStore.setFindData(iItemInternal,wfd);
+			InvalidateItemGroup(iItemInternal);
+			AddItemToNameIndex(iItemInternal);
+
+			/* Any tasks that are still queued for this item
+			were created using the old file information. */
+			CancelItemTasks(iItemInternal);
+
+			ulFileSize.QuadPart = m_itemStore.getSize(iItemInternal);
 
 			m_ulTotalDirSize.QuadPart += ulFileSize.QuadPart;
 
 			if(ListView_GetItemState(m_hListView,iItem,LVIS_SELECTED)
 				== LVIS_SELECTED)
 			{
-				ulFileSize.LowPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeLow;
-				ulFileSize.HighPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeHigh;
+				ulFileSize.QuadPart = m_itemStore.getSize(iItemInternal);
 
 				m_ulFileSelectionSize.QuadPart += ulFileSize.QuadPart;
 			}
 
-			if((m_itemInfoMap.at(iItemInternal).wfd.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN) ==
+			if(m_ownerDataListView)
+			{
+				/* The icon overlay, hidden state and column
+				text will all be retrieved again. */
+				InvalidateOwnerDataItem(iItemInternal);
+			}
+			else if((m_itemStore.getAttributes(iItemInternal) & FILE_ATTRIBUTE_HIDDEN) ==
 				FILE_ATTRIBUTE_HIDDEN)
 			{
 				ListView_SetItemState(m_hListView,iItem,LVIS_CUT,LVIS_CUT);
@@ -452,8 +539,8 @@ void CShellBrowser::ModifyItemInternal(const TCHAR *FileName)
 			modification. If the internal structures still hold
 			the old size, the total directory size will become
 			corrupted. */
-			m_itemInfoMap.at(iItemInternal).wfd.nFileSizeLow = 0;
-			m_itemInfoMap.at(iItemInternal).wfd.nFileSizeHigh = 0;
+			m_itemStore.setSize(iItemInternal,0);
+			InvalidateItemGroup(iItemInternal);
 		}
 	}
 }
@@ -516,13 +603,11 @@ void CShellBrowser::RenameItem(int iItemInternal,const TCHAR *szNewFileName)
 	LPITEMIDLIST	pidlFull = NULL;
 	LPITEMIDLIST	pidlRelative = NULL;
 	SHFILEINFO		shfi;
-	LVFINDINFO		lvfi;
 	TCHAR			szDisplayName[MAX_PATH];
 	LVITEM			lvItem;
 	TCHAR			szFullFileName[MAX_PATH];
 	DWORD_PTR		res;
 	HRESULT			hr;
-	int				iItem;
 
 	if(iItemInternal == -1)
 		return;
@@ -542,17 +627,15 @@ void CShellBrowser::RenameItem(int iItemInternal,const TCHAR *szNewFileName)
 
 			if(SUCCEEDED(hr))
 			{
-				m_itemInfoMap.at(iItemInternal).pidlComplete.reset(ILClone(pidlFull));
-				m_itemInfoMap.at(iItemInternal).pridl.reset(ILClone(pidlRelative));
-				StringCchCopy(m_itemInfoMap.at(iItemInternal).szDisplayName,
-					SIZEOF_ARRAY(m_itemInfoMap.at(iItemInternal).szDisplayName),
-					szDisplayName);
+				m_itemStore.setPidls(iItemInternal,pidlFull,pidlRelative);
+				m_itemStore.setDisplayName(iItemInternal,szDisplayName);
+				InvalidateItemGroup(iItemInternal);
 
 				/* Need to update internal storage for the item, since
 				it's name has now changed. */
-				StringCchCopy(m_itemInfoMap.at(iItemInternal).wfd.cFileName,
-					SIZEOF_ARRAY(m_itemInfoMap.at(iItemInternal).wfd.cFileName),
-					szNewFileName);
+				RemoveItemFromNameIndex(iItemInternal);
+				m_itemStore.setFileName(iItemInternal,szNewFileName);
+				AddItemToNameIndex(iItemInternal);
 
 				/* The files' type may have changed, so retrieve the files'
 				icon again. */
@@ -563,11 +646,18 @@ void CShellBrowser::RenameItem(int iItemInternal,const TCHAR *szNewFileName)
 				if(res != 0)
 				{
 					/* Locate the item within the listview. */
-					lvfi.flags	= LVFI_PARAM;
-					lvfi.lParam	= iItemInternal;
-					iItem = ListView_FindItem(m_hListView,-1,&lvfi);
+					auto iItem = LocateItemByInternalIndex(iItemInternal);
 
-					if(iItem != -1)
+					if(iItem && m_ownerDataListView)
+					{
+						InvalidateOwnerDataItem(iItemInternal);
+
+						if(IsFileFiltered(iItemInternal))
+						{
+							RemoveFilteredItem(*iItem,iItemInternal);
+						}
+					}
+					else if(iItem)
 					{
 						BasicItemInfo_t basicItemInfo = getBasicItemInfo(iItemInternal);
 						std::wstring filename = ProcessItemFileName(basicItemInfo, m_config->globalFolderSettings);
@@ -576,7 +666,7 @@ void CShellBrowser::RenameItem(int iItemInternal,const TCHAR *szNewFileName)
 						StringCchCopy(filenameCopy, SIZEOF_ARRAY(filenameCopy), filename.c_str());
 
 						lvItem.mask			= LVIF_TEXT|LVIF_IMAGE|LVIF_STATE;
-						lvItem.iItem		= iItem;
+						lvItem.iItem		= *iItem;
 						lvItem.iSubItem		= 0;
 						lvItem.iImage		= shfi.iIcon;
 						lvItem.pszText		= filenameCopy;
@@ -593,7 +683,7 @@ void CShellBrowser::RenameItem(int iItemInternal,const TCHAR *szNewFileName)
 						/* TODO: Does the file need to be filtered out? */
 						if(IsFileFiltered(iItemInternal))
 						{
-							RemoveFilteredItem(iItem,iItemInternal);
+							RemoveFilteredItem(*iItem,iItemInternal);
 						}
 					}
 
@@ -608,11 +698,78 @@ void CShellBrowser::RenameItem(int iItemInternal,const TCHAR *szNewFileName)
 	}
 	else
 	{
-		StringCchCopy(m_itemInfoMap.at(iItemInternal).szDisplayName,
-			SIZEOF_ARRAY(m_itemInfoMap.at(iItemInternal).szDisplayName), szNewFileName);
+		m_itemStore.setDisplayName(iItemInternal,szNewFileName);
+		InvalidateItemGroup(iItemInternal);
+
+		RemoveItemFromNameIndex(iItemInternal);
+		m_itemStore.setFileName(iItemInternal,szNewFileName);
+		AddItemToNameIndex(iItemInternal);
+	}
+}
+
+/* Compares the current items against the supplied find data
+for the directory. Only items that have actually changed are
+updated. Used when a snapshot of the folder is restored and when
+change notifications have been lost, in which case the individual
+changes aren't known. */
+void CShellBrowser::ReconcileItems(FindDataMap_t directoryFindData)
+{
+	std::vector<int> removedItems;
+	std::vector<std::wstring> modifiedItems;
+
+	for(int internalIndex : m_itemStore.getItemIds())
+	{
+		const TCHAR *fileName = m_itemStore.getFileName(internalIndex);
+		auto itr = directoryFindData.find(fileName);
+
+		if(itr == directoryFindData.end())
+		{
+			removedItems.push_back(internalIndex);
+			continue;
+		}
+
+		const WIN32_FIND_DATA &wfdNew = itr->second;
+
+		ULARGE_INTEGER newFileSize;
+		newFileSize.LowPart = wfdNew.nFileSizeLow;
+		newFileSize.HighPart = wfdNew.nFileSizeHigh;
+
+		if(CompareFileTime(&m_itemStore.getLastWriteTime(internalIndex),&wfdNew.ftLastWriteTime) != 0 ||
+			m_itemStore.getSize(internalIndex) != newFileSize.QuadPart ||
+			m_itemStore.getAttributes(internalIndex) != wfdNew.dwFileAttributes)
+		{
+			modifiedItems.push_back(fileName);
+		}
+
+		/* Anything left over once all the existing items have
+		been checked is new. */
+		directoryFindData.erase(itr);
+	}
+
+	for(int internalIndex : removedItems)
+	{
+		if(LocateItemByInternalIndex(internalIndex))
+		{
+			RemoveItem(internalIndex);
+		}
+		else
+		{
+			/* The item has been filtered out, so isn't
+			currently shown. */
+			m_itemFilter.removeItem(internalIndex);
+			InvalidateItemGroup(internalIndex);
+			RemoveItemFromNameIndex(internalIndex);
+			m_itemStore.removeItem(internalIndex);
+		}
+	}
 
-		StringCchCopy(m_itemInfoMap.at(iItemInternal).wfd.cFileName,
-			SIZEOF_ARRAY(m_itemInfoMap.at(iItemInternal).wfd.cFileName),
-			szNewFileName);
+	for(const auto &fileName : modifiedItems)
+	{
+		ModifyItemInternal(fileName.c_str());
+	}
+
+	for(const auto &findData : directoryFindData)
+	{
+		OnFileActionAdded(findData.first.c_str());
 	}
 }
\ No newline at end of file
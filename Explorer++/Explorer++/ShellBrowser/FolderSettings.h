@@ -34,6 +34,8 @@ struct GlobalFolderSettings
 	SizeDisplayFormat_t sizeDisplayFormat;
 	BOOL oneClickActivate;
 	UINT oneClickActivateHoverTime;
+	UINT parallelSortThreshold;
+	BOOL virtualListView;
 
 	FolderColumns folderColumns;
 };
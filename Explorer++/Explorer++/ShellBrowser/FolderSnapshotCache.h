@@ -0,0 +1,71 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <ShlObj.h>
+#include <list>
+#include <memory>
+
+// Holds the snapshots of the most recently visited folders, most recent
+// first. Each snapshot is expected to have a pidlDirectory member
+// (holding a PIDLPointer), which identifies the folder it belongs to.
+//
+// Snapshots are moved in and out of the cache, rather than copied, since
+// they own all the items in a folder.
+template <typename T>
+class FolderSnapshotCache
+{
+public:
+
+	explicit FolderSnapshotCache(size_t maxSnapshots) :
+		m_maxSnapshots(maxSnapshots)
+	{
+
+	}
+
+	// Replaces any existing snapshot of the same folder. Once the cache
+	// is full, the least recently saved snapshot is discarded.
+	void save(std::unique_ptr<T> snapshot)
+	{
+		take(snapshot->pidlDirectory.get());
+
+		m_snapshots.push_front(std::move(snapshot));
+
+		if (m_snapshots.size() > m_maxSnapshots)
+		{
+			m_snapshots.pop_back();
+		}
+	}
+
+	// Removes the snapshot for the specified folder from the cache and
+	// returns it. Returns null if there's no snapshot.
+	std::unique_ptr<T> take(PCIDLIST_ABSOLUTE pidlDirectory)
+	{
+		for (auto itr = m_snapshots.begin(); itr != m_snapshots.end(); ++itr)
+		{
+			if (!ILIsEqual((*itr)->pidlDirectory.get(), pidlDirectory))
+			{
+				continue;
+			}
+
+			std::unique_ptr<T> snapshot = std::move(*itr);
+			m_snapshots.erase(itr);
+
+			return snapshot;
+		}
+
+		return nullptr;
+	}
+
+	size_t size() const
+	{
+		return m_snapshots.size();
+	}
+
+private:
+
+	const size_t m_maxSnapshots;
+	std::list<std::unique_ptr<T>> m_snapshots;
+};
@@ -0,0 +1,204 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+/* Keeps the state of recently visited folders, so that going
+back (or forward) to one of them doesn't require the folder to be
+enumerated, sorted and have its icons and column text retrieved all
+over again. The item store (along with the other per-folder data) is
+moved into the snapshot when the folder is left and moved back when
+it's restored, so neither step involves copying the items.
+
+A restored folder is shown immediately, then reconciled with the
+directory's current contents once its find data has been read on the
+enumeration thread (see ProcessEnumerationResults()). */
+
+#include "stdafx.h"
+#include "iShellView.h"
+#include "../Helper/Logging.h"
+
+/* Must be called before the listview is cleared, since the order,
+selection and scroll position of the items are read from it. */
+void CShellBrowser::SaveFolderSnapshot()
+{
+	auto snapshot = std::make_unique<FolderSnapshot_t>();
+	snapshot->pidlDirectory.reset(ILClone(m_pidlDirectory));
+	snapshot->showHidden = m_folderSettings.showHidden;
+	snapshot->sortMode = m_folderSettings.sortMode;
+	snapshot->sortAscending = m_folderSettings.sortAscending;
+	snapshot->viewMode = m_folderSettings.viewMode;
+
+	int nRows = m_itemRows.size();
+	snapshot->shownItems.reserve(nRows);
+
+	for(int i = 0;i < nRows;i++)
+	{
+		snapshot->shownItems.push_back(m_itemRows.getInternalIndex(i));
+	}
+
+	for(int internalIndex : m_itemStore.getItemIds())
+	{
+		if(!m_itemRows.getRow(internalIndex))
+		{
+			snapshot->hiddenItems.push_back(internalIndex);
+		}
+	}
+
+	int iItem = -1;
+
+	while((iItem = ListView_GetNextItem(m_hListView,iItem,LVNI_SELECTED)) != -1)
+	{
+		snapshot->selectedItems.push_back(m_itemRows.getInternalIndex(iItem));
+	}
+
+	int iFocused = ListView_GetNextItem(m_hListView,-1,LVNI_FOCUSED);
+	snapshot->focusedItem = (iFocused != -1) ? m_itemRows.getInternalIndex(iFocused) : -1;
+
+	snapshot->topItem = -1;
+
+	POINT origin;
+
+	if(ListView_GetOrigin(m_hListView,&origin))
+	{
+		snapshot->scrollOrigin = origin;
+	}
+	else
+	{
+		int topIndex = ListView_GetTopIndex(m_hListView);
+
+		if(topIndex >= 0 && topIndex < nRows)
+		{
+			snapshot->topItem = m_itemRows.getInternalIndex(topIndex);
+		}
+	}
+
+	/* The members that are moved from here are cleared by
+	ResetFolderMemoryAllocations(). */
+	snapshot->itemStore = std::move(m_itemStore);
+	snapshot->itemNameIndex = std::move(m_itemNameIndex);
+	snapshot->itemIDCounter = m_itemIDCounter;
+	snapshot->cachedFolderSizes = std::move(m_cachedFolderSizes);
+	snapshot->ownerDataItems = std::move(m_ownerDataItems);
+
+	/* Any older snapshot of the same folder is out of date,
+	so will be replaced. */
+	m_folderSnapshots.save(std::move(snapshot));
+}
+
+/* Removes the snapshot for the specified folder from the cache
+and returns it. Returns null if there's no snapshot, or if it
+can't be used with the current settings. */
+std::unique_ptr<CShellBrowser::FolderSnapshot_t> CShellBrowser::TakeFolderSnapshot(LPCITEMIDLIST pidlDirectory)
+{
+	std::unique_ptr<FolderSnapshot_t> snapshot = m_folderSnapshots.take(pidlDirectory);
+
+	if(!snapshot)
+	{
+		return nullptr;
+	}
+
+	/* Hidden items are only enumerated when they're shown,
+	so the snapshot may be missing items. */
+	if(snapshot->showHidden != m_folderSettings.showHidden)
+	{
+		return nullptr;
+	}
+
+	return snapshot;
+}
+
+/* Shows the items from the snapshot in the listview. Filtering is
+reapplied, since the filter may have changed in the meantime. */
+void CShellBrowser::RestoreFolderSnapshot(std::unique_ptr<FolderSnapshot_t> snapshot)
+{
+	m_itemStore = std::move(snapshot->itemStore);
+	m_itemNameIndex = std::move(snapshot->itemNameIndex);
+	m_itemIDCounter = snapshot->itemIDCounter;
+	m_cachedFolderSizes = std::move(snapshot->cachedFolderSizes);
+
+	if(m_ownerDataListView)
+	{
+		m_ownerDataItems = std::move(snapshot->ownerDataItems);
+
+		/* The thumbnails imagelist is recreated for each folder,
+		so only icon indices can be reused. */
+		if(m_folderSettings.viewMode != snapshot->viewMode
+			|| m_folderSettings.viewMode == +ViewMode::Thumbnails)
+		{
+			ResetOwnerDataImages();
+		}
+	}
+
+	for(const auto *items : {&snapshot->shownItems,&snapshot->hiddenItems})
+	{
+		for(int internalIndex : *items)
+		{
+			m_nAwaitingAdd++;
+			AddItemInternal(-1,internalIndex,FALSE);
+		}
+	}
+
+	InsertAwaitingItems(m_folderSettings.showInGroups);
+
+	/* The items are already in order, unless the sort settings
+	have changed or a previously hidden item is now shown (in which
+	case it will have been added at the end). Groups are always
+	rebuilt by sorting. */
+	bool sorted = (snapshot->sortMode == m_folderSettings.sortMode)
+		&& (snapshot->sortAscending == m_folderSettings.sortAscending)
+		&& !m_folderSettings.showInGroups;
+
+	for(int internalIndex : snapshot->hiddenItems)
+	{
+		if(!sorted)
+		{
+			break;
+		}
+
+		sorted = !m_itemFilter.isItemVisible(internalIndex);
+	}
+
+	if(!sorted)
+	{
+		SortFolder(m_folderSettings.sortMode);
+	}
+
+	for(int internalIndex : snapshot->selectedItems)
+	{
+		auto iRow = LocateItemByInternalIndex(internalIndex);
+
+		if(iRow)
+		{
+			ListView_SetItemState(m_hListView,*iRow,LVIS_SELECTED,LVIS_SELECTED);
+		}
+	}
+
+	auto iFocusedRow = LocateItemByInternalIndex(snapshot->focusedItem);
+	ListView_SetItemState(m_hListView,iFocusedRow ? *iFocusedRow : 0,LVIS_FOCUSED,LVIS_FOCUSED);
+
+	if(snapshot->scrollOrigin && snapshot->viewMode == m_folderSettings.viewMode)
+	{
+		ListView_Scroll(m_hListView,snapshot->scrollOrigin->x,snapshot->scrollOrigin->y);
+	}
+	else
+	{
+		auto iTopRow = LocateItemByInternalIndex(snapshot->topItem);
+
+		if(iTopRow && m_folderSettings.viewMode == +ViewMode::Details)
+		{
+			/* In details view, the listview scrolls by whole
+			rows, so the top row can be restored exactly. */
+			RECT rcItem;
+			ListView_GetItemRect(m_hListView,0,&rcItem,LVIR_BOUNDS);
+			ListView_Scroll(m_hListView,0,*iTopRow * (rcItem.bottom - rcItem.top));
+		}
+		else if(iTopRow)
+		{
+			ListView_EnsureVisible(m_hListView,*iTopRow,FALSE);
+		}
+	}
+
+	LOG(debug) << _T("ShellBrowser - Restored ") << m_itemRows.size() << _T(" items for \"") << m_CurDir << _T("\"");
+
+	SendMessage(m_hOwner,WM_USER_DIRECTORYMODIFIED,m_ID,0);
+}
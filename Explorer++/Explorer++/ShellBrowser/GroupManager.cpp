@@ -17,13 +17,30 @@
 #include <iphlpapi.h>
 #include <propkey.h>
 #include <cassert>
-#include <list>
 
 namespace
 {
 	static const UINT KBYTE = 1024;
 	static const UINT MBYTE = 1024 * 1024;
 	static const UINT GBYTE = 1024 * 1024 *1024;
+
+	/* Headers that depend on the current date (e.g.
+	"Yesterday") or on live drive information can change
+	without the item changing, so they can't be cached. */
+	bool CanCacheGroupHeaders(SortMode sortMode)
+	{
+		switch(sortMode)
+		{
+		case SortMode::DateModified:
+		case SortMode::Created:
+		case SortMode::Accessed:
+		case SortMode::FreeSpace:
+			return false;
+
+		default:
+			return true;
+		}
+	}
 }
 
 #define GROUP_BY_DATECREATED	0
@@ -71,8 +88,8 @@ INT CALLBACK CShellBrowser::GroupNameComparisonStub(INT Group1_ID, INT Group2_ID
 
 INT CALLBACK CShellBrowser::GroupNameComparison(INT Group1_ID, INT Group2_ID)
 {
-	TCHAR *pszGroupHeader1 = NULL;
-	TCHAR *pszGroupHeader2 = NULL;
+	const TCHAR *pszGroupHeader1 = NULL;
+	const TCHAR *pszGroupHeader2 = NULL;
 	int iReturnValue;
 
 	pszGroupHeader1 = RetrieveGroupHeader(Group1_ID);
@@ -114,8 +131,8 @@ INT CALLBACK CShellBrowser::GroupFreeSpaceComparisonStub(INT Group1_ID, INT Grou
 
 INT CALLBACK CShellBrowser::GroupFreeSpaceComparison(INT Group1_ID, INT Group2_ID)
 {
-	TCHAR *pszGroupHeader1 = NULL;
-	TCHAR *pszGroupHeader2 = NULL;
+	const TCHAR *pszGroupHeader1 = NULL;
+	const TCHAR *pszGroupHeader2 = NULL;
 	int iReturnValue;
 
 	pszGroupHeader1 = RetrieveGroupHeader(Group1_ID);
@@ -149,19 +166,16 @@ INT CALLBACK CShellBrowser::GroupFreeSpaceComparison(INT Group1_ID, INT Group2_I
 	return iReturnValue;
 }
 
-TCHAR *CShellBrowser::RetrieveGroupHeader(int iGroupId)
+const TCHAR *CShellBrowser::RetrieveGroupHeader(int iGroupId) const
 {
-	std::list<TypeGroup_t>::iterator	itr;
+	const ListViewGroupSet::Group *group = m_groups.getGroup(iGroupId);
 
-	for(itr = m_GroupList.begin();itr != m_GroupList.end();itr++)
+	if(group == nullptr)
 	{
-		if(itr->iGroupId == iGroupId)
-		{
-			return itr->szHeader;
-		}
+		return NULL;
 	}
 
-	return NULL;
+	return group->header.c_str();
 }
 
 /*
@@ -170,9 +184,48 @@ TCHAR *CShellBrowser::RetrieveGroupHeader(int iGroupId)
  */
 int CShellBrowser::DetermineItemGroup(int iItemInternal)
 {
-	PFNLVGROUPCOMPARE	pfnGroupCompare = NULL;
-	TCHAR				szGroupHeader[512];
-	int					iGroupId;
+	PFNLVGROUPCOMPARE pfnGroupCompare;
+
+	if(m_folderSettings.sortMode == +SortMode::FreeSpace)
+	{
+		pfnGroupCompare = GroupFreeSpaceComparisonStub;
+	}
+	else
+	{
+		pfnGroupCompare = GroupNameComparisonStub;
+	}
+
+	if(!CanCacheGroupHeaders(m_folderSettings.sortMode))
+	{
+		return CheckGroup(DetermineItemGroupHeader(iItemInternal),pfnGroupCompare);
+	}
+
+	/* The cached headers are only valid for the sort
+	mode they were built under. */
+	if(!m_itemGroupHeadersSortMode || *m_itemGroupHeadersSortMode != m_folderSettings.sortMode)
+	{
+		m_itemGroupHeaders.clear();
+		m_itemGroupHeadersSortMode = m_folderSettings.sortMode;
+	}
+
+	auto itr = m_itemGroupHeaders.find(iItemInternal);
+
+	if(itr == m_itemGroupHeaders.end())
+	{
+		itr = m_itemGroupHeaders.emplace(iItemInternal, DetermineItemGroupHeader(iItemInternal)).first;
+	}
+
+	return CheckGroup(itr->second,pfnGroupCompare);
+}
+
+/*
+ * Builds the header text for the group the
+ * specified item belongs to, under the current
+ * sort mode.
+ */
+std::wstring CShellBrowser::DetermineItemGroupHeader(int iItemInternal) const
+{
+	TCHAR szGroupHeader[512] = _T("");
 
 	BasicItemInfo_t basicItemInfo = getBasicItemInfo(iItemInternal);
 
@@ -180,32 +233,26 @@ int CShellBrowser::DetermineItemGroup(int iItemInternal)
 	{
 		case SortMode::Name:
 			DetermineItemNameGroup(iItemInternal,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::Type:
 			DetermineItemTypeGroupVirtual(iItemInternal,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::Size:
 			DetermineItemSizeGroup(iItemInternal,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::DateModified:
 			DetermineItemDateGroup(iItemInternal,GROUP_BY_DATEMODIFIED,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::TotalSize:
 			DetermineItemTotalSizeGroup(iItemInternal,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::FreeSpace:
 			DetermineItemFreeSpaceGroup(iItemInternal,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupFreeSpaceComparisonStub;
 			break;
 
 		case SortMode::DateDeleted:
@@ -213,47 +260,38 @@ int CShellBrowser::DetermineItemGroup(int iItemInternal)
 
 		case SortMode::OriginalLocation:
 			DetermineItemSummaryGroup(basicItemInfo, &SCID_ORIGINAL_LOCATION, szGroupHeader, SIZEOF_ARRAY(szGroupHeader), m_config->globalFolderSettings);
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::Attributes:
 			DetermineItemAttributeGroup(iItemInternal,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::ShortName:
 			DetermineItemNameGroup(iItemInternal,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::Owner:
 			DetermineItemOwnerGroup(iItemInternal,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::ProductName:
-			DetermineItemVersionGroup(iItemInternal,_T("ProductName"),szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
+			DetermineItemVersionGroup(iItemInternal,CM_PRODUCTNAME,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
 			break;
 
 		case SortMode::Company:
-			DetermineItemVersionGroup(iItemInternal,_T("CompanyName"),szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
+			DetermineItemVersionGroup(iItemInternal,CM_COMPANY,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
 			break;
 
 		case SortMode::Description:
-			DetermineItemVersionGroup(iItemInternal,_T("FileDescription"),szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
+			DetermineItemVersionGroup(iItemInternal,CM_DESCRIPTION,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
 			break;
 
 		case SortMode::FileVersion:
-			DetermineItemVersionGroup(iItemInternal,_T("FileVersion"),szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
+			DetermineItemVersionGroup(iItemInternal,CM_FILEVERSION,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
 			break;
 
 		case SortMode::ProductVersion:
-			DetermineItemVersionGroup(iItemInternal,_T("ProductVersion"),szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
+			DetermineItemVersionGroup(iItemInternal,CM_PRODUCTVERSION,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
 			break;
 
 		case SortMode::ShortcutTo:
@@ -264,63 +302,51 @@ int CShellBrowser::DetermineItemGroup(int iItemInternal)
 
 		case SortMode::Extension:
 			DetermineItemExtensionGroup(iItemInternal,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::Created:
 			DetermineItemDateGroup(iItemInternal,GROUP_BY_DATECREATED,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::Accessed:
 			DetermineItemDateGroup(iItemInternal,GROUP_BY_DATEACCESSED,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::Title:
 			DetermineItemSummaryGroup(basicItemInfo,&PKEY_Title,szGroupHeader,SIZEOF_ARRAY(szGroupHeader), m_config->globalFolderSettings);
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::Subject:
 			DetermineItemSummaryGroup(basicItemInfo,&PKEY_Subject,szGroupHeader,SIZEOF_ARRAY(szGroupHeader), m_config->globalFolderSettings);
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::Authors:
 			DetermineItemSummaryGroup(basicItemInfo,&PKEY_Author,szGroupHeader,SIZEOF_ARRAY(szGroupHeader), m_config->globalFolderSettings);
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::Keywords:
 			DetermineItemSummaryGroup(basicItemInfo,&PKEY_Keywords,szGroupHeader,SIZEOF_ARRAY(szGroupHeader), m_config->globalFolderSettings);
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::Comments:
 			DetermineItemSummaryGroup(basicItemInfo,&PKEY_Comment,szGroupHeader,SIZEOF_ARRAY(szGroupHeader), m_config->globalFolderSettings);
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 
 		case SortMode::CameraModel:
-			DetermineItemCameraPropertyGroup(iItemInternal,PropertyTagEquipModel,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
+			DetermineItemCameraPropertyGroup(iItemInternal,CM_CAMERAMODEL,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
 			break;
 
 		case SortMode::DateTaken:
-			DetermineItemCameraPropertyGroup(iItemInternal,PropertyTagDateTime,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
+			DetermineItemCameraPropertyGroup(iItemInternal,CM_DATETAKEN,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
 			break;
 
 		case SortMode::Width:
-			DetermineItemCameraPropertyGroup(iItemInternal,PropertyTagImageWidth,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
+			DetermineItemCameraPropertyGroup(iItemInternal,CM_WIDTH,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
 			break;
 
 		case SortMode::Height:
-			DetermineItemCameraPropertyGroup(iItemInternal,PropertyTagImageHeight,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
+			DetermineItemCameraPropertyGroup(iItemInternal,CM_HEIGHT,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
 			break;
 
 
@@ -329,7 +355,6 @@ int CShellBrowser::DetermineItemGroup(int iItemInternal)
 
 		case SortMode::FileSystem:
 			DetermineItemFileSystemGroup(iItemInternal,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		case SortMode::NumPrinterDocuments:
@@ -346,7 +371,6 @@ int CShellBrowser::DetermineItemGroup(int iItemInternal)
 
 		case SortMode::NetworkAdapterStatus:
 			DetermineItemNetworkStatus(iItemInternal,szGroupHeader,SIZEOF_ARRAY(szGroupHeader));
-			pfnGroupCompare = GroupNameComparisonStub;
 			break;
 
 		default:
@@ -354,78 +378,73 @@ int CShellBrowser::DetermineItemGroup(int iItemInternal)
 			break;
 	}
 
-	iGroupId = CheckGroup(szGroupHeader,pfnGroupCompare);
-
-	return iGroupId;
+	return szGroupHeader;
 }
 
 /*
- * Checks if a group with specified id is already
- * in the listview. If not, the group is inserted
- * into its sorted position with the specified
- * header text.
+ * Checks if a group with the specified header is
+ * already in the listview. If not, the group is
+ * inserted into its sorted position with the
+ * specified header text.
+ *
+ * The item count shown in each header isn't updated
+ * here. Call UpdateGroupHeaders once the current set
+ * of items has been added.
  */
-int CShellBrowser::CheckGroup(const TCHAR *szGroupHeader,
+int CShellBrowser::CheckGroup(const std::wstring &groupHeader,
 PFNLVGROUPCOMPARE pfnGroupCompare)
 {
-	LVINSERTGROUPSORTED			lvigs;
-	std::list<TypeGroup_t>::iterator	itr;
-	TypeGroup_t					TypeGroup;
-	WCHAR						wszHeader[512];
-	BOOL						bFoundGroup = FALSE;
-	int							iGroupId = -1;
+	auto result = m_groups.addItem(groupHeader);
+	int iGroupId = result.first;
 
-	/* Check to see if the group has already been inserted... */
-	for(itr = m_GroupList.begin();itr != m_GroupList.end();itr++)
+	if(!result.second)
 	{
-		if(lstrcmpi(szGroupHeader,itr->szHeader) == 0)
-		{
-			LVGROUP lvGroup;
-
-			bFoundGroup = TRUE;
-			iGroupId = itr->iGroupId;
-			itr->nItems++;
-
-			StringCchPrintf(wszHeader, SIZEOF_ARRAY(wszHeader),
-				_T("%s (%d)"), szGroupHeader, itr->nItems);
+		return iGroupId;
+	}
 
-			lvGroup.cbSize = sizeof(LVGROUP);
-			lvGroup.mask = LVGF_HEADER;
-			lvGroup.pszHeader = wszHeader;
+	/* The group is not in the listview, so insert it in. */
+	LVINSERTGROUPSORTED lvigs;
+	lvigs.lvGroup.cbSize	= sizeof(LVGROUP);
+	lvigs.lvGroup.mask		= LVGF_HEADER | LVGF_GROUPID | LVGF_STATE;
+	lvigs.lvGroup.state		= LVGS_COLLAPSIBLE;
+	lvigs.lvGroup.pszHeader	= const_cast<LPWSTR>(groupHeader.c_str());
+	lvigs.lvGroup.iGroupId	= iGroupId;
+	lvigs.lvGroup.stateMask	= 0;
+	lvigs.pfnGroupCompare	= pfnGroupCompare;
+	lvigs.pvData			= reinterpret_cast<void *>(this);
 
-			ListView_SetGroupInfo(m_hListView, iGroupId, &lvGroup);
+	ListView_InsertGroupSorted(m_hListView,&lvigs);
 
-			break;
-		}
-	}
+	return iGroupId;
+}
 
-	if(!bFoundGroup)
+/*
+ * Rewrites the header of each group whose item
+ * count has changed since it was last shown.
+ */
+void CShellBrowser::UpdateGroupHeaders(void)
+{
+	for(const auto &group : m_groups.takeChangedGroups())
 	{
-		iGroupId = m_iGroupId++;
-
-		StringCchCopy(TypeGroup.szHeader,SIZEOF_ARRAY(TypeGroup.szHeader),
-			szGroupHeader);
-		TypeGroup.iGroupId = iGroupId;
-		TypeGroup.nItems = 1;
-		m_GroupList.push_back(TypeGroup);
-
+		WCHAR wszHeader[512];
 		StringCchPrintf(wszHeader, SIZEOF_ARRAY(wszHeader),
-			_T("%s (%d)"), szGroupHeader, TypeGroup.nItems);
-
-		/* The group is not in the listview, so insert it in. */
-		lvigs.lvGroup.cbSize	= sizeof(LVGROUP);
-		lvigs.lvGroup.mask		= LVGF_HEADER | LVGF_GROUPID | LVGF_STATE;
-		lvigs.lvGroup.state		= LVGS_COLLAPSIBLE;
-		lvigs.lvGroup.pszHeader	= wszHeader;
-		lvigs.lvGroup.iGroupId	= iGroupId;
-		lvigs.lvGroup.stateMask	= 0;
-		lvigs.pfnGroupCompare	= pfnGroupCompare;
-		lvigs.pvData			= reinterpret_cast<void *>(this);
+			_T("%s (%d)"), group.header.c_str(), group.numItems);
 
-		ListView_InsertGroupSorted(m_hListView,&lvigs);
+		LVGROUP lvGroup;
+		lvGroup.cbSize = sizeof(LVGROUP);
+		lvGroup.mask = LVGF_HEADER;
+		lvGroup.pszHeader = wszHeader;
+		ListView_SetGroupInfo(m_hListView, group.id, &lvGroup);
 	}
+}
 
-	return iGroupId;
+/*
+ * Should be called whenever an item changes in
+ * a way that may affect the group it belongs to.
+ */
+void CShellBrowser::InvalidateItemGroup(int iItemInternal)
+{
+	m_itemGroupHeaders.erase(iItemInternal);
 }
 
 /*
@@ -438,11 +457,10 @@ PFNLVGROUPCOMPARE pfnGroupCompare)
 void CShellBrowser::DetermineItemNameGroup(int iItemInternal,TCHAR *szGroupHeader,int cchMax) const
 {
 	TCHAR ch;
-	std::list<TypeGroup_t>::iterator itr;
 
 	/* Take the first character of the item's name,
 	and use it to determine which group it belongs to. */
-	ch = m_itemInfoMap.at(iItemInternal).szDisplayName[0];
+	ch = m_itemStore.getDisplayName(iItemInternal)[0];
 
 	if(iswalpha(ch))
 	{
@@ -470,7 +488,7 @@ void CShellBrowser::DetermineItemSizeGroup(int iItemInternal,TCHAR *szGroupHeade
 	int iSize;
 	int i;
 
-	if((m_itemInfoMap.at(iItemInternal).wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+	if((m_itemStore.getAttributes(iItemInternal) & FILE_ATTRIBUTE_DIRECTORY)
 	== FILE_ATTRIBUTE_DIRECTORY)
 	{
 		/* This item is a folder. */
@@ -480,8 +498,7 @@ void CShellBrowser::DetermineItemSizeGroup(int iItemInternal,TCHAR *szGroupHeade
 	{
 		i = nGroups - 1;
 
-		double FileSize = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeLow +
-		(m_itemInfoMap.at(iItemInternal).wfd.nFileSizeHigh * pow(2.0,32.0));
+		double FileSize = static_cast<double>(m_itemStore.getSize(iItemInternal));
 
 		/* Check which of the size groups this item belongs to. */
 		while(FileSize < SizeGroupLimits[i]
@@ -526,7 +543,7 @@ void CShellBrowser::DetermineItemTotalSizeGroup(int iItemInternal,TCHAR *szGroup
 
 	GetIdlFromParsingName(m_CurDir,&pidlDirectory);
 
-	SHBindToParent(m_itemInfoMap.at(iItemInternal).pidlComplete.get(), IID_PPV_ARGS(&pShellFolder), (LPCITEMIDLIST *) &pidlRelative);
+	SHBindToParent(m_itemStore.getPidlComplete(iItemInternal), IID_PPV_ARGS(&pShellFolder), (LPCITEMIDLIST *) &pidlRelative);
 
 	pShellFolder->GetDisplayNameOf(pidlRelative,SHGDN_FORPARSING,&str);
 	StrRetToBuf(&str,pidlRelative,szItem,SIZEOF_ARRAY(szItem));
@@ -559,9 +576,8 @@ void CShellBrowser::DetermineItemTotalSizeGroup(int iItemInternal,TCHAR *szGroup
 void CShellBrowser::DetermineItemTypeGroupVirtual(int iItemInternal,TCHAR *szGroupHeader,int cchMax) const
 {
 	SHFILEINFO shfi;
-	std::list<TypeGroup_t>::iterator itr;
 
-	SHGetFileInfo((LPTSTR)m_itemInfoMap.at(iItemInternal).pidlComplete.get(),
+	SHGetFileInfo((LPTSTR)m_itemStore.getPidlComplete(iItemInternal),
 		0,&shfi,sizeof(shfi),SHGFI_PIDL|SHGFI_TYPENAME);
 
 	StringCchCopy(szGroupHeader,cchMax,shfi.szTypeName);
@@ -578,15 +594,15 @@ void CShellBrowser::DetermineItemDateGroup(int iItemInternal,int iDateType,TCHAR
 	switch(iDateType)
 	{
 	case GROUP_BY_DATEMODIFIED:
-		ret = FileTimeToLocalSystemTime(&m_itemInfoMap.at(iItemInternal).wfd.ftLastWriteTime, &stFileTime);
+		ret = FileTimeToLocalSystemTime(&m_itemStore.getLastWriteTime(iItemInternal), &stFileTime);
 		break;
 
 	case GROUP_BY_DATECREATED:
-		ret = FileTimeToLocalSystemTime(&m_itemInfoMap.at(iItemInternal).wfd.ftCreationTime, &stFileTime);
+		ret = FileTimeToLocalSystemTime(&m_itemStore.getCreationTime(iItemInternal), &stFileTime);
 		break;
 
 	case GROUP_BY_DATEACCESSED:
-		ret = FileTimeToLocalSystemTime(&m_itemInfoMap.at(iItemInternal).wfd.ftLastAccessTime, &stFileTime);
+		ret = FileTimeToLocalSystemTime(&m_itemStore.getLastAccessTime(iItemInternal), &stFileTime);
 		break;
 
 	default:
@@ -706,7 +722,6 @@ void CShellBrowser::DetermineItemSummaryGroup(const BasicItemInfo_t &itemInfo, c
 /* TODO: Need to sort based on percentage free. */
 void CShellBrowser::DetermineItemFreeSpaceGroup(int iItemInternal,TCHAR *szGroupHeader,int cchMax) const
 {
-	std::list<TypeGroup_t>::iterator itr;
 	LPITEMIDLIST pidlDirectory	= NULL;
 	TCHAR szFreeSpace[MAX_PATH];
 	IShellFolder *pShellFolder	= NULL;
@@ -719,7 +734,7 @@ void CShellBrowser::DetermineItemFreeSpaceGroup(int iItemInternal,TCHAR *szGroup
 	BOOL bRes = FALSE;
 
 	GetIdlFromParsingName(m_CurDir,&pidlDirectory);
-	SHBindToParent(m_itemInfoMap.at(iItemInternal).pidlComplete.get(),
+	SHBindToParent(m_itemStore.getPidlComplete(iItemInternal),
 		IID_PPV_ARGS(&pShellFolder), (LPCITEMIDLIST *)&pidlRelative);
 
 	pShellFolder->GetDisplayNameOf(pidlRelative,SHGDN_FORPARSING,&str);
@@ -757,11 +772,10 @@ void CShellBrowser::DetermineItemFreeSpaceGroup(int iItemInternal,TCHAR *szGroup
 void CShellBrowser::DetermineItemAttributeGroup(int iItemInternal,TCHAR *szGroupHeader,int cchMax) const
 {
 	TCHAR FullFileName[MAX_PATH];
-	std::list<TypeGroup_t>::iterator itr;
 	TCHAR szAttributes[32];
 
 	StringCchCopy(FullFileName,SIZEOF_ARRAY(FullFileName),m_CurDir);
-	PathAppend(FullFileName,m_itemInfoMap.at(iItemInternal).wfd.cFileName);
+	PathAppend(FullFileName,m_itemStore.getFileName(iItemInternal));
 
 	BuildFileAttributeString(FullFileName,szAttributes,
 		SIZEOF_ARRAY(szAttributes));
@@ -771,67 +785,33 @@ void CShellBrowser::DetermineItemAttributeGroup(int iItemInternal,TCHAR *szGroup
 
 void CShellBrowser::DetermineItemOwnerGroup(int iItemInternal,TCHAR *szGroupHeader,int cchMax) const
 {
-	TCHAR FullFileName[MAX_PATH];
-	std::list<TypeGroup_t>::iterator itr;
-	TCHAR szOwner[512];
-
-	StringCchCopy(FullFileName,SIZEOF_ARRAY(FullFileName),m_CurDir);
-	PathAppend(FullFileName,m_itemInfoMap.at(iItemInternal).wfd.cFileName);
-
-	BOOL ret = GetFileOwner(FullFileName,szOwner,SIZEOF_ARRAY(szOwner));
-
-	if(!ret)
-	{
-		StringCchCopy(szOwner,SIZEOF_ARRAY(szOwner),EMPTY_STRING);
-	}
-
-	StringCchCopy(szGroupHeader,cchMax,szOwner);
+	std::wstring owner = GetCachedColumnText(CM_OWNER,getBasicItemInfo(iItemInternal));
+	StringCchCopy(szGroupHeader,cchMax,owner.c_str());
 }
 
-void CShellBrowser::DetermineItemVersionGroup(int iItemInternal,TCHAR *szVersionType,TCHAR *szGroupHeader,int cchMax) const
+void CShellBrowser::DetermineItemVersionGroup(int iItemInternal,unsigned int ColumnID,TCHAR *szGroupHeader,int cchMax) const
 {
-	BOOL bGroupFound = FALSE;
-	TCHAR FullFileName[MAX_PATH];
-	std::list<TypeGroup_t>::iterator itr;
-	TCHAR szVersion[512];
-	BOOL bVersionInfoObtained;
-
-	StringCchCopy(FullFileName,SIZEOF_ARRAY(FullFileName),m_CurDir);
-	PathAppend(FullFileName,m_itemInfoMap.at(iItemInternal).wfd.cFileName);
-
-	bVersionInfoObtained = GetVersionInfoString(FullFileName,
-		szVersionType,szVersion,SIZEOF_ARRAY(szVersion));
-
-	bGroupFound = FALSE;
+	std::wstring version = GetCachedColumnText(ColumnID,getBasicItemInfo(iItemInternal));
 
-	if(!bVersionInfoObtained)
-		StringCchCopy(szVersion,SIZEOF_ARRAY(szVersion),_T("Unspecified"));
+	if(version.empty())
+		version = _T("Unspecified");
 
-	StringCchCopy(szGroupHeader,cchMax,szVersion);
+	StringCchCopy(szGroupHeader,cchMax,version.c_str());
 }
 
-void CShellBrowser::DetermineItemCameraPropertyGroup(int iItemInternal,PROPID PropertyId,TCHAR *szGroupHeader,int cchMax) const
+void CShellBrowser::DetermineItemCameraPropertyGroup(int iItemInternal,unsigned int ColumnID,TCHAR *szGroupHeader,int cchMax) const
 {
-	TCHAR szFullFileName[MAX_PATH];
-	std::list<TypeGroup_t>::iterator itr;
-	TCHAR szProperty[512];
-	BOOL bRes;
-
-	StringCchCopy(szFullFileName,SIZEOF_ARRAY(szFullFileName),m_CurDir);
-	PathAppend(szFullFileName,m_itemInfoMap.at(iItemInternal).wfd.cFileName);
+	std::wstring property = GetCachedColumnText(ColumnID,getBasicItemInfo(iItemInternal));
 
-	bRes = ReadImageProperty(szFullFileName,PropertyId,szProperty,
-		SIZEOF_ARRAY(szProperty));
+	if(property.empty())
+		property = _T("Other");
 
-	if(!bRes)
-		StringCchCopy(szProperty,SIZEOF_ARRAY(szProperty),_T("Other"));
-
-	StringCchCopy(szGroupHeader,cchMax,szProperty);
+	StringCchCopy(szGroupHeader,cchMax,property.c_str());
 }
 
 void CShellBrowser::DetermineItemExtensionGroup(int iItemInternal,TCHAR *szGroupHeader,int cchMax) const
 {
-	if ((m_itemInfoMap.at(iItemInternal).wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY)
+	if ((m_itemStore.getAttributes(iItemInternal) & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY)
 	{
 		LoadString(m_hResourceModule, IDS_GROUPBY_EXTENSION_FOLDER, szGroupHeader, cchMax);
 		return;
@@ -839,7 +819,7 @@ void CShellBrowser::DetermineItemExtensionGroup(int iItemInternal,TCHAR *szGroup
 
 	TCHAR FullFileName[MAX_PATH];
 	StringCchCopy(FullFileName,SIZEOF_ARRAY(FullFileName),m_CurDir);
-	PathAppend(FullFileName,m_itemInfoMap.at(iItemInternal).wfd.cFileName);
+	PathAppend(FullFileName,m_itemStore.getFileName(iItemInternal));
 
 	TCHAR *pExt = PathFindExtension(FullFileName);
 
@@ -863,7 +843,7 @@ void CShellBrowser::DetermineItemFileSystemGroup(int iItemInternal,TCHAR *szGrou
 	BOOL bRoot;
 	BOOL bRes;
 
-	SHBindToParent(m_itemInfoMap.at(iItemInternal).pidlComplete.get(),
+	SHBindToParent(m_itemStore.getPidlComplete(iItemInternal),
 		IID_PPV_ARGS(&pShellFolder), (LPCITEMIDLIST *)&pidlRelative);
 
 	pShellFolder->GetDisplayNameOf(pidlRelative,SHGDN_FORPARSING,&str);
@@ -899,7 +879,6 @@ void CShellBrowser::DetermineItemNetworkStatus(int iItemInternal,TCHAR *szGroupH
 	can be removed. */
 	UNREFERENCED_PARAMETER(iItemInternal);
 
-	std::list<TypeGroup_t>::iterator itr;
 
 	TCHAR szStatus[32] = EMPTY_STRING;
 	IP_ADAPTER_ADDRESSES *pAdapterAddresses = NULL;
@@ -976,8 +955,7 @@ void CShellBrowser::MoveItemsIntoGroups(void)
 
 	SendMessage(m_hListView,WM_SETREDRAW,(WPARAM)FALSE,(LPARAM)NULL);
 
-	m_GroupList.clear();
-	m_iGroupId = 0;
+	m_groups.clear();
 
 	for(i = 0;i < nItems ;i++)
 	{
@@ -991,5 +969,7 @@ void CShellBrowser::MoveItemsIntoGroups(void)
 		InsertItemIntoGroup(i,iGroupId);
 	}
 
+	UpdateGroupHeaders();
+
 	SendMessage(m_hListView,WM_SETREDRAW,(WPARAM)TRUE,(LPARAM)NULL);
 }
\ No newline at end of file
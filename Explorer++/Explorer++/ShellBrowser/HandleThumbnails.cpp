@@ -10,12 +10,91 @@
 #include "../Helper/FileOperations.h"
 #include "../Helper/FolderSize.h"
 #include "../Helper/Helper.h"
+#include "../Helper/ImageHelper.h"
 #include "../Helper/ShellHelper.h"
+#include "../Helper/ThumbnailCache.h"
 #include <boost/scope_exit.hpp>
+#include <algorithm>
 #include <list>
 
 #pragma warning(disable:4459) // declaration of 'boost_scope_exit_aux_args' hides global declaration
 
+namespace
+{
+	boost::optional<ThumbnailCache::Key> GetThumbnailCacheKey(const BasicItemInfo_t &basicItemInfo,
+		int requestedWidth, int requestedHeight)
+	{
+		// Only items in the filesystem have a size and modification
+		// time that can be used to tell whether a cached thumbnail
+		// is still valid.
+		TCHAR path[MAX_PATH];
+		BOOL res = SHGetPathFromIDList(basicItemInfo.pidlComplete.get(), path);
+
+		if (!res)
+		{
+			return boost::none;
+		}
+
+		ULARGE_INTEGER fileSize;
+		fileSize.LowPart = basicItemInfo.wfd.nFileSizeLow;
+		fileSize.HighPart = basicItemInfo.wfd.nFileSizeHigh;
+
+		ULARGE_INTEGER lastWriteTime;
+		lastWriteTime.LowPart = basicItemInfo.wfd.ftLastWriteTime.dwLowDateTime;
+		lastWriteTime.HighPart = basicItemInfo.wfd.ftLastWriteTime.dwHighDateTime;
+
+		return ThumbnailCache::Key{ path, fileSize.QuadPart, lastWriteTime.QuadPart,
+			requestedWidth, requestedHeight };
+	}
+
+	boost::optional<ThumbnailCache::Bitmap> ConvertToCacheBitmap(HBITMAP hBitmap)
+	{
+		BITMAP bm;
+
+		if (GetObject(hBitmap, sizeof(bm), &bm) == 0)
+		{
+			return boost::none;
+		}
+
+		ThumbnailCache::Bitmap bitmap;
+		bitmap.width = bm.bmWidth;
+		bitmap.height = bm.bmHeight;
+		bitmap.pixels.resize(static_cast<size_t>(bm.bmWidth) * bm.bmHeight);
+
+		// A negative height requests the rows top-down.
+		BITMAPINFO bmi;
+		ImageHelper::InitBitmapInfo(&bmi, sizeof(bmi), bm.bmWidth, -bm.bmHeight, 32);
+
+		HDC hdc = GetDC(NULL);
+		int numLines = GetDIBits(hdc, hBitmap, 0, bm.bmHeight, bitmap.pixels.data(), &bmi, DIB_RGB_COLORS);
+		ReleaseDC(NULL, hdc);
+
+		if (numLines != bm.bmHeight)
+		{
+			return boost::none;
+		}
+
+		return bitmap;
+	}
+
+	HBITMAP ConvertFromCacheBitmap(const ThumbnailCache::Bitmap &bitmap)
+	{
+		SIZE size = { bitmap.width, -bitmap.height };
+		void *bits;
+		HBITMAP hBitmap;
+		HRESULT hr = ImageHelper::Create32BitHBITMAP(NULL, &size, &bits, &hBitmap);
+
+		if (FAILED(hr))
+		{
+			return NULL;
+		}
+
+		std::copy(bitmap.pixels.begin(), bitmap.pixels.end(), static_cast<std::uint32_t *>(bits));
+
+		return hBitmap;
+	}
+}
+
 void CShellBrowser::SetupThumbnailsView(void)
 {
 	HIMAGELIST himl;
@@ -44,13 +123,20 @@ void CShellBrowser::SetupThumbnailsView(void)
 	himl = ImageList_Create(THUMBNAIL_ITEM_WIDTH,THUMBNAIL_ITEM_HEIGHT,ILC_COLOR32,nItems,nItems + 100);
 	ListView_SetImageList(m_hListView,himl,LVSIL_NORMAL);
 
-	for(i = 0;i < nItems;i++)
+	if(m_ownerDataListView)
+	{
+		ResetOwnerDataImages();
+	}
+	else
 	{
-		lvItem.mask		= LVIF_IMAGE;
-		lvItem.iItem	= i;
-		lvItem.iSubItem	= 0;
-		lvItem.iImage	= I_IMAGECALLBACK;
-		ListView_SetItem(m_hListView,&lvItem);
+		for(i = 0;i < nItems;i++)
+		{
+			lvItem.mask		= LVIF_IMAGE;
+			lvItem.iItem	= i;
+			lvItem.iSubItem	= 0;
+			lvItem.iImage	= I_IMAGECALLBACK;
+			ListView_SetItem(m_hListView,&lvItem);
+		}
 	}
 
 	m_bThumbnailsSetup = TRUE;
@@ -71,16 +157,26 @@ void CShellBrowser::RemoveThumbnailsView(void)
 
 	nItems = ListView_GetItemCount(m_hListView);
 
-	m_itemImageThreadPool.clear_queue();
-	m_thumbnailResults.clear();
+	/* Every image is reset below, so any icons or thumbnails
+	that are still queued are no longer needed. */
+	CancelItemTasks([] (const ItemTaskScheduler::TaskKey &key) {
+		return key.taskType == ITEM_TASK_ICON || key.taskType == ITEM_TASK_THUMBNAIL;
+	});
 
-	for(i = 0;i < nItems;i++)
+	if(m_ownerDataListView)
+	{
+		ResetOwnerDataImages();
+	}
+	else
 	{
-		lvItem.mask		= LVIF_IMAGE;
-		lvItem.iItem	= i;
-		lvItem.iSubItem	= 0;
-		lvItem.iImage	= I_IMAGECALLBACK;
-		ListView_SetItem(m_hListView,&lvItem);
+		for(i = 0;i < nItems;i++)
+		{
+			lvItem.mask		= LVIF_IMAGE;
+			lvItem.iItem	= i;
+			lvItem.iSubItem	= 0;
+			lvItem.iImage	= I_IMAGECALLBACK;
+			ListView_SetItem(m_hListView,&lvItem);
+		}
 	}
 
 	/* Destroy the thumbnails imagelist. */
@@ -93,28 +189,85 @@ void CShellBrowser::RemoveThumbnailsView(void)
 
 void CShellBrowser::QueueThumbnailTask(int internalIndex)
 {
-	int thumbnailResultID = m_thumbnailResultIDCounter++;
-
 	BasicItemInfo_t basicItemInfo = getBasicItemInfo(internalIndex);
+	HWND listView = m_hListView;
+	auto itemResults = m_itemResults;
+	ThumbnailCache *thumbnailCache = m_thumbnailCache;
+	int generation = m_itemResultGeneration;
+
+	// Nothing will be queued if a thumbnail has already been
+	// requested for this item.
+	m_itemTaskScheduler->QueueTask(m_ID, { internalIndex, ITEM_TASK_THUMBNAIL },
+		[listView, itemResults, thumbnailCache, generation, internalIndex, basicItemInfo] {
+		auto result = FindThumbnailAsync(internalIndex, basicItemInfo, thumbnailCache);
+
+		if (result)
+		{
+			result->generation = generation;
+			itemResults->Add(listView, itemResults->thumbnailResults, std::move(*result));
+		}
+	});
+}
+
+/* Thumbnails are read from the cache when possible. Anything
+that has to be extracted is added to the cache. */
+boost::optional<CShellBrowser::ThumbnailResult_t> CShellBrowser::FindThumbnailAsync(int internalIndex,
+	const BasicItemInfo_t &basicItemInfo, ThumbnailCache *thumbnailCache)
+{
+	boost::optional<ThumbnailCache::Key> cacheKey;
 
-	auto result = m_itemImageThreadPool.push([this, thumbnailResultID, internalIndex, basicItemInfo](int id) {
-		UNREFERENCED_PARAMETER(id);
+	if (thumbnailCache != nullptr)
+	{
+		cacheKey = GetThumbnailCacheKey(basicItemInfo, THUMBNAIL_ITEM_WIDTH, THUMBNAIL_ITEM_HEIGHT);
+	}
 
-		return FindThumbnailAsync(m_hListView, thumbnailResultID, internalIndex, basicItemInfo);
-	});
+	HBITMAP hThumbnailBitmap = NULL;
 
-	m_thumbnailResults.insert({ thumbnailResultID, std::move(result) });
+	if (cacheKey)
+	{
+		auto cachedBitmap = thumbnailCache->Lookup(*cacheKey);
+
+		if (cachedBitmap)
+		{
+			hThumbnailBitmap = ConvertFromCacheBitmap(*cachedBitmap);
+		}
+	}
+
+	if (hThumbnailBitmap == NULL)
+	{
+		hThumbnailBitmap = ExtractThumbnail(basicItemInfo);
+
+		if (hThumbnailBitmap == NULL)
+		{
+			return boost::none;
+		}
+
+		if (cacheKey)
+		{
+			auto cacheBitmap = ConvertToCacheBitmap(hThumbnailBitmap);
+
+			if (cacheBitmap)
+			{
+				thumbnailCache->Insert(*cacheKey, *cacheBitmap);
+			}
+		}
+	}
+
+	ThumbnailResult_t result;
+	result.itemInternalIndex = internalIndex;
+	result.bitmap = HBitmapPtr(hThumbnailBitmap);
+
+	return result;
 }
 
-boost::optional<CShellBrowser::ThumbnailResult_t> CShellBrowser::FindThumbnailAsync(HWND listView,
-	int thumbnailResultId, int internalIndex, const BasicItemInfo_t &basicItemInfo)
+HBITMAP CShellBrowser::ExtractThumbnail(const BasicItemInfo_t &basicItemInfo)
 {
 	IShellFolder *pShellFolder = nullptr;
 	HRESULT hr = SHBindToParent(basicItemInfo.pidlComplete.get(), IID_PPV_ARGS(&pShellFolder), nullptr);
 
 	if (FAILED(hr))
 	{
-		return boost::none;
+		return NULL;
 	}
 
 	BOOST_SCOPE_EXIT(pShellFolder) {
@@ -127,7 +280,7 @@ boost::optional<CShellBrowser::ThumbnailResult_t> CShellBrowser::FindThumbnailAs
 
 	if (FAILED(hr))
 	{
-		return boost::none;
+		return NULL;
 	}
 
 	BOOST_SCOPE_EXIT(pExtractImage) {
@@ -148,7 +301,7 @@ boost::optional<CShellBrowser::ThumbnailResult_t> CShellBrowser::FindThumbnailAs
 
 	if (FAILED(hr))
 	{
-		return boost::none;
+		return NULL;
 	}
 
 	HBITMAP hThumbnailBitmap;
@@ -156,47 +309,33 @@ boost::optional<CShellBrowser::ThumbnailResult_t> CShellBrowser::FindThumbnailAs
 
 	if (FAILED(hr))
 	{
-		return boost::none;
+		return NULL;
 	}
 
-	PostMessage(listView, WM_APP_THUMBNAIL_RESULT_READY, thumbnailResultId, 0);
-
-	ThumbnailResult_t result;
-	result.itemInternalIndex = internalIndex;
-	result.bitmap = HBitmapPtr(hThumbnailBitmap);
-
-	return result;
+	return hThumbnailBitmap;
 }
 
-void CShellBrowser::ProcessThumbnailResult(int thumbnailResultId)
+/* Returns the row that was updated (if any). */
+boost::optional<int> CShellBrowser::ProcessThumbnailResult(const ThumbnailResult_t &result)
 {
-	auto itr = m_thumbnailResults.find(thumbnailResultId);
-
-	if (itr == m_thumbnailResults.end())
-	{
-		return;
-	}
-
 	if (m_folderSettings.viewMode != +ViewMode::Thumbnails)
 	{
-		return;
+		return boost::none;
 	}
 
-	auto result = itr->second.get();
+	auto index = LocateItemByInternalIndex(result.itemInternalIndex);
 
-	if (!result)
+	if (!index)
 	{
-		// Thumbnail lookup failed.
-		return;
+		return boost::none;
 	}
 
-	int imageIndex = GetExtractedThumbnail(result->bitmap.get());
-
-	auto index = LocateItemByInternalIndex(result->itemInternalIndex);
+	int imageIndex = GetExtractedThumbnail(result.bitmap.get());
 
-	if (!index)
+	if (m_ownerDataListView)
 	{
-		return;
+		GetOwnerDataItem(result.itemInternalIndex).iImage = imageIndex;
+		return index;
 	}
 
 	LVITEM lvItem;
@@ -205,6 +344,8 @@ void CShellBrowser::ProcessThumbnailResult(int thumbnailResultId)
 	lvItem.iSubItem = 0;
 	lvItem.iImage = imageIndex;
 	ListView_SetItem(m_hListView, &lvItem);
+
+	return index;
 }
 
 /* Draws a thumbnail based on an items icon. */
@@ -275,7 +416,7 @@ void CShellBrowser::DrawIconThumbnailInternal(HDC hdcBacking,int iInternalIndex)
 	int iIconWidth;
 	int iIconHeight;
 
-	SHGetFileInfo((LPCTSTR)m_itemInfoMap.at(iInternalIndex).pidlComplete.get(),0,&shfi,sizeof(shfi),SHGFI_PIDL|SHGFI_SYSICONINDEX);
+	SHGetFileInfo((LPCTSTR)m_itemStore.getPidlComplete(iInternalIndex),0,&shfi,sizeof(shfi),SHGFI_PIDL|SHGFI_SYSICONINDEX);
 
 	hIcon = ImageList_GetIcon(m_hListViewImageList,
 		shfi.iIcon,ILD_NORMAL);
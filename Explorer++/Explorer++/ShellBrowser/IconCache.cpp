@@ -0,0 +1,425 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "IconCache.h"
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <cwctype>
+#include <istream>
+#include <ostream>
+
+namespace
+{
+	/* Strings are limited to this length when being read back in,
+	so that a corrupt file can't cause a huge allocation. */
+	const std::uint32_t MAX_STRING_LENGTH = 32768;
+
+	void WriteUInt32(std::ostream &outputStream, std::uint32_t value)
+	{
+		outputStream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+	}
+
+	bool ReadUInt32(std::istream &inputStream, std::uint32_t &value)
+	{
+		inputStream.read(reinterpret_cast<char *>(&value), sizeof(value));
+		return static_cast<bool>(inputStream);
+	}
+
+	/* Strings are written as UTF-16 code units, preceded by their
+	length. */
+	void WriteString(std::ostream &outputStream, const std::wstring &str)
+	{
+		WriteUInt32(outputStream, static_cast<std::uint32_t>(str.size()));
+
+		for (wchar_t c : str)
+		{
+			std::uint16_t codeUnit = static_cast<std::uint16_t>(c);
+			outputStream.write(reinterpret_cast<const char *>(&codeUnit), sizeof(codeUnit));
+		}
+	}
+
+	bool ReadString(std::istream &inputStream, std::wstring &str)
+	{
+		std::uint32_t length;
+
+		if (!ReadUInt32(inputStream, length) || length > MAX_STRING_LENGTH)
+		{
+			return false;
+		}
+
+		std::vector<std::uint16_t> codeUnits(length);
+		inputStream.read(reinterpret_cast<char *>(codeUnits.data()), length * sizeof(std::uint16_t));
+
+		if (!inputStream)
+		{
+			return false;
+		}
+
+		str.assign(codeUnits.begin(), codeUnits.end());
+
+		return true;
+	}
+}
+
+IconCache::IconCache(const boost::filesystem::path &cacheFile, std::size_t maxPathEntries,
+	IconIndexResolver resolveIconIndex) :
+	m_cacheFile(cacheFile),
+	m_maxPathEntries(maxPathEntries),
+	m_resolveIconIndex(resolveIconIndex),
+	m_loaded(false),
+	m_modified(false)
+{
+
+}
+
+void IconCache::Insert(const std::wstring &path, bool isFolder, const IconLocation &location, bool perClass)
+{
+	EnsureLoaded();
+
+	std::size_t locationId = AddLocation(location);
+
+	if (perClass && !isFolder)
+	{
+		std::wstring extension = GetExtensionKey(path);
+		auto itr = m_extensionEntries.find(extension);
+
+		if (itr != m_extensionEntries.end() && itr->second == locationId)
+		{
+			return;
+		}
+
+		m_extensionEntries[extension] = locationId;
+		m_modified = true;
+
+		return;
+	}
+
+	auto &pathIndex = m_pathEntries.get<1>();
+	auto itr = pathIndex.find(path);
+
+	if (itr != pathIndex.end())
+	{
+		if (itr->locationId != locationId)
+		{
+			pathIndex.modify(itr, [locationId] (PathEntry &pathEntry) {
+				pathEntry.locationId = locationId;
+			});
+
+			m_modified = true;
+		}
+
+		m_pathEntries.relocate(m_pathEntries.begin(), m_pathEntries.project<0>(itr));
+
+		return;
+	}
+
+	m_pathEntries.push_front({ path, locationId });
+	m_modified = true;
+
+	if (m_pathEntries.size() > m_maxPathEntries)
+	{
+		m_pathEntries.pop_back();
+	}
+}
+
+/* Items are looked up by path first, since the icon for a
+particular item takes priority over the icon for its type. */
+boost::optional<int> IconCache::Lookup(const std::wstring &path, bool isFolder)
+{
+	EnsureLoaded();
+
+	auto &pathIndex = m_pathEntries.get<1>();
+	auto itr = pathIndex.find(path);
+
+	if (itr != pathIndex.end())
+	{
+		m_pathEntries.relocate(m_pathEntries.begin(), m_pathEntries.project<0>(itr));
+		return ResolveLocation(itr->locationId);
+	}
+
+	if (isFolder)
+	{
+		return boost::none;
+	}
+
+	auto extensionItr = m_extensionEntries.find(GetExtensionKey(path));
+
+	if (extensionItr == m_extensionEntries.end())
+	{
+		return boost::none;
+	}
+
+	return ResolveLocation(extensionItr->second);
+}
+
+boost::optional<int> IconCache::ResolveLocation(std::size_t locationId)
+{
+	LocationEntry &locationEntry = m_locations[locationId];
+
+	if (!locationEntry.resolved)
+	{
+		locationEntry.iconIndex = m_resolveIconIndex(locationEntry.location);
+		locationEntry.resolved = true;
+	}
+
+	return locationEntry.iconIndex;
+}
+
+std::size_t IconCache::AddLocation(const IconLocation &location)
+{
+	auto itr = m_locationIds.find(location);
+
+	if (itr != m_locationIds.end())
+	{
+		return itr->second;
+	}
+
+	std::size_t locationId = m_locations.size();
+	m_locations.push_back({ location, false, boost::none });
+	m_locationIds.emplace(location, locationId);
+
+	return locationId;
+}
+
+std::wstring IconCache::GetExtensionKey(const std::wstring &path)
+{
+	auto lastSeparator = path.find_last_of(L"\\/");
+	auto lastDot = path.find_last_of(L'.');
+
+	if (lastDot == std::wstring::npos
+		|| (lastSeparator != std::wstring::npos && lastDot < lastSeparator))
+	{
+		return std::wstring();
+	}
+
+	std::wstring extension = path.substr(lastDot);
+
+	for (wchar_t &c : extension)
+	{
+		c = static_cast<wchar_t>(std::towlower(c));
+	}
+
+	return extension;
+}
+
+void IconCache::EnsureLoaded()
+{
+	if (m_loaded)
+	{
+		return;
+	}
+
+	m_loaded = true;
+
+	if (m_cacheFile.empty())
+	{
+		return;
+	}
+
+	boost::filesystem::ifstream inputStream(m_cacheFile, std::ios::binary);
+
+	if (inputStream)
+	{
+		Load(inputStream);
+	}
+}
+
+bool IconCache::Save()
+{
+	if (!m_modified || m_cacheFile.empty())
+	{
+		return true;
+	}
+
+	// The cache is written to a temporary file first, so that
+	// the existing file is left intact if writing fails.
+	boost::filesystem::path tempFile = m_cacheFile;
+	tempFile += L".tmp";
+
+	{
+		boost::filesystem::ofstream outputStream(tempFile, std::ios::binary | std::ios::trunc);
+		Save(outputStream);
+
+		if (!outputStream)
+		{
+			return false;
+		}
+	}
+
+	boost::system::error_code error;
+	boost::filesystem::rename(tempFile, m_cacheFile, error);
+
+	if (error)
+	{
+		return false;
+	}
+
+	m_modified = false;
+
+	return true;
+}
+
+/* Only the locations that are still referenced are written
+out. */
+void IconCache::Save(std::ostream &outputStream)
+{
+	EnsureLoaded();
+
+	std::vector<std::size_t> savedLocationIds(m_locations.size(), SIZE_MAX);
+	std::vector<std::size_t> savedLocations;
+
+	auto mapLocationId = [&savedLocationIds, &savedLocations] (std::size_t locationId) {
+		if (savedLocationIds[locationId] == SIZE_MAX)
+		{
+			savedLocationIds[locationId] = savedLocations.size();
+			savedLocations.push_back(locationId);
+		}
+
+		return static_cast<std::uint32_t>(savedLocationIds[locationId]);
+	};
+
+	std::vector<std::pair<std::wstring, std::uint32_t>> extensionEntries;
+
+	for (const auto &extensionEntry : m_extensionEntries)
+	{
+		extensionEntries.emplace_back(extensionEntry.first, mapLocationId(extensionEntry.second));
+	}
+
+	std::vector<std::pair<std::wstring, std::uint32_t>> pathEntries;
+
+	for (const auto &pathEntry : m_pathEntries)
+	{
+		pathEntries.emplace_back(pathEntry.path, mapLocationId(pathEntry.locationId));
+	}
+
+	WriteUInt32(outputStream, CACHE_FILE_MAGIC);
+	WriteUInt32(outputStream, CACHE_FILE_VERSION);
+
+	WriteUInt32(outputStream, static_cast<std::uint32_t>(savedLocations.size()));
+
+	for (std::size_t locationId : savedLocations)
+	{
+		const IconLocation &location = m_locations[locationId].location;
+		WriteString(outputStream, location.file);
+		WriteUInt32(outputStream, static_cast<std::uint32_t>(location.index));
+	}
+
+	// Path entries are written from most to least recently used,
+	// so that the order is kept when they're read back in.
+	for (const auto *entries : { &extensionEntries, &pathEntries })
+	{
+		WriteUInt32(outputStream, static_cast<std::uint32_t>(entries->size()));
+
+		for (const auto &entry : *entries)
+		{
+			WriteString(outputStream, entry.first);
+			WriteUInt32(outputStream, entry.second);
+		}
+	}
+}
+
+/* Replaces the contents of the cache. If the data is invalid,
+the cache is left empty. */
+bool IconCache::Load(std::istream &inputStream)
+{
+	m_loaded = true;
+	Clear();
+
+	std::uint32_t magic;
+	std::uint32_t version;
+
+	if (!ReadUInt32(inputStream, magic) || magic != CACHE_FILE_MAGIC
+		|| !ReadUInt32(inputStream, version) || version != CACHE_FILE_VERSION)
+	{
+		return false;
+	}
+
+	std::uint32_t numLocations;
+
+	if (!ReadUInt32(inputStream, numLocations))
+	{
+		return false;
+	}
+
+	std::vector<std::size_t> locationIds;
+
+	for (std::uint32_t i = 0; i < numLocations; i++)
+	{
+		IconLocation location;
+		std::uint32_t index;
+
+		if (!ReadString(inputStream, location.file) || !ReadUInt32(inputStream, index))
+		{
+			Clear();
+			return false;
+		}
+
+		location.index = static_cast<int>(index);
+		locationIds.push_back(AddLocation(location));
+	}
+
+	for (int tier = 0; tier < 2; tier++)
+	{
+		std::uint32_t numEntries;
+
+		if (!ReadUInt32(inputStream, numEntries))
+		{
+			Clear();
+			return false;
+		}
+
+		for (std::uint32_t i = 0; i < numEntries; i++)
+		{
+			std::wstring key;
+			std::uint32_t savedLocationId;
+
+			if (!ReadString(inputStream, key) || !ReadUInt32(inputStream, savedLocationId)
+				|| savedLocationId >= locationIds.size())
+			{
+				Clear();
+				return false;
+			}
+
+			std::size_t locationId = locationIds[savedLocationId];
+
+			if (tier == 0)
+			{
+				m_extensionEntries[key] = locationId;
+			}
+			else if (m_pathEntries.size() < m_maxPathEntries)
+			{
+				m_pathEntries.push_back({ key, locationId });
+			}
+		}
+	}
+
+	return true;
+}
+
+void IconCache::Clear()
+{
+	m_locations.clear();
+	m_locationIds.clear();
+	m_extensionEntries.clear();
+	m_pathEntries.clear();
+	m_modified = false;
+}
+
+std::size_t IconCache::GetNumExtensionEntries() const
+{
+	return m_extensionEntries.size();
+}
+
+std::size_t IconCache::GetNumPathEntries() const
+{
+	return m_pathEntries.size();
+}
+
+std::size_t IconCache::IconLocationHash::operator()(const IconLocation &location) const
+{
+	std::size_t hash = std::hash<std::wstring>()(location.file);
+	hash ^= std::hash<int>()(location.index) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+	return hash;
+}
@@ -0,0 +1,130 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "../Helper/Macros.h"
+#include <boost/filesystem/path.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct IconLocation
+{
+	std::wstring file;
+	int index;
+
+	bool operator==(const IconLocation &other) const
+	{
+		return index == other.index && file == other.file;
+	}
+};
+
+/* Remembers where the icon for each item came from, so that an
+item can be shown with its real icon straight away, while the
+icon (along with any overlay) is retrieved in the background.
+
+There are two tiers. Most file types use the same icon for
+every file, so a single entry per extension is enough. Items
+whose icon can vary from one to the next (e.g. executables,
+shortcuts, icon files and folders) are instead cached by path,
+in an LRU list of limited size.
+
+Icon locations are stored, rather than system image list
+indexes, since the indexes are only valid within a single
+process. That allows the cache to be saved and reused in later
+sessions. Each location is resolved to an index (through the
+supplied function) at most once per session. The cache file is
+loaded the first time the cache is used.
+
+This class isn't thread-safe. */
+class IconCache
+{
+public:
+
+	/* Returns the system image list index for an icon. */
+	typedef std::function<boost::optional<int>(const IconLocation &location)> IconIndexResolver;
+
+	IconCache(const boost::filesystem::path &cacheFile, std::size_t maxPathEntries,
+		IconIndexResolver resolveIconIndex);
+
+	/* perClass should be true if the icon applies to every file
+	with the same extension. It's ignored for folders. */
+	void Insert(const std::wstring &path, bool isFolder, const IconLocation &location, bool perClass);
+
+	boost::optional<int> Lookup(const std::wstring &path, bool isFolder);
+
+	/* Does nothing if the cache hasn't changed since it was
+	loaded. */
+	bool Save();
+
+	void Save(std::ostream &outputStream);
+	bool Load(std::istream &inputStream);
+
+	std::size_t GetNumExtensionEntries() const;
+	std::size_t GetNumPathEntries() const;
+
+private:
+
+	DISALLOW_COPY_AND_ASSIGN(IconCache);
+
+	static const std::uint32_t CACHE_FILE_MAGIC = 0x4E434958;
+	static const std::uint32_t CACHE_FILE_VERSION = 1;
+
+	struct PathEntry
+	{
+		std::wstring path;
+		std::size_t locationId;
+	};
+
+	typedef boost::multi_index_container<
+		PathEntry,
+		boost::multi_index::indexed_by<
+			boost::multi_index::sequenced<>,
+			boost::multi_index::hashed_unique<boost::multi_index::member<PathEntry, std::wstring, &PathEntry::path>>
+		>
+	> PathEntrySet;
+
+	struct LocationEntry
+	{
+		IconLocation location;
+
+		/* Only valid for the current session, so never saved. */
+		bool resolved;
+		boost::optional<int> iconIndex;
+	};
+
+	struct IconLocationHash
+	{
+		std::size_t operator()(const IconLocation &location) const;
+	};
+
+	static std::wstring GetExtensionKey(const std::wstring &path);
+
+	void EnsureLoaded();
+	void Clear();
+	std::size_t AddLocation(const IconLocation &location);
+	boost::optional<int> ResolveLocation(std::size_t locationId);
+
+	const boost::filesystem::path m_cacheFile;
+	const std::size_t m_maxPathEntries;
+	IconIndexResolver m_resolveIconIndex;
+
+	bool m_loaded;
+	bool m_modified;
+
+	std::vector<LocationEntry> m_locations;
+	std::unordered_map<IconLocation, std::size_t, IconLocationHash> m_locationIds;
+
+	std::unordered_map<std::wstring, std::size_t> m_extensionEntries;
+	PathEntrySet m_pathEntries;
+};
@@ -4,25 +4,33 @@
 
 #include "stdafx.h"
 #include "iShellView.h"
-#include "CachedIcons.h"
+#include "../Helper/ShellHelper.h"
 
-void CShellBrowser::QueueIconTask(int internalIndex)
+/* iconCached should be set if the icon cache already holds an
+icon for the item. */
+void CShellBrowser::QueueIconTask(int internalIndex, bool iconCached)
 {
-	int iconResultID = m_iconResultIDCounter++;
-
 	BasicItemInfo_t basicItemInfo = getBasicItemInfo(internalIndex);
-
-	auto result = m_itemImageThreadPool.push([this, iconResultID, internalIndex, basicItemInfo](int id) {
-		UNREFERENCED_PARAMETER(id);
-
-		return FindIconAsync(m_hListView, iconResultID, internalIndex, basicItemInfo);
+	HWND listView = m_hListView;
+	auto itemResults = m_itemResults;
+	int generation = m_itemResultGeneration;
+
+	// Nothing will be queued if the icon for this item has
+	// already been requested.
+	m_itemTaskScheduler->QueueTask(m_ID, { internalIndex, ITEM_TASK_ICON },
+		[listView, itemResults, generation, internalIndex, basicItemInfo, iconCached] {
+		auto result = FindIconAsync(internalIndex, basicItemInfo, iconCached);
+
+		if (result)
+		{
+			result->generation = generation;
+			itemResults->Add(listView, itemResults->iconResults, *result);
+		}
 	});
-
-	m_iconResults.insert({ iconResultID, std::move(result) });
 }
 
-boost::optional<CShellBrowser::IconResult_t> CShellBrowser::FindIconAsync(HWND listView, int iconResultId, int internalIndex,
-	const BasicItemInfo_t &basicItemInfo)
+boost::optional<CShellBrowser::IconResult_t> CShellBrowser::FindIconAsync(int internalIndex,
+	const BasicItemInfo_t &basicItemInfo, bool iconCached)
 {
 	// Must use SHGFI_ICON here, rather than SHGFO_SYSICONINDEX, or else 
 	// icon overlays won't be applied.
@@ -37,56 +45,85 @@ boost::optional<CShellBrowser::IconResult_t> CShellBrowser::FindIconAsync(HWND l
 
 	DestroyIcon(shfi.hIcon);
 
-	PostMessage(listView, WM_APP_ICON_RESULT_READY, iconResultId, 0);
-
 	IconResult_t result;
 	result.itemInternalIndex = internalIndex;
 	result.iconIndex = shfi.iIcon;
+	result.perClassIcon = false;
+
+	// If the icon was found in the cache, there's no need to look
+	// up its location again. The icon itself is still retrieved
+	// above, since the cache doesn't hold overlays.
+	if (iconCached)
+	{
+		return result;
+	}
+
+	// The location is what's cached (rather than the index above),
+	// since it remains valid across sessions. Icons that don't come
+	// from a file can't be cached.
+	TCHAR iconFile[MAX_PATH];
+	int iconIndex;
+	UINT flags;
+	HRESULT hr = GetItemIconLocation(basicItemInfo.pidlComplete.get(), iconFile,
+		SIZEOF_ARRAY(iconFile), &iconIndex, &flags);
+
+	if (SUCCEEDED(hr) && (flags & GIL_NOTFILENAME) == 0)
+	{
+		result.iconLocation = IconLocation{ iconFile, iconIndex };
+		result.perClassIcon = ((flags & GIL_PERCLASS) == GIL_PERCLASS
+			&& (flags & GIL_PERINSTANCE) == 0);
+	}
 
 	return result;
 }
 
-void CShellBrowser::ProcessIconResult(int iconResultId)
+/* Returns the row that was updated (if any). */
+boost::optional<int> CShellBrowser::ProcessIconResult(const IconResult_t &result)
 {
-	auto itr = m_iconResults.find(iconResultId);
+	auto index = LocateItemByInternalIndex(result.itemInternalIndex);
 
-	if (itr == m_iconResults.end())
+	if (!index)
 	{
-		return;
+		return boost::none;
 	}
 
-	auto result = itr->second.get();
+	UpdateIconCache(result);
 
-	if (!result)
+	// The thumbnails view uses a separate imagelist, so an icon
+	// index that arrives after switching to that view isn't
+	// valid.
+	if (m_folderSettings.viewMode == +ViewMode::Thumbnails)
 	{
-		// Icon lookup failed.
-		return;
+		return boost::none;
 	}
 
-	auto index = LocateItemByInternalIndex(result->itemInternalIndex);
-
-	if (!index)
+	if (m_ownerDataListView)
 	{
-		return;
+		GetOwnerDataItem(result.itemInternalIndex).iImage = result.iconIndex;
+		return index;
 	}
 
-	const ItemInfo_t &itemInfo = m_itemInfoMap.at(result->itemInternalIndex);
-	UpdateIconCache(itemInfo, result->iconIndex);
-
 	LVITEM lvItem;
 	lvItem.mask = LVIF_IMAGE | LVIF_STATE;
 	lvItem.iItem = *index;
 	lvItem.iSubItem = 0;
-	lvItem.iImage = result->iconIndex;
+	lvItem.iImage = result.iconIndex;
 	lvItem.stateMask = LVIS_OVERLAYMASK;
-	lvItem.state = INDEXTOOVERLAYMASK(result->iconIndex >> 24);
+	lvItem.state = INDEXTOOVERLAYMASK(result.iconIndex >> 24);
 	ListView_SetItem(m_hListView, &lvItem);
+
+	return index;
 }
 
-void CShellBrowser::UpdateIconCache(const ItemInfo_t &itemInfo, int iconIndex)
+void CShellBrowser::UpdateIconCache(const IconResult_t &result)
 {
+	if (!result.iconLocation)
+	{
+		return;
+	}
+
 	TCHAR filePath[MAX_PATH];
-	HRESULT hr = GetDisplayName(itemInfo.pidlComplete.get(),
+	HRESULT hr = GetDisplayName(m_itemStore.getPidlComplete(result.itemInternalIndex),
 		filePath, SIZEOF_ARRAY(filePath), SHGDN_FORPARSING);
 
 	if (FAILED(hr))
@@ -96,19 +133,7 @@ void CShellBrowser::UpdateIconCache(const ItemInfo_t &itemInfo, int iconIndex)
 		return;
 	}
 
-	auto cachedItr = m_cachedIcons->findByPath(filePath);
+	bool isFolder = ((m_itemStore.getAttributes(result.itemInternalIndex) & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY);
 
-	if (cachedItr != m_cachedIcons->end())
-	{
-		CachedIcon existingCachedIcon = *cachedItr;
-		existingCachedIcon.iconIndex = iconIndex;
-		m_cachedIcons->replace(cachedItr, existingCachedIcon);
-	}
-	else
-	{
-		CachedIcon cachedIcon;
-		cachedIcon.file = filePath;
-		cachedIcon.iconIndex = iconIndex;
-		m_cachedIcons->insert(cachedIcon);
-	}
+	m_iconCache->Insert(filePath, isFolder, *result.iconLocation, result.perClassIcon);
 }
\ No newline at end of file
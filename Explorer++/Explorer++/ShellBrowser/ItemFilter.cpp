@@ -0,0 +1,137 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ItemFilter.h"
+#include <cassert>
+
+ItemFilter::ItemFilter() :
+	m_numItems(0),
+	m_numVisibleItems(0)
+{
+
+}
+
+void ItemFilter::clear()
+{
+	m_present.clear();
+	m_visible.clear();
+	m_numItems = 0;
+	m_numVisibleItems = 0;
+}
+
+void ItemFilter::setItemVisible(int internalIndex, bool visible)
+{
+	assert(internalIndex >= 0);
+
+	size_t index = static_cast<size_t>(internalIndex);
+
+	if (index >= m_present.size())
+	{
+		m_present.resize(index + 1, false);
+		m_visible.resize(index + 1, false);
+	}
+
+	if (!m_present[index])
+	{
+		m_present[index] = true;
+		m_numItems++;
+	}
+	else if (m_visible[index])
+	{
+		m_numVisibleItems--;
+	}
+
+	m_visible[index] = visible;
+
+	if (visible)
+	{
+		m_numVisibleItems++;
+	}
+}
+
+void ItemFilter::removeItem(int internalIndex)
+{
+	if (!containsItem(internalIndex))
+	{
+		return;
+	}
+
+	size_t index = static_cast<size_t>(internalIndex);
+
+	if (m_visible[index])
+	{
+		m_numVisibleItems--;
+	}
+
+	m_present[index] = false;
+	m_visible[index] = false;
+	m_numItems--;
+}
+
+bool ItemFilter::containsItem(int internalIndex) const
+{
+	return internalIndex >= 0
+		&& static_cast<size_t>(internalIndex) < m_present.size()
+		&& m_present[internalIndex];
+}
+
+bool ItemFilter::isItemVisible(int internalIndex) const
+{
+	return containsItem(internalIndex) && m_visible[internalIndex];
+}
+
+int ItemFilter::getNumItems() const
+{
+	return m_numItems;
+}
+
+int ItemFilter::getNumVisibleItems() const
+{
+	return m_numVisibleItems;
+}
+
+ItemFilter::Diff ItemFilter::update(Scope scope, const Predicate &isVisible)
+{
+	Diff diff;
+
+	for (size_t index = 0; index < m_present.size(); index++)
+	{
+		if (!m_present[index])
+		{
+			continue;
+		}
+
+		bool visible = m_visible[index];
+
+		if ((scope == Scope::VisibleItems && !visible)
+			|| (scope == Scope::HiddenItems && visible))
+		{
+			continue;
+		}
+
+		int internalIndex = static_cast<int>(index);
+		bool nowVisible = isVisible(internalIndex);
+
+		if (nowVisible == visible)
+		{
+			continue;
+		}
+
+		m_visible[index] = nowVisible;
+
+		if (nowVisible)
+		{
+			diff.shownItems.push_back(internalIndex);
+			m_numVisibleItems++;
+		}
+		else
+		{
+			diff.hiddenItems.push_back(internalIndex);
+			m_numVisibleItems--;
+		}
+	}
+
+	return diff;
+}
@@ -0,0 +1,65 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+// Tracks which items in a folder pass the current filter. Each item is
+// recorded in a pair of bitmaps, indexed directly by internal index: one
+// indicating that the item exists and the other that it's visible.
+//
+// When the filter changes, only the items whose state could change need
+// to be tested again. If the new filter is narrower than the old one
+// (e.g. because a character was added to the pattern), no hidden item
+// can start to match, so only the visible items are re-tested. Likewise,
+// if the filter was widened, only the hidden items are re-tested. The
+// items that changed are returned as a single diff, so that the listview
+// can be updated in one pass, rather than being walked row by row.
+class ItemFilter
+{
+public:
+
+	enum class Scope
+	{
+		AllItems,
+		VisibleItems,
+		HiddenItems
+	};
+
+	// The items whose visibility has changed, in ascending order.
+	struct Diff
+	{
+		std::vector<int> hiddenItems;
+		std::vector<int> shownItems;
+	};
+
+	// Returns true if the specified item should be visible.
+	typedef std::function<bool(int internalIndex)> Predicate;
+
+	ItemFilter();
+
+	void clear();
+
+	// Adds the item if it isn't already present.
+	void setItemVisible(int internalIndex, bool visible);
+	void removeItem(int internalIndex);
+	bool containsItem(int internalIndex) const;
+	bool isItemVisible(int internalIndex) const;
+
+	int getNumItems() const;
+	int getNumVisibleItems() const;
+
+	// Re-tests the items within the specified scope and updates their
+	// visibility.
+	Diff update(Scope scope, const Predicate &isVisible);
+
+private:
+
+	std::vector<bool> m_present;
+	std::vector<bool> m_visible;
+	int m_numItems;
+	int m_numVisibleItems;
+};
@@ -0,0 +1,97 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "../Helper/MPSCQueue.h"
+#include <boost/optional.hpp>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+// Ensures that at most one notification is outstanding for a set of
+// result queues. The consumer is only notified when the first result
+// arrives after it last started draining the queues, so a burst of
+// results results in a single notification.
+class ResultNotifier
+{
+public:
+
+	// Called (from any thread) once a result has been queued. Returns
+	// true if the consumer needs to be notified.
+	bool onResultAdded()
+	{
+		return !m_pending.exchange(true);
+	}
+
+	// Called by the consumer before it drains the queues. Any result
+	// added after this point will cause another notification.
+	void onDrainStarted()
+	{
+		m_pending = false;
+	}
+
+private:
+
+	std::atomic<bool> m_pending{ false };
+};
+
+// Takes every result from the queue, dropping any that were queued
+// under a different generation (i.e. for a previous folder).
+template <typename T>
+std::vector<T> TakeCurrentResults(MPSCQueue<T> &queue, int generation)
+{
+	auto results = queue.PopAll();
+
+	results.erase(std::remove_if(results.begin(), results.end(), [generation] (const T &result) {
+		return result.generation != generation;
+	}), results.end());
+
+	return results;
+}
+
+// Records the range of rows updated while a set of results is applied,
+// so that only those rows need to be redrawn.
+class UpdatedRowRange
+{
+public:
+
+	void addRow(boost::optional<int> row)
+	{
+		if (!row)
+		{
+			return;
+		}
+
+		if (!m_firstRow || *row < *m_firstRow)
+		{
+			m_firstRow = *row;
+		}
+
+		if (!m_lastRow || *row > *m_lastRow)
+		{
+			m_lastRow = *row;
+		}
+	}
+
+	bool isEmpty() const
+	{
+		return !m_firstRow;
+	}
+
+	int getFirstRow() const
+	{
+		return *m_firstRow;
+	}
+
+	int getLastRow() const
+	{
+		return *m_lastRow;
+	}
+
+private:
+
+	boost::optional<int> m_firstRow;
+	boost::optional<int> m_lastRow;
+};
@@ -0,0 +1,107 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ItemRowMap.h"
+#include <cassert>
+
+ItemRowMap::ItemRowMap() :
+	m_rowsInserted(0),
+	m_rowsRemoved(0)
+{
+
+}
+
+void ItemRowMap::clear()
+{
+	m_internalIndices.clear();
+	m_rows.clear();
+	m_rowsInserted = 0;
+	m_rowsRemoved = 0;
+}
+
+void ItemRowMap::insertItem(int row, int internalIndex)
+{
+	assert(row >= 0 && row <= size());
+
+	m_internalIndices.insert(m_internalIndices.begin() + row, internalIndex);
+	m_rows[internalIndex] = row;
+	m_rowsInserted++;
+}
+
+void ItemRowMap::removeRow(int row)
+{
+	assert(row >= 0 && row < size());
+
+	m_rows.erase(m_internalIndices[row]);
+	m_internalIndices.erase(m_internalIndices.begin() + row);
+	m_rowsRemoved++;
+}
+
+void ItemRowMap::setRows(std::vector<int> internalIndices)
+{
+	m_internalIndices = std::move(internalIndices);
+	rebuildRows();
+}
+
+boost::optional<int> ItemRowMap::getRow(int internalIndex) const
+{
+	if ((m_rowsInserted + m_rowsRemoved) > MAX_ROW_DRIFT)
+	{
+		rebuildRows();
+	}
+
+	auto itr = m_rows.find(internalIndex);
+
+	if (itr == m_rows.end())
+	{
+		return boost::none;
+	}
+
+	// Each insertion can have moved the item down by at most one row
+	// and each removal can have moved it up by at most one row.
+	int cachedRow = itr->second;
+	int firstRow = (std::max)(cachedRow - m_rowsRemoved, 0);
+	int lastRow = (std::min)(cachedRow + m_rowsInserted, size() - 1);
+
+	for (int row = firstRow; row <= lastRow; row++)
+	{
+		if (m_internalIndices[row] == internalIndex)
+		{
+			itr->second = row;
+			return row;
+		}
+	}
+
+	// The window above should always contain the item.
+	assert(false);
+
+	rebuildRows();
+
+	return m_rows.at(internalIndex);
+}
+
+int ItemRowMap::getInternalIndex(int row) const
+{
+	return m_internalIndices.at(row);
+}
+
+int ItemRowMap::size() const
+{
+	return static_cast<int>(m_internalIndices.size());
+}
+
+void ItemRowMap::rebuildRows() const
+{
+	m_rows.clear();
+	m_rows.reserve(m_internalIndices.size());
+
+	for (int row = 0; row < size(); row++)
+	{
+		m_rows[m_internalIndices[row]] = row;
+	}
+
+	m_rowsInserted = 0;
+	m_rowsRemoved = 0;
+}
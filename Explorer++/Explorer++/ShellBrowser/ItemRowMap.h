@@ -0,0 +1,57 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <unordered_map>
+#include <vector>
+
+// Tracks the listview row that each item (identified by its internal
+// index) currently occupies, so that an item can be located without
+// having to search the listview.
+//
+// Inserting or removing a row shifts the position of every row after
+// it. Rather than updating each of those entries straight away, the
+// cached row for an item is allowed to drift by at most the number of
+// insertions/removals made since the cache was last rebuilt. A lookup
+// then only needs to check the rows within that window.
+class ItemRowMap
+{
+public:
+
+	ItemRowMap();
+
+	void clear();
+
+	// Inserts an item at the specified row. Rows at or after that
+	// position are shifted down by one.
+	void insertItem(int row, int internalIndex);
+	void removeRow(int row);
+
+	// Replaces the current set of rows. Used after the items have been
+	// reordered (e.g. by sorting).
+	void setRows(std::vector<int> internalIndices);
+
+	boost::optional<int> getRow(int internalIndex) const;
+	int getInternalIndex(int row) const;
+	int size() const;
+
+private:
+
+	// Once this many rows have been inserted or removed, the cached
+	// positions are rebuilt, so that lookups stay cheap.
+	static const int MAX_ROW_DRIFT = 32;
+
+	void rebuildRows() const;
+
+	// The internal index of the item at each row. This always mirrors
+	// the listview exactly.
+	std::vector<int> m_internalIndices;
+
+	// The (possibly stale) row for each item.
+	mutable std::unordered_map<int, int> m_rows;
+	mutable int m_rowsInserted;
+	mutable int m_rowsRemoved;
+};
@@ -0,0 +1,351 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ItemStore.h"
+#include "../Helper/Macros.h"
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+ItemStore::ItemStore() :
+	m_numItems(0),
+	m_stringArena(STRING_BLOCK_SIZE),
+	m_pidlArena(PIDL_BLOCK_SIZE)
+{
+
+}
+
+void ItemStore::addItem(int id, const WIN32_FIND_DATA &wfd, const TCHAR *displayName,
+	LPCITEMIDLIST pidlComplete, LPCITEMIDLIST pidlRelative)
+{
+	assert(id >= 0);
+
+	size_t index = static_cast<size_t>(id);
+
+	if (index >= m_present.size())
+	{
+		size_t newSize = index + 1;
+
+		m_present.resize(newSize, false);
+		m_attributes.resize(newSize);
+		m_sizes.resize(newSize);
+		m_creationTimes.resize(newSize);
+		m_lastAccessTimes.resize(newSize);
+		m_lastWriteTimes.resize(newSize);
+		m_fileNames.resize(newSize);
+		m_alternateFileNames.resize(newSize);
+		m_displayNames.resize(newSize);
+		m_pidlsComplete.resize(newSize);
+		m_pidlsRelative.resize(newSize);
+		m_relativeSorts.resize(newSize);
+	}
+
+	assert(!m_present[index]);
+
+	m_present[index] = true;
+	m_numItems++;
+
+	setFindData(id, wfd);
+	setDisplayName(id, displayName);
+	setPidls(id, pidlComplete, pidlRelative);
+	m_relativeSorts[index] = 0;
+}
+
+void ItemStore::removeItem(int id)
+{
+	if (!containsItem(id))
+	{
+		return;
+	}
+
+	// The item's strings and PIDLs stay in their arenas until the store
+	// is cleared.
+	m_present[id] = false;
+	m_fileNames[id] = nullptr;
+	m_alternateFileNames[id] = nullptr;
+	m_displayNames[id] = nullptr;
+	m_pidlsComplete[id] = nullptr;
+	m_pidlsRelative[id] = nullptr;
+	m_drives.erase(id);
+	m_numItems--;
+}
+
+bool ItemStore::containsItem(int id) const
+{
+	return id >= 0 && static_cast<size_t>(id) < m_present.size() && m_present[id];
+}
+
+bool ItemStore::empty() const
+{
+	return m_numItems == 0;
+}
+
+void ItemStore::clear()
+{
+	m_present.clear();
+	m_numItems = 0;
+
+	m_attributes.clear();
+	m_sizes.clear();
+	m_creationTimes.clear();
+	m_lastAccessTimes.clear();
+	m_lastWriteTimes.clear();
+	m_fileNames.clear();
+	m_alternateFileNames.clear();
+	m_displayNames.clear();
+	m_pidlsComplete.clear();
+	m_pidlsRelative.clear();
+	m_relativeSorts.clear();
+	m_drives.clear();
+
+	m_internedStrings.clear();
+	m_stringArena.clear();
+	m_pidlArena.clear();
+}
+
+std::vector<int> ItemStore::getItemIds() const
+{
+	std::vector<int> ids;
+	ids.reserve(m_numItems);
+
+	for (size_t i = 0; i < m_present.size(); i++)
+	{
+		if (m_present[i])
+		{
+			ids.push_back(static_cast<int>(i));
+		}
+	}
+
+	return ids;
+}
+
+WIN32_FIND_DATA ItemStore::getFindData(int id) const
+{
+	checkItem(id);
+
+	WIN32_FIND_DATA wfd = {};
+	wfd.dwFileAttributes = m_attributes[id];
+	wfd.ftCreationTime = m_creationTimes[id];
+	wfd.ftLastAccessTime = m_lastAccessTimes[id];
+	wfd.ftLastWriteTime = m_lastWriteTimes[id];
+
+	ULARGE_INTEGER size;
+	size.QuadPart = m_sizes[id];
+	wfd.nFileSizeLow = size.LowPart;
+	wfd.nFileSizeHigh = size.HighPart;
+
+	StringCchCopy(wfd.cFileName, SIZEOF_ARRAY(wfd.cFileName), m_fileNames[id]);
+	StringCchCopy(wfd.cAlternateFileName, SIZEOF_ARRAY(wfd.cAlternateFileName), m_alternateFileNames[id]);
+
+	return wfd;
+}
+
+void ItemStore::setFindData(int id, const WIN32_FIND_DATA &wfd)
+{
+	checkItem(id);
+
+	m_attributes[id] = wfd.dwFileAttributes;
+
+	ULARGE_INTEGER size;
+	size.LowPart = wfd.nFileSizeLow;
+	size.HighPart = wfd.nFileSizeHigh;
+	m_sizes[id] = size.QuadPart;
+
+	m_creationTimes[id] = wfd.ftCreationTime;
+	m_lastAccessTimes[id] = wfd.ftLastAccessTime;
+	m_lastWriteTimes[id] = wfd.ftLastWriteTime;
+
+	m_fileNames[id] = internString(wfd.cFileName, SIZEOF_ARRAY(wfd.cFileName));
+	m_alternateFileNames[id] = internString(wfd.cAlternateFileName, SIZEOF_ARRAY(wfd.cAlternateFileName));
+}
+
+DWORD ItemStore::getAttributes(int id) const
+{
+	checkItem(id);
+	return m_attributes[id];
+}
+
+ULONGLONG ItemStore::getSize(int id) const
+{
+	checkItem(id);
+	return m_sizes[id];
+}
+
+void ItemStore::setSize(int id, ULONGLONG size)
+{
+	checkItem(id);
+	m_sizes[id] = size;
+}
+
+const FILETIME &ItemStore::getCreationTime(int id) const
+{
+	checkItem(id);
+	return m_creationTimes[id];
+}
+
+const FILETIME &ItemStore::getLastAccessTime(int id) const
+{
+	checkItem(id);
+	return m_lastAccessTimes[id];
+}
+
+const FILETIME &ItemStore::getLastWriteTime(int id) const
+{
+	checkItem(id);
+	return m_lastWriteTimes[id];
+}
+
+const TCHAR *ItemStore::getFileName(int id) const
+{
+	checkItem(id);
+	return m_fileNames[id];
+}
+
+void ItemStore::setFileName(int id, const TCHAR *fileName)
+{
+	checkItem(id);
+	m_fileNames[id] = internString(fileName, MAX_PATH);
+}
+
+const TCHAR *ItemStore::getAlternateFileName(int id) const
+{
+	checkItem(id);
+	return m_alternateFileNames[id];
+}
+
+const TCHAR *ItemStore::getDisplayName(int id) const
+{
+	checkItem(id);
+	return m_displayNames[id];
+}
+
+void ItemStore::setDisplayName(int id, const TCHAR *displayName)
+{
+	checkItem(id);
+	m_displayNames[id] = internString(displayName, MAX_PATH);
+}
+
+LPCITEMIDLIST ItemStore::getPidlComplete(int id) const
+{
+	checkItem(id);
+	return m_pidlsComplete[id];
+}
+
+LPCITEMIDLIST ItemStore::getPidlRelative(int id) const
+{
+	checkItem(id);
+	return m_pidlsRelative[id];
+}
+
+void ItemStore::setPidls(int id, LPCITEMIDLIST pidlComplete, LPCITEMIDLIST pidlRelative)
+{
+	checkItem(id);
+	m_pidlsComplete[id] = storePidl(pidlComplete);
+	m_pidlsRelative[id] = storePidl(pidlRelative);
+}
+
+void ItemStore::setDrive(int id, const TCHAR *drive)
+{
+	checkItem(id);
+	m_drives[id] = internString(drive, MAX_PATH);
+}
+
+const TCHAR *ItemStore::getDrive(int id) const
+{
+	checkItem(id);
+
+	auto itr = m_drives.find(id);
+
+	if (itr == m_drives.end())
+	{
+		return nullptr;
+	}
+
+	return itr->second;
+}
+
+int ItemStore::getRelativeSort(int id) const
+{
+	checkItem(id);
+	return m_relativeSorts[id];
+}
+
+void ItemStore::setRelativeSort(int id, int relativeSort)
+{
+	checkItem(id);
+	m_relativeSorts[id] = relativeSort;
+}
+
+size_t ItemStore::getMemoryUsage() const
+{
+	size_t usage = sizeof(*this);
+
+	usage += m_present.capacity() / 8;
+	usage += m_attributes.capacity() * sizeof(DWORD);
+	usage += m_sizes.capacity() * sizeof(ULONGLONG);
+	usage += (m_creationTimes.capacity() + m_lastAccessTimes.capacity()
+		+ m_lastWriteTimes.capacity()) * sizeof(FILETIME);
+	usage += (m_fileNames.capacity() + m_alternateFileNames.capacity()
+		+ m_displayNames.capacity()) * sizeof(const TCHAR *);
+	usage += (m_pidlsComplete.capacity() + m_pidlsRelative.capacity()) * sizeof(LPCITEMIDLIST);
+	usage += m_relativeSorts.capacity() * sizeof(int);
+
+	// Each node in the hash set holds the view and a next pointer.
+	usage += m_internedStrings.bucket_count() * sizeof(void *);
+	usage += m_internedStrings.size() * (sizeof(std::basic_string_view<TCHAR>) + sizeof(void *));
+
+	usage += m_drives.bucket_count() * sizeof(void *);
+	usage += m_drives.size() * (sizeof(std::pair<const int, const TCHAR *>) + sizeof(void *));
+
+	usage += m_stringArena.getMemoryUsage();
+	usage += m_pidlArena.getMemoryUsage();
+
+	return usage;
+}
+
+void ItemStore::checkItem(int id) const
+{
+	if (!containsItem(id))
+	{
+		throw std::out_of_range("Invalid item id");
+	}
+}
+
+const TCHAR *ItemStore::internString(const TCHAR *str, size_t maxLength)
+{
+	std::basic_string_view<TCHAR> view(str, _tcsnlen(str, maxLength));
+
+	auto itr = m_internedStrings.find(view);
+
+	if (itr != m_internedStrings.end())
+	{
+		return itr->data();
+	}
+
+	TCHAR *data = m_stringArena.allocate(view.size() + 1);
+	std::copy(view.begin(), view.end(), data);
+	data[view.size()] = '\0';
+
+	m_internedStrings.insert(std::basic_string_view<TCHAR>(data, view.size()));
+
+	return data;
+}
+
+LPCITEMIDLIST ItemStore::storePidl(LPCITEMIDLIST pidl)
+{
+	if (pidl == nullptr)
+	{
+		return nullptr;
+	}
+
+	UINT size = ILGetSize(pidl);
+
+	// Allocations are rounded up to an even size, so that the size
+	// field at the start of each PIDL stays aligned.
+	BYTE *data = m_pidlArena.allocate((size + 1) & ~1u);
+	memcpy(data, pidl, size);
+
+	return reinterpret_cast<LPCITEMIDLIST>(data);
+}
@@ -0,0 +1,182 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Hands out storage from a series of fixed-size blocks. Blocks are
+// never moved or freed (until clear() is called), so any pointer
+// returned remains valid for the lifetime of the arena.
+template <typename T>
+class ArenaAllocator
+{
+public:
+
+	explicit ArenaAllocator(size_t blockSize) :
+		m_blockSize(blockSize),
+		m_blockUsed(0),
+		m_bytesAllocated(0)
+	{
+
+	}
+
+	T *allocate(size_t count)
+	{
+		// Large requests get a block of their own, so that the
+		// remainder of the current block isn't wasted.
+		if (count > m_blockSize / 4)
+		{
+			m_largeBlocks.push_back(std::make_unique<T[]>(count));
+			m_bytesAllocated += count * sizeof(T);
+
+			return m_largeBlocks.back().get();
+		}
+
+		if (m_blocks.empty() || count > m_blockSize - m_blockUsed)
+		{
+			m_blocks.push_back(std::make_unique<T[]>(m_blockSize));
+			m_blockUsed = 0;
+			m_bytesAllocated += m_blockSize * sizeof(T);
+		}
+
+		T *data = m_blocks.back().get() + m_blockUsed;
+		m_blockUsed += count;
+
+		return data;
+	}
+
+	void clear()
+	{
+		m_blocks.clear();
+		m_largeBlocks.clear();
+		m_blockUsed = 0;
+		m_bytesAllocated = 0;
+	}
+
+	size_t getMemoryUsage() const
+	{
+		return m_bytesAllocated
+			+ (m_blocks.capacity() + m_largeBlocks.capacity()) * sizeof(std::unique_ptr<T[]>);
+	}
+
+private:
+
+	size_t m_blockSize;
+	std::vector<std::unique_ptr<T[]>> m_blocks;
+	std::vector<std::unique_ptr<T[]>> m_largeBlocks;
+
+	// The amount of the last block in m_blocks that's been handed out.
+	size_t m_blockUsed;
+
+	size_t m_bytesAllocated;
+};
+
+// Stores the data for each item in a folder. Rather than keeping a
+// separate structure (with several fixed-size path buffers) for each
+// item, each field is held in its own dense array, indexed directly by
+// item id. Names are stored once in a shared arena (so that, for
+// example, a file name and an identical display name take up the
+// space of a single string) and PIDLs are packed into a second arena.
+//
+// Scans over a single field (such as the attribute checks made when
+// filtering, or the sizes read when sorting) therefore only touch the
+// memory for that field.
+//
+// Strings and PIDLs that are replaced (e.g. when an item is renamed)
+// aren't reclaimed until the store is cleared, which happens whenever
+// a new folder is browsed to. The pointers returned by the accessors
+// below remain valid until then, even if the store is moved (as it is
+// when a folder is kept for back/forward navigation).
+class ItemStore
+{
+public:
+
+	ItemStore();
+
+	void addItem(int id, const WIN32_FIND_DATA &wfd, const TCHAR *displayName,
+		LPCITEMIDLIST pidlComplete, LPCITEMIDLIST pidlRelative);
+	void removeItem(int id);
+	bool containsItem(int id) const;
+	bool empty() const;
+	void clear();
+
+	// Returns the ids of all items in the store, in ascending order.
+	std::vector<int> getItemIds() const;
+
+	WIN32_FIND_DATA getFindData(int id) const;
+	void setFindData(int id, const WIN32_FIND_DATA &wfd);
+
+	DWORD getAttributes(int id) const;
+	ULONGLONG getSize(int id) const;
+	void setSize(int id, ULONGLONG size);
+	const FILETIME &getCreationTime(int id) const;
+	const FILETIME &getLastAccessTime(int id) const;
+	const FILETIME &getLastWriteTime(int id) const;
+
+	const TCHAR *getFileName(int id) const;
+	void setFileName(int id, const TCHAR *fileName);
+	const TCHAR *getAlternateFileName(int id) const;
+	const TCHAR *getDisplayName(int id) const;
+	void setDisplayName(int id, const TCHAR *displayName);
+
+	LPCITEMIDLIST getPidlComplete(int id) const;
+	LPCITEMIDLIST getPidlRelative(int id) const;
+	void setPidls(int id, LPCITEMIDLIST pidlComplete, LPCITEMIDLIST pidlRelative);
+
+	// Only drives have a drive name set. It's needed so that the item
+	// can be found again once the drive has been removed.
+	void setDrive(int id, const TCHAR *drive);
+	const TCHAR *getDrive(int id) const;
+
+	// Used for temporary sorting in details mode (i.e. when items need
+	// to be rearranged).
+	int getRelativeSort(int id) const;
+	void setRelativeSort(int id, int relativeSort);
+
+	// The approximate number of bytes used by the store.
+	size_t getMemoryUsage() const;
+
+private:
+
+	static const size_t STRING_BLOCK_SIZE = 64 * 1024;
+	static const size_t PIDL_BLOCK_SIZE = 128 * 1024;
+
+	// Throws std::out_of_range if the item doesn't exist.
+	void checkItem(int id) const;
+
+	const TCHAR *internString(const TCHAR *str, size_t maxLength);
+	LPCITEMIDLIST storePidl(LPCITEMIDLIST pidl);
+
+	std::vector<bool> m_present;
+	size_t m_numItems;
+
+	std::vector<DWORD> m_attributes;
+	std::vector<ULONGLONG> m_sizes;
+	std::vector<FILETIME> m_creationTimes;
+	std::vector<FILETIME> m_lastAccessTimes;
+	std::vector<FILETIME> m_lastWriteTimes;
+
+	std::vector<const TCHAR *> m_fileNames;
+	std::vector<const TCHAR *> m_alternateFileNames;
+	std::vector<const TCHAR *> m_displayNames;
+
+	std::vector<LPCITEMIDLIST> m_pidlsComplete;
+	std::vector<LPCITEMIDLIST> m_pidlsRelative;
+
+	std::vector<int> m_relativeSorts;
+
+	// There are generally very few drives, so they're stored
+	// separately.
+	std::unordered_map<int, const TCHAR *> m_drives;
+
+	ArenaAllocator<TCHAR> m_stringArena;
+	std::unordered_set<std::basic_string_view<TCHAR>> m_internedStrings;
+
+	ArenaAllocator<BYTE> m_pidlArena;
+};
@@ -20,20 +20,12 @@ LRESULT CALLBACK CShellBrowser::ListViewProc(HWND hwnd, UINT uMsg, WPARAM wParam
 {
 	switch (uMsg)
 	{
-	case WM_APP_COLUMN_RESULT_READY:
-		ProcessColumnResult(static_cast<int>(wParam));
+	case WM_APP_ITEM_RESULTS_READY:
+		ProcessItemResults();
 		break;
 
-	case WM_APP_THUMBNAIL_RESULT_READY:
-		ProcessThumbnailResult(static_cast<int>(wParam));
-		break;
-
-	case WM_APP_ICON_RESULT_READY:
-		ProcessIconResult(static_cast<int>(wParam));
-		break;
-
-	case WM_APP_INFO_TIP_READY:
-		ProcessInfoTipResult(static_cast<int>(wParam));
+	case WM_APP_ENUMERATION_RESULTS_READY:
+		ProcessEnumerationResults(static_cast<int>(wParam));
 		break;
 	}
 
@@ -61,6 +53,10 @@ LRESULT CALLBACK CShellBrowser::ListViewParentProc(HWND hwnd, UINT uMsg, WPARAM
 				OnListViewGetDisplayInfo(lParam);
 				break;
 
+			case LVN_ODFINDITEM:
+				return OnListViewFindItem(reinterpret_cast<NMLVFINDITEM *>(lParam));
+				break;
+
 			case LVN_GETINFOTIP:
 				return OnListViewGetInfoTip(reinterpret_cast<NMLVGETINFOTIP *>(lParam));
 				break;
@@ -68,6 +64,10 @@ LRESULT CALLBACK CShellBrowser::ListViewParentProc(HWND hwnd, UINT uMsg, WPARAM
 			case LVN_COLUMNCLICK:
 				ColumnClicked(reinterpret_cast<NMLISTVIEW *>(lParam)->iSubItem);
 				break;
+
+			case LVN_ENDSCROLL:
+				CancelOffscreenItemTasks();
+				break;
 			}
 		}
 		break;
@@ -86,6 +86,12 @@ void CShellBrowser::OnListViewGetDisplayInfo(LPARAM lParam)
 	plvItem = &pnmv->item;
 	nmhdr = &pnmv->hdr;
 
+	if (m_ownerDataListView)
+	{
+		OnListViewGetDisplayInfoOwnerData(pnmv);
+		return;
+	}
+
 	/* Construct an image here using the items
 	actual icon. This image will be shown initially.
 	If the item also has a thumbnail image, this
@@ -112,8 +118,8 @@ void CShellBrowser::OnListViewGetDisplayInfo(LPARAM lParam)
 
 	if ((plvItem->mask & LVIF_IMAGE) == LVIF_IMAGE)
 	{
-		const ItemInfo_t &itemInfo = m_itemInfoMap.at(static_cast<int>(plvItem->lParam));
-		auto cachedIconIndex = GetCachedIconIndex(itemInfo);
+		int internalIndex = static_cast<int>(plvItem->lParam);
+		auto cachedIconIndex = GetCachedIconIndex(internalIndex);
 
 		if (cachedIconIndex)
 		{
@@ -136,7 +142,7 @@ void CShellBrowser::OnListViewGetDisplayInfo(LPARAM lParam)
 		}
 		else
 		{
-			if ((itemInfo.wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY)
+			if ((m_itemStore.getAttributes(internalIndex) & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY)
 			{
 				plvItem->iImage = m_iFolderIcon;
 			}
@@ -146,7 +152,7 @@ void CShellBrowser::OnListViewGetDisplayInfo(LPARAM lParam)
 			}
 		}
 
-		QueueIconTask(static_cast<int>(plvItem->lParam));
+		QueueIconTask(internalIndex, cachedIconIndex != boost::none);
 	}
 
 	plvItem->mask |= LVIF_DI_SETITEM;
@@ -167,36 +173,43 @@ LRESULT CShellBrowser::OnListViewGetInfoTip(NMLVGETINFOTIP *getInfoTip)
 
 void CShellBrowser::QueueInfoTipTask(int internalIndex, const std::wstring &existingInfoTip)
 {
-	int infoTipResultId = m_infoTipResultIDCounter++;
-
 	BasicItemInfo_t basicItemInfo = getBasicItemInfo(internalIndex);
 	Config configCopy = *m_config;
 	bool virtualFolder = InVirtualFolder();
-
-	auto result = m_infoTipsThreadPool.push([this, infoTipResultId, internalIndex,
-		basicItemInfo, configCopy, virtualFolder, existingInfoTip](int id) {
-		UNREFERENCED_PARAMETER(id);
-
-		auto result = GetInfoTipAsync(m_hListView, infoTipResultId, internalIndex, basicItemInfo, configCopy,
-			m_hResourceModule, virtualFolder);
+	HWND listView = m_hListView;
+	auto itemResults = m_itemResults;
+	HINSTANCE resourceModule = m_hResourceModule;
+	int generation = m_itemResultGeneration;
+
+	// Nothing will be queued if the infotip for this item is
+	// still being retrieved.
+	m_itemTaskScheduler->QueueTask(m_ID, { internalIndex, ITEM_TASK_INFOTIP },
+		[listView, itemResults, resourceModule, generation, internalIndex,
+		basicItemInfo, configCopy, virtualFolder, existingInfoTip] {
+		auto result = GetInfoTipAsync(internalIndex, basicItemInfo, configCopy,
+			resourceModule, virtualFolder);
+
+		if (!result)
+		{
+			return;
+		}
 
 		// If the item name is truncated in the listview,
 		// existingInfoTip will contain that value. Therefore, it's
 		// important that the rest of the infotip is concatenated onto
 		// that value if it's there.
-		if (result && !existingInfoTip.empty())
+		if (!existingInfoTip.empty())
 		{
 			result->infoTip = existingInfoTip + L"\n" + result->infoTip;
 		}
 
-		return result;
+		result->generation = generation;
+		itemResults->Add(listView, itemResults->infoTipResults, std::move(*result));
 	});
-
-	m_infoTipResults.insert({ infoTipResultId, std::move(result) });
 }
 
-boost::optional<CShellBrowser::InfoTipResult> CShellBrowser::GetInfoTipAsync(HWND listView, int infoTipResultId,
-	int internalIndex, const BasicItemInfo_t &basicItemInfo, const Config &config, HINSTANCE instance, bool virtualFolder)
+boost::optional<CShellBrowser::InfoTipResult> CShellBrowser::GetInfoTipAsync(int internalIndex,
+	const BasicItemInfo_t &basicItemInfo, const Config &config, HINSTANCE instance, bool virtualFolder)
 {
 	std::wstring infoTip;
 
@@ -231,8 +244,6 @@ boost::optional<CShellBrowser::InfoTipResult> CShellBrowser::GetInfoTipAsync(HWN
 		infoTip = str(boost::wformat(_T("%s: %s")) % dateModified % fileModificationText);
 	}
 
-	PostMessage(listView, WM_APP_INFO_TIP_READY, infoTipResultId, 0);
-
 	InfoTipResult result;
 	result.itemInternalIndex = internalIndex;
 	result.infoTip = infoTip;
@@ -240,24 +251,9 @@ boost::optional<CShellBrowser::InfoTipResult> CShellBrowser::GetInfoTipAsync(HWN
 	return result;
 }
 
-void CShellBrowser::ProcessInfoTipResult(int infoTipResultId)
+void CShellBrowser::ProcessInfoTipResult(const InfoTipResult &result)
 {
-	auto itr = m_infoTipResults.find(infoTipResultId);
-
-	if (itr == m_infoTipResults.end())
-	{
-		return;
-	}
-
-	auto result = itr->second.get();
-	m_infoTipResults.erase(itr);
-
-	if (!result)
-	{
-		return;
-	}
-
-	auto index = LocateItemByInternalIndex(result->itemInternalIndex);
+	auto index = LocateItemByInternalIndex(result.itemInternalIndex);
 
 	if (!index)
 	{
@@ -265,7 +261,7 @@ void CShellBrowser::ProcessInfoTipResult(int infoTipResultId)
 	}
 
 	TCHAR infoTipText[256];
-	StringCchCopy(infoTipText, SIZEOF_ARRAY(infoTipText), result->infoTip.c_str());
+	StringCchCopy(infoTipText, SIZEOF_ARRAY(infoTipText), result.infoTip.c_str());
 
 	LVSETINFOTIP infoTip;
 	infoTip.cbSize = sizeof(infoTip);
@@ -276,8 +272,85 @@ void CShellBrowser::ProcessInfoTipResult(int infoTipResultId)
 	ListView_SetInfoTip(m_hListView, &infoTip);
 }
 
+/* Applies every result that's arrived since the last time this
+was called. Redrawing is suspended while the results are
+applied, so that the listview is only repainted once, rather
+than once per cell. Results for a previous folder are
+dropped. */
+void CShellBrowser::ProcessItemResults()
+{
+	// Any result added from this point on will cause another
+	// message to be posted.
+	m_itemResults->notifier.onDrainStarted();
+
+	auto columnResults = TakeCurrentResults(m_itemResults->columnResults, m_itemResultGeneration);
+	auto folderSizeResults = TakeCurrentResults(m_itemResults->folderSizeResults, m_itemResultGeneration);
+	auto iconResults = TakeCurrentResults(m_itemResults->iconResults, m_itemResultGeneration);
+	auto thumbnailResults = TakeCurrentResults(m_itemResults->thumbnailResults, m_itemResultGeneration);
+	auto infoTipResults = TakeCurrentResults(m_itemResults->infoTipResults, m_itemResultGeneration);
+
+	for (const auto &infoTipResult : infoTipResults)
+	{
+		ProcessInfoTipResult(infoTipResult);
+	}
+
+	if (columnResults.empty() && folderSizeResults.empty()
+		&& iconResults.empty() && thumbnailResults.empty())
+	{
+		return;
+	}
+
+	ColumnIndexMap_t columnIndexes;
+
+	if (!columnResults.empty() || !folderSizeResults.empty())
+	{
+		columnIndexes = GetColumnIndexMap();
+	}
+
+	UpdatedRowRange updatedRows;
+
+	SendMessage(m_hListView, WM_SETREDRAW, FALSE, 0);
+
+	for (const auto &columnResult : columnResults)
+	{
+		updatedRows.addRow(ProcessColumnResult(columnResult, columnIndexes));
+	}
+
+	for (const auto &folderSizeResult : folderSizeResults)
+	{
+		updatedRows.addRow(ProcessFolderSizeResult(folderSizeResult, columnIndexes));
+	}
+
+	for (const auto &iconResult : iconResults)
+	{
+		updatedRows.addRow(ProcessIconResult(iconResult));
+	}
+
+	for (const auto &thumbnailResult : thumbnailResults)
+	{
+		updatedRows.addRow(ProcessThumbnailResult(thumbnailResult));
+	}
+
+	SendMessage(m_hListView, WM_SETREDRAW, TRUE, 0);
+
+	if (!updatedRows.isEmpty())
+	{
+		ListView_RedrawItems(m_hListView, updatedRows.getFirstRow(), updatedRows.getLastRow());
+	}
+}
+
 int CShellBrowser::GetItemInternalIndex(int item) const
 {
+	if (m_ownerDataListView)
+	{
+		if (item < 0 || item >= m_itemRows.size())
+		{
+			throw std::runtime_error("Item lookup failed");
+		}
+
+		return m_itemRows.getInternalIndex(item);
+	}
+
 	LVITEM lvItem;
 	lvItem.mask = LVIF_PARAM;
 	lvItem.iItem = item;
@@ -290,4 +363,145 @@ int CShellBrowser::GetItemInternalIndex(int item) const
 	}
 
 	return static_cast<int>(lvItem.lParam);
+}
+
+bool CShellBrowser::IsItemInViewport(int internalIndex) const
+{
+	auto index = LocateItemByInternalIndex(internalIndex);
+
+	if (!index)
+	{
+		return false;
+	}
+
+	RECT itemRect;
+	BOOL res = ListView_GetItemRect(m_hListView, *index, &itemRect, LVIR_BOUNDS);
+
+	if (!res)
+	{
+		return false;
+	}
+
+	RECT clientRect;
+	GetClientRect(m_hListView, &clientRect);
+
+	RECT intersectionRect;
+	return IntersectRect(&intersectionRect, &itemRect, &clientRect) != FALSE;
+}
+
+/* Tasks are queued as items are painted. When scrolling quickly
+through a large folder, most of the items painted along the way
+will no longer be visible by the time their tasks would run, so
+those tasks are dropped here. They'll be queued again if the
+items are scrolled back into view. */
+void CShellBrowser::CancelOffscreenItemTasks()
+{
+	CancelItemTasks([this] (const ItemTaskScheduler::TaskKey &key) {
+		return !IsItemInViewport(key.itemId);
+	});
+}
+
+void CShellBrowser::CancelItemTasks(int internalIndex)
+{
+	CancelItemTasks([internalIndex] (const ItemTaskScheduler::TaskKey &key) {
+		return key.itemId == internalIndex;
+	});
+}
+
+void CShellBrowser::CancelItemTasks(std::function<bool(const ItemTaskScheduler::TaskKey &key)> shouldCancel)
+{
+	auto cancelledTasks = m_itemTaskScheduler->CancelTasks(m_ID, shouldCancel);
+
+	for (const auto &cancelledTask : cancelledTasks)
+	{
+		ResetCancelledItemTask(cancelledTask);
+	}
+}
+
+/* The listview (or, in owner data mode, m_ownerDataItems) has
+already been given a placeholder for the cancelled cell. That
+placeholder is removed here, so that the cell will be requested
+again the next time it's shown. */
+void CShellBrowser::ResetCancelledItemTask(const ItemTaskScheduler::TaskKey &cancelledTask)
+{
+	int internalIndex = cancelledTask.itemId;
+
+	// Infotips are only requested while the mouse is over an
+	// item, so there's nothing to reset.
+	if (cancelledTask.taskType == ITEM_TASK_INFOTIP)
+	{
+		return;
+	}
+
+	if (cancelledTask.taskType == ITEM_TASK_ICON || cancelledTask.taskType == ITEM_TASK_THUMBNAIL)
+	{
+		if (m_ownerDataListView)
+		{
+			auto itr = m_ownerDataItems.find(internalIndex);
+
+			if (itr != m_ownerDataItems.end())
+			{
+				itr->second.iImage = -1;
+			}
+
+			return;
+		}
+
+		auto index = LocateItemByInternalIndex(internalIndex);
+
+		if (!index)
+		{
+			return;
+		}
+
+		LVITEM lvItem;
+		lvItem.mask = LVIF_IMAGE;
+		lvItem.iItem = *index;
+		lvItem.iSubItem = 0;
+		lvItem.iImage = I_IMAGECALLBACK;
+		ListView_SetItem(m_hListView, &lvItem);
+
+		return;
+	}
+
+	if (cancelledTask.taskType == ITEM_TASK_VERSION_INFO_COLUMNS
+		|| cancelledTask.taskType == ITEM_TASK_MEDIA_METADATA_COLUMNS)
+	{
+		ColumnBundle_t bundle = (cancelledTask.taskType == ITEM_TASK_VERSION_INFO_COLUMNS)
+			? COLUMN_BUNDLE_VERSION_INFO : COLUMN_BUNDLE_MEDIA_METADATA;
+
+		for (unsigned int columnID : GetColumnIdsInBundle(bundle))
+		{
+			ResetCancelledColumnText(internalIndex, columnID);
+		}
+
+		return;
+	}
+
+	ResetCancelledColumnText(internalIndex, static_cast<unsigned int>(cancelledTask.taskType));
+}
+
+void CShellBrowser::ResetCancelledColumnText(int internalIndex, unsigned int columnID)
+{
+	if (m_ownerDataListView)
+	{
+		auto itr = m_ownerDataItems.find(internalIndex);
+
+		if (itr != m_ownerDataItems.end())
+		{
+			itr->second.columnText.erase(columnID);
+		}
+
+		return;
+	}
+
+	auto index = LocateItemByInternalIndex(internalIndex);
+	auto columnIndex = GetColumnIndexById(columnID);
+
+	if (!index || !columnIndex)
+	{
+		return;
+	}
+
+	ListView_SetItemText(m_hListView, *index, *columnIndex, LPSTR_TEXTCALLBACK);
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ListViewGroupSet.h"
+
+void ListViewGroupSet::clear()
+{
+	m_groups.clear();
+	m_groupIdsByKey.clear();
+}
+
+std::pair<int, bool> ListViewGroupSet::addItem(const std::wstring &header)
+{
+	std::wstring key = getKey(header);
+	auto itr = m_groupIdsByKey.find(key);
+
+	if (itr != m_groupIdsByKey.end())
+	{
+		m_groups[itr->second].numItems++;
+		return { itr->second, false };
+	}
+
+	int id = static_cast<int>(m_groups.size());
+
+	Group group;
+	group.header = header;
+	group.id = id;
+	group.numItems = 1;
+	group.numItemsShown = 0;
+	m_groups.push_back(group);
+
+	m_groupIdsByKey.emplace(key, id);
+
+	return { id, true };
+}
+
+const ListViewGroupSet::Group *ListViewGroupSet::getGroup(int id) const
+{
+	if (id < 0 || id >= static_cast<int>(m_groups.size()))
+	{
+		return nullptr;
+	}
+
+	return &m_groups[id];
+}
+
+std::vector<ListViewGroupSet::Group> ListViewGroupSet::takeChangedGroups()
+{
+	std::vector<Group> changedGroups;
+
+	for (auto &group : m_groups)
+	{
+		if (group.numItems == group.numItemsShown)
+		{
+			continue;
+		}
+
+		group.numItemsShown = group.numItems;
+		changedGroups.push_back(group);
+	}
+
+	return changedGroups;
+}
+
+std::wstring ListViewGroupSet::getKey(const std::wstring &header)
+{
+	if (header.empty())
+	{
+		return header;
+	}
+
+	std::wstring key(header.size(), L'\0');
+	int numChars = LCMapString(LOCALE_USER_DEFAULT, LCMAP_LOWERCASE, header.c_str(),
+		static_cast<int>(header.size()), &key[0], static_cast<int>(key.size()));
+
+	if (numChars == 0)
+	{
+		return header;
+	}
+
+	key.resize(numChars);
+
+	return key;
+}
@@ -0,0 +1,56 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Tracks the groups shown in the listview, along with the number of
+// items in each group.
+//
+// Headers are matched case-insensitively, so that an item's group can
+// be found without comparing against every existing header. The item
+// count shown in each header is only updated on request (see
+// takeChangedGroups), rather than every time an item is added.
+class ListViewGroupSet
+{
+public:
+
+	struct Group
+	{
+		std::wstring header;
+		int id;
+
+		// Mimics the item count shown in group headers in Windows Vista
+		// and later.
+		int numItems;
+		int numItemsShown;
+	};
+
+	void clear();
+
+	// Adds an item to the group with the specified header, creating the
+	// group if necessary. Returns the id of the group and whether it
+	// was created.
+	std::pair<int, bool> addItem(const std::wstring &header);
+
+	const Group *getGroup(int id) const;
+
+	// Returns each group whose item count has changed since it was last
+	// returned from here. The counts are then considered to be shown.
+	std::vector<Group> takeChangedGroups();
+
+private:
+
+	static std::wstring getKey(const std::wstring &header);
+
+	// Indexed by group id.
+	std::vector<Group> m_groups;
+
+	// Maps the lowercased header of each group to its id.
+	std::unordered_map<std::wstring, int> m_groupIdsByKey;
+};
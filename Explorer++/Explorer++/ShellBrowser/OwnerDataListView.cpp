@@ -0,0 +1,370 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+/* Support for showing folders in an owner data (LVS_OWNERDATA)
+listview. In this mode, the listview only tracks the number of
+items, along with their selection and focus state. The order of
+items comes from m_itemRows, while text, images and the remaining
+state are supplied on demand in response to LVN_GETDISPINFO. That
+means that sorting and filtering only need to rearrange m_itemRows,
+rather than moving items around within the listview. */
+
+#include "stdafx.h"
+#include "iShellView.h"
+#include "Config.h"
+#include "OwnerDataSelection.h"
+
+/* Nothing is inserted into the listview here. Each item
+is added to m_itemRows and the listview is then told the
+new item count. */
+void CShellBrowser::InsertAwaitingItemsOwnerData()
+{
+	int nPrevItems = m_itemRows.size();
+	int nAdded = 0;
+
+	UpdateOwnerDataRows([this,&nAdded] {
+		for(const auto &awaitingAdd : m_AwaitingAddList)
+		{
+			if(IsFileFiltered(awaitingAdd.iItemInternal))
+			{
+				m_itemFilter.setItemVisible(awaitingAdd.iItemInternal,false);
+				continue;
+			}
+
+			int iItemIndex = awaitingAdd.iItem;
+
+			if(iItemIndex < 0 || iItemIndex > m_itemRows.size())
+			{
+				iItemIndex = m_itemRows.size();
+			}
+
+			m_itemRows.insertItem(iItemIndex,awaitingAdd.iItemInternal);
+			m_itemFilter.setItemVisible(awaitingAdd.iItemInternal,true);
+
+			if(m_bNewItemCreated)
+			{
+				if(CompareIdls(m_itemStore.getPidlComplete(awaitingAdd.iItemInternal),m_pidlNewItem))
+					m_bNewItemCreated = FALSE;
+
+				m_iIndexNewItem = iItemIndex;
+			}
+
+			ULARGE_INTEGER ulFileSize;
+			ulFileSize.QuadPart = m_itemStore.getSize(awaitingAdd.iItemInternal);
+
+			m_ulTotalDirSize.QuadPart += ulFileSize.QuadPart;
+
+			nAdded++;
+		}
+	});
+
+	/* Tile text is stored by item, so can only be
+	set once the rows are in place. */
+	if(m_folderSettings.viewMode == +ViewMode::Tiles)
+	{
+		for(const auto &awaitingAdd : m_AwaitingAddList)
+		{
+			auto iItem = LocateItemByInternalIndex(awaitingAdd.iItemInternal);
+
+			if(iItem)
+			{
+				SetTileViewItemInfo(*iItem,awaitingAdd.iItemInternal);
+			}
+		}
+	}
+
+	m_nTotalItems = nPrevItems + nAdded;
+
+	m_AwaitingAddList.clear();
+	m_nAwaitingAdd = 0;
+}
+
+void CShellBrowser::OnListViewGetDisplayInfoOwnerData(NMLVDISPINFO *pnmv)
+{
+	LVITEM *plvItem = &pnmv->item;
+
+	if(plvItem->iItem < 0 || plvItem->iItem >= m_itemRows.size())
+	{
+		return;
+	}
+
+	int internalIndex = m_itemRows.getInternalIndex(plvItem->iItem);
+	OwnerDataItem_t &ownerDataItem = GetOwnerDataItem(internalIndex);
+
+	if((plvItem->mask & LVIF_PARAM) == LVIF_PARAM)
+	{
+		plvItem->lParam = internalIndex;
+	}
+
+	if((plvItem->mask & LVIF_TEXT) == LVIF_TEXT && plvItem->cchTextMax > 0)
+	{
+		std::wstring text;
+
+		if(plvItem->iSubItem == 0)
+		{
+			text = ProcessItemFileName(getBasicItemInfo(internalIndex), m_config->globalFolderSettings);
+		}
+		else if(m_folderSettings.viewMode == +ViewMode::Details)
+		{
+			auto columnID = GetColumnIdByIndex(plvItem->iSubItem);
+
+			if(columnID)
+			{
+				auto itr = ownerDataItem.columnText.find(*columnID);
+
+				if(itr != ownerDataItem.columnText.end())
+				{
+					text = itr->second;
+				}
+				else
+				{
+					/* An empty entry is added here, so that the
+					column text isn't requested again each time
+					the item is redrawn before the result arrives. */
+					ownerDataItem.columnText.insert({ *columnID, L"" });
+					QueueColumnTask(internalIndex, plvItem->iSubItem);
+				}
+			}
+		}
+		else if(m_folderSettings.viewMode == +ViewMode::Tiles)
+		{
+			size_t tileIndex = static_cast<size_t>(plvItem->iSubItem - 1);
+
+			if(tileIndex < ownerDataItem.tileText.size())
+			{
+				text = ownerDataItem.tileText[tileIndex];
+			}
+		}
+
+		StringCchCopy(plvItem->pszText, plvItem->cchTextMax, text.c_str());
+	}
+
+	if((plvItem->mask & LVIF_COLUMNS) == LVIF_COLUMNS && m_folderSettings.viewMode == +ViewMode::Tiles)
+	{
+		if(plvItem->puColumns != NULL && plvItem->cColumns >= 2)
+		{
+			plvItem->puColumns[0] = 1;
+			plvItem->puColumns[1] = 2;
+			plvItem->cColumns = 2;
+		}
+		else
+		{
+			plvItem->cColumns = 0;
+		}
+	}
+
+	if((plvItem->mask & LVIF_IMAGE) == LVIF_IMAGE)
+	{
+		if(ownerDataItem.iImage == -1)
+		{
+			/* The image assigned here will be shown until the
+			real icon/thumbnail has been found. */
+			if(m_folderSettings.viewMode == +ViewMode::Thumbnails)
+			{
+				ownerDataItem.iImage = GetIconThumbnail(internalIndex);
+				QueueThumbnailTask(internalIndex);
+			}
+			else
+			{
+				auto cachedIconIndex = GetCachedIconIndex(internalIndex);
+
+				if(cachedIconIndex)
+				{
+					ownerDataItem.iImage = *cachedIconIndex;
+				}
+				else if((m_itemStore.getAttributes(internalIndex) & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY)
+				{
+					ownerDataItem.iImage = m_iFolderIcon;
+				}
+				else
+				{
+					ownerDataItem.iImage = m_iFileIcon;
+				}
+
+				QueueIconTask(internalIndex, cachedIconIndex != boost::none);
+			}
+		}
+
+		if(m_folderSettings.viewMode == +ViewMode::Thumbnails)
+		{
+			plvItem->iImage = ownerDataItem.iImage;
+		}
+		else
+		{
+			plvItem->iImage = ownerDataItem.iImage & 0x00FFFFFF;
+		}
+	}
+
+	if((plvItem->mask & LVIF_STATE) == LVIF_STATE)
+	{
+		plvItem->state = 0;
+
+		if((plvItem->stateMask & LVIS_OVERLAYMASK) && ownerDataItem.iImage != -1
+			&& m_folderSettings.viewMode != +ViewMode::Thumbnails)
+		{
+			plvItem->state |= INDEXTOOVERLAYMASK(static_cast<UINT>(ownerDataItem.iImage) >> 24);
+		}
+
+		/* Hidden items are always ghosted. */
+		if((plvItem->stateMask & LVIS_CUT) &&
+			((m_itemStore.getAttributes(internalIndex) & FILE_ATTRIBUTE_HIDDEN) || ownerDataItem.bGhosted))
+		{
+			plvItem->state |= LVIS_CUT;
+		}
+	}
+}
+
+/* Used for type-ahead searching. The listview can't search item
+text itself in this mode. */
+int CShellBrowser::OnListViewFindItem(const NMLVFINDITEM *findItem) const
+{
+	const LVFINDINFO &findInfo = findItem->lvfi;
+
+	if((findInfo.flags & (LVFI_STRING|LVFI_PARTIAL)) == 0 || findInfo.psz == NULL)
+	{
+		return -1;
+	}
+
+	int nItems = m_itemRows.size();
+
+	if(nItems == 0)
+	{
+		return -1;
+	}
+
+	int iStart = findItem->iStart;
+
+	if(iStart < 0 || iStart >= nItems)
+	{
+		iStart = 0;
+	}
+
+	size_t searchLength = lstrlen(findInfo.psz);
+
+	for(int i = 0;i < nItems;i++)
+	{
+		if(iStart + i >= nItems && (findInfo.flags & LVFI_WRAP) != LVFI_WRAP)
+		{
+			break;
+		}
+
+		int iItem = (iStart + i) % nItems;
+		const TCHAR *displayName = m_itemStore.getDisplayName(m_itemRows.getInternalIndex(iItem));
+
+		BOOL bMatch;
+
+		if((findInfo.flags & LVFI_PARTIAL) == LVFI_PARTIAL)
+		{
+			bMatch = (_wcsnicmp(displayName, findInfo.psz, searchLength) == 0);
+		}
+		else
+		{
+			bMatch = (lstrcmpi(displayName, findInfo.psz) == 0);
+		}
+
+		if(bMatch)
+		{
+			return iItem;
+		}
+	}
+
+	return -1;
+}
+
+CShellBrowser::OwnerDataItem_t &CShellBrowser::GetOwnerDataItem(int internalIndex)
+{
+	auto itr = m_ownerDataItems.find(internalIndex);
+
+	if(itr != m_ownerDataItems.end())
+	{
+		return itr->second;
+	}
+
+	OwnerDataItem_t ownerDataItem;
+	ownerDataItem.iImage = -1;
+	ownerDataItem.bGhosted = FALSE;
+
+	return m_ownerDataItems.insert({ internalIndex, std::move(ownerDataItem) }).first->second;
+}
+
+/* Discards any text and image data held for the
+specified item, so that it will be retrieved again
+the next time the item is drawn. */
+void CShellBrowser::InvalidateOwnerDataItem(int internalIndex)
+{
+	auto itr = m_ownerDataItems.find(internalIndex);
+
+	if(itr != m_ownerDataItems.end())
+	{
+		itr->second.iImage = -1;
+		itr->second.columnText.clear();
+		itr->second.tileText.clear();
+	}
+
+	auto iItem = LocateItemByInternalIndex(internalIndex);
+
+	if(iItem)
+	{
+		ListView_RedrawItems(m_hListView,*iItem,*iItem);
+	}
+}
+
+/* Called when the listview imagelist changes. Any image
+indices that have been stored refer to the previous
+imagelist. */
+void CShellBrowser::ResetOwnerDataImages()
+{
+	for(auto &ownerDataItem : m_ownerDataItems)
+	{
+		ownerDataItem.second.iImage = -1;
+	}
+
+	InvalidateRect(m_hListView,NULL,TRUE);
+}
+
+/* Runs the supplied function (which is expected to
+reorder or resize m_itemRows), then updates the listview
+to match. As the listview tracks selection by row, the
+selected and focused items are reapplied afterwards. */
+void CShellBrowser::UpdateOwnerDataRows(const std::function<void()> &updateRows)
+{
+	std::vector<int> selectedRows;
+	int iItem = -1;
+
+	while((iItem = ListView_GetNextItem(m_hListView,iItem,LVNI_SELECTED)) != -1)
+	{
+		selectedRows.push_back(iItem);
+	}
+
+	boost::optional<int> focusedRow;
+	int iFocused = ListView_GetNextItem(m_hListView,-1,LVNI_FOCUSED);
+
+	if(iFocused != -1)
+	{
+		focusedRow = iFocused;
+	}
+
+	OwnerDataSelection selection(m_itemRows,selectedRows,focusedRow);
+
+	updateRows();
+
+	ListView_SetItemCountEx(m_hListView,m_itemRows.size(),LVSICF_NOSCROLL);
+
+	if(selection.hasSelection())
+	{
+		ListView_SetItemState(m_hListView,-1,0,LVIS_SELECTED);
+
+		for(int iRow : selection.getSelectedRows(m_itemRows))
+		{
+			ListView_SetItemState(m_hListView,iRow,LVIS_SELECTED,LVIS_SELECTED);
+		}
+	}
+
+	auto iFocusedRow = selection.getFocusedRow(m_itemRows);
+
+	if(iFocusedRow)
+	{
+		ListView_SetItemState(m_hListView,*iFocusedRow,LVIS_FOCUSED,LVIS_FOCUSED);
+	}
+}
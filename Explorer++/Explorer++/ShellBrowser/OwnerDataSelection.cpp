@@ -0,0 +1,53 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "OwnerDataSelection.h"
+#include "ItemRowMap.h"
+
+OwnerDataSelection::OwnerDataSelection(const ItemRowMap &itemRows, const std::vector<int> &selectedRows,
+	boost::optional<int> focusedRow)
+{
+	for (int row : selectedRows)
+	{
+		m_selectedItems.push_back(itemRows.getInternalIndex(row));
+	}
+
+	if (focusedRow)
+	{
+		m_focusedItem = itemRows.getInternalIndex(*focusedRow);
+	}
+}
+
+bool OwnerDataSelection::hasSelection() const
+{
+	return !m_selectedItems.empty();
+}
+
+std::vector<int> OwnerDataSelection::getSelectedRows(const ItemRowMap &itemRows) const
+{
+	std::vector<int> selectedRows;
+
+	for (int internalIndex : m_selectedItems)
+	{
+		auto row = itemRows.getRow(internalIndex);
+
+		if (row)
+		{
+			selectedRows.push_back(*row);
+		}
+	}
+
+	return selectedRows;
+}
+
+boost::optional<int> OwnerDataSelection::getFocusedRow(const ItemRowMap &itemRows) const
+{
+	if (!m_focusedItem)
+	{
+		return boost::none;
+	}
+
+	return itemRows.getRow(*m_focusedItem);
+}
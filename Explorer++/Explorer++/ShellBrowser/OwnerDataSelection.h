@@ -0,0 +1,36 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <vector>
+
+class ItemRowMap;
+
+// An owner data listview tracks selection and focus by row. When the
+// rows are rearranged (e.g. by sorting or filtering), that state would
+// stay with the row, rather than the item. This records the selected
+// and focused items before the rows change, so that the state can then
+// be moved to the rows those items end up in.
+class OwnerDataSelection
+{
+public:
+
+	OwnerDataSelection(const ItemRowMap &itemRows, const std::vector<int> &selectedRows,
+		boost::optional<int> focusedRow);
+
+	bool hasSelection() const;
+
+	// Returns the rows the selected items now occupy. Items that are no
+	// longer shown are skipped.
+	std::vector<int> getSelectedRows(const ItemRowMap &itemRows) const;
+	boost::optional<int> getFocusedRow(const ItemRowMap &itemRows) const;
+
+private:
+
+	// Internal indices.
+	std::vector<int> m_selectedItems;
+	boost::optional<int> m_focusedItem;
+};
@@ -0,0 +1,103 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "../ThirdParty/CTPL/cpl_stl.h"
+#include <algorithm>
+#include <future>
+#include <iterator>
+#include <vector>
+
+// Sorts the range [first, last) using the threads in the supplied pool.
+// The range is split into one chunk per thread, each chunk is sorted
+// independently and adjacent chunks are then merged in pairs until a
+// single sorted range remains. Each round of merges runs in parallel as
+// well, so only the final merge is performed on a single thread.
+//
+// This function blocks until the sort is complete. The comparison
+// function will be called concurrently, so it must not modify any
+// shared state.
+template <typename RandomIt, typename Compare>
+void ParallelSort(ctpl::thread_pool &threadPool, RandomIt first, RandomIt last, Compare comp)
+{
+	auto numItems = std::distance(first, last);
+	auto numChunks = static_cast<decltype(numItems)>(threadPool.size());
+
+	if (numChunks < 2 || numItems < numChunks * 2)
+	{
+		std::sort(first, last, comp);
+		return;
+	}
+
+	// Chunk i covers [boundaries[i], boundaries[i + 1]).
+	std::vector<RandomIt> boundaries;
+	boundaries.reserve(numChunks + 1);
+
+	for (decltype(numItems) i = 0; i < numChunks; i++)
+	{
+		boundaries.push_back(first + (numItems * i) / numChunks);
+	}
+
+	boundaries.push_back(last);
+
+	std::vector<std::future<void>> futures;
+	futures.reserve(numChunks);
+
+	for (size_t i = 0; i + 1 < boundaries.size(); i++)
+	{
+		RandomIt chunkFirst = boundaries[i];
+		RandomIt chunkLast = boundaries[i + 1];
+
+		futures.push_back(threadPool.push([chunkFirst, chunkLast, &comp] (int id) {
+			UNREFERENCED_PARAMETER(id);
+
+			std::sort(chunkFirst, chunkLast, comp);
+		}));
+	}
+
+	for (auto &future : futures)
+	{
+		future.get();
+	}
+
+	while (boundaries.size() > 2)
+	{
+		std::vector<RandomIt> mergedBoundaries;
+		mergedBoundaries.reserve(boundaries.size() / 2 + 2);
+
+		futures.clear();
+
+		size_t i;
+
+		for (i = 0; i + 2 < boundaries.size(); i += 2)
+		{
+			RandomIt mergeFirst = boundaries[i];
+			RandomIt mergeMiddle = boundaries[i + 1];
+			RandomIt mergeLast = boundaries[i + 2];
+
+			futures.push_back(threadPool.push([mergeFirst, mergeMiddle, mergeLast, &comp] (int id) {
+				UNREFERENCED_PARAMETER(id);
+
+				std::inplace_merge(mergeFirst, mergeMiddle, mergeLast, comp);
+			}));
+
+			mergedBoundaries.push_back(mergeFirst);
+		}
+
+		// If there are an odd number of chunks, the last one is carried
+		// over to the next round unchanged.
+		for (; i < boundaries.size(); i++)
+		{
+			mergedBoundaries.push_back(boundaries[i]);
+		}
+
+		for (auto &future : futures)
+		{
+			future.get();
+		}
+
+		boundaries = std::move(mergedBoundaries);
+	}
+}
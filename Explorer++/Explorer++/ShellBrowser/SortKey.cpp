@@ -0,0 +1,160 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "SortKey.h"
+#include <propvarutil.h>
+
+SortKey::SortKey() :
+	internalIndex(-1),
+	isFolder(false),
+	precedence(0),
+	number(0)
+{
+	VariantInit(&variant);
+}
+
+SortKey::SortKey(SortKey &&other) :
+	internalIndex(other.internalIndex),
+	isFolder(other.isFolder),
+	precedence(other.precedence),
+	number(other.number),
+	collationKey(std::move(other.collationKey)),
+	variant(other.variant),
+	displayNameCollationKey(std::move(other.displayNameCollationKey))
+{
+	VariantInit(&other.variant);
+}
+
+SortKey &SortKey::operator=(SortKey &&other)
+{
+	if (this != &other)
+	{
+		VariantClear(&variant);
+
+		internalIndex = other.internalIndex;
+		isFolder = other.isFolder;
+		precedence = other.precedence;
+		number = other.number;
+		collationKey = std::move(other.collationKey);
+		variant = other.variant;
+		displayNameCollationKey = std::move(other.displayNameCollationKey);
+
+		VariantInit(&other.variant);
+	}
+
+	return *this;
+}
+
+SortKey::~SortKey()
+{
+	VariantClear(&variant);
+}
+
+static int CompareValues(ULONGLONG value1, ULONGLONG value2)
+{
+	if (value1 < value2)
+	{
+		return -1;
+	}
+	else if (value1 > value2)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+static int CompareCollationKeys(const std::string &collationKey1, const std::string &collationKey2)
+{
+	int res = collationKey1.compare(collationKey2);
+
+	if (res < 0)
+	{
+		return -1;
+	}
+	else if (res > 0)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+int CompareSortKeys(const SortKey &sortKey1, const SortKey &sortKey2, bool foldersFirst, bool ascending)
+{
+	int res = 0;
+
+	if (foldersFirst && (sortKey1.isFolder != sortKey2.isFolder))
+	{
+		res = sortKey1.isFolder ? -1 : 1;
+	}
+	else
+	{
+		if (sortKey1.precedence != sortKey2.precedence)
+		{
+			res = (sortKey1.precedence < sortKey2.precedence) ? -1 : 1;
+		}
+
+		if (res == 0)
+		{
+			res = CompareValues(sortKey1.number, sortKey2.number);
+		}
+
+		if (res == 0)
+		{
+			res = CompareCollationKeys(sortKey1.collationKey, sortKey2.collationKey);
+		}
+
+		if (res == 0 && sortKey1.variant.vt != VT_EMPTY && sortKey1.variant.vt == sortKey2.variant.vt)
+		{
+			res = VariantCompare(sortKey1.variant, sortKey2.variant);
+		}
+
+		if (res == 0)
+		{
+			res = CompareCollationKeys(sortKey1.displayNameCollationKey, sortKey2.displayNameCollationKey);
+		}
+	}
+
+	if (!ascending)
+	{
+		res = -res;
+	}
+
+	return res;
+}
+
+// Returns a binary key that orders strings in the same way as comparing
+// them with CompareStringEx() would (ignoring case and treating runs of
+// digits as numbers, in the same way StrCmpLogicalW() does). Comparing
+// two keys is then a simple byte comparison.
+std::string GetCollationKey(const std::wstring &text)
+{
+	if (text.empty())
+	{
+		return std::string();
+	}
+
+	const DWORD flags = LCMAP_SORTKEY | NORM_IGNORECASE | SORT_DIGITSASNUMBERS;
+
+	int size = LCMapStringEx(LOCALE_NAME_USER_DEFAULT, flags, text.c_str(), static_cast<int>(text.size()),
+		NULL, 0, NULL, NULL, 0);
+
+	if (size == 0)
+	{
+		return std::string(reinterpret_cast<const char *>(text.c_str()), text.size() * sizeof(wchar_t));
+	}
+
+	// When LCMAP_SORTKEY is specified, the output is a byte array (and
+	// its size is given in bytes).
+	std::string collationKey(size, '\0');
+	size = LCMapStringEx(LOCALE_NAME_USER_DEFAULT, flags, text.c_str(), static_cast<int>(text.size()),
+		reinterpret_cast<LPWSTR>(&collationKey[0]), size, NULL, NULL, 0);
+
+	// The key is null-terminated, which isn't needed here.
+	collationKey.resize((size > 0) ? size - 1 : 0);
+
+	return collationKey;
+}
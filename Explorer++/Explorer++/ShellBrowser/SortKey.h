@@ -0,0 +1,38 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <string>
+
+// Holds everything needed to compare one item against another under a
+// particular sort mode. A key is built once per item (see
+// CShellBrowser::BuildSortKey()), so that the comparisons performed
+// while sorting don't need to call into the shell or allocate.
+struct SortKey
+{
+	SortKey();
+	SortKey(SortKey &&other);
+	SortKey &operator=(SortKey &&other);
+	~SortKey();
+
+	SortKey(const SortKey &) = delete;
+	SortKey &operator=(const SortKey &) = delete;
+
+	int internalIndex;
+	bool isFolder;
+
+	// The fields below are compared in order. Any field that isn't used
+	// by a particular sort mode is simply left at its default value.
+	int precedence;
+	ULONGLONG number;
+	std::string collationKey;
+	VARIANT variant;
+
+	// Items that are otherwise equal are sorted by display name.
+	std::string displayNameCollationKey;
+};
+
+int CompareSortKeys(const SortKey &sortKey1, const SortKey &sortKey2, bool foldersFirst, bool ascending);
+std::string GetCollationKey(const std::wstring &text);
@@ -7,24 +7,52 @@
 #include "ColumnDataRetrieval.h"
 #include "Config.h"
 #include "iShellBrowser_internal.h"
+#include "ParallelSort.h"
+#include "SortKey.h"
 #include "SortModes.h"
 #include "ViewModes.h"
 #include "../Helper/Controls.h"
 #include "../Helper/FileOperations.h"
-#include "../Helper/FolderSize.h"
+#include "../Helper/FolderSizeService.h"
 #include "../Helper/Helper.h"
 #include "../Helper/Macros.h"
 #include "../Helper/ShellHelper.h"
 #include <propkey.h>
 #include <propvarutil.h>
 #include <cassert>
+#include <algorithm>
 #include <list>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+static int CALLBACK SortBySortedPositionStub(LPARAM lParam1,LPARAM lParam2,LPARAM lParamSort)
+{
+	auto sortedPositions = reinterpret_cast<const std::unordered_map<int,int> *>(lParamSort);
+	return sortedPositions->at(static_cast<int>(lParam1)) - sortedPositions->at(static_cast<int>(lParam2));
+}
+
+/* Sorting only happens on the UI thread, so a single pool is
+shared between all tabs. It's only created the first time a
+folder large enough to be sorted in parallel is encountered. */
+static ctpl::thread_pool &GetSortThreadPool()
+{
+	static ctpl::thread_pool sortThreadPool(static_cast<int>((std::max)(std::thread::hardware_concurrency(), 1u)));
+	return sortThreadPool;
+}
+
+static ULONGLONG FileTimeToSortValue(const FILETIME &fileTime)
+{
+	ULARGE_INTEGER value = {fileTime.dwLowDateTime,fileTime.dwHighDateTime};
+	return value.QuadPart;
+}
 
 void CShellBrowser::SortFolder(SortMode sortMode)
 {
 	m_folderSettings.sortMode = sortMode;
 
-	if(m_folderSettings.showInGroups)
+	/* Owner data listviews don't support groups. */
+	if(m_folderSettings.showInGroups && !m_ownerDataListView)
 	{
 		ListView_EnableGroupView(m_hListView,FALSE);
 		ListView_RemoveAllGroups(m_hListView);
@@ -33,441 +61,349 @@ void CShellBrowser::SortFolder(SortMode sortMode)
 		SetShowInGroups(TRUE);
 	}
 
-	SendMessage(m_hListView,LVM_SORTITEMS,reinterpret_cast<WPARAM>(this),reinterpret_cast<LPARAM>(SortStub));
+	int nItems = ListView_GetItemCount(m_hListView);
 
-	/* If in details view, the column sort
-	arrow will need to be changed to reflect
-	the new sorting mode. */
-	if(m_folderSettings.viewMode == +ViewMode::Details)
+	/* Build a key for each item up-front and sort the
+	keys. This means that any work needed to retrieve
+	the sort data for an item happens only once, rather
+	than once per comparison. */
+	std::vector<SortKey> sortKeys;
+	sortKeys.reserve(nItems);
+
+	for(int i = 0;i < nItems;i++)
 	{
-		ApplyHeaderSortArrow();
+		sortKeys.push_back(BuildSortKey(GetItemInternalIndex(i)));
 	}
-}
 
-int CALLBACK SortStub(LPARAM lParam1,LPARAM lParam2,LPARAM lParamSort)
-{
-	CShellBrowser *pShellBrowser = reinterpret_cast<CShellBrowser *>(lParamSort);
-	return pShellBrowser->Sort(static_cast<int>(lParam1),static_cast<int>(lParam2));
-}
-
-/* Also see NBookmarkHelper::Sort. */
-int CALLBACK CShellBrowser::Sort(int InternalIndex1,int InternalIndex2) const
-{
-	int ComparisonResult = 0;
+	bool foldersFirst = !CompareVirtualFolders(CSIDL_BITBUCKET);
+	bool ascending = m_folderSettings.sortAscending ? true : false;
 
-	BasicItemInfo_t basicItemInfo1 = getBasicItemInfo(InternalIndex1);
-	BasicItemInfo_t basicItemInfo2 = getBasicItemInfo(InternalIndex2);
+	auto compareSortKeys = [foldersFirst,ascending](const SortKey &sortKey1,const SortKey &sortKey2) {
+		return CompareSortKeys(sortKey1,sortKey2,foldersFirst,ascending) < 0;
+	};
 
-	bool IsFolder1 = ((basicItemInfo1.wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY) ? true : false;
-	bool IsFolder2 = ((basicItemInfo2.wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY) ? true : false;
-	
-	/* Folders will always be sorted separately from files,
-	except in the recycle bin. */
-	if(IsFolder1 && !IsFolder2 && !CompareVirtualFolders(CSIDL_BITBUCKET))
+	/* Large folders are sorted across all available
+	cores. The keys are self-contained, so the
+	comparisons can safely run off the UI thread. */
+	if(static_cast<UINT>(nItems) >= m_config->globalFolderSettings.parallelSortThreshold)
 	{
-		ComparisonResult = -1;
-	}
-	else if(!IsFolder1 && IsFolder2 && !CompareVirtualFolders(CSIDL_BITBUCKET))
-	{
-		ComparisonResult = 1;
+		ParallelSort(GetSortThreadPool(),sortKeys.begin(),sortKeys.end(),compareSortKeys);
 	}
 	else
 	{
-		switch(m_folderSettings.sortMode)
-		{
-		case SortMode::Name:
-			ComparisonResult = SortByName(basicItemInfo1, basicItemInfo2, m_config->globalFolderSettings);
-			break;
-
-		case SortMode::Type:
-			ComparisonResult = SortByType(basicItemInfo1,basicItemInfo2);
-			break;
-
-		case SortMode::Size:
-			ComparisonResult = SortBySize(InternalIndex1,InternalIndex2);
-			break;
-
-		case SortMode::DateModified:
-			ComparisonResult = SortByDate(InternalIndex1,InternalIndex2,DATE_TYPE_MODIFIED);
-			break;
-
-		case SortMode::TotalSize:
-			ComparisonResult = SortByTotalSize(basicItemInfo1,basicItemInfo2,TRUE);
-			break;
-
-		case SortMode::FreeSpace:
-			ComparisonResult = SortByTotalSize(basicItemInfo1,basicItemInfo2,FALSE);
-			break;
-
-		case SortMode::DateDeleted:
-			ComparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2, &SCID_DATE_DELETED);
-			break;
-
-		case SortMode::OriginalLocation:
-			ComparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2, &SCID_ORIGINAL_LOCATION);
-			break;
-
-		case SortMode::Attributes:
-			ComparisonResult = SortByAttributes(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::RealSize:
-			ComparisonResult = SortByRealSize(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::ShortName:
-			ComparisonResult = SortByShortName(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::Owner:
-			ComparisonResult = SortByOwner(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::ProductName:
-			ComparisonResult = SortByVersionInfo(basicItemInfo1, basicItemInfo2,VERSION_INFO_PRODUCT_NAME);
-			break;
-
-		case SortMode::Company:
-			ComparisonResult = SortByVersionInfo(basicItemInfo1, basicItemInfo2,VERSION_INFO_COMPANY);
-			break;
+		std::sort(sortKeys.begin(),sortKeys.end(),compareSortKeys);
+	}
 
-		case SortMode::Description:
-			ComparisonResult = SortByVersionInfo(basicItemInfo1, basicItemInfo2,VERSION_INFO_DESCRIPTION);
-			break;
+	std::vector<int> sortedInternalIndices;
+	sortedInternalIndices.reserve(nItems);
 
-		case SortMode::FileVersion:
-			ComparisonResult = SortByVersionInfo(basicItemInfo1, basicItemInfo2,VERSION_INFO_FILE_VERSION);
-			break;
+	for(const auto &sortKey : sortKeys)
+	{
+		sortedInternalIndices.push_back(sortKey.internalIndex);
+	}
 
-		case SortMode::ProductVersion:
-			ComparisonResult = SortByVersionInfo(basicItemInfo1, basicItemInfo2,VERSION_INFO_PRODUCT_VERSION);
-			break;
+	if(m_ownerDataListView)
+	{
+		/* The rows are the only thing that needs to
+		change here. */
+		UpdateOwnerDataRows([this,&sortedInternalIndices] {
+			m_itemRows.setRows(std::move(sortedInternalIndices));
+		});
+	}
+	else
+	{
+		/* The listview can then be reordered in one pass,
+		with each comparison being a simple lookup. */
+		std::unordered_map<int,int> sortedPositions;
+		sortedPositions.reserve(nItems);
 
-		case SortMode::ShortcutTo:
-			ComparisonResult = SortByShortcutTo(basicItemInfo1, basicItemInfo2);
-			break;
+		for(int i = 0;i < nItems;i++)
+		{
+			sortedPositions[sortKeys[i].internalIndex] = i;
+		}
 
-		case SortMode::HardLinks:
-			ComparisonResult = SortByHardlinks(basicItemInfo1, basicItemInfo2);
-			break;
+		ListView_SortItems(m_hListView,SortBySortedPositionStub,reinterpret_cast<LPARAM>(&sortedPositions));
 
-		case SortMode::Extension:
-			ComparisonResult = SortByExtension(basicItemInfo1,basicItemInfo2);
-			break;
+		m_itemRows.setRows(std::move(sortedInternalIndices));
+	}
 
-		case SortMode::Created:
-			ComparisonResult = SortByDate(InternalIndex1,InternalIndex2,DATE_TYPE_CREATED);
-			break;
+	/* If in details view, the column sort
+	arrow will need to be changed to reflect
+	the new sorting mode. */
+	if(m_folderSettings.viewMode == +ViewMode::Details)
+	{
+		ApplyHeaderSortArrow();
+	}
+}
 
-		case SortMode::Accessed:
-			ComparisonResult = SortByDate(InternalIndex1,InternalIndex2,DATE_TYPE_ACCESSED);
-			break;
+/* Retrieves the data the current sort mode orders items
+by. Folders will always be sorted separately from files
+(except in the recycle bin), and items that are otherwise
+equal will be sub-sorted by their display names. */
+SortKey CShellBrowser::BuildSortKey(int InternalIndex) const
+{
+	BasicItemInfo_t basicItemInfo = getBasicItemInfo(InternalIndex);
 
-		case SortMode::Title:
-			ComparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2,&PKEY_Title);
-			break;
+	SortKey sortKey;
+	sortKey.internalIndex = InternalIndex;
+	sortKey.isFolder = ((m_itemStore.getAttributes(InternalIndex) & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY);
+	sortKey.displayNameCollationKey = GetCollationKey(m_itemStore.getDisplayName(InternalIndex));
 
-		case SortMode::Subject:
-			ComparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2,&PKEY_Subject);
-			break;
+	switch(m_folderSettings.sortMode)
+	{
+	case SortMode::Name:
+		BuildNameSortKey(basicItemInfo,sortKey);
+		break;
 
-		case SortMode::Authors:
-			ComparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2,&PKEY_Author);
-			break;
+	case SortMode::Type:
+		BuildTypeSortKey(basicItemInfo,sortKey);
+		break;
 
-		case SortMode::Keywords:
-			ComparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2,&PKEY_Keywords);
-			break;
+	case SortMode::Size:
+		BuildSizeSortKey(InternalIndex,sortKey);
+		break;
 
-		case SortMode::Comments:
-			ComparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2,&PKEY_Comment);
-			break;
+	case SortMode::DateModified:
+		sortKey.number = FileTimeToSortValue(m_itemStore.getLastWriteTime(InternalIndex));
+		break;
 
-		case SortMode::CameraModel:
-			ComparisonResult = SortByImageProperty(basicItemInfo1, basicItemInfo2,PropertyTagEquipModel);
-			break;
+	case SortMode::TotalSize:
+		BuildDriveSpaceSortKey(basicItemInfo,true,sortKey);
+		break;
 
-		case SortMode::DateTaken:
-			ComparisonResult = SortByImageProperty(basicItemInfo1, basicItemInfo2,PropertyTagDateTime);
-			break;
+	case SortMode::FreeSpace:
+		BuildDriveSpaceSortKey(basicItemInfo,false,sortKey);
+		break;
 
-		case SortMode::Width:
-			ComparisonResult = SortByImageProperty(basicItemInfo1, basicItemInfo2,PropertyTagImageWidth);
-			break;
+	case SortMode::DateDeleted:
+		BuildItemDetailsSortKey(basicItemInfo,&SCID_DATE_DELETED,sortKey);
+		break;
 
-		case SortMode::Height:
-			ComparisonResult = SortByImageProperty(basicItemInfo1, basicItemInfo2,PropertyTagImageHeight);
-			break;
+	case SortMode::OriginalLocation:
+		BuildItemDetailsSortKey(basicItemInfo,&SCID_ORIGINAL_LOCATION,sortKey);
+		break;
 
-		case SortMode::VirtualComments:
-			ComparisonResult = SortByVirtualComments(basicItemInfo1, basicItemInfo2);
-			break;
+	case SortMode::Attributes:
+		sortKey.collationKey = GetCollationKey(GetAttributeColumnText(basicItemInfo));
+		break;
 
-		case SortMode::FileSystem:
-			ComparisonResult = SortByFileSystem(basicItemInfo1,basicItemInfo2);
-			break;
+	case SortMode::RealSize:
+	{
+		ULARGE_INTEGER RealFileSize;
+		bool Res = GetRealSizeColumnRawData(basicItemInfo,RealFileSize);
 
-		case SortMode::NumPrinterDocuments:
-			ComparisonResult = SortByPrinterProperty(basicItemInfo1,basicItemInfo2,PRINTER_INFORMATION_TYPE_NUM_JOBS);
-			break;
+		/* Items without a size are placed first. */
+		sortKey.precedence = Res ? 1 : 0;
+		sortKey.number = Res ? RealFileSize.QuadPart : 0;
+	}
+		break;
 
-		case SortMode::PrinterStatus:
-			ComparisonResult = SortByPrinterProperty(basicItemInfo1,basicItemInfo2,PRINTER_INFORMATION_TYPE_STATUS);
-			break;
+	case SortMode::ShortName:
+		sortKey.collationKey = GetCollationKey(GetShortNameColumnText(basicItemInfo));
+		break;
 
-		case SortMode::PrinterComments:
-			ComparisonResult = SortByPrinterProperty(basicItemInfo1,basicItemInfo2,PRINTER_INFORMATION_TYPE_COMMENTS);
-			break;
+	case SortMode::Owner:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_OWNER,basicItemInfo));
+		break;
 
-		case SortMode::PrinterLocation:
-			ComparisonResult = SortByPrinterProperty(basicItemInfo1,basicItemInfo2,PRINTER_INFORMATION_TYPE_LOCATION);
-			break;
+	case SortMode::ProductName:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_PRODUCTNAME,basicItemInfo));
+		break;
 
-		case SortMode::NetworkAdapterStatus:
-			ComparisonResult = SortByNetworkAdapterStatus(basicItemInfo1,basicItemInfo2);
-			break;
+	case SortMode::Company:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_COMPANY,basicItemInfo));
+		break;
 
-		case SortMode::MediaBitrate:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_BITRATE);
-			break;
+	case SortMode::Description:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_DESCRIPTION,basicItemInfo));
+		break;
 
-		case SortMode::MediaCopyright:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_COPYRIGHT);
-			break;
+	case SortMode::FileVersion:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_FILEVERSION,basicItemInfo));
+		break;
 
-		case SortMode::MediaDuration:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_DURATION);
-			break;
+	case SortMode::ProductVersion:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_PRODUCTVERSION,basicItemInfo));
+		break;
 
-		case SortMode::MediaProtected:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_PROTECTED);
-			break;
+	case SortMode::ShortcutTo:
+		sortKey.collationKey = GetCollationKey(GetShortcutToColumnText(basicItemInfo));
+		break;
 
-		case SortMode::MediaRating:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_RATING);
-			break;
+	case SortMode::HardLinks:
+		sortKey.number = GetHardLinksColumnRawData(basicItemInfo,m_metadataCache);
+		break;
 
-		case SortMode::MediaAlbumArtist:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_ALBUM_ARTIST);
-			break;
+	case SortMode::Extension:
+		sortKey.collationKey = GetCollationKey(GetExtensionColumnText(basicItemInfo));
+		break;
 
-		case SortMode::MediaAlbum:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_ALBUM_TITLE);
-			break;
+	case SortMode::Created:
+		sortKey.number = FileTimeToSortValue(m_itemStore.getCreationTime(InternalIndex));
+		break;
 
-		case SortMode::MediaBeatsPerMinute:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_BEATS_PER_MINUTE);
-			break;
+	case SortMode::Accessed:
+		sortKey.number = FileTimeToSortValue(m_itemStore.getLastAccessTime(InternalIndex));
+		break;
 
-		case SortMode::MediaComposer:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_COMPOSER);
-			break;
+	case SortMode::Title:
+		BuildItemDetailsSortKey(basicItemInfo,&PKEY_Title,sortKey);
+		break;
 
-		case SortMode::MediaConductor:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_CONDUCTOR);
-			break;
+	case SortMode::Subject:
+		BuildItemDetailsSortKey(basicItemInfo,&PKEY_Subject,sortKey);
+		break;
 
-		case SortMode::MediaDirector:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_DIRECTOR);
-			break;
+	case SortMode::Authors:
+		BuildItemDetailsSortKey(basicItemInfo,&PKEY_Author,sortKey);
+		break;
 
-		case SortMode::MediaGenre:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_GENRE);
-			break;
+	case SortMode::Keywords:
+		BuildItemDetailsSortKey(basicItemInfo,&PKEY_Keywords,sortKey);
+		break;
 
-		case SortMode::MediaLanguage:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_LANGUAGE);
-			break;
+	case SortMode::Comments:
+		BuildItemDetailsSortKey(basicItemInfo,&PKEY_Comment,sortKey);
+		break;
 
-		case SortMode::MediaBroadcastDate:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_BROADCASTDATE);
-			break;
+	case SortMode::CameraModel:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_CAMERAMODEL,basicItemInfo));
+		break;
 
-		case SortMode::MediaChannel:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_CHANNEL);
-			break;
+	case SortMode::DateTaken:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_DATETAKEN,basicItemInfo));
+		break;
 
-		case SortMode::MediaStationName:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_STATIONNAME);
-			break;
+	case SortMode::Width:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_WIDTH,basicItemInfo));
+		break;
 
-		case SortMode::MediaMood:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_MOOD);
-			break;
+	case SortMode::Height:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_HEIGHT,basicItemInfo));
+		break;
 
-		case SortMode::MediaParentalRating:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_PARENTALRATING);
-			break;
+	case SortMode::VirtualComments:
+		sortKey.collationKey = GetCollationKey(GetControlPanelCommentsColumnText(basicItemInfo));
+		break;
 
-		case SortMode::MediaParentalRatingReason:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_PARENTALRATINGREASON);
-			break;
+	case SortMode::FileSystem:
+		sortKey.collationKey = GetCollationKey(GetFileSystemColumnText(basicItemInfo));
+		break;
 
-		case SortMode::MediaPeriod:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_PERIOD);
-			break;
+	case SortMode::NumPrinterDocuments:
+		sortKey.collationKey = GetCollationKey(GetPrinterColumnText(basicItemInfo,PRINTER_INFORMATION_TYPE_NUM_JOBS));
+		break;
 
-		case SortMode::MediaProducer:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_PRODUCER);
-			break;
+	case SortMode::PrinterStatus:
+		sortKey.collationKey = GetCollationKey(GetPrinterColumnText(basicItemInfo,PRINTER_INFORMATION_TYPE_STATUS));
+		break;
 
-		case SortMode::MediaPublisher:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_PUBLISHER);
-			break;
+	case SortMode::PrinterComments:
+		sortKey.collationKey = GetCollationKey(GetPrinterColumnText(basicItemInfo,PRINTER_INFORMATION_TYPE_COMMENTS));
+		break;
 
-		case SortMode::MediaWriter:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_WRITER);
-			break;
+	case SortMode::PrinterLocation:
+		sortKey.collationKey = GetCollationKey(GetPrinterColumnText(basicItemInfo,PRINTER_INFORMATION_TYPE_LOCATION));
+		break;
 
-		case SortMode::MediaYear:
-			ComparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,MEDIAMETADATA_TYPE_YEAR);
-			break;
+	case SortMode::NetworkAdapterStatus:
+		sortKey.collationKey = GetCollationKey(GetNetworkAdapterColumnText(basicItemInfo));
+		break;
 
-		default:
-			assert(false);
-			break;
-		}
-	}
+	case SortMode::MediaBitrate:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_BITRATE,basicItemInfo));
+		break;
 
-	if(ComparisonResult == 0)
-	{
-		/* By default, items that are equal will be sub-sorted
-		by their display names. */
-		ComparisonResult = StrCmpLogicalW(m_itemInfoMap.at(InternalIndex1).szDisplayName,
-			m_itemInfoMap.at(InternalIndex2).szDisplayName);
-	}
+	case SortMode::MediaCopyright:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_COPYRIGHT,basicItemInfo));
+		break;
 
-	if(!m_folderSettings.sortAscending)
-	{
-		ComparisonResult = -ComparisonResult;
-	}
+	case SortMode::MediaDuration:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_DURATION,basicItemInfo));
+		break;
 
-	return ComparisonResult;
-}
+	case SortMode::MediaProtected:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_PROTECTED,basicItemInfo));
+		break;
 
-int CALLBACK CShellBrowser::SortByName(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, const GlobalFolderSettings &globalFolderSettings) const
-{
-	if(m_bVirtualFolder)
-	{
-		BOOL IsRoot1 = PathIsRoot(itemInfo1.getFullPath().c_str());
-		BOOL IsRoot2 = PathIsRoot(itemInfo2.getFullPath().c_str());
+	case SortMode::MediaRating:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_RATING,basicItemInfo));
+		break;
 
-		if(IsRoot1 && !IsRoot2)
-		{
-			return -1;
-		}
-		else if(!IsRoot1 && IsRoot2)
-		{
-			return 1;
-		}
-		else if(IsRoot1 && IsRoot2)
-		{
-			/* If the items been compared are both drives,
-			sort by drive letter, rather than display name. */
-			return StrCmpLogicalW(itemInfo1.getFullPath().c_str(), itemInfo2.getFullPath().c_str());
-		}
-	}
+	case SortMode::MediaAlbumArtist:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_ALBUMARTIST,basicItemInfo));
+		break;
 
-	std::wstring Name1 = GetNameColumnText(itemInfo1, globalFolderSettings);
-	std::wstring Name2 = GetNameColumnText(itemInfo2, globalFolderSettings);
+	case SortMode::MediaAlbum:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_ALBUM,basicItemInfo));
+		break;
 
-	return StrCmpLogicalW(Name1.c_str(),Name2.c_str());
-}
+	case SortMode::MediaBeatsPerMinute:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_BEATSPERMINUTE,basicItemInfo));
+		break;
 
-int CALLBACK CShellBrowser::SortBySize(int InternalIndex1,int InternalIndex2) const
-{
-	bool IsFolder1 = ((m_itemInfoMap.at(InternalIndex1).wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY) ? true : false;
-	bool IsFolder2 = ((m_itemInfoMap.at(InternalIndex2).wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY) ? true : false;
+	case SortMode::MediaComposer:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_COMPOSER,basicItemInfo));
+		break;
 
-	ULONGLONG size1;
-	ULONGLONG size2;
-	
-	if(IsFolder1 && IsFolder2)
-	{
-		auto itr1 = m_cachedFolderSizes.find(InternalIndex1);
-		auto itr2 = m_cachedFolderSizes.find(InternalIndex2);
+	case SortMode::MediaConductor:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_CONDUCTOR,basicItemInfo));
+		break;
 
-		if (itr1 == m_cachedFolderSizes.end() && itr2 == m_cachedFolderSizes.end())
-		{
-			return 0;
-		}
-		else if (itr1 != m_cachedFolderSizes.end() && itr2 == m_cachedFolderSizes.end())
-		{
-			return 1;
-		}
-		else if (itr1 == m_cachedFolderSizes.end() && itr2 != m_cachedFolderSizes.end())
-		{
-			return -1;
-		}
+	case SortMode::MediaDirector:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_DIRECTOR,basicItemInfo));
+		break;
 
-		size1 = itr1->second;
-		size2 = itr2->second;
-	}
-	else
-	{
-		// Both items are files (as opposed to folders).
-		ULARGE_INTEGER FileSize1 = { m_itemInfoMap.at(InternalIndex1).wfd.nFileSizeLow,m_itemInfoMap.at(InternalIndex1).wfd.nFileSizeHigh };
-		ULARGE_INTEGER FileSize2 = { m_itemInfoMap.at(InternalIndex2).wfd.nFileSizeLow,m_itemInfoMap.at(InternalIndex2).wfd.nFileSizeHigh };
+	case SortMode::MediaGenre:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_GENRE,basicItemInfo));
+		break;
 
-		size1 = FileSize1.QuadPart;
-		size2 = FileSize2.QuadPart;
-	}
+	case SortMode::MediaLanguage:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_LANGUAGE,basicItemInfo));
+		break;
 
-	if(size1 > size2)
-	{
-		return 1;
-	}
-	else if(size1 < size2)
-	{
-		return -1;
-	}
+	case SortMode::MediaBroadcastDate:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_BROADCASTDATE,basicItemInfo));
+		break;
 
-	return 0;
-}
+	case SortMode::MediaChannel:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_CHANNEL,basicItemInfo));
+		break;
 
-int CALLBACK CShellBrowser::SortByType(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const
-{
-	if(m_bVirtualFolder)
-	{
-		TCHAR FullFileName1[MAX_PATH];
-		GetDisplayName(itemInfo1.pidlComplete.get(),FullFileName1,SIZEOF_ARRAY(FullFileName1),SHGDN_FORPARSING);
+	case SortMode::MediaStationName:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_STATIONNAME,basicItemInfo));
+		break;
 
-		TCHAR FullFileName2[MAX_PATH];
-		GetDisplayName(itemInfo2.pidlComplete.get(),FullFileName2,SIZEOF_ARRAY(FullFileName2),SHGDN_FORPARSING);
+	case SortMode::MediaMood:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_MOOD,basicItemInfo));
+		break;
 
-		BOOL IsRoot1 = PathIsRoot(FullFileName1);
-		BOOL IsRoot2 = PathIsRoot(FullFileName2);
+	case SortMode::MediaParentalRating:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_PARENTALRATING,basicItemInfo));
+		break;
 
-		if(IsRoot1 && !IsRoot2)
-		{
-			return -1;
-		}
-		else if(!IsRoot1 && IsRoot2)
-		{
-			return 1;
-		}
-	}
+	case SortMode::MediaParentalRatingReason:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_PARENTALRATINGREASON,basicItemInfo));
+		break;
 
-	std::wstring Type1 = GetTypeColumnText(itemInfo1);
-	std::wstring Type2 = GetTypeColumnText(itemInfo2);
+	case SortMode::MediaPeriod:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_PERIOD,basicItemInfo));
+		break;
 
-	return StrCmpLogicalW(Type1.c_str(),Type2.c_str());
-}
+	case SortMode::MediaProducer:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_PRODUCER,basicItemInfo));
+		break;
 
-int CALLBACK CShellBrowser::SortByDate(int InternalIndex1,int InternalIndex2,DateType_t DateType) const
-{
-	switch(DateType)
-	{
-	case DATE_TYPE_CREATED:
-		return CompareFileTime(&m_itemInfoMap.at(InternalIndex1).wfd.ftCreationTime,&m_itemInfoMap.at(InternalIndex2).wfd.ftCreationTime);
+	case SortMode::MediaPublisher:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_PUBLISHER,basicItemInfo));
 		break;
 
-	case DATE_TYPE_MODIFIED:
-		return CompareFileTime(&m_itemInfoMap.at(InternalIndex1).wfd.ftLastWriteTime,&m_itemInfoMap.at(InternalIndex2).wfd.ftLastWriteTime);
+	case SortMode::MediaWriter:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_WRITER,basicItemInfo));
 		break;
 
-	case DATE_TYPE_ACCESSED:
-		return CompareFileTime(&m_itemInfoMap.at(InternalIndex1).wfd.ftLastAccessTime,&m_itemInfoMap.at(InternalIndex2).wfd.ftLastAccessTime);
+	case SortMode::MediaYear:
+		sortKey.collationKey = GetCollationKey(GetCachedColumnText(CM_MEDIA_YEAR,basicItemInfo));
 		break;
 
 	default:
@@ -475,203 +411,101 @@ int CALLBACK CShellBrowser::SortByDate(int InternalIndex1,int InternalIndex2,Dat
 		break;
 	}
 
-	return 0;
+	return sortKey;
 }
 
-int CALLBACK CShellBrowser::SortByTotalSize(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, bool TotalSize) const
+void CShellBrowser::BuildNameSortKey(const BasicItemInfo_t &itemInfo, SortKey &sortKey) const
 {
-	ULARGE_INTEGER DriveSpace1;
-	BOOL Res1 = GetDriveSpaceColumnRawData(itemInfo1,TotalSize,DriveSpace1);
-
-	ULARGE_INTEGER DriveSpace2;
-	BOOL Res2 = GetDriveSpaceColumnRawData(itemInfo2,TotalSize,DriveSpace2);
-
-	if(Res1 && !Res2)
-	{
-		return 1;
-	}
-	else if(!Res1 && Res2)
-	{
-		return -1;
-	}
-	else if(!Res1 && !Res2)
-	{
-		return 0;
-	}
-
-	if(DriveSpace1.QuadPart > DriveSpace2.QuadPart)
-	{
-		return 1;
-	}
-	else if(DriveSpace1.QuadPart < DriveSpace2.QuadPart)
+	if(m_bVirtualFolder)
 	{
-		return -1;
-	}
+		std::wstring fullPath = itemInfo.getFullPath();
 
-	return 0;
-}
+		/* Drives are placed before other items, and
+		are sorted by drive letter, rather than display
+		name. */
+		if(PathIsRoot(fullPath.c_str()))
+		{
+			sortKey.precedence = 0;
+			sortKey.collationKey = GetCollationKey(fullPath);
+			return;
+		}
 
-int CALLBACK CShellBrowser::SortByAttributes(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const
-{
-	std::wstring AttributeString1 = GetAttributeColumnText(itemInfo1);
-	std::wstring AttributeString2 = GetAttributeColumnText(itemInfo2);
+		sortKey.precedence = 1;
+	}
 
-	return StrCmpLogicalW(AttributeString1.c_str(),AttributeString2.c_str());
+	sortKey.collationKey = GetCollationKey(GetNameColumnText(itemInfo, m_config->globalFolderSettings));
 }
 
-int CALLBACK CShellBrowser::SortByRealSize(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const
+void CShellBrowser::BuildTypeSortKey(const BasicItemInfo_t &itemInfo, SortKey &sortKey) const
 {
-	ULARGE_INTEGER RealFileSize1;
-	bool Res1 = GetRealSizeColumnRawData(itemInfo1,RealFileSize1);
-
-	ULARGE_INTEGER RealFileSize2;
-	bool Res2 = GetRealSizeColumnRawData(itemInfo2,RealFileSize2);
-
-	if(Res1 && !Res2)
-	{
-		return 1;
-	}
-	else if(!Res1 && Res2)
-	{
-		return -1;
-	}
-	else if(!Res1 && !Res2)
-	{
-		return 0;
-	}
-
-	if(RealFileSize1.QuadPart > RealFileSize2.QuadPart)
-	{
-		return 1;
-	}
-	else if(RealFileSize1.QuadPart < RealFileSize2.QuadPart)
+	if(m_bVirtualFolder)
 	{
-		return -1;
+		/* Drives are placed before other items. */
+		sortKey.precedence = PathIsRoot(itemInfo.getFullPath().c_str()) ? 0 : 1;
 	}
 
-	return 0;
-}
-
-int CALLBACK CShellBrowser::SortByShortName(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const
-{
-	std::wstring ShortName1 = GetShortNameColumnText(itemInfo1);
-	std::wstring ShortName2 = GetShortNameColumnText(itemInfo2);
-
-	return StrCmpLogicalW(ShortName1.c_str(),ShortName2.c_str());
-}
-
-int CALLBACK CShellBrowser::SortByOwner(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const
-{
-	std::wstring Owner1 = GetOwnerColumnText(itemInfo1);
-	std::wstring Owner2 = GetOwnerColumnText(itemInfo2);
-
-	return StrCmpLogicalW(Owner1.c_str(),Owner2.c_str());
+	sortKey.collationKey = GetCollationKey(GetTypeColumnText(itemInfo));
 }
 
-int CALLBACK CShellBrowser::SortByVersionInfo(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, VersionInfoType_t VersioninfoType) const
+void CShellBrowser::BuildSizeSortKey(int InternalIndex, SortKey &sortKey) const
 {
-	std::wstring VersionInfo1 = GetVersionColumnText(itemInfo1,VersioninfoType);
-	std::wstring VersionInfo2 = GetVersionColumnText(itemInfo2,VersioninfoType);
-
-	return StrCmpLogicalW(VersionInfo1.c_str(),VersionInfo2.c_str());
-}
-
-int CALLBACK CShellBrowser::SortByShortcutTo(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const
-{
-	std::wstring ResolvedLinkPath1 = GetShortcutToColumnText(itemInfo1);
-	std::wstring ResolvedLinkPath2 = GetShortcutToColumnText(itemInfo2);
-
-	return StrCmpLogicalW(ResolvedLinkPath1.c_str(),ResolvedLinkPath2.c_str());
-}
-
-int CALLBACK CShellBrowser::SortByHardlinks(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const
-{
-	DWORD NumHardLinks1 = GetHardLinksColumnRawData(itemInfo1);
-	DWORD NumHardLinks2 = GetHardLinksColumnRawData(itemInfo2);
-
-	return NumHardLinks1 - NumHardLinks2;
-}
-
-int CALLBACK CShellBrowser::SortByExtension(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const
-{
-	std::wstring Extension1 = GetExtensionColumnText(itemInfo1);
-	std::wstring Extension2 = GetExtensionColumnText(itemInfo2);
-
-	return StrCmpLogicalW(Extension1.c_str(),Extension2.c_str());
-}
-
-int CALLBACK CShellBrowser::SortByItemDetails(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, const SHCOLUMNID *pscid) const
-{
-	VARIANT vt1;
-	HRESULT hr1 = GetItemDetailsRawData(itemInfo1, pscid, &vt1);
-
-	VARIANT vt2;
-	HRESULT hr2 = GetItemDetailsRawData(itemInfo2, pscid, &vt2);
+	if(sortKey.isFolder)
+	{
+		/* Folders whose size hasn't been calculated
+		are placed first. */
+		auto itr = m_cachedFolderSizes.find(InternalIndex);
 
-	int ret = 0;
+		if(itr != m_cachedFolderSizes.end())
+		{
+			sortKey.precedence = 1;
+			sortKey.number = itr->second;
+			return;
+		}
 
-	if (SUCCEEDED(hr1) && SUCCEEDED(hr2) && vt1.vt == vt2.vt)
-	{
-		ret = VariantCompare(vt1, vt2);
-	}
+		/* The size may have been calculated elsewhere (e.g.
+		in another tab), in which case it will be cached by
+		the service. */
+		if(m_folderSizeService != nullptr)
+		{
+			auto folderSize = m_folderSizeService->GetCachedFolderSize(
+				getBasicItemInfo(InternalIndex).getFullPath());
+
+			if(folderSize)
+			{
+				sortKey.precedence = 1;
+				sortKey.number = folderSize->size;
+				return;
+			}
+		}
 
-	if (SUCCEEDED(hr1))
-	{
-		VariantClear(&vt1);
+		sortKey.precedence = 0;
 	}
-
-	if (SUCCEEDED(hr2))
+	else
 	{
-		VariantClear(&vt2);
+		sortKey.precedence = 1;
+		sortKey.number = m_itemStore.getSize(InternalIndex);
 	}
-
-	return ret;
-}
-
-int CALLBACK CShellBrowser::SortByImageProperty(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, PROPID PropertyId) const
-{
-	std::wstring ImageProperty1 = GetImageColumnText(itemInfo1,PropertyId);
-	std::wstring ImageProperty2 = GetImageColumnText(itemInfo2,PropertyId);
-
-	return StrCmpLogicalW(ImageProperty1.c_str(),ImageProperty2.c_str());
-}
-
-int CALLBACK CShellBrowser::SortByVirtualComments(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const
-{
-	std::wstring Comments1 = GetControlPanelCommentsColumnText(itemInfo1);
-	std::wstring Comments2 = GetControlPanelCommentsColumnText(itemInfo2);
-
-	return StrCmpLogicalW(Comments1.c_str(),Comments2.c_str());
 }
 
-int CALLBACK CShellBrowser::SortByFileSystem(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const
+void CShellBrowser::BuildDriveSpaceSortKey(const BasicItemInfo_t &itemInfo, bool TotalSize, SortKey &sortKey) const
 {
-	std::wstring FileSystemName1 = GetFileSystemColumnText(itemInfo1);
-	std::wstring FileSystemName2 = GetFileSystemColumnText(itemInfo2);
+	ULARGE_INTEGER DriveSpace;
+	BOOL Res = GetDriveSpaceColumnRawData(itemInfo,TotalSize,DriveSpace);
 
-	return StrCmpLogicalW(FileSystemName1.c_str(),FileSystemName2.c_str());
+	/* Items that aren't drives are placed first. */
+	sortKey.precedence = Res ? 1 : 0;
+	sortKey.number = Res ? DriveSpace.QuadPart : 0;
 }
 
-int CALLBACK CShellBrowser::SortByPrinterProperty(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, PrinterInformationType_t PrinterInformationType) const
+void CShellBrowser::BuildItemDetailsSortKey(const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid, SortKey &sortKey) const
 {
-	std::wstring PrinterInformation1 = GetPrinterColumnText(itemInfo1,PrinterInformationType);
-	std::wstring PrinterInformation2 = GetPrinterColumnText(itemInfo2,PrinterInformationType);
-
-	return StrCmpLogicalW(PrinterInformation1.c_str(),PrinterInformation2.c_str());
-}
+	/* Two variants are only compared if they were both
+	retrieved and are of the same type. */
+	VARIANT vt;
+	HRESULT hr = GetItemDetailsRawData(itemInfo,pscid,&vt);
 
-int CALLBACK CShellBrowser::SortByNetworkAdapterStatus(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const
-{
-	std::wstring Status1 = GetNetworkAdapterColumnText(itemInfo1);
-	std::wstring Status2 = GetNetworkAdapterColumnText(itemInfo2);
-
-	return StrCmpLogicalW(Status1.c_str(),Status2.c_str());
+	if(SUCCEEDED(hr))
+	{
+		sortKey.variant = vt;
+	}
 }
-
-int CALLBACK CShellBrowser::SortByMediaMetadata(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, MediaMetadataType_t MediaMetaDataType) const
-{
-	std::wstring MediaMetadata1 = GetMediaMetadataColumnText(itemInfo1,MediaMetaDataType);
-	std::wstring MediaMetadata2 = GetMediaMetadataColumnText(itemInfo2,MediaMetaDataType);
-
-	return StrCmpLogicalW(MediaMetadata1.c_str(),MediaMetadata2.c_str());
-}
\ No newline at end of file
@@ -281,7 +281,7 @@ void CShellBrowser::HandleDragSelection(const POINT *ppt)
 		if(bOverItem)
 		{
 			/* Check for a clash (only if over a folder). */
-			if((m_itemInfoMap.at(iInternalIndex).wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			if((m_itemStore.getAttributes(iInternalIndex) & FILE_ATTRIBUTE_DIRECTORY)
 				== FILE_ATTRIBUTE_DIRECTORY)
 			{
 				if(m_bDragging)
@@ -430,7 +430,7 @@ DWORD grfKeyState,POINTL ptl,DWORD *pdwEffect)
 		lvItem.iSubItem	= 0;
 		ListView_GetItem(m_hListView,&lvItem);
 
-		PathAppend(szDestDirectory,m_itemInfoMap.at((int)lvItem.lParam).wfd.cFileName);
+		PathAppend(szDestDirectory,m_itemStore.getFileName((int)lvItem.lParam));
 	}
 
 	szDestDirectory[lstrlen(szDestDirectory) + 1] = '\0';
@@ -521,8 +521,8 @@ int CALLBACK SortTemporaryStub(LPARAM lParam1,LPARAM lParam2,LPARAM lParamSort)
 
 int CALLBACK CShellBrowser::SortTemporary(LPARAM lParam1,LPARAM lParam2)
 {
-	return m_itemInfoMap.at(static_cast<int>(lParam1)).iRelativeSort -
-		m_itemInfoMap.at(static_cast<int>(lParam2)).iRelativeSort;
+	return m_itemStore.getRelativeSort(static_cast<int>(lParam1)) -
+		m_itemStore.getRelativeSort(static_cast<int>(lParam2));
 }
 
 void CShellBrowser::RepositionLocalFiles(const POINT *ppt)
@@ -593,14 +593,14 @@ void CShellBrowser::RepositionLocalFiles(const POINT *ppt)
 					{
 						if(i == iItem)
 						{
-							m_itemInfoMap.at((int)lvItem.lParam).iRelativeSort = iInsert;
+							m_itemStore.setRelativeSort((int)lvItem.lParam,iInsert);
 						}
 						else
 						{
 							if(iSort == iInsert)
 								iSort++;
 
-							m_itemInfoMap.at((int)lvItem.lParam).iRelativeSort = iSort;
+							m_itemStore.setRelativeSort((int)lvItem.lParam,iSort);
 						}
 					}
 
@@ -608,6 +608,7 @@ void CShellBrowser::RepositionLocalFiles(const POINT *ppt)
 				}
 
 				ListView_SortItems(m_hListView,SortTemporaryStub,(LPARAM)this);
+				SyncItemRowsWithListView();
 			}
 			else
 			{
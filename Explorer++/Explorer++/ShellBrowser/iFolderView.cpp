@@ -57,32 +57,36 @@ ULONG __stdcall CShellBrowser::Release(void)
 }
 
 CShellBrowser *CShellBrowser::CreateNew(int id, HINSTANCE resourceInstance, HWND hOwner, HWND hListView,
-	CachedIcons *cachedIcons, std::shared_ptr<const Config> config, const FolderSettings &folderSettings,
-	boost::optional<FolderColumns> initialColumns)
+	IconCache *iconCache, FolderSizeService *folderSizeService, ThumbnailCache *thumbnailCache,
+	MetadataCache *metadataCache, ItemTaskScheduler *itemTaskScheduler, std::shared_ptr<const Config> config,
+	const FolderSettings &folderSettings, boost::optional<FolderColumns> initialColumns)
 {
-	return new CShellBrowser(id, resourceInstance, hOwner, hListView, cachedIcons, config,
-		folderSettings, initialColumns);
+	return new CShellBrowser(id, resourceInstance, hOwner, hListView, iconCache, folderSizeService,
+		thumbnailCache, metadataCache, itemTaskScheduler, config, folderSettings, initialColumns);
 }
 
 CShellBrowser::CShellBrowser(int id, HINSTANCE resourceInstance, HWND hOwner, HWND hListView,
-	CachedIcons *cachedIcons, std::shared_ptr<const Config> config, const FolderSettings &folderSettings,
-	boost::optional<FolderColumns> initialColumns) :
+	IconCache *iconCache, FolderSizeService *folderSizeService, ThumbnailCache *thumbnailCache,
+	MetadataCache *metadataCache, ItemTaskScheduler *itemTaskScheduler, std::shared_ptr<const Config> config,
+	const FolderSettings &folderSettings, boost::optional<FolderColumns> initialColumns) :
 	m_ID(id),
 	m_hResourceModule(resourceInstance),
 	m_hOwner(hOwner),
 	m_hListView(hListView),
-	m_cachedIcons(cachedIcons),
+	m_iconCache(iconCache),
+	m_folderSizeService(folderSizeService),
+	m_thumbnailCache(thumbnailCache),
+	m_metadataCache(metadataCache),
 	m_config(config),
 	m_folderSettings(folderSettings),
 	m_folderColumns(initialColumns ? *initialColumns : config->globalFolderSettings.folderColumns),
 	m_itemIDCounter(0),
-	m_columnThreadPool(1),
-	m_columnResultIDCounter(0),
-	m_itemImageThreadPool(1),
-	m_thumbnailResultIDCounter(0),
-	m_iconResultIDCounter(0),
-	m_infoTipsThreadPool(1),
-	m_infoTipResultIDCounter(0)
+	m_itemResults(std::make_shared<ItemResults_t>()),
+	m_itemResultGeneration(0),
+	m_itemTaskScheduler(itemTaskScheduler),
+	m_enumerationThreadPool(1),
+	m_enumerationIDCounter(0),
+	m_folderSnapshots(MAX_FOLDER_SNAPSHOTS)
 {
 	m_iRefCount = 1;
 
@@ -104,6 +108,19 @@ CShellBrowser::CShellBrowser(int id, HINSTANCE resourceInstance, HWND hOwner, HW
 	m_iDropped				= -1;
 
 	m_iUniqueFolderIndex	= 0;
+	m_directoryChangesFolderIndex	= 0;
+
+	m_filterMatcher = WildcardMatcher(m_folderSettings.filter, m_folderSettings.filterCaseSensitive != FALSE);
+	m_appliedFilterMatcher = GetActiveFilterMatcher();
+
+	m_ownerDataListView		= (GetWindowLongPtr(m_hListView,GWL_STYLE) & LVS_OWNERDATA) == LVS_OWNERDATA;
+
+	if(m_ownerDataListView)
+	{
+		/* The listview doesn't store any item state other
+		than selection and focus in this mode. */
+		ListView_SetCallbackMask(m_hListView,LVIS_OVERLAYMASK|LVIS_CUT);
+	}
 
 	m_pidlDirectory			= NULL;
 
@@ -138,7 +155,7 @@ CShellBrowser::CShellBrowser(int id, HINSTANCE resourceInstance, HWND hOwner, HW
 		m_ListViewParentSubclassed = FALSE;
 	}
 
-	m_itemImageThreadPool.push([](int id) {
+	m_enumerationThreadPool.push([](int id) {
 		UNREFERENCED_PARAMETER(id);
 
 		CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
@@ -159,11 +176,13 @@ CShellBrowser::~CShellBrowser()
 		RemoveWindowSubclass(m_hListView, ListViewProcStub, LISTVIEW_SUBCLASS_ID);
 	}
 
-	m_columnThreadPool.clear_queue();
-	m_itemImageThreadPool.clear_queue();
-	m_infoTipsThreadPool.clear_queue();
+	/* Any tasks that are already running only refer to data they
+	hold themselves, so they don't need to be waited for. */
+	m_itemTaskScheduler->CancelAllTasks(m_ID);
 
-	m_itemImageThreadPool.push([](int id) {
+	CancelDirectoryEnumeration();
+
+	m_enumerationThreadPool.push([](int id) {
 		UNREFERENCED_PARAMETER(id);
 
 		CoUninitialize();
@@ -192,6 +211,11 @@ CShellBrowser::~CShellBrowser()
 	CoTaskMemFree(m_pidlDirectory);
 }
 
+FolderSettings CShellBrowser::GetFolderSettings() const
+{
+	return m_folderSettings;
+}
+
 BOOL CShellBrowser::GetAutoArrange(void) const
 {
 	return m_folderSettings.autoArrange;
@@ -337,8 +361,10 @@ void CShellBrowser::SetViewModeInternal(ViewMode viewMode)
 
 	if (viewMode != +ViewMode::Details)
 	{
-		m_columnThreadPool.clear_queue();
-		m_columnResults.clear();
+		m_itemTaskScheduler->CancelTasks(m_ID, [] (const ItemTaskScheduler::TaskKey &key) {
+			return key.taskType != ITEM_TASK_ICON && key.taskType != ITEM_TASK_THUMBNAIL
+				&& key.taskType != ITEM_TASK_INFOTIP;
+		});
 	}
 
 	SendMessage(m_hListView,LVM_SETVIEW,dwStyle,0);
@@ -456,32 +482,51 @@ void CShellBrowser::SetTileViewItemInfo(int iItem,int iItemInternal)
 	int columnFormats[2] = { LVCFMT_LEFT, LVCFMT_LEFT };
 	TCHAR FullFileName[MAX_PATH];
 
-	lvti.cbSize		= sizeof(lvti);
-	lvti.iItem		= iItem;
-	lvti.cColumns	= 2;
-	lvti.puColumns	= uColumns;
-	lvti.piColFmt	= columnFormats;
-	ListView_SetTileInfo(m_hListView,&lvti);
-
 	QueryFullItemName(iItem,FullFileName,SIZEOF_ARRAY(FullFileName));
 
 	SHGetFileInfo(FullFileName,0,
 		&shfi,sizeof(SHFILEINFO),SHGFI_TYPENAME);
 
-	ListView_SetItemText(m_hListView,iItem,1,shfi.szTypeName);
+	/* In owner data mode, the tile columns are supplied
+	through LVN_GETDISPINFO. */
+	std::vector<std::wstring> *tileText = NULL;
 
-	if((m_itemInfoMap.at(iItemInternal).wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) !=
+	if(m_ownerDataListView)
+	{
+		tileText = &GetOwnerDataItem(iItemInternal).tileText;
+		tileText->assign(2,std::wstring());
+		(*tileText)[0] = shfi.szTypeName;
+	}
+	else
+	{
+		lvti.cbSize		= sizeof(lvti);
+		lvti.iItem		= iItem;
+		lvti.cColumns	= 2;
+		lvti.puColumns	= uColumns;
+		lvti.piColFmt	= columnFormats;
+		ListView_SetTileInfo(m_hListView,&lvti);
+
+		ListView_SetItemText(m_hListView,iItem,1,shfi.szTypeName);
+	}
+
+	if((m_itemStore.getAttributes(iItemInternal) & FILE_ATTRIBUTE_DIRECTORY) !=
 		FILE_ATTRIBUTE_DIRECTORY)
 	{
 		TCHAR			lpszFileSize[32];
 		ULARGE_INTEGER	lFileSize;
 
-		lFileSize.LowPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeLow;
-		lFileSize.HighPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeHigh;
+		lFileSize.QuadPart = m_itemStore.getSize(iItemInternal);
 
 		FormatSizeString(lFileSize,lpszFileSize,SIZEOF_ARRAY(lpszFileSize),
 			m_config->globalFolderSettings.forceSize, m_config->globalFolderSettings.sizeDisplayFormat);
 
-		ListView_SetItemText(m_hListView,iItem,2,lpszFileSize);
+		if(tileText != NULL)
+		{
+			(*tileText)[1] = lpszFileSize;
+		}
+		else
+		{
+			ListView_SetItemText(m_hListView,iItem,2,lpszFileSize);
+		}
 	}
 }
\ No newline at end of file
@@ -4,7 +4,6 @@
 
 #include "stdafx.h"
 #include "iShellView.h"
-#include "CachedIcons.h"
 #include "iShellBrowser_internal.h"
 #include "ItemData.h"
 #include "SortModes.h"
@@ -18,10 +17,42 @@
 #include "../Helper/Macros.h"
 #include "../Helper/ShellHelper.h"
 #include <boost/scope_exit.hpp>
+#include <algorithm>
+#include <functional>
 #include <list>
 
 #pragma warning(disable:4459) // declaration of 'boost_scope_exit_aux_args' hides global declaration
 
+namespace
+{
+	/* Filenames are compared case-insensitively by the
+	filesystem, so names are upper-cased (without regard to
+	the user's locale, as the filesystem does) before being
+	added to, or looked up in, the name index. */
+	std::wstring GetNameIndexKey(const TCHAR *name)
+	{
+		std::wstring key(name);
+
+		if(key.empty())
+		{
+			return key;
+		}
+
+		int cchKey = LCMapStringEx(LOCALE_NAME_INVARIANT, LCMAP_UPPERCASE, name,
+			static_cast<int>(key.size()), &key[0], static_cast<int>(key.size()),
+			nullptr, nullptr, 0);
+
+		if(cchKey == 0)
+		{
+			return name;
+		}
+
+		key.resize(cchKey);
+
+		return key;
+	}
+}
+
 void CALLBACK	TimerProc(HWND hwnd,UINT uMsg,UINT_PTR idEvent,DWORD dwTime);
 
 void CShellBrowser::UpdateFileSelectionInfo(int iCacheIndex,BOOL Selected)
@@ -29,11 +60,10 @@ void CShellBrowser::UpdateFileSelectionInfo(int iCacheIndex,BOOL Selected)
 	ULARGE_INTEGER	ulFileSize;
 	BOOL			IsFolder;
 
-	IsFolder = (m_itemInfoMap.at(iCacheIndex).wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+	IsFolder = (m_itemStore.getAttributes(iCacheIndex) & FILE_ATTRIBUTE_DIRECTORY)
 	== FILE_ATTRIBUTE_DIRECTORY;
 
-	ulFileSize.LowPart = m_itemInfoMap.at(iCacheIndex).wfd.nFileSizeLow;
-	ulFileSize.HighPart = m_itemInfoMap.at(iCacheIndex).wfd.nFileSizeHigh;
+	ulFileSize.QuadPart = m_itemStore.getSize(iCacheIndex);
 
 	if(Selected)
 	{
@@ -57,7 +87,7 @@ void CShellBrowser::UpdateFileSelectionInfo(int iCacheIndex,BOOL Selected)
 
 BOOL CShellBrowser::IsFilenameFiltered(const TCHAR *FileName) const
 {
-	if(CheckWildcardMatch(m_folderSettings.filter.c_str(),FileName,m_folderSettings.filterCaseSensitive))
+	if(m_filterMatcher.Matches(FileName))
 		return FALSE;
 
 	return TRUE;
@@ -72,7 +102,7 @@ int CShellBrowser::QueryDisplayName(int iItem,UINT BufferSize,TCHAR *Buffer) con
 	lvItem.iSubItem	= 0;
 	ListView_GetItem(m_hListView,&lvItem);
 
-	StringCchCopy(Buffer,BufferSize,m_itemInfoMap.at((int)lvItem.lParam).wfd.cFileName);
+	StringCchCopy(Buffer,BufferSize,m_itemStore.getFileName((int)lvItem.lParam));
 
 	return lstrlen(Buffer);
 }
@@ -99,7 +129,7 @@ HRESULT CShellBrowser::QueryFullItemName(int iIndex,TCHAR *FullItemPath,UINT cch
 
 void CShellBrowser::QueryFullItemNameInternal(int iItemInternal,TCHAR *szFullFileName,UINT cchMax) const
 {
-	GetDisplayName(m_itemInfoMap.at(iItemInternal).pidlComplete.get(),szFullFileName,cchMax,SHGDN_FORPARSING);
+	GetDisplayName(m_itemStore.getPidlComplete(iItemInternal),szFullFileName,cchMax,SHGDN_FORPARSING);
 }
 
 UINT CShellBrowser::QueryCurrentDirectory(int BufferSize,TCHAR *Buffer) const
@@ -203,65 +233,104 @@ int CShellBrowser::SelectFiles(const TCHAR *FileNamePattern)
 		return 1;
 	}
 
+	/* The item may simply not have been enumerated yet,
+	in which case it will be selected once enumeration
+	has finished. */
+	if(m_directoryEnumeration)
+	{
+		EnterCriticalSection(&m_csDirectoryAltered);
+		m_FileSelectionList.push_back(FileNamePattern);
+		LeaveCriticalSection(&m_csDirectoryAltered);
+	}
+
 	return 0;
 }
 
 int CShellBrowser::LocateFileItemIndex(const TCHAR *szFileName) const
 {
-	LV_FINDINFO	lvFind;
-	int			iItem;
-	int			iInternalIndex;
-
-	iInternalIndex = LocateFileItemInternalIndex(szFileName);
+	int iInternalIndex = LocateFileItemInternalIndex(szFileName);
 
 	if(iInternalIndex != -1)
 	{
-		lvFind.flags	= LVFI_PARAM;
-		lvFind.lParam	= iInternalIndex;
-		iItem			= ListView_FindItem(m_hListView,-1,&lvFind);
+		auto item = LocateItemByInternalIndex(iInternalIndex);
 
-		return iItem;
+		if(item)
+		{
+			return *item;
+		}
 	}
 
 	return -1;
 }
 
+/* Only items that are currently shown in the
+listview will be found. */
 int CShellBrowser::LocateFileItemInternalIndex(const TCHAR *szFileName) const
 {
-	LVITEM	lvItem;
-	int		i = 0;
+	auto itr = m_itemNameIndex.find(GetNameIndexKey(szFileName));
 
-	for(i = 0;i < m_nTotalItems;i++)
+	if(itr == m_itemNameIndex.end())
 	{
-		lvItem.mask		= LVIF_PARAM;
-		lvItem.iItem	= i;
-		lvItem.iSubItem	= 0;
-		ListView_GetItem(m_hListView,&lvItem);
+		return -1;
+	}
 
-		if((lstrcmp(m_itemInfoMap.at((int)lvItem.lParam).wfd.cFileName,szFileName) == 0) ||
-			(lstrcmp(m_itemInfoMap.at((int)lvItem.lParam).wfd.cAlternateFileName,szFileName) == 0))
-		{
-			return (int)lvItem.lParam;
-			break;
-		}
+	if(!m_itemRows.getRow(itr->second))
+	{
+		return -1;
 	}
 
-	return -1;
+	return itr->second;
 }
 
 boost::optional<int> CShellBrowser::LocateItemByInternalIndex(int internalIndex) const
 {
-	LVFINDINFO lvfi;
-	lvfi.flags = LVFI_PARAM;
-	lvfi.lParam = internalIndex;
-	int item = ListView_FindItem(m_hListView, -1, &lvfi);
+	return m_itemRows.getRow(internalIndex);
+}
+
+void CShellBrowser::AddItemToNameIndex(int internalIndex)
+{
+	const TCHAR *alternateFileName = m_itemStore.getAlternateFileName(internalIndex);
 
-	if (item == -1)
+	/* If two items share a name, the first one
+	added takes precedence. */
+	m_itemNameIndex.emplace(GetNameIndexKey(m_itemStore.getFileName(internalIndex)), internalIndex);
+
+	if(alternateFileName[0] != '\0')
 	{
-		return boost::none;
+		m_itemNameIndex.emplace(GetNameIndexKey(alternateFileName), internalIndex);
+	}
+}
+
+void CShellBrowser::RemoveItemFromNameIndex(int internalIndex)
+{
+	for(const TCHAR *name : {m_itemStore.getFileName(internalIndex),
+		m_itemStore.getAlternateFileName(internalIndex)})
+	{
+		auto itr = m_itemNameIndex.find(GetNameIndexKey(name));
+
+		if(itr != m_itemNameIndex.end() && itr->second == internalIndex)
+		{
+			m_itemNameIndex.erase(itr);
+		}
 	}
+}
+
+/* Rebuilds the row mapping from the listview. Only
+needed when the listview has been reordered without
+the new order being known up-front. */
+void CShellBrowser::SyncItemRowsWithListView()
+{
+	int nItems = ListView_GetItemCount(m_hListView);
 
-	return item;
+	std::vector<int> internalIndices;
+	internalIndices.reserve(nItems);
+
+	for(int i = 0;i < nItems;i++)
+	{
+		internalIndices.push_back(GetItemInternalIndex(i));
+	}
+
+	m_itemRows.setRows(std::move(internalIndices));
 }
 
 DWORD CShellBrowser::QueryFileAttributes(int iItem) const
@@ -273,7 +342,7 @@ DWORD CShellBrowser::QueryFileAttributes(int iItem) const
 	lvItem.iSubItem	= 0;
 	ListView_GetItem(m_hListView,&lvItem);
 
-	return m_itemInfoMap.at((int)lvItem.lParam).wfd.dwFileAttributes;
+	return m_itemStore.getAttributes((int)lvItem.lParam);
 }
 
 WIN32_FIND_DATA CShellBrowser::QueryFileFindData(int iItem) const
@@ -285,7 +354,7 @@ WIN32_FIND_DATA CShellBrowser::QueryFileFindData(int iItem) const
 	lvItem.iSubItem	= 0;
 	ListView_GetItem(m_hListView,&lvItem);
 
-	return m_itemInfoMap.at((int)lvItem.lParam).wfd;
+	return m_itemStore.getFindData((int)lvItem.lParam);
 }
 
 void CShellBrowser::DragStarted(int iFirstItem,POINT *ptCursor)
@@ -323,10 +392,10 @@ void CShellBrowser::DragStopped(void)
 	m_bDragging = FALSE;
 }
 
-boost::optional<int> CShellBrowser::GetCachedIconIndex(const ItemInfo_t &itemInfo)
+boost::optional<int> CShellBrowser::GetCachedIconIndex(int internalIndex)
 {
 	TCHAR filePath[MAX_PATH];
-	HRESULT hr = GetDisplayName(itemInfo.pidlComplete.get(),
+	HRESULT hr = GetDisplayName(m_itemStore.getPidlComplete(internalIndex),
 		filePath, SIZEOF_ARRAY(filePath), SHGDN_FORPARSING);
 
 	if (FAILED(hr))
@@ -334,14 +403,9 @@ boost::optional<int> CShellBrowser::GetCachedIconIndex(const ItemInfo_t &itemInf
 		return boost::none;
 	}
 
-	auto cachedItr = m_cachedIcons->findByPath(filePath);
-
-	if (cachedItr == m_cachedIcons->end())
-	{
-		return boost::none;
-	}
+	bool isFolder = ((m_itemStore.getAttributes(internalIndex) & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY);
 
-	return cachedItr->iconIndex;
+	return m_iconCache->Lookup(filePath, isFolder);
 }
 
 LPITEMIDLIST CShellBrowser::QueryItemCompleteIdl(int iItem) const
@@ -357,7 +421,7 @@ LPITEMIDLIST CShellBrowser::QueryItemCompleteIdl(int iItem) const
 		return nullptr;
 	}
 
-	LPITEMIDLIST pidlComplete = ILCombine(m_pidlDirectory, m_itemInfoMap.at((int)lvItem.lParam).pridl.get());
+	LPITEMIDLIST pidlComplete = ILCombine(m_pidlDirectory, m_itemStore.getPidlRelative((int)lvItem.lParam));
 
 	return pidlComplete;
 }
@@ -373,7 +437,7 @@ LPITEMIDLIST CShellBrowser::QueryItemRelativeIdl(int iItem) const
 	bRet = ListView_GetItem(m_hListView,&lvItem);
 
 	if(bRet)
-		return ILClone((ITEMIDLIST *)m_itemInfoMap.at((int)lvItem.lParam).pridl.get());
+		return ILClone((ITEMIDLIST *)m_itemStore.getPidlRelative((int)lvItem.lParam));
 
 	return NULL;
 }
@@ -608,42 +672,38 @@ void CShellBrowser::PositionDroppedItems(void)
 
 int CShellBrowser::DetermineItemSortedPosition(LPARAM lParam) const
 {
-	LVITEM	lvItem;
-	BOOL	bItem;
-	int		res = 1;
-	int		nItems = 0;
-	int		i = 0;
-
-	nItems = ListView_GetItemCount(m_hListView);
-
-	while(res > 0 && i < nItems)
+	SortKey sortKey = BuildSortKey(static_cast<int>(lParam));
+	bool foldersFirst = !CompareVirtualFolders(CSIDL_BITBUCKET);
+	bool ascending = m_folderSettings.sortAscending ? true : false;
+
+	/* The listview is already sorted, so the position
+	can be found with a binary search (with the key for
+	the new item only being built once).
+	The item will always be inserted BEFORE the item at
+	the position returned here. For example, returning 0
+	will place the item at 0 (and push 0 to 1). To place
+	the item in the last position, the item count is
+	returned. */
+	int low = 0;
+	int high = ListView_GetItemCount(m_hListView);
+
+	while(low < high)
 	{
-		lvItem.mask		= LVIF_PARAM;
-		lvItem.iItem	= i;
-		lvItem.iSubItem	= 0;
-		bItem = ListView_GetItem(m_hListView,&lvItem);
+		int mid = low + (high - low) / 2;
 
-		if(bItem)
-			res = Sort(static_cast<int>(lParam),static_cast<int>(lvItem.lParam));
-		else
-			res = 0;
-
-		i++;
-	}
+		SortKey currentSortKey = BuildSortKey(GetItemInternalIndex(mid));
 
-	/* The item will always be inserted BEFORE
-	the item at position i that we specify here.
-	For example, specifying 0, will place the item
-	at 0 (and push 0 to 1), specifying 1 will place
-	the item at 1 (and push 1 to 2).
-	Therefore, to place in the last position, need
-	to place AFTER last item. */
-	if((i - 1) == nItems - 1 && res > 0)
-	{
-		i++;
+		if(CompareSortKeys(sortKey,currentSortKey,foldersFirst,ascending) > 0)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
 	}
 
-	return i - 1;
+	return low;
 }
 
 BOOL CShellBrowser::GhostItem(int iItem)
@@ -670,10 +730,15 @@ BOOL CShellBrowser::GhostItemInternal(int iItem,BOOL bGhost)
 	{
 		/* If the file is hidden, prevent changes to its visibility state (i.e.
 		hidden items will ALWAYS be ghosted). */
-		if(m_itemInfoMap.at((int)lvItem.lParam).wfd.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN)
+		if(m_itemStore.getAttributes((int)lvItem.lParam) & FILE_ATTRIBUTE_HIDDEN)
 			return FALSE;
 
-		if(bGhost)
+		if(m_ownerDataListView)
+		{
+			GetOwnerDataItem((int)lvItem.lParam).bGhosted = bGhost;
+			ListView_RedrawItems(m_hListView,iItem,iItem);
+		}
+		else if(bGhost)
 		{
 			ListView_SetItemState(m_hListView,iItem,LVIS_CUT,LVIS_CUT);
 		}
@@ -686,34 +751,79 @@ BOOL CShellBrowser::GhostItemInternal(int iItem,BOOL bGhost)
 	return TRUE;
 }
 
-void CShellBrowser::RemoveFilteredItems(void)
+/* Removes a set of items (that have already been marked as
+hidden in m_itemFilter) from the listview. The rows are found
+through m_itemRows, rather than by walking the listview, and
+the remaining rows are rebuilt once at the end. */
+void CShellBrowser::RemoveFilteredItems(const std::vector<int> &internalIndices)
 {
-	LVITEM			lvItem;
-	int				nItems;
-	int				i = 0;
-
-	if(!m_folderSettings.applyFilter)
+	if(internalIndices.empty())
 		return;
 
-	nItems = ListView_GetItemCount(m_hListView);
+	std::vector<int> rows;
+	rows.reserve(internalIndices.size());
 
-	for(i = nItems - 1;i >= 0;i--)
+	for(int internalIndex : internalIndices)
 	{
-		lvItem.mask		= LVIF_PARAM;
-		lvItem.iItem	= i;
-		lvItem.iSubItem	= 0;
-		ListView_GetItem(m_hListView,&lvItem);
+		auto iItem = LocateItemByInternalIndex(internalIndex);
 
-		if(!((m_itemInfoMap.at((int)lvItem.lParam).wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY))
+		if(iItem)
 		{
-			if(IsFilenameFiltered(m_itemInfoMap.at((int)lvItem.lParam).szDisplayName))
-			{
-				RemoveFilteredItem(i,(int)lvItem.lParam);
-			}
+			rows.push_back(*iItem);
 		}
 	}
 
-	SendMessage(m_hOwner,WM_USER_UPDATEWINDOWS,0,0);
+	for(int iItem : rows)
+	{
+		ULARGE_INTEGER ulFileSize;
+		ulFileSize.QuadPart = m_itemStore.getSize(m_itemRows.getInternalIndex(iItem));
+
+		if(ListView_GetItemState(m_hListView,iItem,LVIS_SELECTED) == LVIS_SELECTED)
+		{
+			m_ulFileSelectionSize.QuadPart -= ulFileSize.QuadPart;
+		}
+
+		m_ulTotalDirSize.QuadPart -= ulFileSize.QuadPart;
+	}
+
+	m_nTotalItems -= static_cast<int>(rows.size());
+
+	std::vector<int> remainingRows;
+	remainingRows.reserve(m_itemRows.size() - rows.size());
+
+	for(int i = 0;i < m_itemRows.size();i++)
+	{
+		int internalIndex = m_itemRows.getInternalIndex(i);
+
+		if(m_itemFilter.isItemVisible(internalIndex))
+		{
+			remainingRows.push_back(internalIndex);
+		}
+	}
+
+	if(m_ownerDataListView)
+	{
+		UpdateOwnerDataRows([this,&remainingRows] {
+			m_itemRows.setRows(std::move(remainingRows));
+		});
+
+		return;
+	}
+
+	/* Deleting from the end means that the rows that are
+	still to be deleted don't move. */
+	std::sort(rows.begin(),rows.end(),std::greater<int>());
+
+	SendMessage(m_hListView,WM_SETREDRAW,FALSE,0);
+
+	for(int iItem : rows)
+	{
+		ListView_DeleteItem(m_hListView,iItem);
+	}
+
+	m_itemRows.setRows(std::move(remainingRows));
+
+	SendMessage(m_hListView,WM_SETREDRAW,TRUE,0);
 }
 
 void CShellBrowser::RemoveFilteredItem(int iItem,int iItemInternal)
@@ -723,25 +833,24 @@ void CShellBrowser::RemoveFilteredItem(int iItem,int iItemInternal)
 	if(ListView_GetItemState(m_hListView,iItem,LVIS_SELECTED)
 		== LVIS_SELECTED)
 	{
-		ulFileSize.LowPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeLow;
-		ulFileSize.HighPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeHigh;
+		ulFileSize.QuadPart = m_itemStore.getSize(iItemInternal);
 
 		m_ulFileSelectionSize.QuadPart -= ulFileSize.QuadPart;
 	}
 
 	/* Take the file size of the removed file away from the total
 	directory size. */
-	ulFileSize.LowPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeLow;
-	ulFileSize.HighPart = m_itemInfoMap.at(iItemInternal).wfd.nFileSizeHigh;
+	ulFileSize.QuadPart = m_itemStore.getSize(iItemInternal);
 
 	m_ulTotalDirSize.QuadPart -= ulFileSize.QuadPart;
 
 	/* Remove the item from the m_hListView. */
 	ListView_DeleteItem(m_hListView,iItem);
+	m_itemRows.removeRow(iItem);
 
 	m_nTotalItems--;
 
-	m_FilteredItemsList.push_back(iItemInternal);
+	m_itemFilter.setItemVisible(iItemInternal,false);
 }
 
 int CShellBrowser::GetNumItems(void) const
@@ -791,10 +900,10 @@ void CShellBrowser::DetermineFolderVirtual(LPITEMIDLIST pidlDirectory)
 void CShellBrowser::SetFilter(const TCHAR *szFilter)
 {
 	m_folderSettings.filter = szFilter;
+	m_filterMatcher = WildcardMatcher(m_folderSettings.filter, m_folderSettings.filterCaseSensitive != FALSE);
 
 	if(m_folderSettings.applyFilter)
 	{
-		UnfilterAllItems();
 		UpdateFiltering();
 	}
 }
@@ -819,6 +928,7 @@ BOOL CShellBrowser::GetFilterStatus(void) const
 void CShellBrowser::SetFilterCaseSensitive(BOOL bFilterCaseSensitive)
 {
 	m_folderSettings.filterCaseSensitive = bFilterCaseSensitive;
+	m_filterMatcher = WildcardMatcher(m_folderSettings.filter, m_folderSettings.filterCaseSensitive != FALSE);
 }
 
 BOOL CShellBrowser::GetFilterCaseSensitive(void) const
@@ -826,18 +936,87 @@ BOOL CShellBrowser::GetFilterCaseSensitive(void) const
 	return m_folderSettings.filterCaseSensitive;
 }
 
+boost::optional<WildcardMatcher> CShellBrowser::GetActiveFilterMatcher(void) const
+{
+	if(!m_folderSettings.applyFilter)
+	{
+		return boost::none;
+	}
+
+	return m_filterMatcher;
+}
+
+/* If the new filter is narrower than the one that was
+previously applied (e.g. a character has been added to
+the pattern), only the items that are currently shown can
+be affected. If it's wider, only the hidden items can be.
+Items hidden for other reasons (such as being system
+files) stay hidden either way. */
+boost::optional<ItemFilter::Scope> CShellBrowser::GetFilterUpdateScope(void) const
+{
+	auto activeFilterMatcher = GetActiveFilterMatcher();
+
+	if(!m_appliedFilterMatcher && !activeFilterMatcher)
+	{
+		return boost::none;
+	}
+
+	if(!m_appliedFilterMatcher)
+	{
+		return ItemFilter::Scope::VisibleItems;
+	}
+
+	if(!activeFilterMatcher)
+	{
+		return ItemFilter::Scope::HiddenItems;
+	}
+
+	bool narrower = activeFilterMatcher->IsSubsetOf(*m_appliedFilterMatcher);
+	bool wider = m_appliedFilterMatcher->IsSubsetOf(*activeFilterMatcher);
+
+	if(narrower && wider)
+	{
+		return boost::none;
+	}
+	else if(narrower)
+	{
+		return ItemFilter::Scope::VisibleItems;
+	}
+	else if(wider)
+	{
+		return ItemFilter::Scope::HiddenItems;
+	}
+
+	return ItemFilter::Scope::AllItems;
+}
+
 void CShellBrowser::UpdateFiltering(void)
 {
-	if(m_folderSettings.applyFilter)
+	auto scope = GetFilterUpdateScope();
+
+	if(scope)
 	{
-		RemoveFilteredItems();
+		auto diff = m_itemFilter.update(*scope,[this] (int internalIndex) {
+			return !IsFileFiltered(internalIndex);
+		});
+
+		m_appliedFilterMatcher = GetActiveFilterMatcher();
+
+		RemoveFilteredItems(diff.hiddenItems);
+		UnfilterItems(diff.shownItems);
+
+		if(!diff.hiddenItems.empty() || !diff.shownItems.empty())
+		{
+			SendMessage(m_hOwner,WM_USER_UPDATEWINDOWS,0,0);
+		}
+	}
 
+	if(m_folderSettings.applyFilter)
+	{
 		ApplyFilteringBackgroundImage(true);
 	}
 	else
 	{
-		UnfilterAllItems();
-
 		if(m_nTotalItems == 0)
 			ApplyFolderEmptyBackgroundImage(true);
 		else
@@ -845,28 +1024,36 @@ void CShellBrowser::UpdateFiltering(void)
 	}
 }
 
-void CShellBrowser::UnfilterAllItems(void)
+/* Adds a set of items (that have already been marked as
+visible in m_itemFilter) back into the listview. */
+void CShellBrowser::UnfilterItems(const std::vector<int> &internalIndices)
 {
-	std::list<int>::iterator	itr;
-	AwaitingAdd_t		AwaitingAdd;
+	if(internalIndices.empty())
+		return;
+
+	AwaitingAdd_t AwaitingAdd;
 
-	for(itr = m_FilteredItemsList.begin();itr != m_FilteredItemsList.end();itr++)
+	/* In an owner data listview, the items are appended and
+	then put in order with a single sort. Otherwise, each
+	item is inserted directly into its sorted position. */
+	for(int internalIndex : internalIndices)
 	{
-		int iSorted = DetermineItemSortedPosition(*itr);
+		int iSorted = m_ownerDataListView ? -1 : DetermineItemSortedPosition(internalIndex);
 
 		AwaitingAdd.iItem			= iSorted;
-		AwaitingAdd.bPosition		= TRUE;
+		AwaitingAdd.bPosition		= !m_ownerDataListView;
 		AwaitingAdd.iAfter			= iSorted - 1;
-		AwaitingAdd.iItemInternal	= *itr;
+		AwaitingAdd.iItemInternal	= internalIndex;
 
 		m_AwaitingAddList.push_back(AwaitingAdd);
 	}
 
-	m_FilteredItemsList.clear();
-
 	InsertAwaitingItems(m_folderSettings.showInGroups);
 
-	SendMessage(m_hOwner,WM_USER_UPDATEWINDOWS,0,0);
+	if(m_ownerDataListView)
+	{
+		SortFolder(m_folderSettings.sortMode);
+	}
 }
 
 void CShellBrowser::VerifySortMode(void)
@@ -1019,19 +1206,27 @@ void CShellBrowser::ResetFolderMemoryAllocations(void)
 	}
 
 	EnterCriticalSection(&m_csDirectoryAltered);
-	m_AlteredList.clear();
+	m_directoryChanges.Clear();
 	LeaveCriticalSection(&m_csDirectoryAltered);
 
 	m_itemIDCounter = 0;
 
-	m_itemInfoMap.clear();
+	m_itemStore.clear();
+	m_itemNameIndex.clear();
+	m_itemRows.clear();
+	m_ownerDataItems.clear();
 
 	m_cachedFolderSizes.clear();
+	m_itemGroupHeaders.clear();
 
 	CoTaskMemFree(m_pidlDirectory);
 
-	m_FilteredItemsList.clear();
+	m_itemFilter.clear();
 	m_AwaitingAddList.clear();
+
+	/* Items added from here on are filtered with the
+	current settings. */
+	m_appliedFilterMatcher = GetActiveFilterMatcher();
 }
 
 BOOL CShellBrowser::QueryDragging(void) const
@@ -1215,7 +1410,7 @@ void CShellBrowser::QueueRename(LPCITEMIDLIST pidlItem)
 		lvItem.iSubItem	= 0;
 		ListView_GetItem(m_hListView,&lvItem);
 
-		if(CompareIdls(pidlItem, m_itemInfoMap.at((int)lvItem.lParam).pidlComplete.get()))
+		if(CompareIdls(pidlItem, m_itemStore.getPidlComplete((int)lvItem.lParam)))
 		{
 			bItemFound = TRUE;
 
@@ -1377,7 +1572,7 @@ void CShellBrowser::UpdateDriveIcon(const TCHAR *szDrive)
 			lvItem.iSubItem	= 0;
 			ListView_GetItem(m_hListView,&lvItem);
 
-			if(CompareIdls(pidlDrive, m_itemInfoMap.at((int)lvItem.lParam).pidlComplete.get()))
+			if(CompareIdls(pidlDrive, m_itemStore.getPidlComplete((int)lvItem.lParam)))
 			{
 				iItem = i;
 				iItemInternal = (int)lvItem.lParam;
@@ -1393,9 +1588,14 @@ void CShellBrowser::UpdateDriveIcon(const TCHAR *szDrive)
 	{
 		SHGetFileInfo(szDrive,0,&shfi,sizeof(shfi),SHGFI_SYSICONINDEX);
 
-		StringCchCopy(m_itemInfoMap.at(iItemInternal).szDisplayName,
-			SIZEOF_ARRAY(m_itemInfoMap.at(iItemInternal).szDisplayName),
-			szDisplayName);
+		m_itemStore.setDisplayName(iItemInternal,szDisplayName);
+		InvalidateItemGroup(iItemInternal);
+
+		if(m_ownerDataListView)
+		{
+			InvalidateOwnerDataItem(iItemInternal);
+			return;
+		}
 
 		/* Update the drives icon and display name. */
 		lvItem.mask		= LVIF_TEXT|LVIF_IMAGE;
@@ -1420,13 +1620,12 @@ void CShellBrowser::RemoveDrive(const TCHAR *szDrive)
 		lvItem.iSubItem	= 0;
 		ListView_GetItem(m_hListView,&lvItem);
 
-		if(m_itemInfoMap.at((int)lvItem.lParam).bDrive)
+		const TCHAR *drive = m_itemStore.getDrive((int)lvItem.lParam);
+
+		if(drive != NULL && lstrcmp(szDrive,drive) == 0)
 		{
-			if(lstrcmp(szDrive,m_itemInfoMap.at((int)lvItem.lParam).szDrive) == 0)
-			{
-				iItemInternal = (int)lvItem.lParam;
-				break;
-			}
+			iItemInternal = (int)lvItem.lParam;
+			break;
 		}
 	}
 
@@ -1441,13 +1640,12 @@ int CShellBrowser::GetFolderIndex(void) const
 
 BasicItemInfo_t CShellBrowser::getBasicItemInfo(int internalIndex) const
 {
-	const ItemInfo_t &itemInfo = m_itemInfoMap.at(internalIndex);
-
 	BasicItemInfo_t basicItemInfo;
-	basicItemInfo.pidlComplete.reset(ILClone(itemInfo.pidlComplete.get()));
-	basicItemInfo.pridl.reset(ILClone(itemInfo.pridl.get()));
-	basicItemInfo.wfd = itemInfo.wfd;
-	StringCchCopy(basicItemInfo.szDisplayName, SIZEOF_ARRAY(basicItemInfo.szDisplayName), itemInfo.szDisplayName);
+	basicItemInfo.pidlComplete.reset(ILClone(m_itemStore.getPidlComplete(internalIndex)));
+	basicItemInfo.pridl.reset(ILClone(m_itemStore.getPidlRelative(internalIndex)));
+	basicItemInfo.wfd = m_itemStore.getFindData(internalIndex);
+	StringCchCopy(basicItemInfo.szDisplayName, SIZEOF_ARRAY(basicItemInfo.szDisplayName),
+		m_itemStore.getDisplayName(internalIndex));
 
 	return basicItemInfo;
 }
\ No newline at end of file
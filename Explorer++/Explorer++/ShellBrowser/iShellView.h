@@ -7,19 +7,38 @@
 #include "ColumnDataRetrieval.h"
 #include "Columns.h"
 #include "FolderSettings.h"
+#include "FolderSnapshotCache.h"
+#include "IconCache.h"
 #include "iPathManager.h"
+#include "ItemFilter.h"
+#include "ItemResultBatch.h"
+#include "ItemRowMap.h"
+#include "ItemStore.h"
+#include "ListViewGroupSet.h"
+#include "SortKey.h"
 #include "SortModes.h"
 #include "ViewModes.h"
+#include "../Helper/DirectoryChangeJournal.h"
+#include "../Helper/DirectoryFindDataReader.h"
 #include "../Helper/DropHandler.h"
 #include "../Helper/Helper.h"
 #include "../Helper/ImageWrappers.h"
+#include "../Helper/ItemTaskScheduler.h"
 #include "../Helper/Macros.h"
+#include "../Helper/MPSCQueue.h"
 #include "../Helper/StringHelper.h"
+#include "../Helper/WildcardMatcher.h"
 #include "../ThirdParty/CTPL/cpl_stl.h"
 #include <boost/optional.hpp>
+#include <atomic>
+#include <functional>
 #include <future>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #define WM_USER_UPDATEWINDOWS		(WM_APP + 17)
 #define WM_USER_FILESADDED			(WM_APP + 51)
@@ -33,29 +52,24 @@ typedef struct
 	ULARGE_INTEGER TotalSelectionSize;
 } FolderInfo_t;
 
-typedef struct
-{
-	TCHAR szHeader[512];
-	int iGroupId;
-
-	/* Used to record the number of items in this group.
-	Mimics the feature available in Windows Vista and later. */
-	int nItems;
-} TypeGroup_t;
-
 struct BasicItemInfo_t;
-class CachedIcons;
 struct Config;
+class FolderSizeService;
+class MetadataCache;
+class ThumbnailCache;
 
 class CShellBrowser : public IDropTarget, public IDropFilesCallback
 {
-	friend int CALLBACK SortStub(LPARAM lParam1,LPARAM lParam2,LPARAM lParamSort);
-
 public:
 
+	/* The dimensions of each item in thumbnails view. */
+	static const int THUMBNAIL_ITEM_WIDTH = 120;
+	static const int THUMBNAIL_ITEM_HEIGHT = 120;
+
 	static CShellBrowser *CreateNew(int id, HINSTANCE resourceInstance, HWND hOwner, HWND hListView,
-		CachedIcons *cachedIcons, std::shared_ptr<const Config> config, const FolderSettings &folderSettings,
-		boost::optional<FolderColumns> initialColumns);
+		IconCache *iconCache, FolderSizeService *folderSizeService, ThumbnailCache *thumbnailCache,
+		MetadataCache *metadataCache, ItemTaskScheduler *itemTaskScheduler, std::shared_ptr<const Config> config,
+		const FolderSettings &folderSettings, boost::optional<FolderColumns> initialColumns);
 
 	/* IUnknown methods. */
 	HRESULT __stdcall	QueryInterface(REFIID iid,void **ppvObject);
@@ -81,6 +95,7 @@ public:
 	/* Get/Set current state. */
 	LPITEMIDLIST		QueryCurrentDirectoryIdl(void) const;
 	UINT				QueryCurrentDirectory(int BufferSize,TCHAR *Buffer) const;
+	FolderSettings		GetFolderSettings() const;
 	BOOL				GetAutoArrange(void) const;
 	void				SetAutoArrange(BOOL autoArrange);
 	ViewMode			GetViewMode() const;
@@ -167,14 +182,16 @@ private:
 
 	DISALLOW_COPY_AND_ASSIGN(CShellBrowser);
 
+	/* Holds the information gathered for an item
+	before it's added to m_itemStore. This is what's
+	passed from the enumeration thread back to the
+	UI thread. */
 	struct ItemInfo_t
 	{
 		PIDLPointer		pidlComplete;
 		PIDLPointer		pridl;
 		WIN32_FIND_DATA	wfd;
 		TCHAR			szDisplayName[MAX_PATH];
-		BOOL			bIconRetrieved;
-		int				iIcon;
 
 		/* These are only used for drives. They are
 		needed for when a drive is removed from the
@@ -182,24 +199,56 @@ private:
 		so that the removed drive can be found. */
 		BOOL			bDrive;
 		TCHAR			szDrive[4];
-
-		/* Used for temporary sorting in details mode (i.e.
-		when items need to be rearranged). */
-		int				iRelativeSort;
 	};
 
-	enum DateType_t
+	/* Item data that's held by the listview normally, but
+	which has to be stored separately when the listview
+	is in owner data mode. */
+	struct OwnerDataItem_t
 	{
-		DATE_TYPE_CREATED,
-		DATE_TYPE_MODIFIED,
-		DATE_TYPE_ACCESSED
+		/* Index into the current imagelist, or -1 if no
+		image has been assigned yet. For icons, the upper
+		eight bits contain the overlay index. */
+		int				iImage;
+		BOOL			bGhosted;
+
+		/* Details view text, keyed by column id. */
+		std::unordered_map<unsigned int, std::wstring>	columnText;
+
+		std::vector<std::wstring>	tileText;
 	};
 
-	struct AlteredFile_t
+	/* The state of a folder that's been navigated away from.
+	When going back (or forward) to the folder, this is shown
+	straight away, rather than enumerating and sorting the
+	folder again. The folder is then reconciled with its
+	current contents in the background. */
+	struct FolderSnapshot_t
 	{
-		TCHAR	szFileName[MAX_PATH];
-		DWORD	dwAction;
-		int		iFolderIndex;
+		PIDLPointer		pidlDirectory;
+		BOOL			showHidden;
+
+		ItemStore		itemStore;
+		std::unordered_map<std::wstring, int>	itemNameIndex;
+		int				itemIDCounter;
+		std::unordered_map<int, ULONGLONG>	cachedFolderSizes;
+		std::unordered_map<int, OwnerDataItem_t>	ownerDataItems;
+
+		/* The items that were shown, in order, followed by
+		those that had been filtered out. */
+		std::vector<int>	shownItems;
+		std::vector<int>	hiddenItems;
+		SortMode		sortMode = SortMode::Name;
+		BOOL			sortAscending;
+
+		std::vector<int>	selectedItems;
+		int				focusedItem;
+
+		/* The scroll position is kept as an origin in the
+		icon views, or the top item in the other views. */
+		ViewMode		viewMode = ViewMode::Icons;
+		boost::optional<POINT>	scrollOrigin;
+		int				topItem;
 	};
 
 	struct AwaitingAdd_t
@@ -227,46 +276,150 @@ private:
 		TCHAR szFileName[MAX_PATH];
 	};
 
+	/* Each of the results below records the value of
+	m_itemResultGeneration at the time the task was queued,
+	so that results for a previous folder can be ignored. */
 	struct ColumnResult_t
 	{
+		int generation;
 		int itemInternalIndex;
 		int columnID;
 		std::wstring columnText;
 	};
 
+	/* Sent (from a FolderSizeService worker) each
+	time the running total for a folder changes. */
+	struct FolderSizeResult_t
+	{
+		int generation;
+		int itemInternalIndex;
+		ULONGLONG size;
+		bool complete;
+	};
+
 	struct IconResult_t
 	{
+		int generation;
 		int itemInternalIndex;
 		int iconIndex;
+
+		/* Used to update the icon cache. Not all icons have
+		a location that can be cached. */
+		boost::optional<IconLocation> iconLocation;
+		bool perClassIcon;
 	};
 
 	struct ThumbnailResult_t
 	{
+		int generation;
 		int itemInternalIndex;
 		HBitmapPtr bitmap;
 	};
 
 	struct InfoTipResult
 	{
+		int generation;
 		int itemInternalIndex;
 		std::wstring infoTip;
 	};
 
+	/* Results are handed from the background workers to the UI
+	thread through these queues. Only one message is posted
+	until the UI thread has drained the queues, so a large
+	number of results doesn't flood the message queue. Held in
+	a shared_ptr, since folder size results can still arrive
+	after the browser has been destroyed. */
+	struct ItemResults_t
+	{
+		MPSCQueue<ColumnResult_t> columnResults;
+		MPSCQueue<FolderSizeResult_t> folderSizeResults;
+		MPSCQueue<IconResult_t> iconResults;
+		MPSCQueue<ThumbnailResult_t> thumbnailResults;
+		MPSCQueue<InfoTipResult> infoTipResults;
+		ResultNotifier notifier;
+
+		/* Called from worker threads. */
+		template <typename T>
+		void Add(HWND listView, MPSCQueue<T> &queue, T result)
+		{
+			queue.Push(std::move(result));
+
+			if (notifier.onResultAdded())
+			{
+				PostMessage(listView, WM_APP_ITEM_RESULTS_READY, 0, 0);
+			}
+		}
+	};
+
+	typedef std::unordered_map<unsigned int, int> ColumnIndexMap_t;
+	typedef std::unordered_map<std::wstring, WIN32_FIND_DATA> FindDataMap_t;
+
+	// Shared between the UI thread and the thread that enumerates the
+	// current directory. Items are handed over in batches, so that the
+	// listview can be populated while the directory is still being read.
+	struct DirectoryEnumeration_t
+	{
+		int id;
+		std::atomic<bool> cancelled{ false };
+		PIDLPointer pidlDirectory;
+		SHCONTF enumFlags;
+		BOOL virtualFolder;
+
+		/* Set when the items were restored from a snapshot, or
+		when the directory is being rescanned. In that case, only
+		the find data for the directory is read, so that the
+		existing items can be brought up to date. */
+		bool reconcile = false;
+
+		/* Only read on the UI thread. If the find data can't be
+		read, a restored snapshot is replaced by a full
+		enumeration. */
+		bool snapshotRestored = false;
+
+		std::mutex mutex;
+		std::list<std::vector<ItemInfo_t>> pendingBatches;
+		boost::optional<FindDataMap_t> findData;
+		bool finished = false;
+	};
+
+	/* Identifies the icon, thumbnail, column bundle and infotip
+	tasks queued for an item in m_itemTaskScheduler. Other column
+	tasks use the (positive) ID of the column instead. */
+	static const int ITEM_TASK_ICON = -1;
+	static const int ITEM_TASK_THUMBNAIL = -2;
+	static const int ITEM_TASK_VERSION_INFO_COLUMNS = -3;
+	static const int ITEM_TASK_MEDIA_METADATA_COLUMNS = -4;
+	static const int ITEM_TASK_INFOTIP = -5;
+
 	static const int THUMBNAIL_ITEM_HORIZONTAL_SPACING = 20;
 	static const int THUMBNAIL_ITEM_VERTICAL_SPACING = 20;
 
 	static const UINT_PTR LISTVIEW_SUBCLASS_ID = 0;
 
-	static const UINT WM_APP_COLUMN_RESULT_READY = WM_APP + 150;
-	static const UINT WM_APP_THUMBNAIL_RESULT_READY = WM_APP + 151;
-	static const UINT WM_APP_ICON_RESULT_READY = WM_APP + 152;
-	static const UINT WM_APP_INFO_TIP_READY = WM_APP + 153;
+	static const UINT WM_APP_ITEM_RESULTS_READY = WM_APP + 150;
+	static const UINT WM_APP_ENUMERATION_RESULTS_READY = WM_APP + 154;
 
-	static const int THUMBNAIL_ITEM_WIDTH = 120;
-	static const int THUMBNAIL_ITEM_HEIGHT = 120;
+	// The number of items requested from the enumerator in each call
+	// to IEnumIDList::Next().
+	static const ULONG ENUMERATION_FETCH_COUNT = 64;
+
+	// A batch is handed over to the UI thread once it reaches this
+	// size, or once this many milliseconds have passed since the last
+	// batch was handed over (whichever comes first).
+	static const size_t ENUMERATION_BATCH_SIZE = 1000;
+	static const DWORD ENUMERATION_BATCH_INTERVAL = 50;
+
+	// Directory changes are applied in batches, at most once per this
+	// many milliseconds.
+	static const UINT DIRECTORY_CHANGE_BATCH_INTERVAL = 200;
+
+	/* The number of folders (per tab) that are kept in
+	m_folderSnapshots. */
+	static const size_t MAX_FOLDER_SNAPSHOTS = 4;
 
 	CShellBrowser(int id, HINSTANCE resourceInstance, HWND hOwner, HWND hListView,
-		CachedIcons *cachedIcons, std::shared_ptr<const Config> config,
+		IconCache *iconCache, FolderSizeService *folderSizeService, ThumbnailCache *thumbnailCache,
+		MetadataCache *metadataCache, ItemTaskScheduler *itemTaskScheduler, std::shared_ptr<const Config> config,
 		const FolderSettings &folderSettings, boost::optional<FolderColumns> initialColumns);
 	~CShellBrowser();
 
@@ -276,13 +429,22 @@ private:
 	void				VerifySortMode(void);
 
 	/* Browsing support. */
-	void				BrowseVirtualFolder(LPITEMIDLIST pidlDirectory);
+	void				StartDirectoryEnumeration(LPCITEMIDLIST pidlDirectory, bool reconcile);
+	void				CancelDirectoryEnumeration();
+	static void			EnumerateDirectoryAsync(HWND listView, HWND owner, std::shared_ptr<DirectoryEnumeration_t> enumeration);
+	void				ProcessEnumerationResults(int enumerationId);
+	void				SaveFolderSnapshot();
+	std::unique_ptr<FolderSnapshot_t>	TakeFolderSnapshot(LPCITEMIDLIST pidlDirectory);
+	void				RestoreFolderSnapshot(std::unique_ptr<FolderSnapshot_t> snapshot);
 	HRESULT				ParsePath(LPITEMIDLIST *pidlDirectory,UINT uFlags,BOOL *bWriteHistory);
 	void				InsertAwaitingItems(BOOL bInsertIntoGroup);
 	BOOL				IsFileFiltered(int iItemInternal) const;
 	HRESULT				AddItemInternal(LPITEMIDLIST pidlDirectory, LPITEMIDLIST pidlRelative, const TCHAR *szFileName, int iItemIndex, BOOL bPosition);
 	HRESULT				AddItemInternal(int iItemIndex,int iItemId,BOOL bPosition);
 	int					SetItemInformation(LPITEMIDLIST pidlDirectory, LPITEMIDLIST pidlRelative, const TCHAR *szFileName);
+	void				StoreItem(int itemId, const ItemInfo_t &itemInfo);
+	static ItemInfo_t	GetItemInformation(LPCITEMIDLIST pidlDirectory, LPCITEMIDLIST pidlRelative, const TCHAR *szFileName, DirectoryFindDataReader *findDataReader);
+	static boost::optional<FindDataMap_t>	ReadDirectoryFindData(LPCITEMIDLIST pidlDirectory, const std::atomic<bool> &cancelled);
 	void				ResetFolderMemoryAllocations(void);
 	void				SetViewModeInternal(ViewMode viewMode);
 	void				ApplyFolderEmptyBackgroundImage(bool apply);
@@ -301,45 +463,54 @@ private:
 	void				OnListViewGetDisplayInfo(LPARAM lParam);
 	LRESULT				OnListViewGetInfoTip(NMLVGETINFOTIP *getInfoTip);
 	void				QueueInfoTipTask(int internalIndex, const std::wstring &existingInfoTip);
-	static boost::optional<InfoTipResult>	GetInfoTipAsync(HWND listView, int infoTipResultId, int internalIndex, const BasicItemInfo_t &basicItemInfo, const Config &config, HINSTANCE instance, bool virtualFolder);
-	void				ProcessInfoTipResult(int infoTipResultId);
+	static boost::optional<InfoTipResult>	GetInfoTipAsync(int internalIndex, const BasicItemInfo_t &basicItemInfo, const Config &config, HINSTANCE instance, bool virtualFolder);
+	void				ProcessInfoTipResult(const InfoTipResult &result);
+	void				ProcessItemResults();
 	int					GetItemInternalIndex(int item) const;
+	bool				IsItemInViewport(int internalIndex) const;
+	void				CancelOffscreenItemTasks();
+	void				CancelItemTasks(int internalIndex);
+	void				CancelItemTasks(std::function<bool(const ItemTaskScheduler::TaskKey &key)> shouldCancel);
+	void				ResetCancelledItemTask(const ItemTaskScheduler::TaskKey &cancelledTask);
+	void				ResetCancelledColumnText(int internalIndex, unsigned int columnID);
+
+	/* Owner data listview support. */
+	void				InsertAwaitingItemsOwnerData();
+	void				OnListViewGetDisplayInfoOwnerData(NMLVDISPINFO *pnmv);
+	int					OnListViewFindItem(const NMLVFINDITEM *findItem) const;
+	OwnerDataItem_t		&GetOwnerDataItem(int internalIndex);
+	void				InvalidateOwnerDataItem(int internalIndex);
+	void				ResetOwnerDataImages();
+	void				UpdateOwnerDataRows(const std::function<void()> &updateRows);
 
 	BasicItemInfo_t		getBasicItemInfo(int internalIndex) const;
 
 	/* Sorting. */
-	int CALLBACK		Sort(int InternalIndex1,int InternalIndex2) const;
-	int CALLBACK		SortByName(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, const GlobalFolderSettings &globalFolderSettings) const;
-	int CALLBACK		SortBySize(int InternalIndex1,int InternalIndex2) const;
-	int CALLBACK		SortByType(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const;
-	int CALLBACK		SortByDate(int InternalIndex1,int InternalIndex2,DateType_t DateType) const;
-	int CALLBACK		SortByTotalSize(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, bool TotalSize) const;
-	int CALLBACK		SortByAttributes(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const;
-	int CALLBACK		SortByRealSize(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const;
-	int CALLBACK		SortByShortName(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const;
-	int CALLBACK		SortByOwner(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const;
-	int CALLBACK		SortByVersionInfo(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, VersionInfoType_t VersioninfoType) const;
-	int CALLBACK		SortByShortcutTo(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const;
-	int CALLBACK		SortByHardlinks(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const;
-	int CALLBACK		SortByExtension(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const;
-	int CALLBACK		SortByItemDetails(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, const SHCOLUMNID *pscid) const;
-	int CALLBACK		SortByImageProperty(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, PROPID PropertyId) const;
-	int CALLBACK		SortByVirtualComments(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const;
-	int CALLBACK		SortByFileSystem(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const;
-	int CALLBACK		SortByPrinterProperty(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, PrinterInformationType_t PrinterInformationType) const;
-	int CALLBACK		SortByNetworkAdapterStatus(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2) const;
-	int CALLBACK		SortByMediaMetadata(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2, MediaMetadataType_t MediaMetaDataType) const;
+	SortKey				BuildSortKey(int InternalIndex) const;
+	void				BuildNameSortKey(const BasicItemInfo_t &itemInfo, SortKey &sortKey) const;
+	void				BuildTypeSortKey(const BasicItemInfo_t &itemInfo, SortKey &sortKey) const;
+	void				BuildSizeSortKey(int InternalIndex, SortKey &sortKey) const;
+	void				BuildDriveSpaceSortKey(const BasicItemInfo_t &itemInfo, bool TotalSize, SortKey &sortKey) const;
+	void				BuildItemDetailsSortKey(const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid, SortKey &sortKey) const;
 
 	/* Listview column support. */
 	void				PlaceColumns();
 	void				QueueColumnTask(int itemInternalIndex, int columnIndex);
-	static ColumnResult_t	GetColumnTextAsync(HWND listView, int columnResultId, unsigned int ColumnID, int InternalIndex, const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings);
+	static ColumnResult_t	GetColumnTextAsync(unsigned int ColumnID, int InternalIndex, const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings, MetadataCache *metadataCache);
+	std::wstring		GetCachedColumnText(unsigned int ColumnID, const BasicItemInfo_t &basicItemInfo) const;
+	void				QueueColumnBundleTask(int itemInternalIndex, ColumnBundle_t bundle, const BasicItemInfo_t &basicItemInfo);
+	std::vector<unsigned int>	GetColumnIdsInBundle(ColumnBundle_t bundle) const;
+	static int			GetColumnBundleTaskType(ColumnBundle_t bundle);
 	void				InsertColumn(unsigned int ColumnId,int iColumndIndex,int iWidth);
 	void				SetActiveColumnSet();
 	void				GetColumnInternal(unsigned int id,Column_t *pci) const;
 	void				SaveColumnWidths();
-	void				ProcessColumnResult(int columnResultId);
+	boost::optional<int>	ProcessColumnResult(const ColumnResult_t &result, const ColumnIndexMap_t &columnIndexes);
+	void				QueueFolderSizeTask(int itemInternalIndex, const std::wstring &path);
+	boost::optional<int>	ProcessFolderSizeResult(const FolderSizeResult_t &result, const ColumnIndexMap_t &columnIndexes);
+	boost::optional<int>	SetColumnTextForItem(int itemInternalIndex, unsigned int columnID, const std::wstring &columnText, const ColumnIndexMap_t &columnIndexes);
 	boost::optional<int>	GetColumnIndexById(unsigned int id) const;
+	ColumnIndexMap_t	GetColumnIndexMap() const;
 	boost::optional<unsigned int>	GetColumnIdByIndex(int index) const;
 
 	/* Device change support. */
@@ -354,29 +525,33 @@ private:
 	void				OnFileActionRenamedOldName(const TCHAR *szFileName);
 	void				OnFileActionRenamedNewName(const TCHAR *szFileName);
 	void				RenameItem(int iItemInternal, const TCHAR *szNewFileName);
+	void				ReconcileItems(FindDataMap_t directoryFindData);
 	int					DetermineItemSortedPosition(LPARAM lParam) const;
 
 	/* Filtering support. */
 	BOOL				IsFilenameFiltered(const TCHAR *FileName) const;
-	void				RemoveFilteredItems(void);
+	boost::optional<WildcardMatcher>	GetActiveFilterMatcher(void) const;
+	boost::optional<ItemFilter::Scope>	GetFilterUpdateScope(void) const;
+	void				RemoveFilteredItems(const std::vector<int> &internalIndices);
 	void				RemoveFilteredItem(int iItem,int iItemInternal);
 	void				UpdateFiltering(void);
-	void				UnfilterAllItems(void);
+	void				UnfilterItems(const std::vector<int> &internalIndices);
 
 	/* Listview group support (real files). */
 	static INT CALLBACK	GroupNameComparisonStub(INT Group1_ID, INT Group2_ID, void *pvData);
 	INT CALLBACK		GroupNameComparison(INT Group1_ID, INT Group2_ID);
 	static INT CALLBACK	GroupFreeSpaceComparisonStub(INT Group1_ID, INT Group2_ID, void *pvData);
 	INT CALLBACK		GroupFreeSpaceComparison(INT Group1_ID, INT Group2_ID);
-	TCHAR				*RetrieveGroupHeader(int iGroupId);
+	const TCHAR			*RetrieveGroupHeader(int iGroupId) const;
 	int					DetermineItemGroup(int iItemInternal);
+	std::wstring		DetermineItemGroupHeader(int iItemInternal) const;
 	void				DetermineItemNameGroup(int iItemInternal,TCHAR *szGroupHeader,int cchMax) const;
 	void				DetermineItemSizeGroup(int iItemInternal,TCHAR *szGroupHeader,int cchMax) const;
 	void				DetermineItemDateGroup(int iItemInternal,int iDateType,TCHAR *szGroupHeader,int cchMax) const;
 	void				DetermineItemAttributeGroup(int iItemInternal,TCHAR *szGroupHeader,int cchMax) const;
 	void				DetermineItemOwnerGroup(int iItemInternal,TCHAR *szGroupHeader,int cchMax) const;
-	void				DetermineItemVersionGroup(int iItemInternal,TCHAR *szVersionType,TCHAR *szGroupHeader,int cchMax) const;
-	void				DetermineItemCameraPropertyGroup(int iItemInternal,PROPID PropertyId,TCHAR *szGroupHeader,int cchMax) const;
+	void				DetermineItemVersionGroup(int iItemInternal,unsigned int ColumnID,TCHAR *szGroupHeader,int cchMax) const;
+	void				DetermineItemCameraPropertyGroup(int iItemInternal,unsigned int ColumnID,TCHAR *szGroupHeader,int cchMax) const;
 	void				DetermineItemExtensionGroup(int iItemInternal,TCHAR *szGroupHeader,int cchMax) const;
 	void				DetermineItemFileSystemGroup(int iItemInternal,TCHAR *szGroupHeader,int cchMax) const;
 	void				DetermineItemNetworkStatus(int iItemInternal,TCHAR *szGroupHeader,int cchMax) const;
@@ -388,21 +563,24 @@ private:
 	void				DetermineItemSummaryGroup(const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid, TCHAR *szGroupHeader, size_t cchMax, const GlobalFolderSettings &globalFolderSettings) const;
 
 	/* Other grouping support. */
-	int					CheckGroup(const TCHAR *szGroupHeader, PFNLVGROUPCOMPARE pfnGroupCompare);
+	int					CheckGroup(const std::wstring &groupHeader, PFNLVGROUPCOMPARE pfnGroupCompare);
+	void				UpdateGroupHeaders(void);
+	void				InvalidateItemGroup(int iItemInternal);
 	void				InsertItemIntoGroup(int iItem,int iGroupId);
 	void				MoveItemsIntoGroups(void);
 
 	/* Listview icons. */
-	void				QueueIconTask(int internalIndex);
-	static boost::optional<IconResult_t>	FindIconAsync(HWND listView, int iconResultId, int internalIndex, const BasicItemInfo_t &basicItemInfo);
-	void				ProcessIconResult(int iconResultId);
-	void				UpdateIconCache(const ItemInfo_t &itemInfo, int iconIndex);
-	boost::optional<int>	GetCachedIconIndex(const ItemInfo_t &itemInfo);
+	void				QueueIconTask(int internalIndex, bool iconCached);
+	static boost::optional<IconResult_t>	FindIconAsync(int internalIndex, const BasicItemInfo_t &basicItemInfo, bool iconCached);
+	boost::optional<int>	ProcessIconResult(const IconResult_t &result);
+	void				UpdateIconCache(const IconResult_t &result);
+	boost::optional<int>	GetCachedIconIndex(int internalIndex);
 
 	/* Thumbnails view. */
 	void				QueueThumbnailTask(int internalIndex);
-	static boost::optional<ThumbnailResult_t>	FindThumbnailAsync(HWND listView, int thumbnailResultId, int internalIndex, const BasicItemInfo_t &basicItemInfo);
-	void				ProcessThumbnailResult(int thumbnailResultId);
+	static boost::optional<ThumbnailResult_t>	FindThumbnailAsync(int internalIndex, const BasicItemInfo_t &basicItemInfo, ThumbnailCache *thumbnailCache);
+	static HBITMAP		ExtractThumbnail(const BasicItemInfo_t &basicItemInfo);
+	boost::optional<int>	ProcessThumbnailResult(const ThumbnailResult_t &result);
 	void				SetupThumbnailsView(void);
 	void				RemoveThumbnailsView(void);
 	int					GetIconThumbnail(int iInternalIndex) const;
@@ -430,6 +608,9 @@ private:
 	BOOL				CompareVirtualFolders(UINT uFolderCSIDL) const;
 	int					LocateFileItemInternalIndex(const TCHAR *szFileName) const;
 	boost::optional<int>	LocateItemByInternalIndex(int internalIndex) const;
+	void				AddItemToNameIndex(int internalIndex);
+	void				RemoveItemFromNameIndex(int internalIndex);
+	void				SyncItemRowsWithListView();
 	void				ApplyHeaderSortArrow();
 	void				QueryFullItemNameInternal(int iItemInternal,TCHAR *szFullFileName,UINT cchMax) const;
 
@@ -455,24 +636,51 @@ private:
 
 	/* Stores various extra information on files, such
 	as display name. */
-	std::unordered_map<int, ItemInfo_t>	m_itemInfoMap;
-
-	ctpl::thread_pool	m_columnThreadPool;
-	std::unordered_map<int, std::future<ColumnResult_t>> m_columnResults;
-	int					m_columnResultIDCounter;
-
-	ctpl::thread_pool	m_itemImageThreadPool;
-
-	std::unordered_map<int, std::future<boost::optional<IconResult_t>>> m_iconResults;
-	int					m_iconResultIDCounter;
-	CachedIcons			*m_cachedIcons;
-
-	std::unordered_map<int, std::future<boost::optional<ThumbnailResult_t>>> m_thumbnailResults;
-	int					m_thumbnailResultIDCounter;
-
-	ctpl::thread_pool	m_infoTipsThreadPool;
-	std::unordered_map<int, std::future<boost::optional<InfoTipResult>>> m_infoTipResults;
-	int					m_infoTipResultIDCounter;
+	ItemStore			m_itemStore;
+
+	/* Maps both the long and short filename of each
+	item to its internal index. Keyed by the upper-cased
+	name, so lookups are case-insensitive. */
+	std::unordered_map<std::wstring, int>	m_itemNameIndex;
+
+	/* Tracks the listview row of each item that's
+	currently shown. */
+	ItemRowMap			m_itemRows;
+
+	/* Set if the listview was created with LVS_OWNERDATA.
+	In that case, m_itemRows is the only record of which
+	items are shown (and in what order) and the listview
+	requests everything else through LVN_GETDISPINFO. */
+	BOOL				m_ownerDataListView;
+	std::unordered_map<int, OwnerDataItem_t>	m_ownerDataItems;
+
+	/* Filled by the item tasks, which only hold on to this (and
+	the listview handle), so that they can still finish safely
+	after the browser has been destroyed. */
+	std::shared_ptr<ItemResults_t>	m_itemResults;
+	int					m_itemResultGeneration;
+
+	/* Runs the column, icon, thumbnail and infotip tasks. Shared
+	between all tabs; tasks are queued with m_ID as the owner. */
+	ItemTaskScheduler	*m_itemTaskScheduler;
+
+	IconCache			*m_iconCache;
+	FolderSizeService	*m_folderSizeService;
+
+	/* Shared between all tabs. May be null, if the cache file
+	couldn't be opened. */
+	ThumbnailCache		*m_thumbnailCache;
+
+	/* Shared between all tabs. Holds column values that have
+	already been retrieved, for use by the column, sort and
+	group code. May be null. */
+	MetadataCache		*m_metadataCache;
+
+	/* Kept separate from the item tasks, since enumerating a slow
+	(e.g. network) folder can block for a long time. */
+	ctpl::thread_pool	m_enumerationThreadPool;
+	std::shared_ptr<DirectoryEnumeration_t>	m_directoryEnumeration;
+	int					m_enumerationIDCounter;
 
 	/* Cached folder size data. */
 	mutable std::unordered_map<int, ULONGLONG>	m_cachedFolderSizes;
@@ -480,6 +688,10 @@ private:
 	/* Manages browsing history. */
 	CPathManager		m_pathManager;
 
+	/* Recently visited folders. Only used when navigating
+	back or forward. */
+	FolderSnapshotCache<FolderSnapshot_t>	m_folderSnapshots;
+
 	/* Internal state. */
 	LPITEMIDLIST		m_pidlDirectory;
 	const HINSTANCE		m_hResourceModule;
@@ -505,6 +717,10 @@ private:
 	std::shared_ptr<const Config>	m_config;
 	FolderSettings		m_folderSettings;
 
+	/* Compiled from the filter in m_folderSettings. Rebuilt
+	whenever the filter (or its case sensitivity) changes. */
+	WildcardMatcher		m_filterMatcher;
+
 	/* ID. */
 	const int			m_ID;
 
@@ -512,7 +728,8 @@ private:
 	have been modified (i.e. created, deleted,
 	renamed, etc). */
 	CRITICAL_SECTION	m_csDirectoryAltered;
-	std::list<AlteredFile_t>	m_AlteredList;
+	DirectoryChangeJournal	m_directoryChanges;
+	int					m_directoryChangesFolderIndex;
 	std::list<Added_t>	m_FilesAdded;
 
 	/* Stores information on files that have
@@ -555,13 +772,27 @@ private:
 	int					m_bOverFolder;
 	int					m_iDropFolder;
 
-	/* Listview groups. The group id is declared
-	explicitly, rather than taken from the size
-	of the group list, to avoid warnings concerning
-	size_t and int. */
-	std::list<TypeGroup_t>	m_GroupList;
-	int					m_iGroupId;
-
-	/* Filtering related data. */
-	std::list<int>		m_FilteredItemsList;
+	/* Listview groups. The header of each group is only
+	rewritten (in UpdateGroupHeaders) once a batch of
+	items has been added, rather than on every insert. */
+	ListViewGroupSet	m_groups;
+
+	/* The group header for each item, for the sort mode
+	below. Some headers require shell calls to build, so
+	they're only determined once, rather than every time
+	the items are regrouped (e.g. when the sort order is
+	reversed). Entries are removed when an item changes.
+	Date and free space headers are never cached. */
+	std::unordered_map<int, std::wstring>	m_itemGroupHeaders;
+	boost::optional<SortMode>	m_itemGroupHeadersSortMode;
+
+	/* Records which items currently pass the filter,
+	including those that aren't shown. */
+	ItemFilter			m_itemFilter;
+
+	/* The filter the shown items currently reflect (or
+	none, if no filter is applied). Compared against the
+	new filter when it changes, to determine which items
+	need to be tested again. */
+	boost::optional<WildcardMatcher>	m_appliedFilterMatcher;
 };
\ No newline at end of file
@@ -6,7 +6,10 @@
 #include "SplitFileDialog.h"
 #include "Explorer++_internal.h"
 #include "MainResource.h"
+#include "../Helper/ChecksumManifest.h"
+#include "../Helper/ChunkedFileCopier.h"
 #include "../Helper/FileOperations.h"
+#include "../Helper/FileWrappers.h"
 #include "../Helper/Helper.h"
 #include "../Helper/Macros.h"
 #include "../Helper/RegistrySettings.h"
@@ -15,6 +18,7 @@
 #include "../Helper/WindowHelper.h"
 #include "../Helper/XMLSettings.h"
 #include <boost/scope_exit.hpp>
+#include <algorithm>
 #include <comdef.h>
 #include <unordered_map>
 
@@ -28,6 +32,7 @@ namespace NSplitFileDialog
 	const int		WM_APP_INPUTFILEINVALID		= WM_APP + 4;
 
 	const TCHAR		COUNTER_PATTERN[] = _T("/N");
+	const TCHAR		MANIFEST_EXTENSION[] = _T(".sfv");
 
 	DWORD WINAPI	SplitFileThreadProcStub(LPVOID pParam);
 }
@@ -376,7 +381,7 @@ void CSplitFileDialog::OnOk()
 		GetWindowString(hEditOutputDirectory,strOutputDirectory);
 
 		BOOL bTranslated;
-		UINT uSplitSize = GetDlgItemInt(m_hDlg,IDC_SPLIT_EDIT_SIZE,&bTranslated,FALSE);
+		ULONGLONG ullSplitSize = GetDlgItemInt(m_hDlg,IDC_SPLIT_EDIT_SIZE,&bTranslated,FALSE);
 
 		if(!bTranslated)
 		{
@@ -408,21 +413,21 @@ void CSplitFileDialog::OnOk()
 				break;
 
 			case SIZE_TYPE_KB:
-				uSplitSize *= KB;
+				ullSplitSize *= KB;
 				break;
 
 			case SIZE_TYPE_MB:
-				uSplitSize *= MB;
+				ullSplitSize *= MB;
 				break;
 
 			case SIZE_TYPE_GB:
-				uSplitSize *= GB;
+				ullSplitSize *= GB;
 				break;
 			}
 		}
 
 		m_pSplitFile = new CSplitFile(m_hDlg,m_strFullFilename,strOutputFilename,
-			strOutputDirectory,uSplitSize);
+			strOutputDirectory,ullSplitSize);
 
 		GetDlgItemText(m_hDlg,IDOK,m_szOk,SIZEOF_ARRAY(m_szOk));
 
@@ -541,13 +546,13 @@ DWORD WINAPI NSplitFileDialog::SplitFileThreadProcStub(LPVOID pParam)
 
 CSplitFile::CSplitFile(HWND hDlg,std::wstring strFullFilename,
 	std::wstring strOutputFilename,std::wstring strOutputDirectory,
-	UINT uSplitSize)
+	ULONGLONG ullSplitSize)
 {
 	m_hDlg					= hDlg;
 	m_strFullFilename		= strFullFilename;
 	m_strOutputFilename		= strOutputFilename;
 	m_strOutputDirectory	= strOutputDirectory;
-	m_uSplitSize			= uSplitSize;
+	m_ullSplitSize		= ullSplitSize;
 
 	m_bStopSplitting		= false;
 
@@ -561,78 +566,106 @@ CSplitFile::~CSplitFile()
 
 void CSplitFile::SplitFile()
 {
-	HANDLE hInputFile = CreateFile(m_strFullFilename.c_str(),GENERIC_READ,
-		FILE_SHARE_READ,NULL,OPEN_EXISTING,0,NULL);
+	HFilePtr inputFile = CreateFilePtr(m_strFullFilename.c_str(),GENERIC_READ,
+		FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_FLAG_OVERLAPPED|FILE_FLAG_SEQUENTIAL_SCAN,NULL);
 
-	if(hInputFile == INVALID_HANDLE_VALUE)
+	if(!inputFile)
 	{
 		PostMessage(m_hDlg,NSplitFileDialog::WM_APP_INPUTFILEINVALID,0,0);
 		return;
 	}
 
 	LARGE_INTEGER lFileSize;
-	GetFileSizeEx(hInputFile,&lFileSize);
-
-	LONGLONG nSplits = lFileSize.QuadPart / m_uSplitSize;
+	GetFileSizeEx(inputFile.get(),&lFileSize);
 
-	if((lFileSize.QuadPart % m_uSplitSize) != 0)
-		nSplits++;
+	PostMessage(m_hDlg,NSplitFileDialog::WM_APP_SETTOTALSPLITCOUNT,PROGRESS_RANGE,0);
 
-	PostMessage(m_hDlg,NSplitFileDialog::WM_APP_SETTOTALSPLITCOUNT,
-		static_cast<WPARAM>(nSplits),0);
+	SplitFileInternal(inputFile.get(),lFileSize);
 
-	SplitFileInternal(hInputFile,lFileSize);
-
-	CloseHandle(hInputFile);
+	inputFile.reset();
 
 	SendMessage(m_hDlg,NSplitFileDialog::WM_APP_SPLITFINISHED,0,0);
 }
 
+/* Each part is streamed out of the input file in fixed-size
+chunks, so the memory used doesn't depend on the split size.
+Once every part has been written, a manifest holding the
+checksum of each part is saved alongside them, so that the
+parts can be verified when they're merged. */
 void CSplitFile::SplitFileInternal(HANDLE hInputFile,const LARGE_INTEGER &lFileSize)
 {
-	LARGE_INTEGER lRunningSplitSize = {0};
-
-	char *pBuffer = new char[m_uSplitSize];
-	bool bStop = false;
+	std::uint64_t fileSize = lFileSize.QuadPart;
+	std::uint64_t inputOffset = 0;
+	int currentProgress = 0;
 	int nSplitsMade = 1;
+	bool bCompleted = true;
 
-	while(lRunningSplitSize.QuadPart < lFileSize.QuadPart &&
-		!bStop)
-	{
-		DWORD dwNumberOfBytesRead;
-		ReadFile(hInputFile,reinterpret_cast<LPVOID>(pBuffer),m_uSplitSize,&dwNumberOfBytesRead,NULL);
+	ChunkedFileCopier copier;
+	ChunkedFileCopier::Options options;
+	options.computeChecksum = true;
+
+	ChecksumManifest manifest;
+
+	auto progressCallback = [this,fileSize,&inputOffset,&currentProgress] (std::uint64_t bytesCopied) {
+		if(fileSize > 0)
+		{
+			std::uint64_t bytesSplit = (std::min)(inputOffset + bytesCopied,fileSize);
+			int progress = static_cast<int>(bytesSplit * PROGRESS_RANGE / fileSize);
+
+			if(progress != currentProgress)
+			{
+				PostMessage(m_hDlg,NSplitFileDialog::WM_APP_SETCURRENTSPLITCOUNT,progress,0);
+				currentProgress = progress;
+			}
+		}
+
+		EnterCriticalSection(&m_csStop);
+		bool bStop = m_bStopSplitting;
+		LeaveCriticalSection(&m_csStop);
 
+		return !bStop;
+	};
+
+	while(inputOffset < fileSize)
+	{
 		std::wstring strOutputFullFilename;
 		ProcessFilename(nSplitsMade,strOutputFullFilename);
 
-		HANDLE hOutputFile = CreateFile(strOutputFullFilename.c_str(),GENERIC_WRITE,0,NULL,CREATE_NEW,
-			FILE_ATTRIBUTE_NORMAL,NULL);
+		HFilePtr outputFile = CreateFilePtr(strOutputFullFilename.c_str(),GENERIC_WRITE,0,NULL,CREATE_NEW,
+			FILE_ATTRIBUTE_NORMAL|FILE_FLAG_OVERLAPPED,NULL);
 
-		if(hOutputFile != INVALID_HANDLE_VALUE)
+		if(!outputFile)
 		{
-			DWORD dwNumberOfBytesWritten;
-			WriteFile(hOutputFile,reinterpret_cast<LPCVOID>(pBuffer),dwNumberOfBytesRead,
-				&dwNumberOfBytesWritten,NULL);
-
-			CloseHandle(hOutputFile);
+			bCompleted = false;
+			break;
 		}
 
-		/* TODO: Wait for a set period of time before sending message
-		(so as not to block the GUI). */
-		PostMessage(m_hDlg,NSplitFileDialog::WM_APP_SETCURRENTSPLITCOUNT,nSplitsMade,0);
+		auto result = copier.Copy(hInputFile,inputOffset,m_ullSplitSize,outputFile.get(),0,
+			options,progressCallback);
 
-		lRunningSplitSize.QuadPart += dwNumberOfBytesRead;
-		nSplitsMade++;
+		outputFile.reset();
 
-		EnterCriticalSection(&m_csStop);
-		if(m_bStopSplitting)
+		if(result.status != ChunkedFileCopier::Status::Succeeded || result.bytesCopied == 0)
 		{
-			bStop = true;
+			/* Don't leave an incomplete part behind. */
+			DeleteFile(strOutputFullFilename.c_str());
+
+			bCompleted = false;
+			break;
 		}
-		LeaveCriticalSection(&m_csStop);
+
+		manifest.push_back({PathFindFileName(strOutputFullFilename.c_str()),result.checksum});
+
+		inputOffset += result.bytesCopied;
+		nSplitsMade++;
 	}
 
-	delete[] pBuffer;
+	if(bCompleted)
+	{
+		std::wstring strManifestFilename = m_strOutputDirectory + _T("\\")
+			+ PathFindFileName(m_strFullFilename.c_str()) + NSplitFileDialog::MANIFEST_EXTENSION;
+		SaveChecksumManifest(strManifestFilename,manifest);
+	}
 }
 
 void CSplitFile::ProcessFilename(int nSplitsMade,std::wstring &strOutputFullFilename)
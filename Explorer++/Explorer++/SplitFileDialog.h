@@ -49,7 +49,7 @@ class CSplitFile : public CReferenceCount
 {
 public:
 	
-	CSplitFile(HWND hDlg,std::wstring strFullFilename,std::wstring strOutputFilename,std::wstring strOutputDirectory,UINT uSplitSize);
+	CSplitFile(HWND hDlg,std::wstring strFullFilename,std::wstring strOutputFilename,std::wstring strOutputDirectory,ULONGLONG ullSplitSize);
 	~CSplitFile();
 
 	void	SplitFile();
@@ -57,6 +57,10 @@ public:
 
 private:
 
+	/* The progress bar range. Progress is reported as a
+	fraction of the size of the input file. */
+	static const int	PROGRESS_RANGE = 1000;
+
 	void				SplitFileInternal(HANDLE hInputFile,const LARGE_INTEGER &lFileSize);
 	void				ProcessFilename(int nSplitsMade,std::wstring &strOutputFullFilename);
 
@@ -65,7 +69,7 @@ private:
 	std::wstring		m_strFullFilename;
 	std::wstring		m_strOutputFilename;
 	std::wstring		m_strOutputDirectory;
-	UINT				m_uSplitSize;
+	ULONGLONG			m_ullSplitSize;
 
 	CRITICAL_SECTION	m_csStop;
 	bool				m_bStopSplitting;
@@ -6,7 +6,9 @@
 #include "Tab.h"
 
 Tab::Tab(int id) :
+	listView(nullptr),
 	m_id(id),
+	m_shellBrowser(nullptr),
 	m_useCustomName(false),
 	m_locked(false),
 	m_addressLocked(false)
@@ -19,8 +21,19 @@ int Tab::GetId() const
 	return m_id;
 }
 
+// If the tab hasn't been loaded yet, it will be loaded here, so that
+// callers receive a valid shell browser. The only exception is if the
+// tab couldn't be loaded, in which case null is returned.
 CShellBrowser *Tab::GetShellBrowser() const
 {
+	if (!m_shellBrowser && m_loadCallback)
+	{
+		// The callback will be reset while the tab is being loaded, so
+		// it can't be invoked directly.
+		auto loadCallback = m_loadCallback;
+		loadCallback();
+	}
+
 	return m_shellBrowser;
 }
 
@@ -31,6 +44,64 @@ void Tab::SetShellBrowser(CShellBrowser *shellBrowser)
 	m_shellBrowser = shellBrowser;
 }
 
+bool Tab::IsLoaded() const
+{
+	return m_shellBrowser != nullptr;
+}
+
+// Tabs can be created without a listview or shell browser. In that case,
+// the directory and folder settings are held here until the tab is first
+// needed.
+void Tab::SetPendingLoad(std::unique_ptr<PendingLoad> pendingLoad, std::function<void()> loadCallback)
+{
+	m_pendingLoad = std::move(pendingLoad);
+	m_loadCallback = loadCallback;
+}
+
+// Returns null once the tab has been loaded.
+const Tab::PendingLoad *Tab::GetPendingLoad() const
+{
+	return m_pendingLoad.get();
+}
+
+// Should only be called once the tab has a shell browser, since the
+// accessors below rely on the pending load until then.
+std::unique_ptr<Tab::PendingLoad> Tab::ReleasePendingLoad()
+{
+	m_loadCallback = nullptr;
+	return std::move(m_pendingLoad);
+}
+
+PIDLPointer Tab::GetDirectory() const
+{
+	if (m_pendingLoad)
+	{
+		return PIDLPointer(ILClone(m_pendingLoad->pidlDirectory.get()));
+	}
+
+	return PIDLPointer(m_shellBrowser->QueryCurrentDirectoryIdl());
+}
+
+FolderSettings Tab::GetFolderSettings() const
+{
+	if (m_pendingLoad)
+	{
+		return m_pendingLoad->folderSettings;
+	}
+
+	return m_shellBrowser->GetFolderSettings();
+}
+
+FolderColumns Tab::GetFolderColumns() const
+{
+	if (m_pendingLoad)
+	{
+		return m_pendingLoad->folderColumns;
+	}
+
+	return m_shellBrowser->ExportAllColumns();
+}
+
 // If a custom name has been set, that will be returned. Otherwise, the
 // display name of the current directory will be returned.
 std::wstring Tab::GetName() const
@@ -40,7 +111,7 @@ std::wstring Tab::GetName() const
 		return m_customName;
 	}
 
-	PIDLPointer pidlDirectory(m_shellBrowser->QueryCurrentDirectoryIdl());
+	PIDLPointer pidlDirectory = GetDirectory();
 
 	TCHAR name[MAX_PATH];
 	HRESULT hr = GetDisplayName(pidlDirectory.get(), name, SIZEOF_ARRAY(name), SHGDN_INFOLDER);
@@ -6,9 +6,12 @@
 
 #include "ShellBrowser/iShellView.h"
 #include "../Helper/Macros.h"
+#include "../Helper/PIDLWrapper.h"
 #include <boost/optional.hpp>
 #include <boost/parameter.hpp>
 #include <boost/signals2.hpp>
+#include <functional>
+#include <memory>
 
 BOOST_PARAMETER_NAME(name)
 BOOST_PARAMETER_NAME(index)
@@ -69,6 +72,15 @@ public:
 
 	typedef boost::signals2::signal<void(const Tab &tab, PropertyType propertyType)> TabUpdatedSignal;
 
+	// Holds everything needed to create the listview and shell browser
+	// for a tab that hasn't been loaded yet.
+	struct PendingLoad
+	{
+		PIDLPointer pidlDirectory;
+		FolderSettings folderSettings;
+		FolderColumns folderColumns;
+	};
+
 	explicit Tab(int id);
 
 	int GetId() const;
@@ -76,6 +88,15 @@ public:
 	CShellBrowser *GetShellBrowser() const;
 	void SetShellBrowser(CShellBrowser *shellBrowser);
 
+	bool IsLoaded() const;
+	void SetPendingLoad(std::unique_ptr<PendingLoad> pendingLoad, std::function<void()> loadCallback);
+	const PendingLoad *GetPendingLoad() const;
+	std::unique_ptr<PendingLoad> ReleasePendingLoad();
+
+	PIDLPointer GetDirectory() const;
+	FolderSettings GetFolderSettings() const;
+	FolderColumns GetFolderColumns() const;
+
 	std::wstring GetName() const;
 	bool GetUseCustomName() const;
 	void SetCustomName(const std::wstring &name);
@@ -103,6 +124,8 @@ private:
 
 	const int m_id;
 	CShellBrowser *m_shellBrowser;
+	std::unique_ptr<PendingLoad> m_pendingLoad;
+	std::function<void()> m_loadCallback;
 	bool m_useCustomName;
 	std::wstring m_customName;
 	bool m_locked;
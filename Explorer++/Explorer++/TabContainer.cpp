@@ -15,6 +15,7 @@
 #include "TabDropHandler.h"
 #include "../Helper/Controls.h"
 #include "../Helper/iDirectoryMonitor.h"
+#include "../Helper/Logging.h"
 #include "../Helper/MenuHelper.h"
 #include "../Helper/MenuWrapper.h"
 #include "../Helper/ShellHelper.h"
@@ -22,6 +23,7 @@
 #include "../Helper/WindowHelper.h"
 #include <boost/algorithm/string.hpp>
 #include <boost/range/adaptor/map.hpp>
+#include <chrono>
 
 const UINT TAB_CONTROL_STYLES = WS_VISIBLE | WS_CHILD | TCS_FOCUSNEVER | TCS_SINGLELINE
 | TCS_TOOLTIPS | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
@@ -44,7 +46,6 @@ TabContainer::TabContainer(HWND parent, TabContainerInterface *tabContainer, Tab
 	m_hTabFont(nullptr),
 	m_hTabCtrlImageList(nullptr),
 	m_tabIdCounter(1),
-	m_cachedIcons(MAX_CACHED_ICONS),
 	m_tabContainerInterface(tabContainer),
 	m_tabInterface(tabInterface),
 	m_navigation(navigation),
@@ -458,24 +459,29 @@ void TabContainer::ProcessTabCommand(UINT uMenuID, Tab &tab)
 
 void TabContainer::OnOpenParentInNewTab(const Tab &tab)
 {
-	LPITEMIDLIST pidlCurrent = tab.GetShellBrowser()->QueryCurrentDirectoryIdl();
+	PIDLPointer pidlCurrent = tab.GetDirectory();
 
 	LPITEMIDLIST pidlParent = NULL;
-	HRESULT hr = GetVirtualParentPath(pidlCurrent, &pidlParent);
+	HRESULT hr = GetVirtualParentPath(pidlCurrent.get(), &pidlParent);
 
 	if (SUCCEEDED(hr))
 	{
 		CreateNewTab(pidlParent, TabSettings(_selected = true));
 		CoTaskMemFree(pidlParent);
 	}
-
-	CoTaskMemFree(pidlCurrent);
 }
 
 void TabContainer::OnRefreshAllTabs()
 {
 	for (auto &tab : GetAllTabs() | boost::adaptors::map_values)
 	{
+		/* Tabs that haven't been loaded will be enumerated
+		when they're first selected anyway. */
+		if (!tab.IsLoaded())
+		{
+			continue;
+		}
+
 		m_tabInterface->RefreshTab(tab);
 	}
 }
@@ -564,8 +570,16 @@ LRESULT CALLBACK TabContainer::ParentWndProc(HWND hwnd, UINT uMsg, WPARAM wParam
 			break;
 
 		case TCN_SELCHANGE:
-			tabSelectedSignal.m_signal(GetSelectedTab());
-			break;
+		{
+			Tab &selectedTab = GetSelectedTab();
+			HRESULT hr = LoadTab(selectedTab);
+
+			if (SUCCEEDED(hr))
+			{
+				tabSelectedSignal.m_signal(selectedTab);
+			}
+		}
+		break;
 		}
 		break;
 	}
@@ -586,7 +600,7 @@ void TabContainer::OnGetDispInfo(NMTTDISPINFO *dispInfo)
 
 	const Tab &tab = GetTabByIndex(static_cast<int>(dispInfo->hdr.idFrom));
 
-	PIDLPointer pidlDirectory(tab.GetShellBrowser()->QueryCurrentDirectoryIdl());
+	PIDLPointer pidlDirectory = tab.GetDirectory();
 	auto path = GetFolderPathForDisplay(pidlDirectory.get());
 
 	if (!path)
@@ -706,7 +720,7 @@ void TabContainer::SetTabIcon(const Tab &tab)
 	}
 	else
 	{
-		PIDLPointer pidlDirectory(tab.GetShellBrowser()->QueryCurrentDirectoryIdl());
+		PIDLPointer pidlDirectory = tab.GetDirectory();
 
 		SHGetFileInfo((LPCTSTR)pidlDirectory.get(), 0, &shfi, sizeof(shfi),
 			SHGFI_PIDL | SHGFI_ICON | SHGFI_SMALLICON);
@@ -800,13 +814,6 @@ HRESULT TabContainer::CreateNewTab(LPCITEMIDLIST pidlDirectory,
 		tab.SetCustomName(*tabSettings.name);
 	}
 
-	tab.listView = m_expp->CreateMainListView(m_expp->GetMainWindow());
-
-	if (tab.listView == NULL)
-	{
-		return E_FAIL;
-	}
-
 	FolderSettings folderSettingsFinal;
 
 	if (folderSettings)
@@ -818,9 +825,44 @@ HRESULT TabContainer::CreateNewTab(LPCITEMIDLIST pidlDirectory,
 		folderSettingsFinal = GetDefaultFolderSettings(pidlDirectory);
 	}
 
-	tab.SetShellBrowser(CShellBrowser::CreateNew(tab.GetId(), m_instance,
-		m_expp->GetMainWindow(), tab.listView, &m_cachedIcons, m_config,
-		folderSettingsFinal, initialColumns));
+	bool selected = false;
+
+	if (tabSettings.selected)
+	{
+		selected = *tabSettings.selected;
+	}
+
+	/* The tab control will select the first tab that's
+	inserted, so that tab always needs to be loaded. */
+	if (GetNumTabs() == 1)
+	{
+		selected = true;
+	}
+
+	/* When tabs are loaded on demand, creating the listview and
+	shell browser (and enumerating the directory) is deferred
+	until the tab is first selected. */
+	bool loadNow = selected || !m_config->loadTabsOnDemand;
+
+	if (loadNow)
+	{
+		if (!CreateTabView(tab, folderSettingsFinal, initialColumns))
+		{
+			return E_FAIL;
+		}
+	}
+	else
+	{
+		auto pendingLoad = std::make_unique<Tab::PendingLoad>();
+		pendingLoad->pidlDirectory.reset(ILClone(pidlDirectory));
+		pendingLoad->folderSettings = folderSettingsFinal;
+		pendingLoad->folderColumns = initialColumns ? *initialColumns : m_config->globalFolderSettings.folderColumns;
+
+		int tabId = tab.GetId();
+		tab.SetPendingLoad(std::move(pendingLoad), [this, tabId] {
+			LoadTab(GetTab(tabId));
+		});
+	}
 
 	int index;
 
@@ -852,20 +894,22 @@ HRESULT TabContainer::CreateNewTab(LPCITEMIDLIST pidlDirectory,
 	the folder). */
 	InsertNewTab(index, tab.GetId(), pidlDirectory, tabSettings.name);
 
-	bool selected = false;
-
-	if (tabSettings.selected)
+	if (loadNow)
 	{
-		selected = *tabSettings.selected;
-	}
-
-	HRESULT hr = tab.GetShellBrowser()->BrowseFolder(pidlDirectory, SBSP_ABSOLUTE);
+		HRESULT hr = tab.GetShellBrowser()->BrowseFolder(pidlDirectory, SBSP_ABSOLUTE);
 
-	if (hr != S_OK)
+		if (hr != S_OK)
+		{
+			/* Folder was not browsed. Likely that the path does not exist
+			(or is locked, cannot be found, etc). */
+			return E_FAIL;
+		}
+	}
+	else
 	{
-		/* Folder was not browsed. Likely that the path does not exist
-		(or is locked, cannot be found, etc). */
-		return E_FAIL;
+		/* The icon is normally set once navigation has completed,
+		which won't happen until the tab is loaded. */
+		SetTabIcon(tab);
 	}
 
 	if (selected)
@@ -896,6 +940,86 @@ HRESULT TabContainer::CreateNewTab(LPCITEMIDLIST pidlDirectory,
 	return S_OK;
 }
 
+bool TabContainer::CreateTabView(Tab &tab, const FolderSettings &folderSettings,
+	boost::optional<FolderColumns> initialColumns)
+{
+	tab.listView = m_expp->CreateMainListView(m_expp->GetMainWindow());
+
+	if (tab.listView == NULL)
+	{
+		return false;
+	}
+
+	tab.SetShellBrowser(CShellBrowser::CreateNew(tab.GetId(), m_instance,
+		m_expp->GetMainWindow(), tab.listView, m_expp->GetIconCache(), m_expp->GetFolderSizeService(),
+		m_expp->GetThumbnailCache(), m_expp->GetMetadataCache(), m_expp->GetItemTaskScheduler(),
+		m_config, folderSettings, initialColumns));
+
+	return true;
+}
+
+/* Sets up a tab that was created without a listview or shell
+browser. Does nothing if the tab has already been loaded. If the
+listview can't be created, the tab is left unloaded (so that loading
+it can be tried again later). */
+HRESULT TabContainer::LoadTab(Tab &tab)
+{
+	if (tab.IsLoaded())
+	{
+		return S_OK;
+	}
+
+	// Creating the listview sends messages to the main window, which
+	// may in turn attempt to access (and therefore load) the tab.
+	if (m_loadingTabIds.count(tab.GetId()) > 0)
+	{
+		return E_PENDING;
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	m_loadingTabIds.insert(tab.GetId());
+
+	const Tab::PendingLoad *pendingLoad = tab.GetPendingLoad();
+	bool viewCreated = CreateTabView(tab, pendingLoad->folderSettings, pendingLoad->folderColumns);
+
+	m_loadingTabIds.erase(tab.GetId());
+
+	if (!viewCreated)
+	{
+		LOG(warning) << _T("Unable to create the view for tab ") << tab.GetId();
+		return E_FAIL;
+	}
+
+	// The tab now has a shell browser, so its accessors no longer
+	// need the pending load.
+	auto releasedLoad = tab.ReleasePendingLoad();
+
+	HRESULT hr = tab.GetShellBrowser()->BrowseFolder(releasedLoad->pidlDirectory.get(), SBSP_ABSOLUTE);
+
+	if (hr != S_OK)
+	{
+		/* The folder may have been removed (or may be on a share
+		that's no longer available) since the tab was created. */
+		LPITEMIDLIST pidlDefault = NULL;
+		hr = GetIdlFromParsingName(m_config->defaultTabDirectoryStatic.c_str(), &pidlDefault);
+
+		if (SUCCEEDED(hr))
+		{
+			tab.GetShellBrowser()->BrowseFolder(pidlDefault, SBSP_ABSOLUTE);
+			CoTaskMemFree(pidlDefault);
+		}
+	}
+
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - startTime);
+	LOG(debug) << _T("Loaded tab ") << tab.GetId() << _T(" in ") << duration.count() << _T(" ms");
+
+	tabLoadedSignal.m_signal(tab);
+
+	return S_OK;
+}
+
 FolderSettings TabContainer::GetDefaultFolderSettings(LPCITEMIDLIST pidlDirectory) const
 {
 	FolderSettings folderSettings = m_config->defaultFolderSettings;
@@ -1000,11 +1124,14 @@ bool TabContainer::CloseTab(const Tab &tab)
 
 	RemoveTabFromControl(tab);
 
-	m_expp->GetDirectoryMonitor()->StopDirectoryMonitor(tab.GetShellBrowser()->GetDirMonitorId());
+	if (tab.IsLoaded())
+	{
+		m_expp->GetDirectoryMonitor()->StopDirectoryMonitor(tab.GetShellBrowser()->GetDirMonitorId());
 
-	tab.GetShellBrowser()->Release();
+		tab.GetShellBrowser()->Release();
 
-	DestroyWindow(tab.listView);
+		DestroyWindow(tab.listView);
+	}
 
 	// This is needed, as the erase() call below will remove the element
 	// from the tabs container (which will invalidate the reference
@@ -1129,7 +1256,15 @@ void TabContainer::SelectTabAtIndex(int index)
 		return;
 	}
 
-	tabSelectedSignal.m_signal(GetTabByIndex(index));
+	Tab &tab = GetTabByIndex(index);
+	HRESULT hr = LoadTab(tab);
+
+	if (FAILED(hr))
+	{
+		return;
+	}
+
+	tabSelectedSignal.m_signal(tab);
 }
 
 Tab &TabContainer::GetSelectedTab()
@@ -1241,8 +1376,6 @@ std::vector<std::reference_wrapper<const Tab>> TabContainer::GetAllTabsInOrder()
 
 void TabContainer::DuplicateTab(const Tab &tab)
 {
-	TCHAR szTabDirectory[MAX_PATH];
-	tab.GetShellBrowser()->QueryCurrentDirectory(SIZEOF_ARRAY(szTabDirectory), szTabDirectory);
-
-	CreateNewTab(szTabDirectory);
+	PIDLPointer pidlDirectory = tab.GetDirectory();
+	CreateNewTab(pidlDirectory.get());
 }
\ No newline at end of file
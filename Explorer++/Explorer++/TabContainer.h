@@ -5,7 +5,6 @@
 #pragma once
 
 #include "CoreInterface.h"
-#include "ShellBrowser/CachedIcons.h"
 #include "ShellBrowser/iShellView.h"
 #include "SignalWrapper.h"
 #include "Tab.h"
@@ -16,6 +15,7 @@
 #include <boost/signals2.hpp>
 #include <functional>
 #include <unordered_map>
+#include <unordered_set>
 
 struct Config;
 class Navigation;
@@ -62,6 +62,10 @@ public:
 	SignalWrapper<TabContainer, void(const Tab &tab)> tabSelectedSignal;
 	SignalWrapper<TabContainer, void(int tabId)> tabRemovedSignal;
 
+	// Fired once the listview and shell browser for a tab that was created
+	// on demand have been set up.
+	SignalWrapper<TabContainer, void(const Tab &tab)> tabLoadedSignal;
+
 private:
 
 	static const UINT_PTR SUBCLASS_ID = 0;
@@ -69,10 +73,6 @@ private:
 
 	static const int TAB_ICON_LOCK_INDEX = 0;
 
-	// Represents the maximum number of icons that can be cached across
-	// all tabs (as the icon cache is shared between tabs).
-	static const int MAX_CACHED_ICONS = 1000;
-
 	TabContainer(HWND parent, TabContainerInterface *tabContainer, TabInterface *tabInterface,
 		Navigation *navigation, IExplorerplusplus *expp, HINSTANCE instance,
 		std::shared_ptr<Config> config);
@@ -125,6 +125,8 @@ private:
 	void SetTabIcon(const Tab &tab);
 
 	SortMode GetDefaultSortMode(LPCITEMIDLIST pidlDirectory) const;
+	bool CreateTabView(Tab &tab, const FolderSettings &folderSettings, boost::optional<FolderColumns> initialColumns);
+	HRESULT LoadTab(Tab &tab);
 	void InsertNewTab(int index, int tabId, LPCITEMIDLIST pidlDirectory, boost::optional<std::wstring> customName);
 
 	void RemoveTabFromControl(const Tab &tab);
@@ -134,7 +136,9 @@ private:
 
 	std::unordered_map<int, Tab> m_tabs;
 	int m_tabIdCounter;
-	CachedIcons m_cachedIcons;
+
+	// The IDs of the tabs that are in the middle of being loaded.
+	std::unordered_set<int> m_loadingTabIds;
 
 	TabContainerInterface *m_tabContainerInterface;
 	TabInterface *m_tabInterface;
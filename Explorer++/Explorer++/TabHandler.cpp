@@ -168,6 +168,13 @@ HRESULT Explorerplusplus::RestoreTabs(ILoadSave *pLoadSave)
 	states. */
 	for (auto &tab : m_tabContainer->GetAllTabs() | boost::adaptors::map_values)
 	{
+		/* Tabs that haven't been loaded will start monitoring
+		once they've navigated to their directory. */
+		if (!tab.IsLoaded())
+		{
+			continue;
+		}
+
 		HandleDirectoryMonitoring(tab.GetId());
 	}
 
@@ -202,6 +209,10 @@ void Explorerplusplus::OnTabSelected(const Tab &tab)
 	m_hActiveListView = tab.listView;
 	m_pActiveShellBrowser = tab.GetShellBrowser();
 
+	/* The items in the selected tab are the only ones that can
+	currently be seen, so their tasks are run first. */
+	m_itemTaskScheduler->SetPriorityOwner(tab.GetId());
+
 	/* The selected tab has changed, so update the current
 	directory. Although this is not needed internally, context
 	menu extensions may need the current directory to be
@@ -10,6 +10,7 @@
 #include "Tab.h"
 #include "TabContainer.h"
 #include "TabInterface.h"
+#include "../Helper/ShellHelper.h"
 #include "../Helper/StringHelper.h"
 #include "../ThirdParty/Sol/sol.hpp"
 
@@ -27,14 +28,14 @@ namespace Plugins
 			bool showHidden;
 			bool autoArrange;
 
-			FolderSettings(const CShellBrowser &shellBrowser)
+			FolderSettings(const ::FolderSettings &folderSettings)
 			{
-				sortMode = shellBrowser.GetSortMode();
-				viewMode = shellBrowser.GetViewMode();
-				sortAscending = shellBrowser.GetSortAscending();
-				showInGroups = shellBrowser.GetShowInGroups();
-				showHidden = shellBrowser.GetShowHidden();
-				autoArrange = shellBrowser.GetAutoArrange();
+				sortMode = folderSettings.sortMode;
+				viewMode = folderSettings.viewMode;
+				sortAscending = folderSettings.sortAscending;
+				showInGroups = folderSettings.showInGroups;
+				showHidden = folderSettings.showHidden;
+				autoArrange = folderSettings.autoArrange;
 			}
 
 			std::wstring toString()
@@ -59,10 +60,14 @@ namespace Plugins
 			FolderSettings folderSettings;
 
 			Tab(const ::Tab &tabInternal) :
-				folderSettings(*tabInternal.GetShellBrowser())
+				folderSettings(tabInternal.GetFolderSettings())
 			{
+				// This is read through the tab, so that tabs that haven't
+				// been loaded yet don't need to be loaded here.
+				PIDLPointer pidlDirectory = tabInternal.GetDirectory();
+
 				TCHAR path[MAX_PATH];
-				tabInternal.GetShellBrowser()->QueryCurrentDirectory(SIZEOF_ARRAY(path), path);
+				GetDisplayName(pidlDirectory.get(), path, SIZEOF_ARRAY(path), SHGDN_FORPARSING);
 
 				id = tabInternal.GetId();
 				location = path;
@@ -362,8 +362,9 @@ LRESULT CALLBACK TaskbarThumbnails::TabProxyWndProc(HWND hwnd,UINT Msg,WPARAM wP
 
 			/* If the main window is minimized, it won't be possible
 			to generate a thumbnail for any of the tabs. In that
-			case, use a static 'No Preview Available' bitmap. */
-			if(IsIconic(m_expp->GetMainWindow()))
+			case, use a static 'No Preview Available' bitmap. The
+			same applies to tabs that haven't been loaded yet. */
+			if(IsIconic(m_expp->GetMainWindow()) || !m_tabContainer->GetTab(iTabId).IsLoaded())
 			{
 				hbmTab.reset(static_cast<HBITMAP>(LoadImage(GetModuleHandle(0),MAKEINTRESOURCE(IDB_NOPREVIEWAVAILABLE),IMAGE_BITMAP,0,0,0)));
 
@@ -437,7 +438,7 @@ LRESULT CALLBACK TaskbarThumbnails::TabProxyWndProc(HWND hwnd,UINT Msg,WPARAM wP
 
 	case WM_DWMSENDICONICLIVEPREVIEWBITMAP:
 		{
-			if(IsIconic(m_expp->GetMainWindow()))
+			if(IsIconic(m_expp->GetMainWindow()) || !m_tabContainer->GetTab(iTabId).IsLoaded())
 			{
 				/* TODO: Show an image here... */
 			}
@@ -669,7 +670,7 @@ void TaskbarThumbnails::SetTabProxyIcon(const Tab &tab)
 	{
 		if (tabProxyInfo.iTabId == tab.GetId())
 		{
-			PIDLPointer pidlDirectory(tab.GetShellBrowser()->QueryCurrentDirectoryIdl());
+			PIDLPointer pidlDirectory = tab.GetDirectory();
 
 			/* TODO: The proxy icon may also be the lock icon, if
 			the tab is locked. */
@@ -11,6 +11,7 @@ UiTheming::UiTheming(IExplorerplusplus *expp, TabContainer *tabContainer) :
 	m_customListViewColorsApplied(false)
 {
 	m_connections.push_back(m_tabContainer->tabCreatedSignal.AddObserver(boost::bind(&UiTheming::OnTabCreated, this, _1, _2)));
+	m_connections.push_back(m_tabContainer->tabLoadedSignal.AddObserver(boost::bind(&UiTheming::OnTabLoaded, this, _1)));
 }
 
 UiTheming::~UiTheming()
@@ -24,6 +25,21 @@ void UiTheming::OnTabCreated(int tabId, BOOL switchToNewTab)
 
 	const Tab &tab = m_tabContainer->GetTab(tabId);
 
+	/* The colors will be applied once the tab has been
+	loaded. */
+	if (!tab.IsLoaded())
+	{
+		return;
+	}
+
+	if (m_customListViewColorsApplied)
+	{
+		ApplyListViewColorsForTab(tab, m_listViewBackgroundColor, m_listViewTextColor);
+	}
+}
+
+void UiTheming::OnTabLoaded(const Tab &tab)
+{
 	if (m_customListViewColorsApplied)
 	{
 		ApplyListViewColorsForTab(tab, m_listViewBackgroundColor, m_listViewTextColor);
@@ -47,6 +63,11 @@ bool UiTheming::ApplyListViewColorsForAllTabs(COLORREF backgroundColor, COLORREF
 
 	for (const auto &item : m_tabContainer->GetAllTabs())
 	{
+		if (!item.second.IsLoaded())
+		{
+			continue;
+		}
+
 		bool res = ApplyListViewColorsForTab(item.second, backgroundColor, textColor);
 
 		if (!res)
@@ -22,6 +22,7 @@ public:
 private:
 
 	void OnTabCreated(int tabId, BOOL switchToNewTab);
+	void OnTabLoaded(const Tab &tab);
 
 	bool ApplyListViewColorsForAllTabs(COLORREF backgroundColor, COLORREF textColor);
 	bool ApplyListViewColorsForTab(const Tab &tab, COLORREF backgroundColor, COLORREF textColor);
@@ -12,6 +12,7 @@
 #include "../Helper/ListViewHelper.h"
 #include "../Helper/Macros.h"
 #include "../Helper/RegistrySettings.h"
+#include "../Helper/WildcardMatcher.h"
 #include "../Helper/XMLSettings.h"
 
 const TCHAR CWildcardSelectDialogPersistentSettings::SETTINGS_KEY[] = _T("WildcardSelect");
@@ -150,12 +151,14 @@ void CWildcardSelectDialog::SelectItems(TCHAR *szPattern)
 
 	int nItems = ListView_GetItemCount(hListView);
 
+	WildcardMatcher wildcardMatcher(szPattern, false);
+
 	for(int i = 0;i < nItems;i++)
 	{
 		TCHAR szFilename[MAX_PATH];
 		m_pexpp->GetActiveShellBrowser()->QueryDisplayName(i,SIZEOF_ARRAY(szFilename),szFilename);
 
-		if(CheckWildcardMatch(szPattern,szFilename,FALSE) == 1)
+		if(wildcardMatcher.Matches(szFilename))
 		{
 			NListView::ListView_SelectItem(hListView,i,m_bSelect);
 		}
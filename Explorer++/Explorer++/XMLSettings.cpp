@@ -24,6 +24,7 @@
 #include "../DisplayWindow/DisplayWindow.h"
 #include "../Helper/Macros.h"
 #include "../Helper/ProcessHelper.h"
+#include "../Helper/ShellHelper.h"
 #include "../Helper/XMLSettings.h"
 #include <boost/range/adaptor/map.hpp>
 #include <MsXml2.h>
@@ -107,6 +108,10 @@ will need to be changed correspondingly. */
 #define HASH_OVERWRITEEXISTINGFILESCONFIRMATION	1625342835
 #define HASH_LARGETOOLBARICONS		10895007
 #define HASH_PLAYNAVIGATIONSOUND	1987363412
+#define HASH_PARALLELSORTTHRESHOLD	654675431
+#define HASH_VIRTUALLISTVIEW		2982620611
+#define HASH_LOADTABSONDEMAND		3083155189
+#define HASH_THUMBNAILCACHESIZE		3178542232
 
 struct ColumnXMLSaveData
 {
@@ -521,6 +526,8 @@ IXMLDOMElement *pRoot)
 	NXMLSettings::AddWhiteSpaceToNode(pXMLDom,bstr_wsntt,pe);
 	NXMLSettings::WriteStandardSetting(pXMLDom,pe,_T("Setting"),_T("OverwriteExistingFilesConfirmation"),NXMLSettings::EncodeBoolValue(m_config->overwriteExistingFilesConfirmation));
 	NXMLSettings::AddWhiteSpaceToNode(pXMLDom,bstr_wsntt,pe);
+	NXMLSettings::WriteStandardSetting(pXMLDom,pe,_T("Setting"),_T("ParallelSortThreshold"),NXMLSettings::EncodeIntValue(m_config->globalFolderSettings.parallelSortThreshold));
+	NXMLSettings::AddWhiteSpaceToNode(pXMLDom,bstr_wsntt,pe);
 	NXMLSettings::WriteStandardSetting(pXMLDom,pe,_T("Setting"),_T("PlayNavigationSound"),NXMLSettings::EncodeBoolValue(m_config->playNavigationSound));
 
 	NXMLSettings::AddWhiteSpaceToNode(pXMLDom,bstr_wsntt,pe);
@@ -630,6 +637,12 @@ IXMLDOMElement *pRoot)
 	NXMLSettings::AddWhiteSpaceToNode(pXMLDom,bstr_wsntt,pe);
 	_itow_s(m_config->defaultFolderSettings.viewMode,szValue,SIZEOF_ARRAY(szValue),10);
 	NXMLSettings::WriteStandardSetting(pXMLDom,pe,_T("Setting"),_T("ViewModeGlobal"),szValue);
+	NXMLSettings::AddWhiteSpaceToNode(pXMLDom,bstr_wsntt,pe);
+	NXMLSettings::WriteStandardSetting(pXMLDom,pe,_T("Setting"),_T("VirtualListView"),NXMLSettings::EncodeBoolValue(m_config->globalFolderSettings.virtualListView));
+	NXMLSettings::AddWhiteSpaceToNode(pXMLDom,bstr_wsntt,pe);
+	NXMLSettings::WriteStandardSetting(pXMLDom,pe,_T("Setting"),_T("LoadTabsOnDemand"),NXMLSettings::EncodeBoolValue(m_config->loadTabsOnDemand));
+	NXMLSettings::AddWhiteSpaceToNode(pXMLDom,bstr_wsntt,pe);
+	NXMLSettings::WriteStandardSetting(pXMLDom,pe,_T("Setting"),_T("ThumbnailCacheSize"),NXMLSettings::EncodeIntValue(m_config->thumbnailCacheSize));
 
 	NXMLSettings::AddWhiteSpaceToNode(pXMLDom,bstr_wsnt,pe);
 
@@ -691,7 +704,9 @@ int Explorerplusplus::LoadTabSettingsFromXML(IXMLDOMDocument *pXMLDom)
 
 				if(SUCCEEDED(hr))
 				{
-					tabSettings.selected = true;
+					/* When tabs are loaded on demand, only the tab that's
+					eventually selected will be loaded. */
+					tabSettings.selected = !m_config->loadTabsOnDemand;
 
 					/* Retrieve the total number of attributes
 					attached to this node. */
@@ -848,36 +863,38 @@ void Explorerplusplus::SaveTabSettingsToXMLnternal(IXMLDOMDocument *pXMLDom,IXML
 		StringCchPrintf(szNodeName, SIZEOF_ARRAY(szNodeName), _T("%d"), tabNum);
 		NXMLSettings::CreateElementNode(pXMLDom,&pParentNode,pe,_T("Tab"),szNodeName);
 
-		tab.GetShellBrowser()->QueryCurrentDirectory(SIZEOF_ARRAY(szTabDirectory), szTabDirectory);
+		/* Tabs that haven't been loaded yet don't have a shell
+		browser, so everything here is retrieved through the tab. */
+		PIDLPointer pidlDirectory = tab.GetDirectory();
+		GetDisplayName(pidlDirectory.get(), szTabDirectory, SIZEOF_ARRAY(szTabDirectory), SHGDN_FORPARSING);
 		NXMLSettings::AddAttributeToNode(pXMLDom,pParentNode,_T("Directory"),szTabDirectory);
 
+		FolderSettings folderSettings = tab.GetFolderSettings();
+
 		NXMLSettings::AddAttributeToNode(pXMLDom,pParentNode,_T("ApplyFilter"),
-			NXMLSettings::EncodeBoolValue(tab.GetShellBrowser()->GetFilterStatus()));
+			NXMLSettings::EncodeBoolValue(folderSettings.applyFilter));
 
 		NXMLSettings::AddAttributeToNode(pXMLDom,pParentNode,_T("AutoArrange"),
-			NXMLSettings::EncodeBoolValue(tab.GetShellBrowser()->GetAutoArrange()));
-
-		TCHAR szFilter[512];
+			NXMLSettings::EncodeBoolValue(folderSettings.autoArrange));
 
-		tab.GetShellBrowser()->GetFilter(szFilter,SIZEOF_ARRAY(szFilter));
-		NXMLSettings::AddAttributeToNode(pXMLDom,pParentNode,_T("Filter"),szFilter);
+		NXMLSettings::AddAttributeToNode(pXMLDom,pParentNode,_T("Filter"),folderSettings.filter.c_str());
 
 		NXMLSettings::AddAttributeToNode(pXMLDom,pParentNode,_T("FilterCaseSensitive"),
-			NXMLSettings::EncodeBoolValue(tab.GetShellBrowser()->GetFilterCaseSensitive()));
+			NXMLSettings::EncodeBoolValue(folderSettings.filterCaseSensitive));
 
 		NXMLSettings::AddAttributeToNode(pXMLDom,pParentNode,_T("ShowHidden"),
-			NXMLSettings::EncodeBoolValue(tab.GetShellBrowser()->GetShowHidden()));
+			NXMLSettings::EncodeBoolValue(folderSettings.showHidden));
 
 		NXMLSettings::AddAttributeToNode(pXMLDom,pParentNode,_T("ShowInGroups"),
-			NXMLSettings::EncodeBoolValue(tab.GetShellBrowser()->GetShowInGroups()));
+			NXMLSettings::EncodeBoolValue(folderSettings.showInGroups));
 
 		NXMLSettings::AddAttributeToNode(pXMLDom,pParentNode,_T("SortAscending"),
-			NXMLSettings::EncodeBoolValue(tab.GetShellBrowser()->GetSortAscending()));
+			NXMLSettings::EncodeBoolValue(folderSettings.sortAscending));
 
-		SortMode = tab.GetShellBrowser()->GetSortMode();
+		SortMode = folderSettings.sortMode;
 		NXMLSettings::AddAttributeToNode(pXMLDom,pParentNode,_T("SortMode"),NXMLSettings::EncodeIntValue(SortMode));
 
-		ViewMode = tab.GetShellBrowser()->GetViewMode();
+		ViewMode = folderSettings.viewMode;
 		NXMLSettings::AddAttributeToNode(pXMLDom,pParentNode,_T("ViewMode"),NXMLSettings::EncodeIntValue(ViewMode));
 
 		bstr = SysAllocString(L"Columns");
@@ -885,7 +902,7 @@ void Explorerplusplus::SaveTabSettingsToXMLnternal(IXMLDOMDocument *pXMLDom,IXML
 		SysFreeString(bstr);
 		bstr = NULL;
 
-		auto folderColumns = tab.GetShellBrowser()->ExportAllColumns();
+		auto folderColumns = tab.GetFolderColumns();
 
 		int TAB_INDENT = 4;
 
@@ -1611,6 +1628,10 @@ WCHAR *wszName,WCHAR *wszValue)
 		m_config->overwriteExistingFilesConfirmation = NXMLSettings::DecodeBoolValue(wszValue);
 		break;
 
+	case HASH_PARALLELSORTTHRESHOLD:
+		m_config->globalFolderSettings.parallelSortThreshold = NXMLSettings::DecodeIntValue(wszValue);
+		break;
+
 	case HASH_PLAYNAVIGATIONSOUND:
 		m_config->playNavigationSound = NXMLSettings::DecodeBoolValue(wszValue);
 		break;
@@ -1819,6 +1840,18 @@ WCHAR *wszName,WCHAR *wszValue)
 		m_config->defaultFolderSettings.viewMode = ViewMode::_from_integral(NXMLSettings::DecodeIntValue(wszValue));
 		break;
 
+	case HASH_VIRTUALLISTVIEW:
+		m_config->globalFolderSettings.virtualListView = NXMLSettings::DecodeBoolValue(wszValue);
+		break;
+
+	case HASH_LOADTABSONDEMAND:
+		m_config->loadTabsOnDemand = NXMLSettings::DecodeBoolValue(wszValue);
+		break;
+
+	case HASH_THUMBNAILCACHESIZE:
+		m_config->thumbnailCacheSize = NXMLSettings::DecodeIntValue(wszValue);
+		break;
+
 	case HASH_POSITION:
 		{
 			IXMLDOMNode	*pChildNode = NULL;
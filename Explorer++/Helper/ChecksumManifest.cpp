@@ -0,0 +1,158 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ChecksumManifest.h"
+#include "StringHelper.h"
+#include <boost/filesystem/fstream.hpp>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+namespace
+{
+	const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+	bool ParseChecksum(const std::string &text, std::uint32_t &checksum)
+	{
+		if (text.size() != 8)
+		{
+			return false;
+		}
+
+		checksum = 0;
+
+		for (char c : text)
+		{
+			std::uint32_t value;
+
+			if (c >= '0' && c <= '9')
+			{
+				value = c - '0';
+			}
+			else if (c >= 'a' && c <= 'f')
+			{
+				value = c - 'a' + 10;
+			}
+			else if (c >= 'A' && c <= 'F')
+			{
+				value = c - 'A' + 10;
+			}
+			else
+			{
+				return false;
+			}
+
+			checksum = (checksum << 4) | value;
+		}
+
+		return true;
+	}
+}
+
+void WriteChecksumManifest(std::ostream &outputStream, const ChecksumManifest &manifest)
+{
+	for (const auto &entry : manifest)
+	{
+		char checksum[8];
+
+		for (int i = 0; i < 8; i++)
+		{
+			checksum[i] = HEX_DIGITS[(entry.checksum >> ((7 - i) * 4)) & 0xF];
+		}
+
+		outputStream << wstrToStr(entry.filename) << ' ';
+		outputStream.write(checksum, sizeof(checksum));
+		outputStream << "\r\n";
+	}
+}
+
+ChecksumManifest ReadChecksumManifest(std::istream &inputStream)
+{
+	ChecksumManifest manifest;
+	std::string line;
+
+	while (std::getline(inputStream, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+
+		if (line.empty() || line[0] == ';')
+		{
+			continue;
+		}
+
+		// Filenames can contain spaces, so the checksum is
+		// taken from the end of the line.
+		auto separator = line.find_last_of(' ');
+
+		if (separator == std::string::npos || separator == 0)
+		{
+			continue;
+		}
+
+		std::uint32_t checksum;
+
+		if (!ParseChecksum(line.substr(separator + 1), checksum))
+		{
+			continue;
+		}
+
+		std::wstring filename;
+
+		try
+		{
+			filename = strToWstr(line.substr(0, separator));
+		}
+		catch (const std::range_error &)
+		{
+			continue;
+		}
+
+		manifest.push_back({ filename, checksum });
+	}
+
+	return manifest;
+}
+
+bool SaveChecksumManifest(const std::wstring &path, const ChecksumManifest &manifest)
+{
+	boost::filesystem::ofstream outputStream(boost::filesystem::path(path), std::ios::binary | std::ios::trunc);
+
+	if (!outputStream)
+	{
+		return false;
+	}
+
+	WriteChecksumManifest(outputStream, manifest);
+
+	return static_cast<bool>(outputStream);
+}
+
+boost::optional<ChecksumManifest> LoadChecksumManifest(const std::wstring &path)
+{
+	boost::filesystem::ifstream inputStream(boost::filesystem::path(path), std::ios::binary);
+
+	if (!inputStream)
+	{
+		return boost::none;
+	}
+
+	return ReadChecksumManifest(inputStream);
+}
+
+boost::optional<std::uint32_t> FindChecksum(const ChecksumManifest &manifest, const std::wstring &filename)
+{
+	for (const auto &entry : manifest)
+	{
+		if (lstrcmpi(entry.filename.c_str(), filename.c_str()) == 0)
+		{
+			return entry.checksum;
+		}
+	}
+
+	return boost::none;
+}
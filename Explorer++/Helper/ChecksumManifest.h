@@ -0,0 +1,35 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/* A list of files and their CRC-32 checksums, stored in the
+Simple File Verification (.sfv) format. Each line holds a
+filename, followed by a space and the checksum as eight hex
+digits. Lines starting with a semicolon are comments. Files
+are written out as UTF-8. */
+struct ChecksumManifestEntry
+{
+	std::wstring filename;
+	std::uint32_t checksum;
+};
+
+typedef std::vector<ChecksumManifestEntry> ChecksumManifest;
+
+void WriteChecksumManifest(std::ostream &outputStream, const ChecksumManifest &manifest);
+
+/* Lines that can't be parsed are skipped. */
+ChecksumManifest ReadChecksumManifest(std::istream &inputStream);
+
+bool SaveChecksumManifest(const std::wstring &path, const ChecksumManifest &manifest);
+boost::optional<ChecksumManifest> LoadChecksumManifest(const std::wstring &path);
+
+/* Filenames are compared case-insensitively. */
+boost::optional<std::uint32_t> FindChecksum(const ChecksumManifest &manifest, const std::wstring &filename);
@@ -0,0 +1,342 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ChunkedFileCopier.h"
+#include <algorithm>
+#include <array>
+
+namespace
+{
+	typedef std::array<std::array<std::uint32_t, 256>, 8> Crc32Tables;
+
+	/* Builds the tables used to process eight bytes at a time
+	("slicing-by-8"). The first table is the standard byte-wise
+	table for the reflected polynomial. */
+	Crc32Tables BuildCrc32Tables()
+	{
+		Crc32Tables tables;
+
+		for (std::uint32_t i = 0; i < 256; i++)
+		{
+			std::uint32_t crc = i;
+
+			for (int j = 0; j < 8; j++)
+			{
+				crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+			}
+
+			tables[0][i] = crc;
+		}
+
+		for (std::uint32_t i = 0; i < 256; i++)
+		{
+			for (size_t j = 1; j < tables.size(); j++)
+			{
+				tables[j][i] = (tables[j - 1][i] >> 8) ^ tables[0][tables[j - 1][i] & 0xFF];
+			}
+		}
+
+		return tables;
+	}
+
+	DWORD GetChunkSize(DWORD bufferSize, std::uint64_t remaining)
+	{
+		return static_cast<DWORD>((std::min)<std::uint64_t>(bufferSize, remaining));
+	}
+
+	void SetOverlappedOffset(OVERLAPPED &overlapped, std::uint64_t offset, HANDLE event)
+	{
+		ZeroMemory(&overlapped, sizeof(overlapped));
+		overlapped.Offset = static_cast<DWORD>(offset);
+		overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+		overlapped.hEvent = event;
+	}
+}
+
+ChunkedFileCopier::Options::Options() :
+	computeChecksum(false),
+	verifyChecksum(false),
+	expectedChecksum(0)
+{
+
+}
+
+ChunkedFileCopier::ChunkedFileCopier(DWORD bufferSize) :
+	m_bufferSize(0),
+	m_buffers(),
+	m_readEvent(CreateEvent(NULL, TRUE, FALSE, NULL)),
+	m_writeEvent(CreateEvent(NULL, TRUE, FALSE, NULL))
+{
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+
+	DWORD pageSize = systemInfo.dwPageSize;
+	bufferSize = (std::max)<DWORD>(bufferSize, 1);
+	bufferSize = ((bufferSize + pageSize - 1) / pageSize) * pageSize;
+
+	for (auto &buffer : m_buffers)
+	{
+		buffer = VirtualAlloc(NULL, bufferSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+	}
+
+	if (IsValid())
+	{
+		m_bufferSize = bufferSize;
+	}
+}
+
+ChunkedFileCopier::~ChunkedFileCopier()
+{
+	for (auto buffer : m_buffers)
+	{
+		if (buffer != NULL)
+		{
+			VirtualFree(buffer, 0, MEM_RELEASE);
+		}
+	}
+
+	for (auto event : { m_readEvent, m_writeEvent })
+	{
+		if (event != NULL)
+		{
+			CloseHandle(event);
+		}
+	}
+}
+
+bool ChunkedFileCopier::IsValid() const
+{
+	return m_buffers[0] != NULL && m_buffers[1] != NULL
+		&& m_readEvent != NULL && m_writeEvent != NULL;
+}
+
+DWORD ChunkedFileCopier::GetBufferSize() const
+{
+	return m_bufferSize;
+}
+
+/* While chunk n is being written out of one buffer, chunk n + 1
+is read into the other. Both operations are waited on before the
+buffers are swapped, so at most one read and one write are ever
+in flight. */
+ChunkedFileCopier::Result ChunkedFileCopier::Copy(HANDLE inputFile, std::uint64_t inputOffset,
+	std::uint64_t length, HANDLE outputFile, std::uint64_t outputOffset, const Options &options,
+	ProgressCallback progressCallback)
+{
+	Result result = { Status::Succeeded, 0, 0, ERROR_SUCCESS };
+
+	if (!IsValid())
+	{
+		result.status = Status::ReadFailed;
+		result.error = ERROR_NOT_ENOUGH_MEMORY;
+		return result;
+	}
+
+	PendingIo readIo;
+	PendingIo writeIo;
+	int current = 0;
+	DWORD bytesRead = 0;
+	std::uint64_t readOffset = inputOffset;
+	std::uint64_t remaining = length;
+
+	if (remaining > 0)
+	{
+		StartRead(readIo, inputFile, m_buffers[current], GetChunkSize(m_bufferSize, remaining),
+			readOffset, m_readEvent);
+
+		if (!FinishIo(readIo, bytesRead, result.error))
+		{
+			result.status = Status::ReadFailed;
+			return result;
+		}
+
+		readOffset += bytesRead;
+		remaining -= bytesRead;
+	}
+
+	while (bytesRead > 0)
+	{
+		DWORD chunkSize = bytesRead;
+		StartWrite(writeIo, outputFile, m_buffers[current], chunkSize, outputOffset, m_writeEvent);
+
+		bool readNext = (remaining > 0);
+
+		if (readNext)
+		{
+			StartRead(readIo, inputFile, m_buffers[1 - current], GetChunkSize(m_bufferSize, remaining),
+				readOffset, m_readEvent);
+		}
+
+		// The buffer being written is only read from here, so
+		// the checksum can be computed while the write is in
+		// progress.
+		if (options.computeChecksum)
+		{
+			result.checksum = UpdateCrc32(result.checksum, m_buffers[current], chunkSize);
+		}
+
+		DWORD bytesWritten;
+
+		if (!FinishIo(writeIo, bytesWritten, result.error) || bytesWritten != chunkSize)
+		{
+			if (readNext)
+			{
+				AbandonIo(readIo);
+			}
+
+			result.status = Status::WriteFailed;
+
+			if (result.error == ERROR_SUCCESS)
+			{
+				result.error = ERROR_WRITE_FAULT;
+			}
+
+			return result;
+		}
+
+		outputOffset += chunkSize;
+		result.bytesCopied += chunkSize;
+		bytesRead = 0;
+
+		if (readNext)
+		{
+			if (!FinishIo(readIo, bytesRead, result.error))
+			{
+				result.status = Status::ReadFailed;
+				return result;
+			}
+
+			readOffset += bytesRead;
+			remaining -= bytesRead;
+		}
+
+		if (progressCallback && !progressCallback(result.bytesCopied))
+		{
+			result.status = Status::Cancelled;
+			return result;
+		}
+
+		current = 1 - current;
+	}
+
+	if (options.computeChecksum && options.verifyChecksum
+		&& result.checksum != options.expectedChecksum)
+	{
+		result.status = Status::ChecksumMismatch;
+	}
+
+	return result;
+}
+
+void ChunkedFileCopier::StartRead(PendingIo &io, HANDLE file, void *buffer, DWORD size,
+	std::uint64_t offset, HANDLE event)
+{
+	io.file = file;
+	io.startError = ERROR_SUCCESS;
+	SetOverlappedOffset(io.overlapped, offset, event);
+
+	if (!ReadFile(file, buffer, size, NULL, &io.overlapped))
+	{
+		DWORD error = GetLastError();
+
+		if (error != ERROR_IO_PENDING)
+		{
+			io.startError = error;
+		}
+	}
+}
+
+void ChunkedFileCopier::StartWrite(PendingIo &io, HANDLE file, const void *buffer, DWORD size,
+	std::uint64_t offset, HANDLE event)
+{
+	io.file = file;
+	io.startError = ERROR_SUCCESS;
+	SetOverlappedOffset(io.overlapped, offset, event);
+
+	if (!WriteFile(file, buffer, size, NULL, &io.overlapped))
+	{
+		DWORD error = GetLastError();
+
+		if (error != ERROR_IO_PENDING)
+		{
+			io.startError = error;
+		}
+	}
+}
+
+/* Waits for the operation to complete. Reaching the end of the
+file isn't treated as an error; zero bytes are returned
+instead. */
+bool ChunkedFileCopier::FinishIo(PendingIo &io, DWORD &bytesTransferred, DWORD &error)
+{
+	bytesTransferred = 0;
+	error = io.startError;
+
+	if (error == ERROR_SUCCESS
+		&& !GetOverlappedResult(io.file, &io.overlapped, &bytesTransferred, TRUE))
+	{
+		error = GetLastError();
+	}
+
+	if (error == ERROR_HANDLE_EOF)
+	{
+		bytesTransferred = 0;
+		error = ERROR_SUCCESS;
+	}
+
+	return error == ERROR_SUCCESS;
+}
+
+/* The operation has to finish before its buffer and OVERLAPPED
+structure can be reused. */
+void ChunkedFileCopier::AbandonIo(PendingIo &io)
+{
+	if (io.startError != ERROR_SUCCESS)
+	{
+		return;
+	}
+
+	CancelIoEx(io.file, &io.overlapped);
+
+	DWORD bytesTransferred;
+	GetOverlappedResult(io.file, &io.overlapped, &bytesTransferred, TRUE);
+}
+
+std::uint32_t ChunkedFileCopier::UpdateCrc32(std::uint32_t crc, const void *data, size_t size)
+{
+	static const Crc32Tables tables = BuildCrc32Tables();
+
+	auto bytes = static_cast<const unsigned char *>(data);
+	crc = ~crc;
+
+	while (size >= 8)
+	{
+		std::uint32_t low = crc ^ (static_cast<std::uint32_t>(bytes[0])
+			| (static_cast<std::uint32_t>(bytes[1]) << 8)
+			| (static_cast<std::uint32_t>(bytes[2]) << 16)
+			| (static_cast<std::uint32_t>(bytes[3]) << 24));
+		std::uint32_t high = static_cast<std::uint32_t>(bytes[4])
+			| (static_cast<std::uint32_t>(bytes[5]) << 8)
+			| (static_cast<std::uint32_t>(bytes[6]) << 16)
+			| (static_cast<std::uint32_t>(bytes[7]) << 24);
+
+		crc = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF]
+			^ tables[5][(low >> 16) & 0xFF] ^ tables[4][low >> 24]
+			^ tables[3][high & 0xFF] ^ tables[2][(high >> 8) & 0xFF]
+			^ tables[1][(high >> 16) & 0xFF] ^ tables[0][high >> 24];
+
+		bytes += 8;
+		size -= 8;
+	}
+
+	while (size > 0)
+	{
+		crc = (crc >> 8) ^ tables[0][(crc ^ *bytes) & 0xFF];
+		bytes++;
+		size--;
+	}
+
+	return ~crc;
+}
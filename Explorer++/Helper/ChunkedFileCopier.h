@@ -0,0 +1,117 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "Macros.h"
+#include <cstdint>
+#include <functional>
+
+/* Copies a range of bytes from one file to another, through a
+pair of fixed-size buffers. While one buffer is being written
+out, the next chunk is read into the other, so reading and
+writing overlap. The amount of memory used doesn't depend on
+the amount of data being copied.
+
+Reads and writes are issued at explicit offsets, so the same
+handles can be used for several copies (e.g. when appending a
+number of files to a single output file). The I/O only runs
+concurrently if the handles were opened with
+FILE_FLAG_OVERLAPPED; synchronous handles also work, with each
+operation simply completing before the next is issued.
+
+The buffers are allocated once, when the copier is created,
+and are page-aligned. A copier can be reused, but can only
+perform one copy at a time. */
+class ChunkedFileCopier
+{
+public:
+
+	static const DWORD DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+	enum class Status
+	{
+		Succeeded,
+		Cancelled,
+		ReadFailed,
+		WriteFailed,
+		ChecksumMismatch
+	};
+
+	struct Result
+	{
+		Status status;
+		std::uint64_t bytesCopied;
+
+		/* The CRC-32 of the bytes copied. Only set if a
+		checksum was requested. */
+		std::uint32_t checksum;
+
+		/* The Win32 error code, if a read or write failed. */
+		DWORD error;
+	};
+
+	struct Options
+	{
+		Options();
+
+		bool computeChecksum;
+
+		/* If set (along with computeChecksum), the copy
+		fails with ChecksumMismatch if the checksum of the
+		data read doesn't match. The data will still have
+		been written. */
+		bool verifyChecksum;
+		std::uint32_t expectedChecksum;
+	};
+
+	/* Called after each chunk has been written, with the
+	number of bytes copied so far. Returning false cancels
+	the copy. */
+	typedef std::function<bool(std::uint64_t bytesCopied)> ProgressCallback;
+
+	/* The buffer size is rounded up to a multiple of the
+	page size. */
+	explicit ChunkedFileCopier(DWORD bufferSize = DEFAULT_BUFFER_SIZE);
+	~ChunkedFileCopier();
+
+	/* Returns false if the buffers couldn't be allocated, in
+	which case no copies can be performed. */
+	bool IsValid() const;
+
+	DWORD GetBufferSize() const;
+
+	/* Copies up to length bytes. Copying stops early (without
+	error) if the end of the input file is reached. */
+	Result Copy(HANDLE inputFile, std::uint64_t inputOffset, std::uint64_t length,
+		HANDLE outputFile, std::uint64_t outputOffset, const Options &options,
+		ProgressCallback progressCallback);
+
+	/* Incrementally computes a (zlib-compatible) CRC-32. The
+	initial value should be 0. */
+	static std::uint32_t UpdateCrc32(std::uint32_t crc, const void *data, size_t size);
+
+private:
+
+	DISALLOW_COPY_AND_ASSIGN(ChunkedFileCopier);
+
+	struct PendingIo
+	{
+		HANDLE file;
+		OVERLAPPED overlapped;
+
+		/* Set if the operation couldn't be started. */
+		DWORD startError;
+	};
+
+	static void StartRead(PendingIo &io, HANDLE file, void *buffer, DWORD size, std::uint64_t offset, HANDLE event);
+	static void StartWrite(PendingIo &io, HANDLE file, const void *buffer, DWORD size, std::uint64_t offset, HANDLE event);
+	static bool FinishIo(PendingIo &io, DWORD &bytesTransferred, DWORD &error);
+	static void AbandonIo(PendingIo &io);
+
+	DWORD m_bufferSize;
+	void *m_buffers[2];
+	HANDLE m_readEvent;
+	HANDLE m_writeEvent;
+};
@@ -0,0 +1,156 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "DirectoryChangeJournal.h"
+
+DirectoryChangeJournal::DirectoryChangeJournal() :
+	m_rescanRequired(false)
+{
+
+}
+
+void DirectoryChangeJournal::AddChange(const std::wstring &fileName, DWORD action)
+{
+	/* There's no point tracking individual changes if
+	the whole directory is going to be rescanned. */
+	if (m_rescanRequired)
+	{
+		return;
+	}
+
+	if (action == FILE_ACTION_RENAMED_OLD_NAME || action == FILE_ACTION_RENAMED_NEW_NAME)
+	{
+		m_pendingChanges.push_back({ fileName,
+			(action == FILE_ACTION_RENAMED_OLD_NAME) ? PendingState::RenamedOldName : PendingState::RenamedNewName });
+
+		m_latestChanges.erase(fileName);
+		return;
+	}
+
+	auto itr = m_latestChanges.find(fileName);
+
+	if (itr != m_latestChanges.end() && MergeChange(*itr->second, action))
+	{
+		return;
+	}
+
+	PendingState state;
+
+	switch (action)
+	{
+	case FILE_ACTION_ADDED:
+		state = PendingState::Added;
+		break;
+
+	case FILE_ACTION_MODIFIED:
+		state = PendingState::Modified;
+		break;
+
+	case FILE_ACTION_REMOVED:
+		state = PendingState::Removed;
+		break;
+
+	default:
+		return;
+	}
+
+	m_pendingChanges.push_back({ fileName, state });
+	m_latestChanges[fileName] = std::prev(m_pendingChanges.end());
+}
+
+/* Attempts to fold the specified action into an existing
+change. Returns false if the action couldn't be merged.
+Renames are never passed in here. */
+bool DirectoryChangeJournal::MergeChange(PendingChange &pendingChange, DWORD action)
+{
+	switch (action)
+	{
+	case FILE_ACTION_ADDED:
+		if (pendingChange.state == PendingState::Modified || pendingChange.state == PendingState::Removed)
+		{
+			pendingChange.state = PendingState::Replaced;
+		}
+		return true;
+
+	/* Added items are read in full once they're processed,
+	so any subsequent modifications will be picked up then.
+	A modification following a removal is kept separate, so
+	that the two remain in order. */
+	case FILE_ACTION_MODIFIED:
+		return (pendingChange.state != PendingState::Removed);
+
+	/* Note that an item that's added and then removed still
+	results in a removal, since the item may already have been
+	shown (e.g. if it was created while the directory was being
+	enumerated). Removing an item that doesn't exist is
+	harmless. */
+	case FILE_ACTION_REMOVED:
+		pendingChange.state = PendingState::Removed;
+		return true;
+	}
+
+	return false;
+}
+
+void DirectoryChangeJournal::SetRescanRequired()
+{
+	m_pendingChanges.clear();
+	m_latestChanges.clear();
+	m_rescanRequired = true;
+}
+
+bool DirectoryChangeJournal::IsEmpty() const
+{
+	return m_pendingChanges.empty() && !m_rescanRequired;
+}
+
+void DirectoryChangeJournal::Clear()
+{
+	m_pendingChanges.clear();
+	m_latestChanges.clear();
+	m_rescanRequired = false;
+}
+
+DirectoryChangeSet DirectoryChangeJournal::TakeChanges()
+{
+	DirectoryChangeSet changeSet;
+	changeSet.rescanRequired = m_rescanRequired;
+	changeSet.changes.reserve(m_pendingChanges.size());
+
+	for (const auto &pendingChange : m_pendingChanges)
+	{
+		switch (pendingChange.state)
+		{
+		case PendingState::Added:
+			changeSet.changes.push_back({ pendingChange.fileName, FILE_ACTION_ADDED });
+			break;
+
+		case PendingState::Modified:
+			changeSet.changes.push_back({ pendingChange.fileName, FILE_ACTION_MODIFIED });
+			break;
+
+		case PendingState::Removed:
+			changeSet.changes.push_back({ pendingChange.fileName, FILE_ACTION_REMOVED });
+			break;
+
+		case PendingState::Replaced:
+			changeSet.changes.push_back({ pendingChange.fileName, FILE_ACTION_REMOVED });
+			changeSet.changes.push_back({ pendingChange.fileName, FILE_ACTION_ADDED });
+			break;
+
+		case PendingState::RenamedOldName:
+			changeSet.changes.push_back({ pendingChange.fileName, FILE_ACTION_RENAMED_OLD_NAME });
+			break;
+
+		case PendingState::RenamedNewName:
+			changeSet.changes.push_back({ pendingChange.fileName, FILE_ACTION_RENAMED_NEW_NAME });
+			break;
+		}
+	}
+
+	Clear();
+
+	return changeSet;
+}
@@ -0,0 +1,100 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <windows.h>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct DirectoryChange
+{
+	std::wstring fileName;
+
+	/* One of the FILE_ACTION_* values. */
+	DWORD action;
+};
+
+struct DirectoryChangeSet
+{
+	std::vector<DirectoryChange> changes;
+
+	/* Set if notifications were lost (e.g. because the
+	notification buffer overflowed). In that case, the
+	directory needs to be rescanned and changes will be
+	empty. */
+	bool rescanRequired;
+};
+
+/* Accumulates the change notifications for a directory
+between updates, merging successive notifications for
+the same file. For example, a file that's created,
+written to several times and then deleted results in a
+single removal, rather than a series of changes that
+would each need to be applied to the view.
+
+Renames aren't merged, since the old and new names need
+to be processed as a pair. They do, however, act as a
+barrier: notifications for a name received after it has
+been renamed aren't merged with those received before.
+
+This class isn't thread-safe. */
+class DirectoryChangeJournal
+{
+public:
+
+	DirectoryChangeJournal();
+
+	void AddChange(const std::wstring &fileName, DWORD action);
+
+	/* Indicates that notifications have been lost. Any
+	pending changes are discarded, as a rescan will pick
+	them up anyway. */
+	void SetRescanRequired();
+
+	bool IsEmpty() const;
+	void Clear();
+
+	/* Returns the merged set of changes (in the order each
+	file was first changed) and resets the journal. */
+	DirectoryChangeSet TakeChanges();
+
+private:
+
+	enum class PendingState
+	{
+		Added,
+		Modified,
+		Removed,
+
+		/* The file was removed, then another file with the
+		same name was created. */
+		Replaced,
+
+		/* FILE_ACTION_RENAMED_OLD_NAME or
+		FILE_ACTION_RENAMED_NEW_NAME. These are never
+		merged. */
+		RenamedOldName,
+		RenamedNewName
+	};
+
+	struct PendingChange
+	{
+		std::wstring fileName;
+		PendingState state;
+	};
+
+	typedef std::list<PendingChange> PendingChangeList;
+
+	static bool MergeChange(PendingChange &pendingChange, DWORD action);
+
+	PendingChangeList m_pendingChanges;
+
+	/* The most recent, mergeable, change for each name. */
+	std::unordered_map<std::wstring, PendingChangeList::iterator> m_latestChanges;
+
+	bool m_rescanRequired;
+};
@@ -0,0 +1,84 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "DirectoryFindDataReader.h"
+
+DirectoryFindDataReader::DirectoryFindDataReader(const std::wstring &directory)
+{
+	std::wstring searchPath = directory;
+
+	if (!searchPath.empty() && searchPath.back() != '\\')
+	{
+		searchPath += '\\';
+	}
+
+	searchPath += '*';
+
+	WIN32_FIND_DATA wfd;
+	m_hFindFile = FindFirstFileEx(searchPath.c_str(), FindExInfoStandard, &wfd,
+		FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+
+	if (m_hFindFile != INVALID_HANDLE_VALUE && !IsDotEntry(wfd))
+	{
+		m_pendingFindData.emplace(wfd.cFileName, wfd);
+	}
+}
+
+DirectoryFindDataReader::~DirectoryFindDataReader()
+{
+	Close();
+}
+
+boost::optional<WIN32_FIND_DATA> DirectoryFindDataReader::TakeFindData(const std::wstring &fileName)
+{
+	auto itr = m_pendingFindData.find(fileName);
+
+	if (itr != m_pendingFindData.end())
+	{
+		WIN32_FIND_DATA wfd = itr->second;
+		m_pendingFindData.erase(itr);
+		return wfd;
+	}
+
+	WIN32_FIND_DATA wfd;
+
+	while (m_hFindFile != INVALID_HANDLE_VALUE)
+	{
+		if (!FindNextFile(m_hFindFile, &wfd))
+		{
+			Close();
+			break;
+		}
+
+		if (IsDotEntry(wfd))
+		{
+			continue;
+		}
+
+		if (fileName == wfd.cFileName)
+		{
+			return wfd;
+		}
+
+		m_pendingFindData.emplace(wfd.cFileName, wfd);
+	}
+
+	return boost::none;
+}
+
+bool DirectoryFindDataReader::IsDotEntry(const WIN32_FIND_DATA &wfd)
+{
+	return lstrcmp(wfd.cFileName, _T(".")) == 0
+		|| lstrcmp(wfd.cFileName, _T("..")) == 0;
+}
+
+void DirectoryFindDataReader::Close()
+{
+	if (m_hFindFile != INVALID_HANDLE_VALUE)
+	{
+		FindClose(m_hFindFile);
+		m_hFindFile = INVALID_HANDLE_VALUE;
+	}
+}
@@ -0,0 +1,43 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "Macros.h"
+#include <boost/optional.hpp>
+#include <string>
+#include <unordered_map>
+
+/* Reads the find data for the items in a directory through a
+single search handle (with large fetches), but only as far as is
+needed to reach the item that's asked for. Any entries read on the
+way are kept until they're asked for.
+
+Shell folders generally return filesystem items in the same order
+as the search handle does, so each lookup will normally only read a
+single entry. That means the first items in a directory can be
+shown without having to wait for the whole directory to be read. */
+class DirectoryFindDataReader
+{
+public:
+
+	explicit DirectoryFindDataReader(const std::wstring &directory);
+	~DirectoryFindDataReader();
+
+	/* The find data for each item can only be taken once. Returns
+	nothing if the item isn't in the directory (or the directory
+	couldn't be read). Names are matched exactly. */
+	boost::optional<WIN32_FIND_DATA> TakeFindData(const std::wstring &fileName);
+
+private:
+
+	DISALLOW_COPY_AND_ASSIGN(DirectoryFindDataReader);
+
+	static bool IsDotEntry(const WIN32_FIND_DATA &wfd);
+
+	void Close();
+
+	HANDLE m_hFindFile;
+	std::unordered_map<std::wstring, WIN32_FIND_DATA> m_pendingFindData;
+};
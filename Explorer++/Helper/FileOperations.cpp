@@ -4,7 +4,7 @@
 
 #include "stdafx.h"
 #include "FileOperations.h"
-#include "DriveInfo.h"
+#include "FileShredder.h"
 #include "Helper.h"
 #include "iDataObject.h"
 #include "Macros.h"
@@ -13,6 +13,7 @@
 #include <boost/scope_exit.hpp>
 #include <list>
 #include <sstream>
+#include <thread>
 
 #pragma warning(disable:4459) // declaration of 'boost_scope_exit_aux_args' hides global declaration
 
@@ -23,7 +24,9 @@ enum PasteType
 };
 
 int PasteFilesFromClipboardSpecial(const TCHAR *szDestination, PasteType pasteType);
-BOOL GetFileClusterSize(const std::wstring &strFilename, PLARGE_INTEGER lpRealFileSize);
+FileShredder::PassScheme GetOverwritePassScheme(NFileOperations::OverwriteMethod_t overwriteMethod);
+
+const unsigned int MAX_SECURE_DELETE_THREADS = 4;
 
 HRESULT NFileOperations::RenameFile(IShellItem *item, const std::wstring &newName)
 {
@@ -678,136 +681,32 @@ BOOL NFileOperations::CreateBrowseDialog(HWND hOwner,const std::wstring &strTitl
 	return bSuccessful;
 }
 
-BOOL GetFileClusterSize(const std::wstring &strFilename, PLARGE_INTEGER lpRealFileSize)
+void NFileOperations::DeleteFileSecurely(const std::wstring &strFilename,OverwriteMethod_t uOverwriteMethod)
 {
-	DWORD dwClusterSize;
-
-	LARGE_INTEGER lFileSize;
-	BOOL bRet = GetFileSizeEx(strFilename.c_str(), &lFileSize);
-
-	if(!bRet)
-	{
-		return FALSE;
-	}
-
-	TCHAR szRoot[MAX_PATH];
-	HRESULT hr = StringCchCopy(szRoot, SIZEOF_ARRAY(szRoot), strFilename.c_str());
-
-	if(FAILED(hr))
-	{
-		return FALSE;
-	}
-
-	bRet = PathStripToRoot(szRoot);
-
-	if(!bRet)
-	{
-		return FALSE;
-	}
-
-	bRet = GetClusterSize(szRoot, &dwClusterSize);
-
-	if(!bRet)
-	{
-		return FALSE;
-	}
-
-	if((lFileSize.QuadPart % dwClusterSize) != 0)
-	{
-		/* The real size is the logical file size rounded up to the end of the
-		nearest cluster. */
-		lFileSize.QuadPart += dwClusterSize - (lFileSize.QuadPart % dwClusterSize);
-	}
-
-	*lpRealFileSize = lFileSize;
-
-	return TRUE;
+	FileShredder shredder(GetOverwritePassScheme(uOverwriteMethod),false);
+	shredder.ShredFile(strFilename);
 }
 
-void NFileOperations::DeleteFileSecurely(const std::wstring &strFilename,OverwriteMethod_t uOverwriteMethod)
+/* Files are overwritten in parallel, since a lot of the time
+spent on each one is waiting for the disk. If verify is set,
+each pass is read back and checked after it's been written.
+The status for each file is returned in the same order as the
+filenames. */
+std::vector<FileShredder::Status> NFileOperations::DeleteFilesSecurely(const std::vector<std::wstring> &filenames,OverwriteMethod_t uOverwriteMethod,bool verify)
 {
-	HANDLE			hFile;
-	WIN32_FIND_DATA	wfd;
-	HANDLE			hFindFile;
-	HCRYPTPROV		hProv;
-	LARGE_INTEGER	lRealFileSize;
-	BYTE			Pass1Data;
-	BYTE			Pass2Data;
-	BYTE			Pass3Data;
-	DWORD			nBytesWritten;
-	BOOL			bFolder;
-	int				i = 0;
-
-	hFindFile = FindFirstFile(strFilename.c_str(),&wfd);
-
-	if(hFindFile == INVALID_HANDLE_VALUE)
-		return;
-
-	bFolder = (wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY;
-
-	FindClose(hFindFile);
-
-	if(bFolder)
-	{
-		return;
-	}
-
-	/* Determine the actual size of the file on disk
-	(i.e. how many clusters it is allocated). */
-	GetFileClusterSize(strFilename,&lRealFileSize);
-
-	/* Open the file, block any sharing mode, to stop the file
-	been opened while it is overwritten. */
-	hFile = CreateFile(strFilename.c_str(),FILE_WRITE_DATA,0,NULL,OPEN_EXISTING,
-	NULL,NULL);
-
-	if(hFile == INVALID_HANDLE_VALUE)
-		return;
-
-	/* Extend the file out to the end of its last sector. */
-	SetFilePointerEx(hFile,lRealFileSize,NULL,FILE_BEGIN);
-	SetEndOfFile(hFile);
-
-	/* Start at the beginning of the file, and
-	write in the first-pass data, 0x00 over
-	the length of the whole file. */
-	SetFilePointer(hFile,0,NULL,FILE_BEGIN);
-	Pass1Data = 0x00;
+	int maxThreads = (std::max)(static_cast<int>((std::min)(std::thread::hardware_concurrency(),MAX_SECURE_DELETE_THREADS)),1);
+	return FileShredder::ShredFiles(filenames,GetOverwritePassScheme(uOverwriteMethod),verify,maxThreads);
+}
 
-	for(i = 0;i < lRealFileSize.QuadPart;i++)
-	{
-		WriteFile(hFile,(LPVOID)&Pass1Data,1,&nBytesWritten,NULL);
-	}
+FileShredder::PassScheme GetOverwritePassScheme(NFileOperations::OverwriteMethod_t overwriteMethod)
+{
+	FileShredder::PassScheme passes = {FileShredder::Pass::Fill(0x00)};
 
-	if(uOverwriteMethod == OVERWRITE_THREEPASS)
+	if(overwriteMethod == NFileOperations::OVERWRITE_THREEPASS)
 	{
-		/* Start at the beginning of the file, and
-		write in the second-pass data, 0xFF over
-		the length of the whole file. */
-		SetFilePointer(hFile,0,NULL,FILE_BEGIN);
-		Pass2Data = 0xFF;
-
-		for(i = 0;i < lRealFileSize.QuadPart;i++)
-		{
-			WriteFile(hFile,(LPVOID)&Pass2Data,1,&nBytesWritten,NULL);
-		}
-
-		SetFilePointer(hFile,0,NULL,FILE_BEGIN);
-
-		CryptAcquireContext(&hProv,_T("SecureDelete"),NULL,PROV_RSA_AES,CRYPT_NEWKEYSET);
-
-		for(i = 0;i < lRealFileSize.QuadPart;i++)
-		{
-			CryptGenRandom(hProv,1,(LPBYTE)&Pass3Data);
-			WriteFile(hFile,(LPVOID)&Pass3Data,1,&nBytesWritten,NULL);
-		}
-
-		CryptAcquireContext(&hProv,_T("SecureDelete"),NULL,PROV_RSA_AES,CRYPT_DELETEKEYSET);
+		passes.push_back(FileShredder::Pass::Fill(0xFF));
+		passes.push_back(FileShredder::Pass::Random());
 	}
 
-	FlushFileBuffers(hFile);
-
-	CloseHandle(hFile);
-
-	DeleteFile(strFilename.c_str());
+	return passes;
 }
\ No newline at end of file
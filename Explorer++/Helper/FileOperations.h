@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "FileShredder.h"
 #include <list>
 #include <vector>
 
@@ -18,6 +19,7 @@ namespace NFileOperations
 	HRESULT	RenameFile(IShellItem *item, const std::wstring &newName);
 	HRESULT	DeleteFiles(HWND hwnd, std::vector<LPCITEMIDLIST> &pidls, bool permanent, bool silent);
 	void	DeleteFileSecurely(const std::wstring &strFilename,OverwriteMethod_t uOverwriteMethod);
+	std::vector<FileShredder::Status>	DeleteFilesSecurely(const std::vector<std::wstring> &filenames,OverwriteMethod_t uOverwriteMethod,bool verify);
 	HRESULT	CopyFilesToFolder(HWND hOwner, const std::wstring &strTitle, std::vector<LPCITEMIDLIST> &pidls, bool move);
 	HRESULT	CopyFiles(HWND hwnd, IShellItem *destinationFolder, std::vector<LPCITEMIDLIST> &pidls, bool move);
 
@@ -0,0 +1,423 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "FileShredder.h"
+#include "DriveInfo.h"
+#include "FileWrappers.h"
+#include <boost/optional.hpp>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+
+namespace
+{
+	std::uint64_t RotateLeft(std::uint64_t value, int shift)
+	{
+		return (value << shift) | (value >> (64 - shift));
+	}
+
+	DWORD GetChunkSize(DWORD bufferSize, std::uint64_t remaining)
+	{
+		return static_cast<DWORD>((std::min)<std::uint64_t>(bufferSize, remaining));
+	}
+
+	bool SeekToStart(HANDLE file)
+	{
+		LARGE_INTEGER distance;
+		distance.QuadPart = 0;
+		return SetFilePointerEx(file, distance, NULL, FILE_BEGIN) != FALSE;
+	}
+
+	boost::optional<DWORD> GetVolumeClusterSize(const std::wstring &path)
+	{
+		TCHAR root[MAX_PATH];
+		HRESULT hr = StringCchCopy(root, SIZEOF_ARRAY(root), path.c_str());
+
+		if (FAILED(hr) || !PathStripToRoot(root))
+		{
+			return boost::none;
+		}
+
+		DWORD clusterSize;
+
+		if (!GetClusterSize(root, &clusterSize) || clusterSize == 0)
+		{
+			return boost::none;
+		}
+
+		return clusterSize;
+	}
+}
+
+FileShredder::Pass FileShredder::Pass::Fill(unsigned char value)
+{
+	return { Type::Fill, value };
+}
+
+FileShredder::Pass FileShredder::Pass::Random()
+{
+	return { Type::Random, 0 };
+}
+
+/* The seed comes from the system's CSPRNG. std::random_device is
+only used if that isn't available. */
+FileShredder::RandomGenerator::State FileShredder::RandomGenerator::GenerateSeed()
+{
+	State seed = {};
+	HCRYPTPROV provider;
+	bool seeded = false;
+
+	if (CryptAcquireContext(&provider, NULL, NULL, PROV_RSA_AES, CRYPT_VERIFYCONTEXT))
+	{
+		seeded = (CryptGenRandom(provider, sizeof(seed), reinterpret_cast<BYTE *>(seed.data())) != FALSE);
+		CryptReleaseContext(provider, 0);
+	}
+
+	if (!seeded)
+	{
+		std::random_device device;
+
+		for (auto &word : seed)
+		{
+			word = (static_cast<std::uint64_t>(device()) << 32) | device();
+		}
+	}
+
+	return seed;
+}
+
+FileShredder::RandomGenerator::RandomGenerator(const State &seed) :
+	m_state(seed)
+{
+	// xoshiro256** never leaves the all-zero state.
+	if (std::all_of(m_state.begin(), m_state.end(), [] (std::uint64_t word) { return word == 0; }))
+	{
+		m_state[0] = 1;
+	}
+}
+
+std::uint64_t FileShredder::RandomGenerator::Next()
+{
+	std::uint64_t result = RotateLeft(m_state[1] * 5, 7) * 9;
+	std::uint64_t t = m_state[1] << 17;
+
+	m_state[2] ^= m_state[0];
+	m_state[3] ^= m_state[1];
+	m_state[1] ^= m_state[2];
+	m_state[0] ^= m_state[3];
+
+	m_state[2] ^= t;
+	m_state[3] = RotateLeft(m_state[3], 45);
+
+	return result;
+}
+
+void FileShredder::RandomGenerator::Fill(void *buffer, size_t size)
+{
+	auto *output = static_cast<unsigned char *>(buffer);
+	size_t numWords = size / sizeof(std::uint64_t);
+
+	for (size_t i = 0; i < numWords; i++)
+	{
+		std::uint64_t value = Next();
+		memcpy(output + (i * sizeof(value)), &value, sizeof(value));
+	}
+
+	size_t remainder = size % sizeof(std::uint64_t);
+
+	if (remainder > 0)
+	{
+		std::uint64_t value = Next();
+		memcpy(output + (numWords * sizeof(value)), &value, remainder);
+	}
+}
+
+/* The buffers are allocated with VirtualAlloc, so that they're
+page-aligned, as required for unbuffered I/O. */
+FileShredder::FileShredder(const PassScheme &passes, bool verify, DWORD bufferSize) :
+	m_passes(passes),
+	m_verify(verify),
+	m_bufferSize(0),
+	m_dataBuffer(nullptr),
+	m_readBuffer(nullptr)
+{
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+
+	DWORD pageSize = systemInfo.dwPageSize;
+	bufferSize = (std::max)<DWORD>(bufferSize, 1);
+	bufferSize = ((bufferSize + pageSize - 1) / pageSize) * pageSize;
+
+	m_dataBuffer = static_cast<unsigned char *>(VirtualAlloc(NULL, bufferSize,
+		MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+
+	if (m_verify)
+	{
+		m_readBuffer = static_cast<unsigned char *>(VirtualAlloc(NULL, bufferSize,
+			MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+	}
+
+	if (IsValid())
+	{
+		m_bufferSize = bufferSize;
+	}
+}
+
+FileShredder::~FileShredder()
+{
+	for (auto buffer : { m_dataBuffer, m_readBuffer })
+	{
+		if (buffer != nullptr)
+		{
+			VirtualFree(buffer, 0, MEM_RELEASE);
+		}
+	}
+}
+
+bool FileShredder::IsValid() const
+{
+	return m_dataBuffer != nullptr && (!m_verify || m_readBuffer != nullptr);
+}
+
+/* Each pass is flushed to disk before the next one starts (and
+before it's verified), so that it isn't simply replaced in the
+cache by the pass that follows. */
+FileShredder::Status FileShredder::Overwrite(HANDLE file, std::uint64_t size)
+{
+	if (!IsValid())
+	{
+		return Status::WriteFailed;
+	}
+
+	for (const auto &pass : m_passes)
+	{
+		RandomGenerator::State seed = {};
+
+		if (pass.type == Pass::Type::Random)
+		{
+			seed = RandomGenerator::GenerateSeed();
+		}
+
+		RandomGenerator writeGenerator(seed);
+
+		if (!WritePass(file, size, pass, writeGenerator) || !FlushFileBuffers(file))
+		{
+			return Status::WriteFailed;
+		}
+
+		if (m_verify)
+		{
+			// The random data isn't kept. Instead, the same
+			// sequence is generated again from the seed.
+			RandomGenerator verifyGenerator(seed);
+
+			if (!VerifyPass(file, size, pass, verifyGenerator))
+			{
+				return Status::VerifyFailed;
+			}
+		}
+	}
+
+	return Status::Succeeded;
+}
+
+bool FileShredder::WritePass(HANDLE file, std::uint64_t size, const Pass &pass, RandomGenerator &generator)
+{
+	if (!SeekToStart(file))
+	{
+		return false;
+	}
+
+	if (pass.type == Pass::Type::Fill)
+	{
+		memset(m_dataBuffer, pass.fillValue, m_bufferSize);
+	}
+
+	std::uint64_t remaining = size;
+
+	while (remaining > 0)
+	{
+		DWORD chunkSize = GetChunkSize(m_bufferSize, remaining);
+
+		if (pass.type == Pass::Type::Random)
+		{
+			generator.Fill(m_dataBuffer, chunkSize);
+		}
+
+		DWORD bytesWritten;
+		BOOL res = WriteFile(file, m_dataBuffer, chunkSize, &bytesWritten, NULL);
+
+		if (!res || bytesWritten != chunkSize)
+		{
+			return false;
+		}
+
+		remaining -= chunkSize;
+	}
+
+	return true;
+}
+
+bool FileShredder::VerifyPass(HANDLE file, std::uint64_t size, const Pass &pass, RandomGenerator &generator)
+{
+	if (!SeekToStart(file))
+	{
+		return false;
+	}
+
+	if (pass.type == Pass::Type::Fill)
+	{
+		memset(m_dataBuffer, pass.fillValue, m_bufferSize);
+	}
+
+	std::uint64_t remaining = size;
+
+	while (remaining > 0)
+	{
+		DWORD chunkSize = GetChunkSize(m_bufferSize, remaining);
+
+		DWORD bytesRead;
+		BOOL res = ReadFile(file, m_readBuffer, chunkSize, &bytesRead, NULL);
+
+		if (!res || bytesRead != chunkSize)
+		{
+			return false;
+		}
+
+		if (pass.type == Pass::Type::Random)
+		{
+			generator.Fill(m_dataBuffer, chunkSize);
+		}
+
+		if (memcmp(m_readBuffer, m_dataBuffer, chunkSize) != 0)
+		{
+			return false;
+		}
+
+		remaining -= chunkSize;
+	}
+
+	return true;
+}
+
+FileShredder::Status FileShredder::ShredFile(const std::wstring &path)
+{
+	DWORD attributes = GetFileAttributes(path.c_str());
+
+	if (attributes == INVALID_FILE_ATTRIBUTES)
+	{
+		return Status::OpenFailed;
+	}
+
+	if (attributes & FILE_ATTRIBUTE_DIRECTORY)
+	{
+		return Status::NotAFile;
+	}
+
+	{
+		auto clusterSize = GetVolumeClusterSize(path);
+
+		// When the cluster size is known, the size written is always
+		// a multiple of it, so the file can be written without
+		// going through the cache. The sharing mode blocks the file
+		// from being opened while it's being overwritten.
+		DWORD flags = FILE_FLAG_WRITE_THROUGH;
+
+		if (clusterSize)
+		{
+			flags |= FILE_FLAG_NO_BUFFERING;
+		}
+
+		DWORD access = m_verify ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_WRITE;
+		HFilePtr file = CreateFilePtr(path.c_str(), access, 0, NULL, OPEN_EXISTING, flags, NULL);
+
+		if (!file)
+		{
+			return Status::OpenFailed;
+		}
+
+		LARGE_INTEGER fileSize;
+
+		if (!GetFileSizeEx(file.get(), &fileSize))
+		{
+			return Status::OpenFailed;
+		}
+
+		// The file is extended out to the end of its last cluster,
+		// so that the slack space is overwritten as well.
+		std::uint64_t size = fileSize.QuadPart;
+
+		if (clusterSize && (size % *clusterSize) != 0)
+		{
+			size += *clusterSize - (size % *clusterSize);
+
+			LARGE_INTEGER newSize;
+			newSize.QuadPart = size;
+
+			if (!SetFilePointerEx(file.get(), newSize, NULL, FILE_BEGIN) || !SetEndOfFile(file.get()))
+			{
+				return Status::WriteFailed;
+			}
+		}
+
+		Status status = Overwrite(file.get(), size);
+
+		if (status != Status::Succeeded)
+		{
+			return status;
+		}
+	}
+
+	if (!DeleteFile(path.c_str()))
+	{
+		return Status::DeleteFailed;
+	}
+
+	return Status::Succeeded;
+}
+
+/* Each thread takes the next file from the list once it's
+finished with the previous one. The calling thread also takes
+part. */
+std::vector<FileShredder::Status> FileShredder::ShredFiles(const std::vector<std::wstring> &paths,
+	const PassScheme &passes, bool verify, int maxThreads)
+{
+	std::vector<Status> statuses(paths.size(), Status::OpenFailed);
+
+	if (paths.empty())
+	{
+		return statuses;
+	}
+
+	std::atomic<size_t> nextIndex(0);
+
+	auto shredRemainingFiles = [&] () {
+		FileShredder shredder(passes, verify);
+		size_t index;
+
+		while ((index = nextIndex++) < paths.size())
+		{
+			statuses[index] = shredder.ShredFile(paths[index]);
+		}
+	};
+
+	size_t numThreads = (std::min)<size_t>((std::max)(maxThreads, 1), paths.size());
+	std::vector<std::thread> threads;
+
+	for (size_t i = 1; i < numThreads; i++)
+	{
+		threads.emplace_back(shredRemainingFiles);
+	}
+
+	shredRemainingFiles();
+
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	return statuses;
+}
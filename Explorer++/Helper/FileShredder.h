@@ -0,0 +1,115 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "Macros.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Overwrites the contents of files (so that they can't be
+recovered) before deleting them.
+
+Each file is overwritten a block at a time, through a single
+large page-aligned buffer, once for every pass in the scheme.
+A pass either fills the file with a fixed byte value, or with
+random data. After each pass, the data can optionally be read
+back and compared against what was written.
+
+A shredder holds its own buffers, so each thread needs its
+own instance. ShredFiles takes care of that. */
+class FileShredder
+{
+public:
+
+	struct Pass
+	{
+		enum class Type
+		{
+			Fill,
+			Random
+		};
+
+		static Pass Fill(unsigned char value);
+		static Pass Random();
+
+		Type type;
+		unsigned char fillValue;
+	};
+
+	typedef std::vector<Pass> PassScheme;
+
+	enum class Status
+	{
+		Succeeded,
+		NotAFile,
+		OpenFailed,
+		WriteFailed,
+		VerifyFailed,
+		DeleteFailed
+	};
+
+	/* A xoshiro256** generator. It's not cryptographically
+	secure by itself, but each random pass is seeded from the
+	system's CSPRNG, and it's fast enough that generating the
+	data doesn't slow the overwrite down. */
+	class RandomGenerator
+	{
+	public:
+
+		typedef std::array<std::uint64_t, 4> State;
+
+		static State GenerateSeed();
+
+		explicit RandomGenerator(const State &seed);
+
+		std::uint64_t Next();
+		void Fill(void *buffer, size_t size);
+
+	private:
+
+		State m_state;
+	};
+
+	static const DWORD DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+	FileShredder(const PassScheme &passes, bool verify, DWORD bufferSize = DEFAULT_BUFFER_SIZE);
+	~FileShredder();
+
+	/* Overwrites the first size bytes of the file. The handle
+	needs read access if verification is enabled. The file
+	pointer is left in an unspecified position. */
+	Status Overwrite(HANDLE file, std::uint64_t size);
+
+	/* Overwrites the entire file, including any slack space at
+	the end of its last cluster, then deletes it. */
+	Status ShredFile(const std::wstring &path);
+
+	/* Shreds the files using up to maxThreads threads. The
+	status for each file is returned in the same order as the
+	paths. */
+	static std::vector<Status> ShredFiles(const std::vector<std::wstring> &paths,
+		const PassScheme &passes, bool verify, int maxThreads);
+
+private:
+
+	DISALLOW_COPY_AND_ASSIGN(FileShredder);
+
+	bool IsValid() const;
+	bool WritePass(HANDLE file, std::uint64_t size, const Pass &pass, RandomGenerator &generator);
+	bool VerifyPass(HANDLE file, std::uint64_t size, const Pass &pass, RandomGenerator &generator);
+
+	const PassScheme m_passes;
+	const bool m_verify;
+	DWORD m_bufferSize;
+
+	/* Holds the data being written (or, when verifying, the
+	data that's expected). */
+	unsigned char *m_dataBuffer;
+
+	/* Holds the data read back during verification. */
+	unsigned char *m_readBuffer;
+};
@@ -35,4 +35,18 @@ HFilePtr CreateFilePtr(LPCTSTR lpFileName, DWORD dwDesiredAccess, DWORD dwShareM
 HFindFilePtr FindFirstFilePtr(LPCTSTR lpFileName, LPWIN32_FIND_DATA lpFindFileData)
 {
 	return HFindFilePtr(FindFirstFile(lpFileName, lpFindFileData));
+}
+
+HFileMappingPtr CreateFileMappingPtr(HANDLE hFile, LPSECURITY_ATTRIBUTES lpFileMappingAttributes,
+	DWORD flProtect, DWORD dwMaximumSizeHigh, DWORD dwMaximumSizeLow, LPCTSTR lpName)
+{
+	return HFileMappingPtr(CreateFileMapping(hFile, lpFileMappingAttributes, flProtect,
+		dwMaximumSizeHigh, dwMaximumSizeLow, lpName));
+}
+
+MappedViewPtr MapViewOfFilePtr(HANDLE hFileMappingObject, DWORD dwDesiredAccess,
+	DWORD dwFileOffsetHigh, DWORD dwFileOffsetLow, SIZE_T dwNumberOfBytesToMap)
+{
+	return MappedViewPtr(MapViewOfFile(hFileMappingObject, dwDesiredAccess,
+		dwFileOffsetHigh, dwFileOffsetLow, dwNumberOfBytesToMap));
 }
\ No newline at end of file
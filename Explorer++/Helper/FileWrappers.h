@@ -36,10 +36,46 @@ struct FindFileTraits
 	}
 };
 
+struct FileMappingTraits
+{
+	typedef HANDLE pointer;
+
+	static HANDLE invalid()
+	{
+		return NULL;
+	}
+
+	static void close(HANDLE value)
+	{
+		CloseHandle(value);
+	}
+};
+
+struct MappedViewTraits
+{
+	typedef LPVOID pointer;
+
+	static LPVOID invalid()
+	{
+		return NULL;
+	}
+
+	static void close(LPVOID value)
+	{
+		UnmapViewOfFile(value);
+	}
+};
+
 typedef unique_handle<InvalidHandleTraits> HFilePtr;
 typedef unique_handle<FindFileTraits> HFindFilePtr;
+typedef unique_handle<FileMappingTraits> HFileMappingPtr;
+typedef unique_handle<MappedViewTraits> MappedViewPtr;
 
 HFilePtr CreateFilePtr(LPCTSTR lpFileName, DWORD dwDesiredAccess, DWORD dwShareMode,
 	LPSECURITY_ATTRIBUTES lpSecurityAttributes, DWORD dwCreationDisposition,
 	DWORD dwFlagsAndAttributes, HANDLE hTemplateFile);
-HFindFilePtr FindFirstFilePtr(LPCTSTR lpFileName, LPWIN32_FIND_DATA lpFindFileData);
\ No newline at end of file
+HFindFilePtr FindFirstFilePtr(LPCTSTR lpFileName, LPWIN32_FIND_DATA lpFindFileData);
+HFileMappingPtr CreateFileMappingPtr(HANDLE hFile, LPSECURITY_ATTRIBUTES lpFileMappingAttributes,
+	DWORD flProtect, DWORD dwMaximumSizeHigh, DWORD dwMaximumSizeLow, LPCTSTR lpName);
+MappedViewPtr MapViewOfFilePtr(HANDLE hFileMappingObject, DWORD dwDesiredAccess,
+	DWORD dwFileOffsetHigh, DWORD dwFileOffsetLow, SIZE_T dwNumberOfBytesToMap);
\ No newline at end of file
@@ -8,63 +8,58 @@
 #include "Macros.h"
 
 
+/* Directories are processed from an explicit stack,
+rather than recursively, so that very deep trees can't
+exhaust the thread's stack. */
 HRESULT CalculateFolderSize(const TCHAR *szPath,int *nFolders,
 int *nFiles,PULARGE_INTEGER lTotalFolderSize)
 {
 	HANDLE			hFirstFile;
 	WIN32_FIND_DATA	wfd;
-	TCHAR			InitialPath[MAX_PATH + 2];
+	TCHAR			SearchPath[MAX_PATH + 2];
 	TCHAR			TempPath[MAX_PATH + 2];
 	ULARGE_INTEGER	l_TotalFolderSize;
-	ULARGE_INTEGER	r_TotalFolderSize;
 	ULARGE_INTEGER	lFileSize;
 	int				l_NumFiles = 0;
 	int				l_NumFolders = 0;
-	int				r_NumFiles = 0;
-	int				r_NumFolders = 0;
 
 	if(!szPath || ! nFolders || !nFiles || !lTotalFolderSize)
 		return E_INVALIDARG;
 
 	l_TotalFolderSize.QuadPart	= 0;
-	r_TotalFolderSize.QuadPart	= 0;
 
-	StringCchCopy(InitialPath,SIZEOF_ARRAY(InitialPath),szPath);
-	StringCchCat(InitialPath,SIZEOF_ARRAY(InitialPath),_T("\\*"));
+	std::list<std::wstring> pendingDirectories;
+	pendingDirectories.push_back(szPath);
 
-	hFirstFile = FindFirstFile(InitialPath,&wfd);
-
-	if(hFirstFile == INVALID_HANDLE_VALUE)
-		return S_OK;
-	
-	if(StrCmp(wfd.cFileName,_T(".")) != 0)
+	while(!pendingDirectories.empty())
 	{
-		if((wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY)
-		{
-			l_NumFolders++;
-		}
-		else
-		{
-			l_NumFiles++;
-		}
-	}
+		std::wstring directory = pendingDirectories.back();
+		pendingDirectories.pop_back();
 
-	while(FindNextFile(hFirstFile,&wfd) != 0)
-	{
-		if(StrCmp(wfd.cFileName,_T("..")) != 0)
+		StringCchCopy(SearchPath,SIZEOF_ARRAY(SearchPath),directory.c_str());
+		StringCchCat(SearchPath,SIZEOF_ARRAY(SearchPath),_T("\\*"));
+
+		hFirstFile = FindFirstFile(SearchPath,&wfd);
+
+		if(hFirstFile == INVALID_HANDLE_VALUE)
+			continue;
+
+		do
 		{
+			if(StrCmp(wfd.cFileName,_T(".")) == 0 ||
+				StrCmp(wfd.cFileName,_T("..")) == 0)
+			{
+				continue;
+			}
+
 			if((wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY)
 			{
 				l_NumFolders++;
 
-				StringCchCopy(TempPath,SIZEOF_ARRAY(TempPath),szPath);
+				StringCchCopy(TempPath,SIZEOF_ARRAY(TempPath),directory.c_str());
 				PathAppend(TempPath,wfd.cFileName);
 
-				CalculateFolderSize(TempPath,&r_NumFolders,&r_NumFiles,&r_TotalFolderSize);
-
-				l_NumFolders				+= r_NumFolders;
-				l_NumFiles					+= r_NumFiles;
-				l_TotalFolderSize.QuadPart	+= r_TotalFolderSize.QuadPart;
+				pendingDirectories.push_back(TempPath);
 			}
 			else
 			{
@@ -74,36 +69,14 @@ int *nFiles,PULARGE_INTEGER lTotalFolderSize)
 
 				l_TotalFolderSize.QuadPart += lFileSize.QuadPart;
 			}
-		}
+		} while(FindNextFile(hFirstFile,&wfd) != 0);
+
+		FindClose(hFirstFile);
 	}
 
 	*nFolders					= l_NumFolders;
 	*nFiles						= l_NumFiles;
 	lTotalFolderSize->QuadPart	= l_TotalFolderSize.QuadPart;
 
-	FindClose(hFirstFile);
-
 	return S_OK;
-}
-
-DWORD WINAPI Thread_CalculateFolderSize(LPVOID lpParameter)
-{
-	FolderSize_t	*pFolderSize = NULL;
-	static int		nFiles;
-	static int		nFolders;
-	ULARGE_INTEGER	lTotalDirSize;
-	HRESULT			hr;
-
-	if(lpParameter == NULL)
-		return 0;
-
-	pFolderSize = (FolderSize_t *)lpParameter;
-
-	hr = CalculateFolderSize(pFolderSize->szPath,&nFolders,&nFiles,&lTotalDirSize);
-
-	pFolderSize->pfnCallback(nFolders,nFiles,&lTotalDirSize,pFolderSize->pData);
-
-	free(pFolderSize);
-
-	return 1;
 }
\ No newline at end of file
@@ -0,0 +1,671 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "FolderSizeService.h"
+#include <algorithm>
+#include <cassert>
+#include <future>
+
+FolderSizeService::FolderSizeService(int numWorkers, IDirectoryMonitor *directoryMonitor) :
+	m_directoryMonitor(directoryMonitor),
+	m_nextQueue(0),
+	m_numQueuedTasks(0),
+	m_stop(false),
+	m_nextInvalidationSequence(0)
+{
+	m_directoryMonitor->AddRef();
+
+	numWorkers = (std::max)(numWorkers, 1);
+
+	for (int i = 0; i < numWorkers; i++)
+	{
+		m_queues.push_back(std::make_unique<WorkerQueue>());
+	}
+
+	for (int i = 0; i < numWorkers; i++)
+	{
+		m_workers.emplace_back(&FolderSizeService::WorkerThread, this, i);
+	}
+}
+
+FolderSizeService::~FolderSizeService()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_workMutex);
+		m_stop = true;
+	}
+
+	m_workAvailable.notify_all();
+
+	for (auto &worker : m_workers)
+	{
+		worker.join();
+	}
+
+	// Any calculations that haven't finished are simply abandoned.
+	// Their callbacks are released here without being called.
+	m_queues.clear();
+
+	std::lock_guard<std::mutex> lock(m_watchMutex);
+
+	for (const auto &watchedFolder : m_watchedFolders)
+	{
+		m_directoryMonitor->StopDirectoryMonitor(watchedFolder.monitorId);
+	}
+
+	m_directoryMonitor->Release();
+}
+
+void FolderSizeService::CalculateFolderSizeAsync(const std::wstring &path, ResultCallback callback)
+{
+	std::wstring normalizedPath = NormalizePath(path);
+
+	auto cachedFolderSize = GetCachedFolderSize(normalizedPath);
+
+	if (cachedFolderSize)
+	{
+		callback(*cachedFolderSize, true);
+		return;
+	}
+
+	// The folder is watched before it's enumerated, so that changes
+	// made while the calculation is running aren't missed.
+	WatchFolder(normalizedPath);
+
+	auto calculation = std::make_shared<Calculation>();
+	calculation->callback = callback;
+	calculation->complete = false;
+	calculation->size = 0;
+	calculation->numFolders = 0;
+	calculation->numFiles = 0;
+	calculation->lastProgressTime = GetTickCount64();
+
+	{
+		std::lock_guard<std::mutex> lock(m_cacheMutex);
+		calculation->invalidationSequence = m_nextInvalidationSequence;
+		m_runningCalculations.insert(calculation->invalidationSequence);
+	}
+
+	PushTask(static_cast<int>(m_nextQueue++ % m_queues.size()), CreateNode(normalizedPath, nullptr, calculation));
+}
+
+boost::optional<FolderSizeService::FolderSize> FolderSizeService::CalculateFolderSize(const std::wstring &path)
+{
+	std::future<FolderSize> future;
+
+	{
+		// Only the callback should hold on to the promise. If the
+		// calculation is abandoned, the callback (and with it, the
+		// promise) is destroyed, which causes future.get() to throw.
+		auto promise = std::make_shared<std::promise<FolderSize>>();
+		future = promise->get_future();
+
+		CalculateFolderSizeAsync(path, [promise] (const FolderSize &folderSize, bool complete) {
+			if (complete)
+			{
+				promise->set_value(folderSize);
+			}
+		});
+	}
+
+	try
+	{
+		return future.get();
+	}
+	catch (const std::future_error &)
+	{
+		return boost::none;
+	}
+}
+
+boost::optional<FolderSizeService::FolderSize> FolderSizeService::GetCachedFolderSize(const std::wstring &path) const
+{
+	std::wstring normalizedPath = NormalizePath(path);
+
+	std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+	auto itr = m_cache.find(normalizedPath);
+
+	if (itr == m_cache.end())
+	{
+		return boost::none;
+	}
+
+	return itr->second;
+}
+
+void FolderSizeService::InvalidateFolder(const std::wstring &path)
+{
+	InvalidateFolderInternal(NormalizePath(path), true);
+}
+
+void FolderSizeService::ClearCache()
+{
+	std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+	m_cache.clear();
+	RecordInvalidation(_T(""), true);
+}
+
+void FolderSizeService::WorkerThread(int workerIndex)
+{
+	while (true)
+	{
+		if (m_stop)
+		{
+			return;
+		}
+
+		std::shared_ptr<DirectoryNode> task;
+
+		if (PopTask(workerIndex, task))
+		{
+			ProcessDirectory(workerIndex, task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_workMutex);
+		m_workAvailable.wait(lock, [this] { return m_stop || m_numQueuedTasks > 0; });
+
+		if (m_stop)
+		{
+			return;
+		}
+	}
+}
+
+void FolderSizeService::PushTask(int workerIndex, std::shared_ptr<DirectoryNode> task)
+{
+	{
+		WorkerQueue &queue = *m_queues[workerIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_workMutex);
+		m_numQueuedTasks++;
+	}
+
+	m_workAvailable.notify_one();
+}
+
+/* Workers process their own queue in LIFO order (which
+keeps the traversal depth-first and the queues short) and
+steal from the other queues in FIFO order (which tends to
+take the directories nearest the root, and therefore the
+largest pieces of outstanding work). */
+bool FolderSizeService::PopTask(int workerIndex, std::shared_ptr<DirectoryNode> &task)
+{
+	{
+		WorkerQueue &queue = *m_queues[workerIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (!queue.tasks.empty())
+		{
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			m_numQueuedTasks--;
+			return true;
+		}
+	}
+
+	for (size_t i = 1; i < m_queues.size(); i++)
+	{
+		WorkerQueue &queue = *m_queues[(workerIndex + i) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (!queue.tasks.empty())
+		{
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			m_numQueuedTasks--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FolderSizeService::ProcessDirectory(int workerIndex, const std::shared_ptr<DirectoryNode> &node)
+{
+	ULONGLONG size = 0;
+	int numFolders = 0;
+	int numFiles = 0;
+
+	std::wstring searchPath = CombinePath(node->path, _T("*"));
+
+	WIN32_FIND_DATA wfd;
+	HANDLE hFindFile = FindFirstFileEx(searchPath.c_str(), FindExInfoBasic, &wfd,
+		FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+
+	if (hFindFile != INVALID_HANDLE_VALUE)
+	{
+		do
+		{
+			if (lstrcmp(wfd.cFileName, _T(".")) == 0 ||
+				lstrcmp(wfd.cFileName, _T("..")) == 0)
+			{
+				continue;
+			}
+
+			if ((wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != FILE_ATTRIBUTE_DIRECTORY)
+			{
+				ULARGE_INTEGER fileSize;
+				fileSize.LowPart = wfd.nFileSizeLow;
+				fileSize.HighPart = wfd.nFileSizeHigh;
+
+				size += fileSize.QuadPart;
+				numFiles++;
+
+				continue;
+			}
+
+			numFolders++;
+
+			if ((wfd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) == FILE_ATTRIBUTE_REPARSE_POINT)
+			{
+				continue;
+			}
+
+			std::wstring subfolderPath = NormalizePath(CombinePath(node->path, wfd.cFileName));
+			auto cachedFolderSize = GetCachedFolderSize(subfolderPath);
+
+			if (cachedFolderSize)
+			{
+				size += cachedFolderSize->size;
+				numFolders += cachedFolderSize->numFolders;
+				numFiles += cachedFolderSize->numFiles;
+
+				continue;
+			}
+
+			node->pendingCount++;
+			PushTask(workerIndex, CreateNode(subfolderPath, node, node->calculation));
+		} while (FindNextFile(hFindFile, &wfd));
+
+		FindClose(hFindFile);
+	}
+
+	node->size += size;
+	node->numFolders += numFolders;
+	node->numFiles += numFiles;
+
+	Calculation &calculation = *node->calculation;
+	calculation.size += size;
+	calculation.numFolders += numFolders;
+	calculation.numFiles += numFiles;
+
+	ReportProgress(calculation);
+
+	CompleteNode(node);
+}
+
+/* Called once the directory itself has been enumerated and
+each time one of its subdirectories has finished. The last
+of those calls completes the directory, adding its totals to
+those of its parent (which may in turn complete). */
+void FolderSizeService::CompleteNode(std::shared_ptr<DirectoryNode> node)
+{
+	while (node->pendingCount.fetch_sub(1) == 1)
+	{
+		FolderSize folderSize = { node->size, node->numFolders, node->numFiles };
+		std::shared_ptr<Calculation> calculation = node->calculation;
+
+		CacheFolderSize(node->path, folderSize, *calculation);
+
+		if (!node->parent)
+		{
+			FinishCalculation(*calculation);
+
+			std::lock_guard<std::mutex> lock(calculation->callbackMutex);
+			calculation->complete = true;
+			calculation->callback(folderSize, true);
+
+			return;
+		}
+
+		std::shared_ptr<DirectoryNode> parent = node->parent;
+		parent->size += folderSize.size;
+		parent->numFolders += folderSize.numFolders;
+		parent->numFiles += folderSize.numFiles;
+
+		node = parent;
+	}
+}
+
+void FolderSizeService::ReportProgress(Calculation &calculation)
+{
+	ULONGLONG now = GetTickCount64();
+	ULONGLONG lastProgressTime = calculation.lastProgressTime;
+
+	if ((now - lastProgressTime) < PROGRESS_INTERVAL_MS ||
+		!calculation.lastProgressTime.compare_exchange_strong(lastProgressTime, now))
+	{
+		return;
+	}
+
+	// If the callback is already running (either for a previous
+	// progress update or because the calculation has just finished),
+	// this update is simply skipped.
+	std::unique_lock<std::mutex> lock(calculation.callbackMutex, std::try_to_lock);
+
+	if (!lock.owns_lock() || calculation.complete)
+	{
+		return;
+	}
+
+	FolderSize folderSize = { calculation.size, calculation.numFolders, calculation.numFiles };
+	calculation.callback(folderSize, false);
+}
+
+std::shared_ptr<FolderSizeService::DirectoryNode> FolderSizeService::CreateNode(const std::wstring &path,
+	std::shared_ptr<DirectoryNode> parent, std::shared_ptr<Calculation> calculation)
+{
+	auto node = std::make_shared<DirectoryNode>();
+	node->path = path;
+	node->parent = std::move(parent);
+	node->calculation = std::move(calculation);
+	node->size = 0;
+	node->numFolders = 0;
+	node->numFiles = 0;
+	node->pendingCount = 1;
+
+	return node;
+}
+
+void FolderSizeService::WatchFolder(const std::wstring &path)
+{
+	std::lock_guard<std::mutex> lock(m_watchMutex);
+
+	for (const auto &watchedFolder : m_watchedFolders)
+	{
+		if (IsSameOrDescendant(path, watchedFolder.path))
+		{
+			return;
+		}
+	}
+
+	std::wstring watchPath = path;
+
+	// Sizing each folder in a large directory (e.g. through the size
+	// column) would otherwise add a watch for each one. Once the limit
+	// has been reached, a folder whose siblings are already watched is
+	// covered by watching the parent instead, which replaces the
+	// watches on the siblings.
+	if (m_watchedFolders.size() >= MAX_WATCHED_FOLDERS)
+	{
+		auto parentPath = GetParentPath(path);
+
+		if (parentPath && std::any_of(m_watchedFolders.begin(), m_watchedFolders.end(),
+			[&parentPath] (const WatchedFolder &watchedFolder) {
+			return IsSameOrDescendant(watchedFolder.path, *parentPath);
+		}))
+		{
+			watchPath = *parentPath;
+		}
+	}
+
+	int monitorId = StartWatch(watchPath);
+
+	if (monitorId == -1 && watchPath != path)
+	{
+		watchPath = path;
+		monitorId = StartWatch(watchPath);
+	}
+
+	if (monitorId == -1)
+	{
+		// The folder can't be watched, so none of the sizes
+		// calculated within it will be cached.
+		return;
+	}
+
+	// Any descendants that are already being watched are covered by
+	// the new watch. They're only released once the new watch has
+	// started, so no changes are missed (and nothing needs to be
+	// invalidated).
+	for (auto itr = m_watchedFolders.begin(); itr != m_watchedFolders.end();)
+	{
+		if (IsSameOrDescendant(itr->path, watchPath))
+		{
+			m_directoryMonitor->StopDirectoryMonitor(itr->monitorId);
+			itr = m_watchedFolders.erase(itr);
+		}
+		else
+		{
+			++itr;
+		}
+	}
+
+	m_watchedFolders.push_back({ watchPath, monitorId });
+
+	if (m_watchedFolders.size() > MAX_WATCHED_FOLDERS)
+	{
+		WatchedFolder oldestWatchedFolder = m_watchedFolders.front();
+		m_watchedFolders.pop_front();
+
+		m_directoryMonitor->StopDirectoryMonitor(oldestWatchedFolder.monitorId);
+
+		// Changes to this folder will no longer be seen.
+		InvalidateFolderInternal(oldestWatchedFolder.path, true);
+	}
+}
+
+/* Returns -1 if the folder can't be watched. */
+int FolderSizeService::StartWatch(const std::wstring &path)
+{
+	WatchData_t *watchData = static_cast<WatchData_t *>(malloc(sizeof(WatchData_t)));
+
+	if (watchData == NULL)
+	{
+		return -1;
+	}
+
+	watchData->service = this;
+	StringCchCopy(watchData->path, SIZEOF_ARRAY(watchData->path), path.c_str());
+
+	return m_directoryMonitor->WatchDirectory(path.c_str(), FILE_NOTIFY_CHANGE_FILE_NAME |
+		FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE,
+		OnFolderAltered, TRUE, watchData);
+}
+
+bool FolderSizeService::IsFolderWatched(const std::wstring &path) const
+{
+	std::lock_guard<std::mutex> lock(m_watchMutex);
+
+	for (const auto &watchedFolder : m_watchedFolders)
+	{
+		if (IsSameOrDescendant(path, watchedFolder.path))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FolderSizeService::CacheFolderSize(const std::wstring &path, const FolderSize &folderSize,
+	const Calculation &calculation)
+{
+	if (!IsFolderWatched(path))
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+	if (IsInvalidatedSince(path, calculation.invalidationSequence))
+	{
+		return;
+	}
+
+	m_cache[path] = folderSize;
+}
+
+void FolderSizeService::InvalidateFolderInternal(const std::wstring &path, bool includeDescendants)
+{
+	std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+	RecordInvalidation(path, includeDescendants);
+
+	if (includeDescendants)
+	{
+		for (auto itr = m_cache.begin(); itr != m_cache.end();)
+		{
+			if (IsSameOrDescendant(itr->first, path))
+			{
+				itr = m_cache.erase(itr);
+			}
+			else
+			{
+				++itr;
+			}
+		}
+	}
+	else
+	{
+		m_cache.erase(path);
+	}
+
+	auto ancestor = GetParentPath(path);
+
+	while (ancestor)
+	{
+		m_cache.erase(*ancestor);
+		ancestor = GetParentPath(*ancestor);
+	}
+}
+
+/* Must be called with m_cacheMutex held. Invalidations only
+need to be recorded while there are calculations that they
+could affect. */
+void FolderSizeService::RecordInvalidation(const std::wstring &path, bool includeDescendants)
+{
+	if (m_runningCalculations.empty())
+	{
+		return;
+	}
+
+	m_invalidations.push_back({ m_nextInvalidationSequence++, path, includeDescendants });
+}
+
+/* Must be called with m_cacheMutex held. Only invalidations
+within the directory (which change its size) and those that
+cover one of its ancestors are relevant. A change elsewhere
+on the volume doesn't stop the directory from being
+cached. */
+bool FolderSizeService::IsInvalidatedSince(const std::wstring &path, unsigned int sequence) const
+{
+	for (const auto &invalidation : m_invalidations)
+	{
+		if (invalidation.sequence < sequence)
+		{
+			continue;
+		}
+
+		if (invalidation.path.empty() || IsSameOrDescendant(invalidation.path, path))
+		{
+			return true;
+		}
+
+		if (invalidation.includeDescendants && IsSameOrDescendant(path, invalidation.path))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FolderSizeService::FinishCalculation(const Calculation &calculation)
+{
+	std::lock_guard<std::mutex> lock(m_cacheMutex);
+
+	auto itr = m_runningCalculations.find(calculation.invalidationSequence);
+	assert(itr != m_runningCalculations.end());
+	m_runningCalculations.erase(itr);
+
+	// Invalidations made before the oldest remaining calculation
+	// started can't affect any of the calculations.
+	while (!m_invalidations.empty() && (m_runningCalculations.empty()
+		|| m_invalidations.front().sequence < *m_runningCalculations.begin()))
+	{
+		m_invalidations.pop_front();
+	}
+}
+
+void FolderSizeService::OnFolderAltered(const TCHAR *szFileName, DWORD dwAction, void *pData)
+{
+	WatchData_t *watchData = reinterpret_cast<WatchData_t *>(pData);
+
+	if (dwAction == DIRECTORY_MONITOR_ACTION_RESCAN)
+	{
+		// Notifications have been lost, so anything within the folder
+		// may have changed.
+		watchData->service->InvalidateFolderInternal(watchData->path, true);
+		return;
+	}
+
+	std::wstring path = NormalizePath(CombinePath(watchData->path, szFileName));
+
+	// If a directory was removed or renamed, anything cached beneath
+	// it is stale as well.
+	bool includeDescendants = (dwAction == FILE_ACTION_REMOVED || dwAction == FILE_ACTION_RENAMED_OLD_NAME);
+
+	watchData->service->InvalidateFolderInternal(path, includeDescendants);
+}
+
+std::wstring FolderSizeService::NormalizePath(const std::wstring &path)
+{
+	std::wstring normalizedPath = path;
+
+	if (!normalizedPath.empty())
+	{
+		CharLowerBuff(&normalizedPath[0], static_cast<DWORD>(normalizedPath.size()));
+	}
+
+	// Trailing separators are removed, except from drive roots (e.g.
+	// C:\).
+	while (normalizedPath.size() > 1 && normalizedPath.back() == '\\' &&
+		!(normalizedPath.size() == 3 && normalizedPath[1] == ':'))
+	{
+		normalizedPath.pop_back();
+	}
+
+	return normalizedPath;
+}
+
+std::wstring FolderSizeService::CombinePath(const std::wstring &directory, const TCHAR *name)
+{
+	if (!directory.empty() && directory.back() == '\\')
+	{
+		return directory + name;
+	}
+
+	return directory + _T("\\") + name;
+}
+
+boost::optional<std::wstring> FolderSizeService::GetParentPath(const std::wstring &path)
+{
+	auto separatorIndex = path.find_last_of('\\');
+
+	if (separatorIndex == std::wstring::npos || separatorIndex == path.size() - 1)
+	{
+		return boost::none;
+	}
+
+	return NormalizePath(path.substr(0, separatorIndex + 1));
+}
+
+bool FolderSizeService::IsSameOrDescendant(const std::wstring &path, const std::wstring &ancestor)
+{
+	if (path.size() < ancestor.size() || path.compare(0, ancestor.size(), ancestor) != 0)
+	{
+		return false;
+	}
+
+	return path.size() == ancestor.size() || ancestor.back() == '\\' || path[ancestor.size()] == '\\';
+}
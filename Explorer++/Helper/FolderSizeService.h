@@ -0,0 +1,214 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "iDirectoryMonitor.h"
+#include "Macros.h"
+#include <boost/optional.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/* Calculates the total size of folders in the background.
+
+Each directory in a tree is a separate task. Workers take
+tasks from the back of their own queue and, when that's
+empty, steal from the front of the other queues, so a
+single large tree is spread across all the workers.
+
+The size of every directory visited is cached. Each folder
+whose size is requested is watched (recursively) for
+changes, and any change invalidates the cached size of the
+directory it occurs in, along with the cached sizes of all
+of that directory's ancestors. Querying a tree that hasn't
+changed therefore doesn't touch the disk at all. Sizes are
+only cached for trees that can be watched.
+
+Reparse points (e.g. junctions) are counted as folders, but
+aren't followed, so that cycles can't occur.
+
+This class is thread-safe. */
+class FolderSizeService
+{
+public:
+
+	struct FolderSize
+	{
+		ULONGLONG size;
+		int numFolders;
+		int numFiles;
+	};
+
+	/* Invoked with the running totals while a calculation is
+	in progress, then once more (with complete set to true)
+	when it has finished. Calls for a single calculation are
+	never made concurrently, but they are made on one of the
+	service's worker threads (or, if the size is already
+	cached, on the calling thread, before
+	CalculateFolderSizeAsync() returns). */
+	typedef std::function<void(const FolderSize &folderSize, bool complete)> ResultCallback;
+
+	FolderSizeService(int numWorkers, IDirectoryMonitor *directoryMonitor);
+	~FolderSizeService();
+
+	void CalculateFolderSizeAsync(const std::wstring &path, ResultCallback callback);
+
+	/* Blocks until the size of the folder is known. This must
+	not be called from within a ResultCallback. Returns
+	boost::none if the service is destroyed before the
+	calculation finishes. */
+	boost::optional<FolderSize> CalculateFolderSize(const std::wstring &path);
+
+	boost::optional<FolderSize> GetCachedFolderSize(const std::wstring &path) const;
+
+	/* Discards the cached size of the specified folder, its
+	ancestors and its descendants. */
+	void InvalidateFolder(const std::wstring &path);
+
+	void ClearCache();
+
+private:
+
+	DISALLOW_COPY_AND_ASSIGN(FolderSizeService);
+
+	/* Once this limit is reached, a folder whose siblings are
+	already watched is covered by watching its parent instead.
+	If that's not possible, watched folders are released (and
+	the sizes cached for them discarded) in the order they
+	were added. */
+	static const size_t MAX_WATCHED_FOLDERS = 64;
+
+	static const ULONGLONG PROGRESS_INTERVAL_MS = 200;
+
+	struct Calculation
+	{
+		ResultCallback callback;
+		std::mutex callbackMutex;
+		bool complete;
+
+		/* The totals for every directory that's been
+		enumerated so far. */
+		std::atomic<ULONGLONG> size;
+		std::atomic<int> numFolders;
+		std::atomic<int> numFiles;
+
+		std::atomic<ULONGLONG> lastProgressTime;
+
+		/* The sequence number of the first invalidation
+		made after the calculation started. The size of a
+		directory is only cached if none of the invalidations
+		made since then affect it. */
+		unsigned int invalidationSequence;
+	};
+
+	/* Recorded for each invalidation made while a calculation
+	is running. An empty path covers every folder. */
+	struct Invalidation
+	{
+		unsigned int sequence;
+		std::wstring path;
+		bool includeDescendants;
+	};
+
+	struct DirectoryNode
+	{
+		std::wstring path;
+		std::shared_ptr<DirectoryNode> parent;
+		std::shared_ptr<Calculation> calculation;
+
+		/* The totals for this directory and each of its
+		subdirectories that have finished. */
+		std::atomic<ULONGLONG> size;
+		std::atomic<int> numFolders;
+		std::atomic<int> numFiles;
+
+		/* One for the enumeration of this directory, plus
+		one for each subdirectory that hasn't finished. */
+		std::atomic<int> pendingCount;
+	};
+
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<std::shared_ptr<DirectoryNode>> tasks;
+	};
+
+	struct WatchedFolder
+	{
+		std::wstring path;
+		int monitorId;
+	};
+
+	/* Owned (and freed) by the directory monitor. */
+	struct WatchData_t
+	{
+		FolderSizeService *service;
+		TCHAR path[MAX_PATH];
+	};
+
+	static void OnFolderAltered(const TCHAR *szFileName, DWORD dwAction, void *pData);
+
+	void WorkerThread(int workerIndex);
+	void PushTask(int workerIndex, std::shared_ptr<DirectoryNode> task);
+	bool PopTask(int workerIndex, std::shared_ptr<DirectoryNode> &task);
+	void ProcessDirectory(int workerIndex, const std::shared_ptr<DirectoryNode> &node);
+	void CompleteNode(std::shared_ptr<DirectoryNode> node);
+	void ReportProgress(Calculation &calculation);
+	static std::shared_ptr<DirectoryNode> CreateNode(const std::wstring &path,
+		std::shared_ptr<DirectoryNode> parent, std::shared_ptr<Calculation> calculation);
+
+	void WatchFolder(const std::wstring &path);
+	int StartWatch(const std::wstring &path);
+	bool IsFolderWatched(const std::wstring &path) const;
+	void CacheFolderSize(const std::wstring &path, const FolderSize &folderSize, const Calculation &calculation);
+	void InvalidateFolderInternal(const std::wstring &path, bool includeDescendants);
+	void RecordInvalidation(const std::wstring &path, bool includeDescendants);
+	bool IsInvalidatedSince(const std::wstring &path, unsigned int sequence) const;
+	void FinishCalculation(const Calculation &calculation);
+
+	static std::wstring NormalizePath(const std::wstring &path);
+	static std::wstring CombinePath(const std::wstring &directory, const TCHAR *name);
+	static bool IsSameOrDescendant(const std::wstring &path, const std::wstring &ancestor);
+	static boost::optional<std::wstring> GetParentPath(const std::wstring &path);
+
+	IDirectoryMonitor *m_directoryMonitor;
+
+	std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+	std::vector<std::thread> m_workers;
+	std::atomic<unsigned int> m_nextQueue;
+
+	std::mutex m_workMutex;
+	std::condition_variable m_workAvailable;
+	std::atomic<int> m_numQueuedTasks;
+
+	/* Checked before each task is taken, so that the service
+	can be destroyed without waiting for every outstanding
+	directory to be enumerated. */
+	std::atomic<bool> m_stop;
+
+	mutable std::mutex m_watchMutex;
+	std::list<WatchedFolder> m_watchedFolders;
+
+	mutable std::mutex m_cacheMutex;
+	std::unordered_map<std::wstring, FolderSize> m_cache;
+
+	/* The invalidations made since the oldest running
+	calculation started, oldest first. */
+	std::deque<Invalidation> m_invalidations;
+	unsigned int m_nextInvalidationSequence;
+
+	/* The invalidation sequence number of each running
+	calculation. */
+	std::multiset<unsigned int> m_runningCalculations;
+};
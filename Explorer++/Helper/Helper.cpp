@@ -25,6 +25,9 @@ BOOL GetFileVersionValue(const TCHAR *szFullFileName, VersionSubBlockType_t subB
 BOOL GetStringTableValue(void *pBlock, LangAndCodePage *plcp, UINT nItems,
 	const TCHAR *szVersionInfo, TCHAR *szVersionBuffer, UINT cchMax);
 
+typedef HRESULT (WINAPI *WMCREATEEDITOR_PROC)(IWMMetadataEditor **);
+WMCREATEEDITOR_PROC GetWMCreateEditorProc();
+
 BOOL CreateFileTimeString(const FILETIME *utcFileTime,
 	TCHAR *szBuffer, size_t cchMax, BOOL bFriendlyDate)
 {
@@ -520,6 +523,54 @@ BOOL GetVersionInfoString(const TCHAR *szFullFileName, const TCHAR *szVersionInf
 		NULL, NULL, NULL, szVersionInfo, szVersionBuffer, cchMax);
 }
 
+/* Retrieves several values from the version information string
+table, reading the version information only once. An entry in
+the output is left empty if the corresponding value couldn't be
+found. */
+BOOL GetVersionInfoStrings(const TCHAR *szFullFileName, const std::vector<const TCHAR *> &versionInfoNames,
+	std::vector<boost::optional<std::wstring>> &output)
+{
+	output.assign(versionInfoNames.size(), boost::none);
+
+	DWORD dwLen = GetFileVersionInfoSize(szFullFileName, NULL);
+
+	if(dwLen == 0)
+	{
+		return FALSE;
+	}
+
+	std::vector<BYTE> block(dwLen);
+	BOOL bRet = GetFileVersionInfo(szFullFileName, NULL, dwLen, block.data());
+
+	if(!bRet)
+	{
+		return FALSE;
+	}
+
+	LangAndCodePage *plcp = NULL;
+	UINT uLen;
+	bRet = VerQueryValue(block.data(), _T("\\VarFileInfo\\Translation"), reinterpret_cast<LPVOID *>(&plcp), &uLen);
+
+	if(!bRet || (uLen < sizeof(LangAndCodePage)))
+	{
+		return FALSE;
+	}
+
+	for(size_t i = 0; i < versionInfoNames.size(); i++)
+	{
+		TCHAR szVersionBuffer[512];
+		bRet = GetStringTableValue(block.data(), plcp, uLen / sizeof(LangAndCodePage),
+			versionInfoNames[i], szVersionBuffer, SIZEOF_ARRAY(szVersionBuffer));
+
+		if(bRet)
+		{
+			output[i] = szVersionBuffer;
+		}
+	}
+
+	return TRUE;
+}
+
 BOOL GetFileVersionValue(const TCHAR *szFullFileName, VersionSubBlockType_t subBlockType,
 	WORD *pwLanguage, DWORD *pdwProductVersionLS, DWORD *pdwProductVersionMS,
 	const TCHAR *szVersionInfo, TCHAR *szVersionBuffer, UINT cchMax)
@@ -642,66 +693,93 @@ void GetCPUBrandString(char *pszCPUBrand,UINT cchBuf)
 	StringCchCopyA(pszCPUBrand,cchBuf,szCPUBrand);
 }
 
-HRESULT GetMediaMetadata(const TCHAR *szFileName,const TCHAR *szAttribute,BYTE **pszOutput)
+/* wmvcore.dll is only loaded once, and is then kept loaded for
+the lifetime of the process. */
+WMCREATEEDITOR_PROC GetWMCreateEditorProc()
+{
+	static WMCREATEEDITOR_PROC pWMCreateEditor = [] {
+		HMODULE hWMVCore = LoadLibrary(_T("wmvcore.dll"));
+
+		if(hWMVCore == NULL)
+		{
+			return static_cast<WMCREATEEDITOR_PROC>(NULL);
+		}
+
+		return reinterpret_cast<WMCREATEEDITOR_PROC>(GetProcAddress(hWMVCore,"WMCreateEditor"));
+	}();
+
+	return pWMCreateEditor;
+}
+
+/* Retrieves each of the specified attributes, opening the file
+only once. An entry in the output is left empty if the
+corresponding attribute couldn't be retrieved. */
+HRESULT GetMediaMetadata(const TCHAR *szFileName,const std::vector<const TCHAR *> &attributes,
+	std::vector<boost::optional<std::vector<BYTE>>> &output)
 {
-	typedef HRESULT (WINAPI *WMCREATEEDITOR_PROC)(IWMMetadataEditor **);
-	WMCREATEEDITOR_PROC pWMCreateEditor = NULL;
-	HMODULE hWMVCore;
+	output.assign(attributes.size(),boost::none);
+
+	WMCREATEEDITOR_PROC pWMCreateEditor = GetWMCreateEditorProc();
+
+	if(pWMCreateEditor == NULL)
+	{
+		return E_FAIL;
+	}
+
 	IWMMetadataEditor *pEditor = NULL;
-	IWMHeaderInfo *pWMHeaderInfo = NULL;
-	HRESULT hr = E_FAIL;
+	HRESULT hr = pWMCreateEditor(&pEditor);
+
+	if(FAILED(hr))
+	{
+		return hr;
+	}
 
-	hWMVCore = LoadLibrary(_T("wmvcore.dll"));
+	hr = pEditor->Open(szFileName);
 
-	if(hWMVCore != NULL)
+	if(SUCCEEDED(hr))
 	{
-		pWMCreateEditor = (WMCREATEEDITOR_PROC)GetProcAddress(hWMVCore,"WMCreateEditor");
+		IWMHeaderInfo *pWMHeaderInfo = NULL;
+		hr = pEditor->QueryInterface(IID_PPV_ARGS(&pWMHeaderInfo));
 
-		if(pWMCreateEditor != NULL)
+		if(SUCCEEDED(hr))
 		{
-			hr = pWMCreateEditor(&pEditor);
-
-			if(SUCCEEDED(hr))
+			for(size_t i = 0;i < attributes.size();i++)
 			{
-				hr = pEditor->Open(szFileName);
-
-				if(SUCCEEDED(hr))
-				{
-					hr = pEditor->QueryInterface(IID_PPV_ARGS(&pWMHeaderInfo));
+				WMT_ATTR_DATATYPE Type;
+				WORD cbLength;
 
-					if(SUCCEEDED(hr))
-					{
-						WORD wStreamNum;
-						WMT_ATTR_DATATYPE Type;
-						WORD cbLength;
+				/* Any stream. Should be zero for MP3 files. */
+				WORD wStreamNum = 0;
 
-						/* Any stream. Should be zero for MP3 files. */
-						wStreamNum = 0;
+				HRESULT hrAttribute = pWMHeaderInfo->GetAttributeByName(&wStreamNum,attributes[i],&Type,NULL,&cbLength);
 
-						hr = pWMHeaderInfo->GetAttributeByName(&wStreamNum,szAttribute,&Type,NULL,&cbLength);
+				if(FAILED(hrAttribute))
+				{
+					continue;
+				}
 
-						if(SUCCEEDED(hr))
-						{
-							*pszOutput = (BYTE *)malloc(cbLength);
+				std::vector<BYTE> data(cbLength);
 
-							if(*pszOutput != NULL)
-							{
-								hr = pWMHeaderInfo->GetAttributeByName(&wStreamNum,szAttribute,&Type,
-									*pszOutput,&cbLength);
-							}
-						}
+				if(cbLength > 0)
+				{
+					hrAttribute = pWMHeaderInfo->GetAttributeByName(&wStreamNum,attributes[i],&Type,
+						data.data(),&cbLength);
 
-						pWMHeaderInfo->Release();
+					if(FAILED(hrAttribute))
+					{
+						continue;
 					}
 				}
 
-				pEditor->Release();
+				output[i] = std::move(data);
 			}
-		}
 
-		FreeLibrary(hWMVCore);
+			pWMHeaderInfo->Release();
+		}
 	}
 
+	pEditor->Release();
+
 	return hr;
 }
 
@@ -7,8 +7,10 @@
 #include <ShObjIdl.h>
 #include <windows.h>
 #include <winioctl.h>
+#include <boost/optional.hpp>
 #include <list>
 #include <string>
+#include <vector>
 
 struct LangAndCodePage
 {
@@ -35,11 +37,12 @@ HRESULT			BuildFileAttributeString(DWORD dwFileAttributes, TCHAR *szOutput, DWOR
 BOOL			GetFileOwner(const TCHAR *szFile,TCHAR *szOwner,size_t cchMax);
 DWORD			GetNumFileHardLinks(const TCHAR *lpszFileName);
 BOOL			ReadImageProperty(const TCHAR *lpszImage, PROPID propId, TCHAR *szProperty, int cchMax);
-HRESULT			GetMediaMetadata(const TCHAR *szFileName, const TCHAR *szAttribute, BYTE **pszOutput);
+HRESULT			GetMediaMetadata(const TCHAR *szFileName, const std::vector<const TCHAR *> &attributes, std::vector<boost::optional<std::vector<BYTE>>> &output);
 BOOL			IsImage(const TCHAR *FileName);
 BOOL			GetFileProductVersion(const TCHAR *szFullFileName, DWORD *pdwProductVersionLS, DWORD *pdwProductVersionMS);
 BOOL			GetFileLanguage(const TCHAR *szFullFileName, WORD *pwLanguage);
 BOOL			GetVersionInfoString(const TCHAR *szFullFileName, const TCHAR *szVersionInfo, TCHAR *szVersionBuffer, UINT cchMax);
+BOOL			GetVersionInfoStrings(const TCHAR *szFullFileName, const std::vector<const TCHAR *> &versionInfoNames, std::vector<boost::optional<std::wstring>> &output);
 
 /* Ownership and access. */
 BOOL			CheckGroupMembership(GroupType_t GroupType);
@@ -0,0 +1,329 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ItemTaskScheduler.h"
+#include <algorithm>
+
+ItemTaskScheduler::ItemTaskScheduler(int numWorkers, std::function<void()> threadStarted,
+	std::function<void()> threadStopping) :
+	m_maxWorkers(numWorkers > 0 ? numWorkers : (std::max)(static_cast<int>(std::thread::hardware_concurrency()), 1)),
+	m_threadStarted(threadStarted),
+	m_threadStopping(threadStopping),
+	m_sequenceCounter(0),
+	m_peakQueuedTasks(0),
+	m_numTasksRun(0),
+	m_numIdleWorkers(0),
+	m_stop(false)
+{
+
+}
+
+ItemTaskScheduler::~ItemTaskScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_stop = true;
+
+		// Queued tasks are destroyed without being run.
+		m_queue.clear();
+		m_ownerQueues.clear();
+		m_queuedTasks.clear();
+	}
+
+	m_taskAvailable.notify_all();
+
+	for (auto &worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+bool ItemTaskScheduler::QueueTaskInternal(const OwnedTaskKey &key, std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (m_queuedTasks.count(key) > 0 || m_runningTasks.count(key) > 0)
+		{
+			return false;
+		}
+
+		unsigned long long sequence = m_sequenceCounter++;
+
+		QueuedTask queuedTask;
+		queuedTask.key = key;
+		queuedTask.task = std::move(task);
+		m_queue.insert({ sequence, std::move(queuedTask) });
+		m_ownerQueues[key.ownerId].insert(sequence);
+
+		m_queuedTasks.insert({ key, sequence });
+
+		m_peakQueuedTasks = (std::max)(m_peakQueuedTasks, m_queue.size());
+
+		StartWorkerIfNeeded();
+	}
+
+	m_taskAvailable.notify_one();
+
+	return true;
+}
+
+/* Must be called with m_mutex held. */
+void ItemTaskScheduler::StartWorkerIfNeeded()
+{
+	if (static_cast<int>(m_workers.size()) >= m_maxWorkers)
+	{
+		return;
+	}
+
+	if (static_cast<int>(m_queue.size()) <= m_numIdleWorkers)
+	{
+		return;
+	}
+
+	m_workers.emplace_back(&ItemTaskScheduler::WorkerThread, this);
+}
+
+void ItemTaskScheduler::WorkerThread()
+{
+	if (m_threadStarted)
+	{
+		m_threadStarted();
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true)
+	{
+		m_numIdleWorkers++;
+		m_taskAvailable.wait(lock, [this] {
+			return m_stop || !m_queue.empty();
+		});
+		m_numIdleWorkers--;
+
+		if (m_stop)
+		{
+			break;
+		}
+
+		unsigned long long sequence = GetNextTaskSequence();
+		auto itr = m_queue.find(sequence);
+		QueuedTask queuedTask = std::move(itr->second);
+		RemoveQueuedTask(itr);
+
+		m_runningTasks[queuedTask.key] = sequence;
+
+		lock.unlock();
+		queuedTask.task();
+		queuedTask.task = nullptr;
+		lock.lock();
+
+		m_numTasksRun++;
+
+		auto runningItr = m_runningTasks.find(queuedTask.key);
+
+		if (runningItr != m_runningTasks.end() && runningItr->second == sequence)
+		{
+			m_runningTasks.erase(runningItr);
+		}
+	}
+
+	lock.unlock();
+
+	if (m_threadStopping)
+	{
+		m_threadStopping();
+	}
+}
+
+/* Must be called with m_mutex held and at least one task
+queued. The newest task from the priority owner is run first,
+falling back to the newest task overall. */
+unsigned long long ItemTaskScheduler::GetNextTaskSequence() const
+{
+	if (m_priorityOwner)
+	{
+		auto ownerItr = m_ownerQueues.find(*m_priorityOwner);
+
+		if (ownerItr != m_ownerQueues.end())
+		{
+			return *ownerItr->second.rbegin();
+		}
+	}
+
+	return m_queue.rbegin()->first;
+}
+
+/* Must be called with m_mutex held. */
+void ItemTaskScheduler::RemoveQueuedTask(std::map<unsigned long long, QueuedTask>::iterator itr)
+{
+	auto ownerItr = m_ownerQueues.find(itr->second.key.ownerId);
+	ownerItr->second.erase(itr->first);
+
+	if (ownerItr->second.empty())
+	{
+		m_ownerQueues.erase(ownerItr);
+	}
+
+	m_queuedTasks.erase(itr->second.key);
+	m_queue.erase(itr);
+}
+
+std::vector<ItemTaskScheduler::TaskKey> ItemTaskScheduler::CancelTasks(
+	std::function<bool(const TaskKey &key)> shouldCancel)
+{
+	return CancelTasks(DEFAULT_OWNER, shouldCancel);
+}
+
+std::vector<ItemTaskScheduler::TaskKey> ItemTaskScheduler::CancelTasks(int ownerId,
+	std::function<bool(const TaskKey &key)> shouldCancel)
+{
+	return CancelTasksInternal([ownerId, &shouldCancel] (const OwnedTaskKey &ownedKey) {
+		return ownedKey.ownerId == ownerId && shouldCancel(ownedKey.key);
+	});
+}
+
+std::vector<ItemTaskScheduler::TaskKey> ItemTaskScheduler::CancelTasksInternal(
+	std::function<bool(const OwnedTaskKey &key)> shouldCancel)
+{
+	std::vector<std::pair<OwnedTaskKey, unsigned long long>> pendingTasks;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		pendingTasks.reserve(m_queuedTasks.size() + m_runningTasks.size());
+		pendingTasks.insert(pendingTasks.end(), m_queuedTasks.begin(), m_queuedTasks.end());
+		pendingTasks.insert(pendingTasks.end(), m_runningTasks.begin(), m_runningTasks.end());
+	}
+
+	std::vector<std::pair<OwnedTaskKey, unsigned long long>> matchingTasks;
+
+	for (const auto &pendingTask : pendingTasks)
+	{
+		if (shouldCancel(pendingTask.first))
+		{
+			matchingTasks.push_back(pendingTask);
+		}
+	}
+
+	std::vector<TaskKey> cancelledTasks;
+
+	// Tasks may have started or finished in the meantime, so each
+	// one is looked up again by its sequence number.
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (const auto &matchingTask : matchingTasks)
+	{
+		auto itr = m_queue.find(matchingTask.second);
+
+		if (itr != m_queue.end())
+		{
+			cancelledTasks.push_back(itr->second.key.key);
+			RemoveQueuedTask(itr);
+			continue;
+		}
+
+		auto runningItr = m_runningTasks.find(matchingTask.first);
+
+		if (runningItr != m_runningTasks.end() && runningItr->second == matchingTask.second)
+		{
+			m_runningTasks.erase(runningItr);
+		}
+	}
+
+	return cancelledTasks;
+}
+
+std::vector<ItemTaskScheduler::TaskKey> ItemTaskScheduler::CancelAllTasks()
+{
+	return CancelAllTasks(DEFAULT_OWNER);
+}
+
+std::vector<ItemTaskScheduler::TaskKey> ItemTaskScheduler::CancelAllTasks(int ownerId)
+{
+	std::vector<TaskKey> cancelledTasks;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto ownerItr = m_ownerQueues.find(ownerId);
+
+	if (ownerItr != m_ownerQueues.end())
+	{
+		// Copied, since the set is removed along with the last
+		// task.
+		std::set<unsigned long long> sequences = ownerItr->second;
+		cancelledTasks.reserve(sequences.size());
+
+		for (unsigned long long sequence : sequences)
+		{
+			auto itr = m_queue.find(sequence);
+			cancelledTasks.push_back(itr->second.key.key);
+			RemoveQueuedTask(itr);
+		}
+	}
+
+	for (auto itr = m_runningTasks.begin(); itr != m_runningTasks.end();)
+	{
+		if (itr->first.ownerId == ownerId)
+		{
+			itr = m_runningTasks.erase(itr);
+		}
+		else
+		{
+			++itr;
+		}
+	}
+
+	return cancelledTasks;
+}
+
+bool ItemTaskScheduler::IsTaskPending(const TaskKey &key) const
+{
+	return IsTaskPending(DEFAULT_OWNER, key);
+}
+
+bool ItemTaskScheduler::IsTaskPending(int ownerId, const TaskKey &key) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	OwnedTaskKey ownedKey = { ownerId, key };
+	return m_queuedTasks.count(ownedKey) > 0 || m_runningTasks.count(ownedKey) > 0;
+}
+
+void ItemTaskScheduler::SetPriorityOwner(int ownerId)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_priorityOwner = ownerId;
+}
+
+void ItemTaskScheduler::ClearPriorityOwner()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_priorityOwner.reset();
+}
+
+size_t ItemTaskScheduler::GetNumQueuedTasks() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return m_queue.size();
+}
+
+ItemTaskScheduler::Stats ItemTaskScheduler::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Stats stats;
+	stats.numWorkers = static_cast<int>(m_workers.size());
+	stats.numIdleWorkers = m_numIdleWorkers;
+	stats.numQueuedTasks = m_queue.size();
+	stats.peakQueuedTasks = m_peakQueuedTasks;
+	stats.numTasksRun = m_numTasksRun;
+
+	return stats;
+}
@@ -0,0 +1,204 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "Macros.h"
+#include <boost/optional.hpp>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/* Runs background tasks (e.g. column text, icon and thumbnail
+lookups) for the items shown in one or more views.
+
+Each task is identified by an item and a task type (for
+example, a column). A task won't be queued if a task with the
+same key is already queued or running, so an item that's
+repainted several times before its result arrives only
+results in a single lookup.
+
+Tasks are requested as items are painted, so the most
+recently queued tasks are the ones for the items currently in
+view. Tasks are therefore run newest first. Once the view has
+scrolled, CancelTasks() can be used to drop the tasks for
+items that are no longer visible.
+
+A single scheduler can be shared between several views (e.g.
+each of the tabs), with each view queuing its tasks under its
+own owner ID. Keys only need to be unique within an owner, and
+the owner versions of the methods below only affect that
+owner's tasks. Tasks from the priority owner (typically the
+view that's currently shown) are run before anyone else's.
+
+Workers are started as needed, up to the specified number. */
+class ItemTaskScheduler
+{
+public:
+
+	struct TaskKey
+	{
+		int itemId;
+		int taskType;
+
+		bool operator==(const TaskKey &other) const
+		{
+			return itemId == other.itemId && taskType == other.taskType;
+		}
+	};
+
+	struct Stats
+	{
+		int numWorkers;
+		int numIdleWorkers;
+		size_t numQueuedTasks;
+		size_t peakQueuedTasks;
+		unsigned long long numTasksRun;
+	};
+
+	/* Used by the methods that don't take an owner. */
+	static const int DEFAULT_OWNER = 0;
+
+	/* If numWorkers is 0, one worker is used per core. The
+	thread callbacks (which may be empty) are run on each
+	worker thread when it starts and just before it exits. */
+	ItemTaskScheduler(int numWorkers, std::function<void()> threadStarted = nullptr,
+		std::function<void()> threadStopping = nullptr);
+	~ItemTaskScheduler();
+
+	/* Returns boost::none (and doesn't queue anything) if a
+	task with the same key is already queued or running. If
+	the task is cancelled before it runs, the returned future
+	will hold a broken_promise error. */
+	template <typename F>
+	auto QueueTask(const TaskKey &key, F &&f) -> boost::optional<std::future<decltype(f())>>
+	{
+		return QueueTask(DEFAULT_OWNER, key, std::forward<F>(f));
+	}
+
+	template <typename F>
+	auto QueueTask(int ownerId, const TaskKey &key, F &&f) -> boost::optional<std::future<decltype(f())>>
+	{
+		typedef decltype(f()) ResultType;
+
+		auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<F>(f));
+		std::future<ResultType> future = task->get_future();
+
+		bool queued = QueueTaskInternal({ ownerId, key }, [task] {
+			(*task)();
+		});
+
+		if (!queued)
+		{
+			return boost::none;
+		}
+
+		return future;
+	}
+
+	/* Removes each queued task for which shouldCancel returns
+	true, and returns the keys of the tasks removed. Matching tasks that are already running will finish,
+	but no longer block a task with the same key from being
+	queued again. The predicate is called without any locks
+	held, so it's safe for it to call back into the UI (which
+	may queue further tasks). */
+	std::vector<TaskKey> CancelTasks(std::function<bool(const TaskKey &key)> shouldCancel);
+	std::vector<TaskKey> CancelTasks(int ownerId, std::function<bool(const TaskKey &key)> shouldCancel);
+
+	/* Removes every queued task. As above, running tasks will
+	finish, but no longer block their keys. */
+	std::vector<TaskKey> CancelAllTasks();
+	std::vector<TaskKey> CancelAllTasks(int ownerId);
+
+	bool IsTaskPending(const TaskKey &key) const;
+	bool IsTaskPending(int ownerId, const TaskKey &key) const;
+
+	/* Queued tasks from this owner are run (newest first) before
+	those of any other owner. */
+	void SetPriorityOwner(int ownerId);
+	void ClearPriorityOwner();
+
+	/* Returns the number of queued tasks, across all owners. */
+	size_t GetNumQueuedTasks() const;
+
+	Stats GetStats() const;
+
+private:
+
+	DISALLOW_COPY_AND_ASSIGN(ItemTaskScheduler);
+
+	struct OwnedTaskKey
+	{
+		int ownerId;
+		TaskKey key;
+
+		bool operator==(const OwnedTaskKey &other) const
+		{
+			return ownerId == other.ownerId && key == other.key;
+		}
+	};
+
+	struct OwnedTaskKeyHash
+	{
+		size_t operator()(const OwnedTaskKey &ownedKey) const
+		{
+			size_t keyHash = std::hash<unsigned long long>()((static_cast<unsigned long long>(static_cast<unsigned int>(ownedKey.key.itemId)) << 32)
+				| static_cast<unsigned int>(ownedKey.key.taskType));
+			return keyHash ^ (std::hash<int>()(ownedKey.ownerId) + 0x9e3779b9 + (keyHash << 6) + (keyHash >> 2));
+		}
+	};
+
+	struct QueuedTask
+	{
+		OwnedTaskKey key;
+		std::function<void()> task;
+	};
+
+	typedef std::unordered_map<OwnedTaskKey, unsigned long long, OwnedTaskKeyHash> TaskSequenceMap;
+
+	bool QueueTaskInternal(const OwnedTaskKey &key, std::function<void()> task);
+	void StartWorkerIfNeeded();
+	void WorkerThread();
+	unsigned long long GetNextTaskSequence() const;
+	void RemoveQueuedTask(std::map<unsigned long long, QueuedTask>::iterator itr);
+	std::vector<TaskKey> CancelTasksInternal(std::function<bool(const OwnedTaskKey &key)> shouldCancel);
+
+	const int m_maxWorkers;
+	const std::function<void()> m_threadStarted;
+	const std::function<void()> m_threadStopping;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_taskAvailable;
+
+	/* Keyed by sequence number, so that the newest task is
+	always at the end. */
+	std::map<unsigned long long, QueuedTask> m_queue;
+
+	/* The sequence numbers of the tasks in m_queue, grouped by
+	owner. Owners without any queued tasks have no entry. */
+	std::unordered_map<int, std::set<unsigned long long>> m_ownerQueues;
+
+	/* The sequence number of each queued or running task. A
+	running task only removes its entry when it finishes if
+	the entry hasn't since been replaced. */
+	TaskSequenceMap m_queuedTasks;
+	TaskSequenceMap m_runningTasks;
+
+	unsigned long long m_sequenceCounter;
+	boost::optional<int> m_priorityOwner;
+
+	size_t m_peakQueuedTasks;
+	unsigned long long m_numTasksRun;
+
+	std::vector<std::thread> m_workers;
+	int m_numIdleWorkers;
+	bool m_stop;
+};
@@ -0,0 +1,123 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "Macros.h"
+#include <atomic>
+#include <vector>
+
+/* A lock-free queue with any number of producers and a single
+consumer.
+
+Producers push items onto a linked list with a single
+compare-and-swap. The consumer takes the entire list in one
+go, rather than removing items one at a time, which suits
+the case where results from background threads are applied
+in batches on the UI thread. */
+template <typename T>
+class MPSCQueue
+{
+public:
+
+	MPSCQueue() :
+		m_head(nullptr)
+	{
+
+	}
+
+	~MPSCQueue()
+	{
+		DeleteNodes(m_head.exchange(nullptr));
+	}
+
+	/* May be called from any thread. Returns true if the queue
+	was empty before the item was added. */
+	bool Push(T value)
+	{
+		Node *node = new Node(std::move(value));
+		Node *head = m_head.load(std::memory_order_relaxed);
+
+		do
+		{
+			node->next = head;
+		} while (!m_head.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+
+		return head == nullptr;
+	}
+
+	/* Must only be called from the consumer thread. Items are
+	returned in the order they were pushed (for any single
+	producer). */
+	std::vector<T> PopAll()
+	{
+		Node *head = m_head.exchange(nullptr, std::memory_order_acquire);
+
+		size_t numItems = 0;
+
+		for (Node *node = head; node != nullptr; node = node->next)
+		{
+			numItems++;
+		}
+
+		std::vector<T> items;
+		items.reserve(numItems);
+
+		// The list is in reverse order, since each item is pushed
+		// onto the front.
+		Node *reversed = nullptr;
+
+		while (head != nullptr)
+		{
+			Node *next = head->next;
+			head->next = reversed;
+			reversed = head;
+			head = next;
+		}
+
+		while (reversed != nullptr)
+		{
+			Node *next = reversed->next;
+			items.push_back(std::move(reversed->value));
+			delete reversed;
+			reversed = next;
+		}
+
+		return items;
+	}
+
+	bool IsEmpty() const
+	{
+		return m_head.load(std::memory_order_acquire) == nullptr;
+	}
+
+private:
+
+	DISALLOW_COPY_AND_ASSIGN(MPSCQueue);
+
+	struct Node
+	{
+		explicit Node(T value) :
+			value(std::move(value)),
+			next(nullptr)
+		{
+
+		}
+
+		T value;
+		Node *next;
+	};
+
+	static void DeleteNodes(Node *node)
+	{
+		while (node != nullptr)
+		{
+			Node *next = node->next;
+			delete node;
+			node = next;
+		}
+	}
+
+	std::atomic<Node *> m_head;
+};
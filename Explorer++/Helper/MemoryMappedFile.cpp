@@ -0,0 +1,63 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "MemoryMappedFile.h"
+
+std::unique_ptr<MemoryMappedFile> MemoryMappedFile::Open(const std::wstring &path, size_t size)
+{
+	if (size == 0)
+	{
+		return nullptr;
+	}
+
+	HFilePtr file = CreateFilePtr(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+		OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (!file)
+	{
+		return nullptr;
+	}
+
+	// If the file is smaller than the requested size, the
+	// mapping will extend it.
+	ULARGE_INTEGER mappingSize;
+	mappingSize.QuadPart = size;
+	HFileMappingPtr mapping = CreateFileMappingPtr(file.get(), nullptr, PAGE_READWRITE,
+		mappingSize.HighPart, mappingSize.LowPart, nullptr);
+
+	if (!mapping)
+	{
+		return nullptr;
+	}
+
+	MappedViewPtr view = MapViewOfFilePtr(mapping.get(), FILE_MAP_ALL_ACCESS, 0, 0, size);
+
+	if (!view)
+	{
+		return nullptr;
+	}
+
+	return std::unique_ptr<MemoryMappedFile>(new MemoryMappedFile(std::move(file),
+		std::move(mapping), std::move(view), size));
+}
+
+MemoryMappedFile::MemoryMappedFile(HFilePtr file, HFileMappingPtr mapping, MappedViewPtr view, size_t size) :
+	m_file(std::move(file)),
+	m_mapping(std::move(mapping)),
+	m_view(std::move(view)),
+	m_size(size)
+{
+
+}
+
+void *MemoryMappedFile::GetData() const
+{
+	return m_view.get();
+}
+
+size_t MemoryMappedFile::GetSize() const
+{
+	return m_size;
+}
@@ -0,0 +1,39 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "FileWrappers.h"
+#include "Macros.h"
+#include <memory>
+#include <string>
+
+/* A file that's mapped into memory in its entirety, for both
+reading and writing. The file is created, or extended, to
+the requested size if necessary. Changes are written back
+to the file by the system. */
+class MemoryMappedFile
+{
+public:
+
+	/* Returns nullptr if the file couldn't be opened or
+	mapped. */
+	static std::unique_ptr<MemoryMappedFile> Open(const std::wstring &path, size_t size);
+
+	void *GetData() const;
+	size_t GetSize() const;
+
+private:
+
+	DISALLOW_COPY_AND_ASSIGN(MemoryMappedFile);
+
+	MemoryMappedFile(HFilePtr file, HFileMappingPtr mapping, MappedViewPtr view, size_t size);
+
+	/* Declared in this order so that the view is unmapped
+	before the handles are closed. */
+	HFilePtr m_file;
+	HFileMappingPtr m_mapping;
+	MappedViewPtr m_view;
+	size_t m_size;
+};
@@ -0,0 +1,404 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "MetadataCache.h"
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <algorithm>
+#include <cwctype>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace
+{
+	/* Strings are limited to this length when being read back in,
+	so that a corrupt file can't cause a huge allocation. */
+	const std::uint32_t MAX_STRING_LENGTH = 32768;
+
+	template <typename T>
+	void WriteValue(std::ostream &outputStream, T value)
+	{
+		outputStream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+	}
+
+	template <typename T>
+	bool ReadValue(std::istream &inputStream, T &value)
+	{
+		inputStream.read(reinterpret_cast<char *>(&value), sizeof(value));
+		return static_cast<bool>(inputStream);
+	}
+
+	/* Strings are written as UTF-16 code units, preceded by their
+	length. */
+	void WriteString(std::ostream &outputStream, const std::wstring &str)
+	{
+		WriteValue(outputStream, static_cast<std::uint32_t>(str.size()));
+
+		for (wchar_t c : str)
+		{
+			WriteValue(outputStream, static_cast<std::uint16_t>(c));
+		}
+	}
+
+	bool ReadString(std::istream &inputStream, std::wstring &str)
+	{
+		std::uint32_t length;
+
+		if (!ReadValue(inputStream, length) || length > MAX_STRING_LENGTH)
+		{
+			return false;
+		}
+
+		std::vector<std::uint16_t> codeUnits(length);
+		inputStream.read(reinterpret_cast<char *>(codeUnits.data()), length * sizeof(std::uint16_t));
+
+		if (!inputStream)
+		{
+			return false;
+		}
+
+		str.assign(codeUnits.begin(), codeUnits.end());
+
+		return true;
+	}
+}
+
+MetadataCache::MetadataCache(const boost::filesystem::path &cacheFile, size_t maxEntries) :
+	m_cacheFile(cacheFile),
+	m_maxEntries(maxEntries),
+	m_loaded(false),
+	m_modified(false),
+	m_hits(0),
+	m_misses(0)
+{
+
+}
+
+boost::optional<MetadataCache::Value> MetadataCache::Lookup(const FileKey &file, unsigned int propertyId)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	EnsureLoaded();
+
+	auto &keyIndex = m_entries.get<1>();
+	auto itr = keyIndex.find(boost::make_tuple(NormalizePath(file.path), propertyId));
+
+	if (itr == keyIndex.end())
+	{
+		m_misses++;
+		return boost::none;
+	}
+
+	if (itr->fileSize != file.fileSize || itr->lastWriteTime != file.lastWriteTime)
+	{
+		// The file has changed since the value was retrieved, so
+		// the value is of no further use.
+		if (itr->persist)
+		{
+			m_modified = true;
+		}
+
+		keyIndex.erase(itr);
+		m_misses++;
+
+		return boost::none;
+	}
+
+	m_entries.relocate(m_entries.begin(), m_entries.project<0>(itr));
+	m_hits++;
+
+	return itr->value;
+}
+
+void MetadataCache::Insert(const FileKey &file, unsigned int propertyId, const Value &value, bool persist)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	EnsureLoaded();
+
+	AddEntry({ NormalizePath(file.path), propertyId, file.fileSize, file.lastWriteTime, value, persist });
+
+	if (persist)
+	{
+		m_modified = true;
+	}
+}
+
+/* Replaces any existing entry with the same key, and moves the
+entry to the front of the list. */
+void MetadataCache::AddEntry(Entry &&entry)
+{
+	auto &keyIndex = m_entries.get<1>();
+	auto itr = keyIndex.find(boost::make_tuple(entry.path, entry.propertyId));
+
+	if (itr != keyIndex.end())
+	{
+		keyIndex.replace(itr, std::move(entry));
+		m_entries.relocate(m_entries.begin(), m_entries.project<0>(itr));
+		return;
+	}
+
+	m_entries.push_front(std::move(entry));
+
+	if (m_entries.size() > m_maxEntries)
+	{
+		m_entries.pop_back();
+	}
+}
+
+void MetadataCache::Invalidate(const std::wstring &path)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto &pathIndex = m_entries.get<2>();
+	auto range = pathIndex.equal_range(NormalizePath(path));
+
+	for (auto itr = range.first; itr != range.second; ++itr)
+	{
+		if (itr->persist)
+		{
+			m_modified = true;
+			break;
+		}
+	}
+
+	pathIndex.erase(range.first, range.second);
+}
+
+void MetadataCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	bool hadPersistentEntries = std::any_of(m_entries.begin(), m_entries.end(), [] (const Entry &entry) {
+		return entry.persist;
+	});
+
+	ClearInternal();
+
+	if (hadPersistentEntries)
+	{
+		m_modified = true;
+	}
+}
+
+void MetadataCache::ClearInternal()
+{
+	m_entries.clear();
+}
+
+void MetadataCache::EnsureLoaded()
+{
+	if (m_loaded)
+	{
+		return;
+	}
+
+	m_loaded = true;
+
+	if (m_cacheFile.empty())
+	{
+		return;
+	}
+
+	boost::filesystem::ifstream inputStream(m_cacheFile, std::ios::binary);
+
+	if (inputStream)
+	{
+		LoadInternal(inputStream);
+	}
+}
+
+bool MetadataCache::Save()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (!m_modified || m_cacheFile.empty())
+	{
+		return true;
+	}
+
+	// The cache is written to a temporary file first, so that
+	// the existing file is left intact if writing fails.
+	boost::filesystem::path tempFile = m_cacheFile;
+	tempFile += L".tmp";
+
+	{
+		boost::filesystem::ofstream outputStream(tempFile, std::ios::binary | std::ios::trunc);
+		SaveInternal(outputStream);
+
+		if (!outputStream)
+		{
+			return false;
+		}
+	}
+
+	boost::system::error_code error;
+	boost::filesystem::rename(tempFile, m_cacheFile, error);
+
+	if (error)
+	{
+		return false;
+	}
+
+	m_modified = false;
+
+	return true;
+}
+
+void MetadataCache::Save(std::ostream &outputStream)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	SaveInternal(outputStream);
+}
+
+/* Only persistent entries are written out. They're written from
+most to least recently used, so that the order is kept when
+they're read back in. */
+void MetadataCache::SaveInternal(std::ostream &outputStream)
+{
+	EnsureLoaded();
+
+	std::uint32_t numEntries = static_cast<std::uint32_t>(std::count_if(m_entries.begin(), m_entries.end(),
+		[] (const Entry &entry) {
+		return entry.persist;
+	}));
+
+	WriteValue(outputStream, CACHE_FILE_MAGIC);
+	WriteValue(outputStream, CACHE_FILE_VERSION);
+	WriteValue(outputStream, numEntries);
+
+	for (const auto &entry : m_entries)
+	{
+		if (!entry.persist)
+		{
+			continue;
+		}
+
+		WriteString(outputStream, entry.path);
+		WriteValue(outputStream, static_cast<std::uint32_t>(entry.propertyId));
+		WriteValue(outputStream, entry.fileSize);
+		WriteValue(outputStream, entry.lastWriteTime);
+
+		if (const std::wstring *str = boost::get<std::wstring>(&entry.value))
+		{
+			WriteValue(outputStream, ValueType::String);
+			WriteString(outputStream, *str);
+		}
+		else
+		{
+			WriteValue(outputStream, ValueType::Number);
+			WriteValue(outputStream, boost::get<std::uint64_t>(entry.value));
+		}
+	}
+}
+
+/* Replaces the contents of the cache. If the data is invalid,
+the cache is left empty. */
+bool MetadataCache::Load(std::istream &inputStream)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_loaded = true;
+
+	return LoadInternal(inputStream);
+}
+
+bool MetadataCache::LoadInternal(std::istream &inputStream)
+{
+	ClearInternal();
+	m_modified = false;
+
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint32_t numEntries;
+
+	if (!ReadValue(inputStream, magic) || magic != CACHE_FILE_MAGIC
+		|| !ReadValue(inputStream, version) || version != CACHE_FILE_VERSION
+		|| !ReadValue(inputStream, numEntries))
+	{
+		return false;
+	}
+
+	std::vector<Entry> entries;
+
+	for (std::uint32_t i = 0; i < numEntries; i++)
+	{
+		Entry entry;
+		std::uint32_t propertyId;
+		ValueType valueType;
+
+		if (!ReadString(inputStream, entry.path) || !ReadValue(inputStream, propertyId)
+			|| !ReadValue(inputStream, entry.fileSize) || !ReadValue(inputStream, entry.lastWriteTime)
+			|| !ReadValue(inputStream, valueType))
+		{
+			return false;
+		}
+
+		if (valueType == ValueType::String)
+		{
+			std::wstring str;
+
+			if (!ReadString(inputStream, str))
+			{
+				return false;
+			}
+
+			entry.value = str;
+		}
+		else if (valueType == ValueType::Number)
+		{
+			std::uint64_t number;
+
+			if (!ReadValue(inputStream, number))
+			{
+				return false;
+			}
+
+			entry.value = number;
+		}
+		else
+		{
+			return false;
+		}
+
+		entry.propertyId = propertyId;
+		entry.persist = true;
+		entries.push_back(std::move(entry));
+	}
+
+	// The entries were saved from most to least recently used.
+	for (auto &entry : entries)
+	{
+		if (m_entries.size() >= m_maxEntries)
+		{
+			break;
+		}
+
+		m_entries.push_back(std::move(entry));
+	}
+
+	return true;
+}
+
+MetadataCache::Stats MetadataCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return { m_hits, m_misses, m_entries.size() };
+}
+
+/* Paths are compared case-insensitively. */
+std::wstring MetadataCache::NormalizePath(const std::wstring &path)
+{
+	std::wstring normalizedPath = path;
+
+	for (wchar_t &c : normalizedPath)
+	{
+		c = static_cast<wchar_t>(std::towlower(c));
+	}
+
+	return normalizedPath;
+}
@@ -0,0 +1,140 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "Macros.h"
+#include <boost/filesystem/path.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/optional.hpp>
+#include <boost/variant.hpp>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+
+/* A cache of metadata read from files (e.g. the owner, version
+information or media tags of a file), shared between all
+views.
+
+Each value is keyed by the file's path, along with an
+identifier for the property. The size and last write time of
+the file are stored with each value, and a value is only
+returned if both still match. A value is either a number
+(currently only used for hard link counts) or the text that's
+displayed for the property. Text values (such as the image
+width, height and date taken) are sorted by that text, not by
+their underlying value. Once the cache is full, the least
+recently used values are dropped.
+
+Values that are slow to retrieve can be marked as persistent,
+in which case they're saved to the cache file, and reused in
+later sessions. The cache file is loaded the first time the
+cache is used.
+
+This class is thread-safe. */
+class MetadataCache
+{
+public:
+
+	typedef boost::variant<std::wstring, std::uint64_t> Value;
+
+	struct FileKey
+	{
+		std::wstring path;
+		std::uint64_t fileSize;
+		std::uint64_t lastWriteTime;
+	};
+
+	struct Stats
+	{
+		std::uint64_t hits;
+		std::uint64_t misses;
+		size_t numEntries;
+	};
+
+	/* If cacheFile is empty, nothing is loaded or saved. */
+	MetadataCache(const boost::filesystem::path &cacheFile, size_t maxEntries);
+
+	boost::optional<Value> Lookup(const FileKey &file, unsigned int propertyId);
+	void Insert(const FileKey &file, unsigned int propertyId, const Value &value, bool persist);
+
+	/* Removes every value for the file, regardless of its size and
+	last write time. */
+	void Invalidate(const std::wstring &path);
+
+	void Clear();
+
+	/* Does nothing if no persistent values have changed since the
+	cache was loaded. */
+	bool Save();
+
+	void Save(std::ostream &outputStream);
+	bool Load(std::istream &inputStream);
+
+	Stats GetStats() const;
+
+private:
+
+	DISALLOW_COPY_AND_ASSIGN(MetadataCache);
+
+	static const std::uint32_t CACHE_FILE_MAGIC = 0x4D444358;
+	static const std::uint32_t CACHE_FILE_VERSION = 1;
+
+	enum class ValueType : std::uint32_t
+	{
+		String = 0,
+		Number = 1
+	};
+
+	struct Entry
+	{
+		std::wstring path;
+		unsigned int propertyId;
+		std::uint64_t fileSize;
+		std::uint64_t lastWriteTime;
+		Value value;
+		bool persist;
+	};
+
+	/* Entries are ordered from most to least recently used. */
+	typedef boost::multi_index_container<
+		Entry,
+		boost::multi_index::indexed_by<
+			boost::multi_index::sequenced<>,
+			boost::multi_index::hashed_unique<
+				boost::multi_index::composite_key<
+					Entry,
+					boost::multi_index::member<Entry, std::wstring, &Entry::path>,
+					boost::multi_index::member<Entry, unsigned int, &Entry::propertyId>
+				>
+			>,
+			boost::multi_index::hashed_non_unique<boost::multi_index::member<Entry, std::wstring, &Entry::path>>
+		>
+	> EntrySet;
+
+	static std::wstring NormalizePath(const std::wstring &path);
+
+	void EnsureLoaded();
+	void SaveInternal(std::ostream &outputStream);
+	bool LoadInternal(std::istream &inputStream);
+	void ClearInternal();
+	void AddEntry(Entry &&entry);
+
+	const boost::filesystem::path m_cacheFile;
+	const size_t m_maxEntries;
+
+	mutable std::mutex m_mutex;
+	EntrySet m_entries;
+
+	bool m_loaded;
+	bool m_modified;
+
+	std::uint64_t m_hits;
+	std::uint64_t m_misses;
+};
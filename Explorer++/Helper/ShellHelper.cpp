@@ -1346,6 +1346,45 @@ HRESULT GetItemInfoTip(LPCITEMIDLIST pidlComplete, TCHAR *szInfoTip, size_t cchM
 	return hr;
 }
 
+/* Retrieves the file (and index within that file) that an
+item's icon is loaded from. The flags indicate whether the
+icon is specific to the item (GIL_PERINSTANCE), or shared by
+all items of the same type (GIL_PERCLASS). */
+HRESULT GetItemIconLocation(LPCITEMIDLIST pidlComplete, TCHAR *szIconFile, UINT cchMax,
+	int *piIndex, UINT *puFlags)
+{
+	IShellFolder	*pShellFolder = NULL;
+	IExtractIcon	*pExtractIcon = NULL;
+	LPCITEMIDLIST	pidlRelative = NULL;
+	HRESULT			hr;
+
+	hr = SHBindToParent(pidlComplete, IID_PPV_ARGS(&pShellFolder), &pidlRelative);
+
+	if(SUCCEEDED(hr))
+	{
+		hr = GetUIObjectOf(pShellFolder, NULL, 1, &pidlRelative,
+			IID_PPV_ARGS(&pExtractIcon));
+
+		if(SUCCEEDED(hr))
+		{
+			hr = pExtractIcon->GetIconLocation(GIL_FORSHELL, szIconFile, cchMax,
+				piIndex, puFlags);
+
+			/* S_FALSE indicates that the default icon
+			should be used. */
+			if(hr == S_FALSE)
+			{
+				hr = E_FAIL;
+			}
+
+			pExtractIcon->Release();
+		}
+		pShellFolder->Release();
+	}
+
+	return hr;
+}
+
 HRESULT ShowMultipleFileProperties(LPITEMIDLIST pidlDirectory, LPCITEMIDLIST *ppidl,
 	HWND hwndOwner, int nFiles)
 {
@@ -88,6 +88,9 @@ int				GetDefaultFolderIconIndex(void);
 int				GetDefaultFileIconIndex(void);
 int				GetDefaultIcon(DefaultIconType defaultIconType);
 
+/* Icon locations. */
+HRESULT			GetItemIconLocation(LPCITEMIDLIST pidlComplete, TCHAR *szIconFile, UINT cchMax, int *piIndex, UINT *puFlags);
+
 /* Infotips. */
 HRESULT			GetItemInfoTip(const TCHAR *szItemPath, TCHAR *szInfoTip, size_t cchMax);
 HRESULT			GetItemInfoTip(LPCITEMIDLIST pidlComplete, TCHAR *szInfoTip, size_t cchMax);
\ No newline at end of file
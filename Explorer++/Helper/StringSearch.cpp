@@ -0,0 +1,143 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "StringSearch.h"
+#include <algorithm>
+
+/* The vector code assumes that each character is a single
+16-bit code unit. */
+#if (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)) && defined(UNICODE)
+#define STRING_SEARCH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	TCHAR FoldAsciiChar(TCHAR ch)
+	{
+		return (ch >= 'A' && ch <= 'Z') ? static_cast<TCHAR>(ch + ('a' - 'A')) : ch;
+	}
+
+#ifdef STRING_SEARCH_SSE2
+	const size_t UNITS_PER_VECTOR = sizeof(__m128i) / sizeof(TCHAR);
+
+	__m128i LoadUnits(const TCHAR *str)
+	{
+		return _mm_loadu_si128(reinterpret_cast<const __m128i *>(str));
+	}
+#endif
+}
+
+bool FoldAsciiCase(const TCHAR *str, size_t length, TCHAR *output)
+{
+	size_t i = 0;
+
+#ifdef STRING_SEARCH_SSE2
+	/* The comparisons below are signed, so units of 0x8000
+	and above (which are negative) are never treated as
+	uppercase letters. They're rejected by the non-ASCII
+	check in any case. */
+	const __m128i nonAsciiMask = _mm_set1_epi16(static_cast<short>(0xFF80));
+	const __m128i beforeUpperA = _mm_set1_epi16('A' - 1);
+	const __m128i afterUpperZ = _mm_set1_epi16('Z' + 1);
+	const __m128i caseDifference = _mm_set1_epi16('a' - 'A');
+	const __m128i zero = _mm_setzero_si128();
+
+	for (; i + UNITS_PER_VECTOR <= length; i += UNITS_PER_VECTOR)
+	{
+		__m128i units = LoadUnits(str + i);
+
+		__m128i nonAscii = _mm_cmpeq_epi16(_mm_and_si128(units, nonAsciiMask), zero);
+
+		if (_mm_movemask_epi8(nonAscii) != 0xFFFF)
+		{
+			return false;
+		}
+
+		__m128i upper = _mm_and_si128(_mm_cmpgt_epi16(units, beforeUpperA),
+			_mm_cmplt_epi16(units, afterUpperZ));
+		units = _mm_add_epi16(units, _mm_and_si128(upper, caseDifference));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(output + i), units);
+	}
+#endif
+
+	for (; i < length; i++)
+	{
+		if (str[i] >= 0x80)
+		{
+			return false;
+		}
+
+		output[i] = FoldAsciiChar(str[i]);
+	}
+
+	return true;
+}
+
+const TCHAR *FindSubstring(const TCHAR *str, size_t length,
+	const TCHAR *substring, size_t substringLength)
+{
+	if (substringLength == 0)
+	{
+		return str;
+	}
+
+	if (substringLength > length)
+	{
+		return nullptr;
+	}
+
+	size_t lastStart = length - substringLength;
+	size_t i = 0;
+
+#ifdef STRING_SEARCH_SSE2
+	/* Each candidate position has to match both the first
+	and last characters of the substring. Checking both
+	rules out most positions without having to compare the
+	rest of the substring. */
+	const __m128i first = _mm_set1_epi16(static_cast<short>(substring[0]));
+	const __m128i last = _mm_set1_epi16(static_cast<short>(substring[substringLength - 1]));
+
+	for (; i + UNITS_PER_VECTOR - 1 <= lastStart; i += UNITS_PER_VECTOR)
+	{
+		__m128i firstMatches = _mm_cmpeq_epi16(LoadUnits(str + i), first);
+		__m128i lastMatches = _mm_cmpeq_epi16(LoadUnits(str + i + substringLength - 1), last);
+
+		/* Two mask bits are produced per 16-bit unit. */
+		unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_and_si128(firstMatches, lastMatches)));
+
+		while (mask != 0)
+		{
+			unsigned int bit = 0;
+
+			while ((mask & (1u << bit)) == 0)
+			{
+				bit++;
+			}
+
+			const TCHAR *candidate = str + i + (bit / 2);
+
+			if (std::equal(substring + 1, substring + substringLength, candidate + 1))
+			{
+				return candidate;
+			}
+
+			mask &= ~(3u << bit);
+		}
+	}
+#endif
+
+	for (; i <= lastStart; i++)
+	{
+		if (str[i] == substring[0]
+			&& std::equal(substring + 1, substring + substringLength, str + i + 1))
+		{
+			return str + i;
+		}
+	}
+
+	return nullptr;
+}
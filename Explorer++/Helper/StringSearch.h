@@ -0,0 +1,27 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <windows.h>
+
+/* Low-level routines used when matching filenames against
+patterns. Where SSE2 is available (which it always is on
+x64), eight UTF-16 code units are processed at a time, with
+any remainder being handled one unit at a time. Both paths
+give exactly the same results. */
+
+/* Lowercases the ASCII letters in the string, writing the
+result to output (which may be the same as str). Returns
+false as soon as a character outside the ASCII range is
+found, in which case the contents of output are unspecified
+and the string should be folded through the locale
+instead. */
+bool FoldAsciiCase(const TCHAR *str, size_t length, TCHAR *output);
+
+/* Returns the first occurrence of substring within str, or
+nullptr if there isn't one. An empty substring is found at
+the start of the string. */
+const TCHAR *FindSubstring(const TCHAR *str, size_t length,
+	const TCHAR *substring, size_t substringLength);
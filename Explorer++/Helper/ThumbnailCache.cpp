@@ -0,0 +1,347 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ThumbnailCache.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	size_t RoundUp(size_t value, size_t multiple)
+	{
+		return ((value + multiple - 1) / multiple) * multiple;
+	}
+}
+
+size_t ThumbnailCache::GetHeaderSize()
+{
+	return RoundUp(sizeof(StorageHeader), sizeof(std::uint64_t));
+}
+
+size_t ThumbnailCache::GetSlotSize(int maxWidth, int maxHeight)
+{
+	size_t size = sizeof(SlotHeader) + (MAX_PATH_LENGTH * sizeof(wchar_t))
+		+ (static_cast<size_t>(maxWidth) * maxHeight * sizeof(std::uint32_t));
+	return RoundUp(size, sizeof(std::uint64_t));
+}
+
+size_t ThumbnailCache::GetStorageSize(int maxWidth, int maxHeight, size_t numEntries)
+{
+	return GetHeaderSize() + (numEntries * GetSlotSize(maxWidth, maxHeight));
+}
+
+ThumbnailCache::ThumbnailCache(void *storage, size_t storageSize, int maxWidth, int maxHeight) :
+	m_storage(static_cast<unsigned char *>(storage)),
+	m_header(nullptr),
+	m_maxWidth(maxWidth),
+	m_maxHeight(maxHeight),
+	m_slotSize(GetSlotSize(maxWidth, maxHeight)),
+	m_numSlots(0),
+	m_hits(0),
+	m_misses(0),
+	m_evictions(0)
+{
+	if (m_storage == nullptr || storageSize < GetHeaderSize())
+	{
+		// There's no room for anything, so every lookup will
+		// simply miss.
+		return;
+	}
+
+	m_header = reinterpret_cast<StorageHeader *>(m_storage);
+	m_numSlots = (storageSize - GetHeaderSize()) / m_slotSize;
+	m_slots.resize(m_numSlots);
+
+	if (m_header->magic == STORAGE_MAGIC
+		&& m_header->version == STORAGE_VERSION
+		&& m_header->maxWidth == static_cast<std::uint32_t>(m_maxWidth)
+		&& m_header->maxHeight == static_cast<std::uint32_t>(m_maxHeight)
+		&& m_header->numSlots == m_numSlots)
+	{
+		LoadIndex();
+	}
+	else
+	{
+		ResetStorage();
+	}
+}
+
+/* Rebuilds the in-memory index (and the LRU order) from the
+slots that were written previously. */
+void ThumbnailCache::LoadIndex()
+{
+	std::vector<std::pair<std::uint64_t, size_t>> usedSlots;
+
+	for (size_t i = 0; i < m_numSlots; i++)
+	{
+		SlotHeader *slotHeader = GetSlotHeader(i);
+
+		if (!IsSlotValid(slotHeader))
+		{
+			slotHeader->state = SlotState::Empty;
+			continue;
+		}
+
+		IndexKey key;
+		key.path.assign(GetSlotPath(i), slotHeader->pathLength);
+		key.requestedWidth = slotHeader->requestedWidth;
+		key.requestedHeight = slotHeader->requestedHeight;
+
+		if (!m_index.emplace(key, i).second)
+		{
+			slotHeader->state = SlotState::Empty;
+			continue;
+		}
+
+		SlotInfo slotInfo;
+		slotInfo.key = std::move(key);
+		m_slots[i] = std::move(slotInfo);
+
+		usedSlots.emplace_back(slotHeader->lastAccess, i);
+	}
+
+	std::sort(usedSlots.begin(), usedSlots.end(),
+		[] (const auto &first, const auto &second) {
+		return first.first > second.first;
+	});
+
+	for (const auto &usedSlot : usedSlots)
+	{
+		m_slots[usedSlot.second]->lruPosition = m_lruSlots.insert(m_lruSlots.end(), usedSlot.second);
+	}
+
+	// Slots are handed out from the back, so lower slots are
+	// used first.
+	for (size_t i = m_numSlots; i > 0; i--)
+	{
+		if (!m_slots[i - 1])
+		{
+			m_freeSlots.push_back(i - 1);
+		}
+	}
+}
+
+void ThumbnailCache::ResetStorage()
+{
+	m_header->magic = STORAGE_MAGIC;
+	m_header->version = STORAGE_VERSION;
+	m_header->maxWidth = m_maxWidth;
+	m_header->maxHeight = m_maxHeight;
+	m_header->numSlots = m_numSlots;
+	m_header->accessCounter = 0;
+
+	m_index.clear();
+	m_lruSlots.clear();
+	m_freeSlots.clear();
+
+	for (size_t i = m_numSlots; i > 0; i--)
+	{
+		GetSlotHeader(i - 1)->state = SlotState::Empty;
+		m_slots[i - 1] = boost::none;
+		m_freeSlots.push_back(i - 1);
+	}
+}
+
+bool ThumbnailCache::IsSlotValid(const SlotHeader *slotHeader) const
+{
+	return slotHeader->state == SlotState::Valid
+		&& slotHeader->pathLength <= static_cast<std::uint32_t>(MAX_PATH_LENGTH)
+		&& slotHeader->width >= 0 && slotHeader->width <= m_maxWidth
+		&& slotHeader->height >= 0 && slotHeader->height <= m_maxHeight;
+}
+
+ThumbnailCache::SlotHeader *ThumbnailCache::GetSlotHeader(size_t slot) const
+{
+	return reinterpret_cast<SlotHeader *>(m_storage + GetHeaderSize() + (slot * m_slotSize));
+}
+
+wchar_t *ThumbnailCache::GetSlotPath(size_t slot) const
+{
+	return reinterpret_cast<wchar_t *>(GetSlotHeader(slot) + 1);
+}
+
+std::uint32_t *ThumbnailCache::GetSlotPixels(size_t slot) const
+{
+	return reinterpret_cast<std::uint32_t *>(GetSlotPath(slot) + MAX_PATH_LENGTH);
+}
+
+boost::optional<ThumbnailCache::Bitmap> ThumbnailCache::Lookup(const Key &key)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto itr = m_index.find({ key.path, key.requestedWidth, key.requestedHeight });
+
+	if (itr == m_index.end())
+	{
+		m_misses++;
+		return boost::none;
+	}
+
+	size_t slot = itr->second;
+	const SlotHeader *slotHeader = GetSlotHeader(slot);
+
+	if (slotHeader->fileSize != key.fileSize
+		|| slotHeader->lastWriteTime != key.lastWriteTime)
+	{
+		// The file has changed since the thumbnail was stored.
+		FreeSlot(slot);
+
+		m_misses++;
+		return boost::none;
+	}
+
+	TouchSlot(slot);
+
+	Bitmap bitmap;
+	bitmap.width = slotHeader->width;
+	bitmap.height = slotHeader->height;
+
+	const std::uint32_t *pixels = GetSlotPixels(slot);
+	bitmap.pixels.assign(pixels, pixels + (static_cast<size_t>(bitmap.width) * bitmap.height));
+
+	m_hits++;
+
+	return bitmap;
+}
+
+bool ThumbnailCache::Insert(const Key &key, const Bitmap &bitmap)
+{
+	if (key.path.size() > static_cast<size_t>(MAX_PATH_LENGTH)
+		|| bitmap.width < 0 || bitmap.width > m_maxWidth
+		|| bitmap.height < 0 || bitmap.height > m_maxHeight
+		|| bitmap.pixels.size() != static_cast<size_t>(bitmap.width) * bitmap.height)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	IndexKey indexKey = { key.path, key.requestedWidth, key.requestedHeight };
+	boost::optional<size_t> slot;
+
+	auto itr = m_index.find(indexKey);
+
+	if (itr != m_index.end())
+	{
+		slot = itr->second;
+	}
+	else
+	{
+		slot = AllocateSlot();
+
+		if (!slot)
+		{
+			return false;
+		}
+
+		m_index.emplace(indexKey, *slot);
+
+		SlotInfo slotInfo;
+		slotInfo.key = std::move(indexKey);
+		slotInfo.lruPosition = m_lruSlots.insert(m_lruSlots.begin(), *slot);
+		m_slots[*slot] = std::move(slotInfo);
+	}
+
+	SlotHeader *slotHeader = GetSlotHeader(*slot);
+
+	// The slot is only marked as valid once everything else
+	// has been written.
+	slotHeader->state = SlotState::Empty;
+	slotHeader->pathLength = static_cast<std::uint32_t>(key.path.size());
+	slotHeader->fileSize = key.fileSize;
+	slotHeader->lastWriteTime = key.lastWriteTime;
+	slotHeader->requestedWidth = key.requestedWidth;
+	slotHeader->requestedHeight = key.requestedHeight;
+	slotHeader->width = bitmap.width;
+	slotHeader->height = bitmap.height;
+
+	std::copy(key.path.begin(), key.path.end(), GetSlotPath(*slot));
+	std::copy(bitmap.pixels.begin(), bitmap.pixels.end(), GetSlotPixels(*slot));
+
+	TouchSlot(*slot);
+
+	slotHeader->state = SlotState::Valid;
+
+	return true;
+}
+
+/* Takes a free slot or, if there aren't any, evicts the least
+recently used entry. */
+boost::optional<size_t> ThumbnailCache::AllocateSlot()
+{
+	if (!m_freeSlots.empty())
+	{
+		size_t slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+		return slot;
+	}
+
+	if (m_lruSlots.empty())
+	{
+		return boost::none;
+	}
+
+	size_t slot = m_lruSlots.back();
+	FreeSlot(slot);
+	m_evictions++;
+
+	m_freeSlots.pop_back();
+
+	return slot;
+}
+
+void ThumbnailCache::TouchSlot(size_t slot)
+{
+	GetSlotHeader(slot)->lastAccess = ++m_header->accessCounter;
+
+	auto &slotInfo = *m_slots[slot];
+	m_lruSlots.splice(m_lruSlots.begin(), m_lruSlots, slotInfo.lruPosition);
+}
+
+void ThumbnailCache::FreeSlot(size_t slot)
+{
+	GetSlotHeader(slot)->state = SlotState::Empty;
+
+	auto &slotInfo = *m_slots[slot];
+	m_index.erase(slotInfo.key);
+	m_lruSlots.erase(slotInfo.lruPosition);
+	m_slots[slot] = boost::none;
+
+	m_freeSlots.push_back(slot);
+}
+
+void ThumbnailCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_header == nullptr)
+	{
+		return;
+	}
+
+	ResetStorage();
+}
+
+ThumbnailCache::Stats ThumbnailCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Stats stats;
+	stats.hits = m_hits;
+	stats.misses = m_misses;
+	stats.evictions = m_evictions;
+	stats.numEntries = m_index.size();
+	stats.capacity = m_numSlots;
+
+	return stats;
+}
+
+size_t ThumbnailCache::IndexKeyHash::operator()(const IndexKey &key) const
+{
+	size_t hash = std::hash<std::wstring>()(key.path);
+	hash ^= std::hash<int>()(key.requestedWidth) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+	hash ^= std::hash<int>()(key.requestedHeight) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+	return hash;
+}
@@ -0,0 +1,182 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "Macros.h"
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* A persistent cache of thumbnail bitmaps.
+
+The cache doesn't own its storage. It's given a block of
+memory (normally a view of a memory-mapped file), which it
+divides into a header and a set of fixed-size slots, each
+able to hold a single thumbnail of up to the maximum
+dimensions. Everything needed to rebuild the index is kept
+in the block itself, so a cache created over the same file
+in a later session picks up where the previous one left
+off.
+
+Entries are keyed by the item's path and the dimensions
+that were requested. The size and last write time of the
+file are stored with each entry, and an entry is only
+returned if both still match. Once every slot is in use,
+the least recently used entry is replaced.
+
+This class is thread-safe. */
+class ThumbnailCache
+{
+public:
+
+	struct Key
+	{
+		std::wstring path;
+		std::uint64_t fileSize;
+		std::uint64_t lastWriteTime;
+		int requestedWidth;
+		int requestedHeight;
+	};
+
+	/* 32-bit pixels, stored top-down, with no padding between
+	rows. */
+	struct Bitmap
+	{
+		int width;
+		int height;
+		std::vector<std::uint32_t> pixels;
+	};
+
+	struct Stats
+	{
+		std::uint64_t hits;
+		std::uint64_t misses;
+		std::uint64_t evictions;
+		size_t numEntries;
+		size_t capacity;
+	};
+
+	static const int MAX_PATH_LENGTH = 260;
+
+	/* Returns the number of bytes of storage needed to hold
+	the specified number of thumbnails. */
+	static size_t GetStorageSize(int maxWidth, int maxHeight, size_t numEntries);
+
+	/* Any existing contents of the storage are kept if they
+	were written with the same maximum dimensions. Otherwise,
+	the storage is reset. */
+	ThumbnailCache(void *storage, size_t storageSize, int maxWidth, int maxHeight);
+
+	boost::optional<Bitmap> Lookup(const Key &key);
+
+	/* Returns false if the bitmap is larger than the maximum
+	dimensions, or the path is too long to be stored. */
+	bool Insert(const Key &key, const Bitmap &bitmap);
+
+	void Clear();
+
+	Stats GetStats() const;
+
+private:
+
+	DISALLOW_COPY_AND_ASSIGN(ThumbnailCache);
+
+	static const std::uint32_t STORAGE_MAGIC = 0x48544E58;
+	static const std::uint32_t STORAGE_VERSION = 1;
+
+	enum class SlotState : std::uint32_t
+	{
+		Empty = 0,
+		Valid = 1
+	};
+
+	struct StorageHeader
+	{
+		std::uint32_t magic;
+		std::uint32_t version;
+		std::uint32_t maxWidth;
+		std::uint32_t maxHeight;
+		std::uint64_t numSlots;
+		std::uint64_t accessCounter;
+	};
+
+	/* Followed (within the slot) by the path and then the
+	pixels. */
+	struct SlotHeader
+	{
+		SlotState state;
+		std::uint32_t pathLength;
+		std::uint64_t fileSize;
+		std::uint64_t lastWriteTime;
+		std::uint64_t lastAccess;
+		std::int32_t requestedWidth;
+		std::int32_t requestedHeight;
+		std::int32_t width;
+		std::int32_t height;
+	};
+
+	struct IndexKey
+	{
+		std::wstring path;
+		int requestedWidth;
+		int requestedHeight;
+
+		bool operator==(const IndexKey &other) const
+		{
+			return requestedWidth == other.requestedWidth
+				&& requestedHeight == other.requestedHeight
+				&& path == other.path;
+		}
+	};
+
+	struct IndexKeyHash
+	{
+		size_t operator()(const IndexKey &key) const;
+	};
+
+	struct SlotInfo
+	{
+		IndexKey key;
+		std::list<size_t>::iterator lruPosition;
+	};
+
+	static size_t GetSlotSize(int maxWidth, int maxHeight);
+	static size_t GetHeaderSize();
+
+	void LoadIndex();
+	void ResetStorage();
+	bool IsSlotValid(const SlotHeader *slotHeader) const;
+
+	SlotHeader *GetSlotHeader(size_t slot) const;
+	wchar_t *GetSlotPath(size_t slot) const;
+	std::uint32_t *GetSlotPixels(size_t slot) const;
+
+	void TouchSlot(size_t slot);
+	void FreeSlot(size_t slot);
+	boost::optional<size_t> AllocateSlot();
+
+	unsigned char *m_storage;
+	StorageHeader *m_header;
+	const int m_maxWidth;
+	const int m_maxHeight;
+	const size_t m_slotSize;
+	size_t m_numSlots;
+
+	mutable std::mutex m_mutex;
+	std::unordered_map<IndexKey, size_t, IndexKeyHash> m_index;
+	std::vector<boost::optional<SlotInfo>> m_slots;
+
+	/* Ordered from most to least recently used. */
+	std::list<size_t> m_lruSlots;
+	std::vector<size_t> m_freeSlots;
+
+	std::uint64_t m_hits;
+	std::uint64_t m_misses;
+	std::uint64_t m_evictions;
+};
@@ -0,0 +1,366 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "WildcardMatcher.h"
+#include "Macros.h"
+#include "StringSearch.h"
+#include <algorithm>
+
+WildcardMatcher::WildcardMatcher() :
+	WildcardMatcher(L"", true)
+{
+
+}
+
+WildcardMatcher::WildcardMatcher(const std::wstring &pattern, bool caseSensitive) :
+	m_pattern(pattern),
+	m_caseSensitive(caseSensitive)
+{
+	std::wstring finalPattern = pattern;
+
+	if (!m_caseSensitive && !finalPattern.empty())
+	{
+		FoldCase(pattern.c_str(), pattern.size(), &finalPattern[0]);
+	}
+
+	if (finalPattern.find(':') == std::wstring::npos)
+	{
+		m_compiledPatterns.push_back(CompilePattern(finalPattern));
+		return;
+	}
+
+	/* Empty patterns (e.g. between two adjacent
+	separators) are skipped. Leading and trailing spaces
+	are removed from the others, so that patterns can be
+	given as "*.h: *.cpp". */
+	size_t start = 0;
+
+	while (start <= finalPattern.size())
+	{
+		size_t separator = finalPattern.find(':', start);
+
+		if (separator == std::wstring::npos)
+		{
+			separator = finalPattern.size();
+		}
+
+		if (separator > start)
+		{
+			std::wstring singlePattern = finalPattern.substr(start, separator - start);
+
+			size_t first = singlePattern.find_first_not_of(' ');
+			size_t last = singlePattern.find_last_not_of(' ');
+
+			if (first == std::wstring::npos)
+			{
+				singlePattern.clear();
+			}
+			else
+			{
+				singlePattern = singlePattern.substr(first, last - first + 1);
+			}
+
+			m_compiledPatterns.push_back(CompilePattern(singlePattern));
+		}
+
+		start = separator + 1;
+	}
+}
+
+bool WildcardMatcher::Matches(const TCHAR *str) const
+{
+	return Matches(str, lstrlen(str));
+}
+
+bool WildcardMatcher::Matches(const TCHAR *str, size_t length) const
+{
+	const TCHAR *finalStr = str;
+	TCHAR foldedStr[MAX_PATH];
+	std::vector<TCHAR> foldedLongStr;
+
+	if (!m_caseSensitive && length > 0)
+	{
+		TCHAR *output = foldedStr;
+
+		if (length > SIZEOF_ARRAY(foldedStr))
+		{
+			foldedLongStr.resize(length);
+			output = foldedLongStr.data();
+		}
+
+		FoldCase(str, length, output);
+		finalStr = output;
+	}
+
+	for (const auto &compiledPattern : m_compiledPatterns)
+	{
+		if (MatchesPattern(compiledPattern, finalStr, length))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+const std::wstring &WildcardMatcher::GetPattern() const
+{
+	return m_pattern;
+}
+
+bool WildcardMatcher::IsCaseSensitive() const
+{
+	return m_caseSensitive;
+}
+
+/* Each of the patterns here needs to be covered by one of
+the patterns in the other matcher. A case-sensitive pattern
+can be compared against a case-insensitive one once it's
+been lowercased, but not the other way around. */
+bool WildcardMatcher::IsSubsetOf(const WildcardMatcher &other) const
+{
+	if (!m_caseSensitive && other.m_caseSensitive)
+	{
+		return false;
+	}
+
+	for (const auto &compiledPattern : m_compiledPatterns)
+	{
+		std::wstring text = compiledPattern.text;
+
+		if (m_caseSensitive && !other.m_caseSensitive && !text.empty())
+		{
+			FoldCase(compiledPattern.text.c_str(), compiledPattern.text.size(), &text[0]);
+		}
+
+		bool covered = std::any_of(other.m_compiledPatterns.begin(), other.m_compiledPatterns.end(),
+			[&text] (const CompiledPattern &otherCompiledPattern) {
+			return PatternCovers(otherCompiledPattern.text, text);
+		});
+
+		if (!covered)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+WildcardMatcher::CompiledPattern WildcardMatcher::CompilePattern(const std::wstring &pattern)
+{
+	CompiledPattern compiledPattern;
+	compiledPattern.text = pattern;
+	compiledPattern.anchoredStart = (pattern.empty() || pattern.front() != '*');
+	compiledPattern.anchoredEnd = (pattern.empty() || pattern.back() != '*');
+
+	if (pattern.find('*') == std::wstring::npos)
+	{
+		Segment segment;
+		segment.text = pattern;
+		segment.hasSingleWildcards = (pattern.find('?') != std::wstring::npos);
+		compiledPattern.segments.push_back(segment);
+
+		return compiledPattern;
+	}
+
+	/* Consecutive '*' characters are equivalent to a
+	single '*', so empty segments can be dropped. */
+	size_t start = 0;
+
+	while (start < pattern.size())
+	{
+		size_t star = pattern.find('*', start);
+
+		if (star == std::wstring::npos)
+		{
+			star = pattern.size();
+		}
+
+		if (star > start)
+		{
+			Segment segment;
+			segment.text = pattern.substr(start, star - start);
+			segment.hasSingleWildcards = (segment.text.find('?') != std::wstring::npos);
+			compiledPattern.segments.push_back(segment);
+		}
+
+		start = star + 1;
+	}
+
+	return compiledPattern;
+}
+
+bool WildcardMatcher::MatchesPattern(const CompiledPattern &compiledPattern, const TCHAR *str, size_t length)
+{
+	const auto &segments = compiledPattern.segments;
+
+	/* No '*' at all, so the string has to match the
+	pattern exactly. */
+	if (compiledPattern.anchoredStart && compiledPattern.anchoredEnd && segments.size() == 1)
+	{
+		return segments[0].text.size() == length && SegmentMatchesAt(segments[0], str);
+	}
+
+	const TCHAR *current = str;
+	const TCHAR *end = str + length;
+	size_t firstSegment = 0;
+	size_t lastSegment = segments.size();
+
+	/* Literal prefixes and suffixes (e.g. the ".cpp" in
+	"*.cpp") can only match in one place, so they're
+	checked first. */
+	if (compiledPattern.anchoredStart)
+	{
+		const Segment &segment = segments.front();
+
+		if (static_cast<size_t>(end - current) < segment.text.size()
+			|| !SegmentMatchesAt(segment, current))
+		{
+			return false;
+		}
+
+		current += segment.text.size();
+		firstSegment++;
+	}
+
+	if (compiledPattern.anchoredEnd)
+	{
+		const Segment &segment = segments.back();
+
+		if (static_cast<size_t>(end - current) < segment.text.size()
+			|| !SegmentMatchesAt(segment, end - segment.text.size()))
+		{
+			return false;
+		}
+
+		end -= segment.text.size();
+		lastSegment--;
+	}
+
+	/* Each remaining segment is matched at the first
+	position it occurs. Matching it any later would only
+	leave less of the string for the segments that
+	follow. */
+	for (size_t i = firstSegment; i < lastSegment; i++)
+	{
+		const TCHAR *match = FindSegment(segments[i], current, end);
+
+		if (match == nullptr)
+		{
+			return false;
+		}
+
+		current = match + segments[i].text.size();
+	}
+
+	return true;
+}
+
+bool WildcardMatcher::SegmentMatchesAt(const Segment &segment, const TCHAR *str)
+{
+	if (!segment.hasSingleWildcards)
+	{
+		return std::equal(segment.text.begin(), segment.text.end(), str);
+	}
+
+	for (size_t i = 0; i < segment.text.size(); i++)
+	{
+		if (segment.text[i] != '?' && segment.text[i] != str[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+const TCHAR *WildcardMatcher::FindSegment(const Segment &segment, const TCHAR *start, const TCHAR *end)
+{
+	size_t segmentLength = segment.text.size();
+
+	if (static_cast<size_t>(end - start) < segmentLength)
+	{
+		return nullptr;
+	}
+
+	if (!segment.hasSingleWildcards)
+	{
+		return FindSubstring(start, end - start, segment.text.c_str(), segmentLength);
+	}
+
+	for (const TCHAR *current = start; current <= end - segmentLength; current++)
+	{
+		if (SegmentMatchesAt(segment, current))
+		{
+			return current;
+		}
+	}
+
+	return nullptr;
+}
+
+/* Matches the general pattern against the specific pattern,
+treating the specific pattern as if it were a string. A '*'
+in the general pattern can absorb anything (including a
+'*'), while a '?' can absorb any single character other
+than a '*'. If that succeeds, any string the specific
+pattern matches will also be matched by the general one.
+
+covers[i][j] indicates whether general[i..] covers
+specific[j..]. */
+bool WildcardMatcher::PatternCovers(const std::wstring &general, const std::wstring &specific)
+{
+	size_t generalLength = general.size();
+	size_t specificLength = specific.size();
+
+	std::vector<std::vector<bool>> covers(generalLength + 1, std::vector<bool>(specificLength + 1, false));
+	covers[generalLength][specificLength] = true;
+
+	for (size_t i = generalLength; i-- > 0;)
+	{
+		for (size_t j = specificLength + 1; j-- > 0;)
+		{
+			bool hasNext = (j < specificLength);
+
+			switch (general[i])
+			{
+			case '*':
+				covers[i][j] = covers[i + 1][j] || (hasNext && covers[i][j + 1]);
+				break;
+
+			case '?':
+				covers[i][j] = hasNext && specific[j] != '*' && covers[i + 1][j + 1];
+				break;
+
+			default:
+				covers[i][j] = hasNext && specific[j] == general[i] && covers[i + 1][j + 1];
+				break;
+			}
+		}
+	}
+
+	return covers[0][0];
+}
+
+/* Lowercases the string in the same way as LCMapString
+(which was previously called for each character), but
+only calls it when the string contains characters
+outside the ASCII range. */
+void WildcardMatcher::FoldCase(const TCHAR *str, size_t length, TCHAR *output)
+{
+	if (FoldAsciiCase(str, length, output))
+	{
+		return;
+	}
+
+	int res = LCMapString(LOCALE_USER_DEFAULT, LCMAP_LOWERCASE, str, static_cast<int>(length),
+		output, static_cast<int>(length));
+
+	if (res == 0)
+	{
+		std::copy(str, str + length, output);
+	}
+}
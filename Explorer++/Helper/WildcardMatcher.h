@@ -0,0 +1,91 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <windows.h>
+#include <string>
+#include <vector>
+
+/* Matches strings against a wildcard pattern, where '*'
+matches any sequence of characters and '?' matches any
+single character. Multiple patterns can be supplied,
+separated by ':' (e.g. "*.h: *.cpp"), in which case a
+string matches if it matches any one of them.
+
+The pattern is split (and, for case-insensitive matches,
+lowercased) once, when the matcher is constructed, so a
+single matcher should be reused when checking many
+strings against the same pattern. Each pattern is broken
+up into the literal segments between its '*' characters,
+which are then located in the string from left to right;
+no backtracking is needed, so a match takes time roughly
+proportional to the length of the string.
+
+Matching doesn't modify the matcher, so a matcher can be
+shared between threads. */
+class WildcardMatcher
+{
+public:
+
+	/* The default matcher has an empty pattern, which
+	only matches the empty string. */
+	WildcardMatcher();
+	WildcardMatcher(const std::wstring &pattern, bool caseSensitive);
+
+	bool Matches(const TCHAR *str) const;
+	bool Matches(const TCHAR *str, size_t length) const;
+
+	const std::wstring &GetPattern() const;
+	bool IsCaseSensitive() const;
+
+	/* Returns true if every string this matcher matches is
+	also matched by the other matcher (e.g. "*abc*" compared
+	with "*ab*"). This is conservative: it may return false
+	for some pairs of patterns that do meet that condition,
+	but never returns true for a pair that doesn't. */
+	bool IsSubsetOf(const WildcardMatcher &other) const;
+
+private:
+
+	struct Segment
+	{
+		std::wstring text;
+
+		/* Set if the segment contains any '?' characters. If
+		it doesn't, it can be compared and searched for
+		directly. */
+		bool hasSingleWildcards;
+	};
+
+	struct CompiledPattern
+	{
+		/* The original (trimmed and, if necessary, lowercased)
+		pattern. */
+		std::wstring text;
+
+		/* The literal parts of the pattern, in order. */
+		std::vector<Segment> segments;
+
+		/* If there's no leading (or trailing) '*', the first
+		(or last) segment is anchored to the start (or end)
+		of the string. A pattern with no '*' at all is a
+		single segment anchored at both ends. */
+		bool anchoredStart;
+		bool anchoredEnd;
+	};
+
+	static CompiledPattern CompilePattern(const std::wstring &pattern);
+	static bool MatchesPattern(const CompiledPattern &compiledPattern, const TCHAR *str, size_t length);
+	static bool SegmentMatchesAt(const Segment &segment, const TCHAR *str);
+	static const TCHAR *FindSegment(const Segment &segment, const TCHAR *start, const TCHAR *end);
+	static bool PatternCovers(const std::wstring &general, const std::wstring &specific);
+
+	static void FoldCase(const TCHAR *str, size_t length, TCHAR *output);
+
+	std::wstring m_pattern;
+	bool m_caseSensitive;
+
+	std::vector<CompiledPattern> m_compiledPatterns;
+};
@@ -31,7 +31,9 @@ public:
 
 private:
 
-	#define PRIMARY_BUFFER_SIZE 1000 * sizeof(FILE_NOTIFY_INFORMATION)
+	/* 64KB is the largest buffer that can be used when
+	monitoring a directory over the network. */
+	#define PRIMARY_BUFFER_SIZE (64 * 1024)
 
 	/* These function are only ever queued as APC's. */
 	static void CALLBACK	WatchAndCreateDirectoryInternal(ULONG_PTR dwParam);
@@ -200,6 +202,7 @@ int CDirectoryMonitor::WatchDirectory(const TCHAR *Directory, UINT WatchFlags,
 	pDirInfo.m_pData				= pData;
 	pDirInfo.m_bWatchSubTree		= bWatchSubTree;
 	pDirInfo.m_bMarkedForDeletion	= FALSE;
+	pDirInfo.m_FileNotifyBuffer		= NULL;
 
 	/* This suppresses crtical error message boxes, such as the one
 	that mey arise from CreateFile() when opening attempting to
@@ -251,6 +254,7 @@ int CDirectoryMonitor::WatchDirectory(HANDLE hDirectory, const TCHAR *Directory,
 	pDirInfo.m_pData				= pData;
 	pDirInfo.m_bWatchSubTree		= bWatchSubTree;
 	pDirInfo.m_bMarkedForDeletion	= FALSE;
+	pDirInfo.m_FileNotifyBuffer		= NULL;
 
 	/* This suppresses crtical error message boxes, such as the one
 	that mey arise from CreateFile() when opening attempting to
@@ -302,7 +306,12 @@ void CDirectoryMonitor::WatchDirectoryInternal(ULONG_PTR dwParam)
 		return;
 	}
 
-	pDirInfo->m_FileNotifyBuffer = (FILE_NOTIFY_INFORMATION *)malloc(PRIMARY_BUFFER_SIZE);
+	/* The buffer is allocated once and then reused each
+	time the directory is rewatched. */
+	if(pDirInfo->m_FileNotifyBuffer == NULL)
+	{
+		pDirInfo->m_FileNotifyBuffer = (FILE_NOTIFY_INFORMATION *)malloc(PRIMARY_BUFFER_SIZE);
+	}
 
 	pDirInfo->m_bDirMonitored = ReadDirectoryChangesW(pDirInfo->m_hDirectory,
 	pDirInfo->m_FileNotifyBuffer,PRIMARY_BUFFER_SIZE,
@@ -312,6 +321,7 @@ void CDirectoryMonitor::WatchDirectoryInternal(ULONG_PTR dwParam)
 	if(!pDirInfo->m_bDirMonitored)
 	{
 		free(pDirInfo->m_FileNotifyBuffer);
+		pDirInfo->m_FileNotifyBuffer = NULL;
 		CancelIo(pDirInfo->m_hDirectory);
 		CloseHandle(pDirInfo->m_hDirectory);
 	}
@@ -349,11 +359,21 @@ DWORD NumberOfBytesTransferred,LPOVERLAPPED lpOverlapped)
 			i++;
 		} while(pfni->NextEntryOffset != 0);
 
-		free(pDirInfo->m_FileNotifyBuffer);
+		/* Rewatch the directory. */
+		WatchDirectoryInternal((ULONG_PTR)pDirInfo);
+	}
+	else if((dwErrorCode == ERROR_SUCCESS && NumberOfBytesTransferred == 0) ||
+		dwErrorCode == ERROR_NOTIFY_ENUM_DIR)
+	{
+		/* The buffer overflowed, so the changes that occurred
+		have been lost. */
+		if(lpOverlapped->hEvent == NULL)
+			return;
 
-		pDirInfo->m_FileNotifyBuffer = NULL;
+		pDirInfo = reinterpret_cast<CDirInfo *>(lpOverlapped->hEvent);
+
+		pDirInfo->m_OnDirectoryAltered(_T(""),DIRECTORY_MONITOR_ACTION_RESCAN,pDirInfo->m_pData);
 
-		/* Rewatch the directory. */
 		WatchDirectoryInternal((ULONG_PTR)pDirInfo);
 	}
 	else if(dwErrorCode == ERROR_OPERATION_ABORTED)
@@ -9,6 +9,12 @@
 
 typedef void (*OnDirectoryAltered)(const TCHAR *szFileName, DWORD dwAction, void *pData);
 
+/* Passed to the callback (with an empty filename) when
+change notifications have been lost (for example, because
+too many changes occurred at once). The directory should be
+rescanned in this case. */
+#define DIRECTORY_MONITOR_ACTION_RESCAN	0x1000
+
 /* Main exported interface. */
 __interface IDirectoryMonitor : IUnknown
 {
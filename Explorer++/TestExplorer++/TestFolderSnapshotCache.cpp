@@ -0,0 +1,110 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Explorer++/ShellBrowser/FolderSnapshotCache.h"
+#include "../Helper/PIDLWrapper.h"
+#include <KnownFolders.h>
+#include <memory>
+
+namespace
+{
+	struct FakeSnapshot
+	{
+		PIDLPointer pidlDirectory;
+		int value;
+	};
+
+	PIDLPointer GetKnownFolderPidl(REFKNOWNFOLDERID folderId)
+	{
+		PIDLIST_ABSOLUTE pidl = nullptr;
+		HRESULT hr = SHGetKnownFolderIDList(folderId, 0, nullptr, &pidl);
+		EXPECT_TRUE(SUCCEEDED(hr));
+		return PIDLPointer(pidl);
+	}
+
+	std::unique_ptr<FakeSnapshot> BuildSnapshot(REFKNOWNFOLDERID folderId, int value)
+	{
+		auto snapshot = std::make_unique<FakeSnapshot>();
+		snapshot->pidlDirectory = GetKnownFolderPidl(folderId);
+		snapshot->value = value;
+		return snapshot;
+	}
+}
+
+TEST(TestFolderSnapshotCache, TestSaveAndTake)
+{
+	FolderSnapshotCache<FakeSnapshot> snapshots(4);
+
+	snapshots.save(BuildSnapshot(FOLDERID_Desktop, 1));
+	snapshots.save(BuildSnapshot(FOLDERID_Windows, 2));
+	EXPECT_EQ(2U, snapshots.size());
+
+	auto snapshot = snapshots.take(GetKnownFolderPidl(FOLDERID_Windows).get());
+	ASSERT_NE(nullptr, snapshot);
+	EXPECT_EQ(2, snapshot->value);
+
+	// A snapshot can only be taken once.
+	EXPECT_EQ(1U, snapshots.size());
+	EXPECT_EQ(nullptr, snapshots.take(GetKnownFolderPidl(FOLDERID_Windows).get()));
+
+	EXPECT_EQ(nullptr, snapshots.take(GetKnownFolderPidl(FOLDERID_System).get()));
+}
+
+TEST(TestFolderSnapshotCache, TestSaveReplacesExisting)
+{
+	FolderSnapshotCache<FakeSnapshot> snapshots(4);
+
+	snapshots.save(BuildSnapshot(FOLDERID_Desktop, 1));
+	snapshots.save(BuildSnapshot(FOLDERID_Desktop, 2));
+	EXPECT_EQ(1U, snapshots.size());
+
+	auto snapshot = snapshots.take(GetKnownFolderPidl(FOLDERID_Desktop).get());
+	ASSERT_NE(nullptr, snapshot);
+	EXPECT_EQ(2, snapshot->value);
+}
+
+TEST(TestFolderSnapshotCache, TestTakeAndRestore)
+{
+	FolderSnapshotCache<FakeSnapshot> snapshots(4);
+
+	snapshots.save(BuildSnapshot(FOLDERID_Desktop, 1));
+
+	// Mirrors going back to a folder and then leaving it again, in
+	// which case the snapshot is restored and then saved once more.
+	auto snapshot = snapshots.take(GetKnownFolderPidl(FOLDERID_Desktop).get());
+	ASSERT_NE(nullptr, snapshot);
+	EXPECT_EQ(0U, snapshots.size());
+
+	snapshot->value = 2;
+	snapshots.save(std::move(snapshot));
+
+	snapshot = snapshots.take(GetKnownFolderPidl(FOLDERID_Desktop).get());
+	ASSERT_NE(nullptr, snapshot);
+	EXPECT_EQ(2, snapshot->value);
+}
+
+TEST(TestFolderSnapshotCache, TestEviction)
+{
+	FolderSnapshotCache<FakeSnapshot> snapshots(2);
+
+	snapshots.save(BuildSnapshot(FOLDERID_Desktop, 1));
+	snapshots.save(BuildSnapshot(FOLDERID_Windows, 2));
+
+	// Saving the desktop again should make it the most recent snapshot,
+	// so that the Windows folder is evicted below.
+	snapshots.save(BuildSnapshot(FOLDERID_Desktop, 3));
+	snapshots.save(BuildSnapshot(FOLDERID_System, 4));
+	EXPECT_EQ(2U, snapshots.size());
+
+	EXPECT_EQ(nullptr, snapshots.take(GetKnownFolderPidl(FOLDERID_Windows).get()));
+
+	auto snapshot = snapshots.take(GetKnownFolderPidl(FOLDERID_Desktop).get());
+	ASSERT_NE(nullptr, snapshot);
+	EXPECT_EQ(3, snapshot->value);
+
+	snapshot = snapshots.take(GetKnownFolderPidl(FOLDERID_System).get());
+	ASSERT_NE(nullptr, snapshot);
+	EXPECT_EQ(4, snapshot->value);
+}
@@ -0,0 +1,382 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Explorer++/ShellBrowser/IconCache.h"
+#include <boost/filesystem.hpp>
+#include <boost/optional/optional_io.hpp>
+#include <ShlObj.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	/* Resolves each location to a fake index, and records how many
+	times it's been called. */
+	class FakeResolver
+	{
+	public:
+
+		FakeResolver() :
+			m_numCalls(std::make_shared<int>(0))
+		{
+
+		}
+
+		IconCache::IconIndexResolver Get()
+		{
+			auto numCalls = m_numCalls;
+
+			return [numCalls] (const IconLocation &location) -> boost::optional<int> {
+				(*numCalls)++;
+				return static_cast<int>(location.file.size()) * 100 + location.index;
+			};
+		}
+
+		int GetNumCalls() const
+		{
+			return *m_numCalls;
+		}
+
+	private:
+
+		std::shared_ptr<int> m_numCalls;
+	};
+
+	int GetFakeIndex(const IconLocation &location)
+	{
+		return static_cast<int>(location.file.size()) * 100 + location.index;
+	}
+
+	/* Mirrors GetItemIconLocation() in the helper library, which
+	the tests don't link against. */
+	HRESULT GetIconLocationForPath(const std::wstring &path, IconLocation &location, UINT &flags)
+	{
+		PIDLIST_ABSOLUTE pidl;
+		HRESULT hr = SHParseDisplayName(path.c_str(), nullptr, &pidl, 0, nullptr);
+
+		if (FAILED(hr))
+		{
+			return hr;
+		}
+
+		IShellFolder *shellFolder;
+		PCUITEMID_CHILD pidlChild;
+		hr = SHBindToParent(pidl, IID_PPV_ARGS(&shellFolder), &pidlChild);
+
+		if (SUCCEEDED(hr))
+		{
+			IExtractIcon *extractIcon;
+			hr = shellFolder->GetUIObjectOf(nullptr, 1, &pidlChild, IID_IExtractIcon, nullptr,
+				reinterpret_cast<void **>(&extractIcon));
+
+			if (SUCCEEDED(hr))
+			{
+				TCHAR iconFile[MAX_PATH];
+				hr = extractIcon->GetIconLocation(GIL_FORSHELL, iconFile, MAX_PATH, &location.index, &flags);
+
+				if (hr == S_OK)
+				{
+					location.file = iconFile;
+				}
+				else
+				{
+					hr = E_FAIL;
+				}
+
+				extractIcon->Release();
+			}
+
+			shellFolder->Release();
+		}
+
+		CoTaskMemFree(pidl);
+
+		return hr;
+	}
+}
+
+TEST(TestIconCache, TestExtensionTier)
+{
+	FakeResolver resolver;
+	IconCache iconCache(L"", 10, resolver.Get());
+
+	IconLocation textLocation = { L"C:\\Windows\\system32\\imageres.dll", 97 };
+	iconCache.Insert(L"C:\\file1.txt", false, textLocation, true);
+
+	EXPECT_EQ(1U, iconCache.GetNumExtensionEntries());
+	EXPECT_EQ(0U, iconCache.GetNumPathEntries());
+
+	// Any file with the same extension should use the same icon.
+	EXPECT_EQ(GetFakeIndex(textLocation), iconCache.Lookup(L"D:\\folder\\file2.TXT", false));
+	EXPECT_EQ(GetFakeIndex(textLocation), iconCache.Lookup(L"C:\\file3.txt", false));
+	EXPECT_FALSE(iconCache.Lookup(L"C:\\file.jpg", false));
+
+	// A folder named like a file shouldn't match.
+	EXPECT_FALSE(iconCache.Lookup(L"C:\\folder.txt", true));
+
+	// The location should only have been resolved once.
+	EXPECT_EQ(1, resolver.GetNumCalls());
+}
+
+TEST(TestIconCache, TestPathTier)
+{
+	FakeResolver resolver;
+	IconCache iconCache(L"", 10, resolver.Get());
+
+	IconLocation appLocation = { L"C:\\app.exe", 0 };
+	iconCache.Insert(L"C:\\app.exe", false, appLocation, false);
+
+	// Folders are always cached by path.
+	IconLocation folderLocation = { L"C:\\Windows\\system32\\shell32.dll", 4 };
+	iconCache.Insert(L"C:\\folder", true, folderLocation, true);
+
+	EXPECT_EQ(0U, iconCache.GetNumExtensionEntries());
+	EXPECT_EQ(2U, iconCache.GetNumPathEntries());
+
+	EXPECT_EQ(GetFakeIndex(appLocation), iconCache.Lookup(L"C:\\app.exe", false));
+	EXPECT_FALSE(iconCache.Lookup(L"C:\\other.exe", false));
+	EXPECT_EQ(GetFakeIndex(folderLocation), iconCache.Lookup(L"C:\\folder", true));
+	EXPECT_FALSE(iconCache.Lookup(L"C:\\other", true));
+}
+
+TEST(TestIconCache, TestPathTakesPriority)
+{
+	FakeResolver resolver;
+	IconCache iconCache(L"", 10, resolver.Get());
+
+	IconLocation classLocation = { L"C:\\class.dll", 1 };
+	iconCache.Insert(L"C:\\file1.ico", false, classLocation, true);
+
+	IconLocation fileLocation = { L"C:\\file2.ico", 0 };
+	iconCache.Insert(L"C:\\file2.ico", false, fileLocation, false);
+
+	EXPECT_EQ(GetFakeIndex(classLocation), iconCache.Lookup(L"C:\\file1.ico", false));
+	EXPECT_EQ(GetFakeIndex(fileLocation), iconCache.Lookup(L"C:\\file2.ico", false));
+}
+
+TEST(TestIconCache, TestMaxPathEntries)
+{
+	FakeResolver resolver;
+	IconCache iconCache(L"", 2, resolver.Get());
+
+	iconCache.Insert(L"C:\\file1.exe", false, { L"C:\\file1.exe", 0 }, false);
+	iconCache.Insert(L"C:\\file2.exe", false, { L"C:\\file2.exe", 0 }, false);
+
+	// Looking up file1 should make it the most recently used item, so
+	// that it's file2 that's removed below.
+	EXPECT_TRUE(iconCache.Lookup(L"C:\\file1.exe", false));
+
+	iconCache.Insert(L"C:\\file3.exe", false, { L"C:\\file3.exe", 0 }, false);
+
+	EXPECT_EQ(2U, iconCache.GetNumPathEntries());
+	EXPECT_TRUE(iconCache.Lookup(L"C:\\file1.exe", false));
+	EXPECT_FALSE(iconCache.Lookup(L"C:\\file2.exe", false));
+	EXPECT_TRUE(iconCache.Lookup(L"C:\\file3.exe", false));
+}
+
+TEST(TestIconCache, TestReplace)
+{
+	FakeResolver resolver;
+	IconCache iconCache(L"", 10, resolver.Get());
+
+	iconCache.Insert(L"C:\\file1.txt", false, { L"C:\\old.dll", 1 }, true);
+	iconCache.Insert(L"C:\\file1.txt", false, { L"C:\\new.dll", 2 }, true);
+
+	iconCache.Insert(L"C:\\file1.exe", false, { L"C:\\file1.exe", 0 }, false);
+	iconCache.Insert(L"C:\\file1.exe", false, { L"C:\\file1.exe", 1 }, false);
+
+	EXPECT_EQ(1U, iconCache.GetNumExtensionEntries());
+	EXPECT_EQ(1U, iconCache.GetNumPathEntries());
+
+	EXPECT_EQ(GetFakeIndex({ L"C:\\new.dll", 2 }), iconCache.Lookup(L"C:\\file2.txt", false));
+	EXPECT_EQ(GetFakeIndex({ L"C:\\file1.exe", 1 }), iconCache.Lookup(L"C:\\file1.exe", false));
+}
+
+TEST(TestIconCache, TestSaveAndLoad)
+{
+	FakeResolver resolver;
+	IconCache iconCache(L"", 10, resolver.Get());
+
+	iconCache.Insert(L"C:\\file1.txt", false, { L"C:\\shared.dll", 1 }, true);
+	iconCache.Insert(L"C:\\file1.jpg", false, { L"C:\\shared.dll", 2 }, true);
+	iconCache.Insert(L"C:\\file1.exe", false, { L"C:\\file1.exe", 0 }, false);
+	iconCache.Insert(L"C:\\file2.exe", false, { L"C:\\file2.exe", 0 }, false);
+
+	std::stringstream stream;
+	iconCache.Save(stream);
+
+	IconCache loadedIconCache(L"", 2, resolver.Get());
+	EXPECT_TRUE(loadedIconCache.Load(stream));
+
+	EXPECT_EQ(2U, loadedIconCache.GetNumExtensionEntries());
+	EXPECT_EQ(2U, loadedIconCache.GetNumPathEntries());
+
+	EXPECT_EQ(GetFakeIndex({ L"C:\\shared.dll", 1 }), loadedIconCache.Lookup(L"C:\\file2.txt", false));
+	EXPECT_EQ(GetFakeIndex({ L"C:\\shared.dll", 2 }), loadedIconCache.Lookup(L"C:\\file2.jpg", false));
+
+	// The LRU order should have been kept, so file1 (the least
+	// recently used item) is removed here.
+	loadedIconCache.Insert(L"C:\\file3.exe", false, { L"C:\\file3.exe", 0 }, false);
+	EXPECT_FALSE(loadedIconCache.Lookup(L"C:\\file1.exe", false));
+	EXPECT_TRUE(loadedIconCache.Lookup(L"C:\\file2.exe", false));
+}
+
+TEST(TestIconCache, TestLoadInvalidData)
+{
+	FakeResolver resolver;
+	IconCache iconCache(L"", 10, resolver.Get());
+	iconCache.Insert(L"C:\\file1.txt", false, { L"C:\\shared.dll", 1 }, true);
+
+	std::stringstream validStream;
+	iconCache.Save(validStream);
+
+	std::string truncatedData = validStream.str();
+	truncatedData.resize(truncatedData.size() - 1);
+
+	for (const auto &data : { std::string("invalid"), truncatedData })
+	{
+		std::stringstream stream(data);
+
+		IconCache loadedIconCache(L"", 10, resolver.Get());
+		EXPECT_FALSE(loadedIconCache.Load(stream));
+		EXPECT_EQ(0U, loadedIconCache.GetNumExtensionEntries());
+		EXPECT_FALSE(loadedIconCache.Lookup(L"C:\\file1.txt", false));
+	}
+}
+
+TEST(TestIconCache, TestLoadsFileLazily)
+{
+	boost::filesystem::path cacheFile = boost::filesystem::temp_directory_path()
+		/ boost::filesystem::unique_path();
+
+	FakeResolver resolver;
+
+	// The file is only read the first time the cache is used, so it
+	// doesn't need to exist when the cache is constructed.
+	IconCache iconCache(cacheFile, 10, resolver.Get());
+
+	{
+		IconCache savedIconCache(cacheFile, 10, resolver.Get());
+		savedIconCache.Insert(L"C:\\file1.txt", false, { L"C:\\shared.dll", 1 }, true);
+		EXPECT_TRUE(savedIconCache.Save());
+	}
+
+	EXPECT_TRUE(iconCache.Lookup(L"C:\\file2.txt", false));
+	EXPECT_EQ(1U, iconCache.GetNumExtensionEntries());
+
+	boost::filesystem::remove(cacheFile);
+}
+
+// Compares the time taken to find the icon for every item in a
+// 10,000 file folder, both without the cache (as on a cold start,
+// where each item has to go through SHGetFileInfo) and with a cache
+// that's been saved and loaded back in (as on a warm start). This
+// is disabled by default; run it with
+// --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+TEST(TestIconCache, DISABLED_BenchmarkFirstPaint)
+{
+	const int NUM_FILES = 10000;
+	const std::vector<std::wstring> EXTENSIONS = { L".txt", L".jpg", L".png", L".pdf", L".zip",
+		L".cpp", L".h", L".docx", L".xlsx", L".mp3" };
+
+	ASSERT_TRUE(SUCCEEDED(CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED)));
+
+	boost::filesystem::path folder = boost::filesystem::temp_directory_path()
+		/ boost::filesystem::unique_path();
+	boost::filesystem::create_directory(folder);
+
+	std::vector<std::wstring> files;
+
+	for (int i = 0; i < NUM_FILES; i++)
+	{
+		boost::filesystem::path file = folder / (L"File " + std::to_wstring(i)
+			+ EXTENSIONS[i % EXTENSIONS.size()]);
+		std::ofstream(file.wstring());
+		files.push_back(file.wstring());
+	}
+
+	boost::filesystem::path cacheFile = folder / L"icons.dat";
+
+	auto resolveIconIndex = [] (const IconLocation &location) -> boost::optional<int> {
+		int iconIndex = Shell_GetCachedImageIndex(location.file.c_str(), location.index, 0);
+
+		if (iconIndex == -1)
+		{
+			return boost::none;
+		}
+
+		return iconIndex;
+	};
+
+	{
+		IconCache iconCache(cacheFile, NUM_FILES, resolveIconIndex);
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (const auto &file : files)
+		{
+			SHFILEINFO shfi;
+			DWORD_PTR res = SHGetFileInfo(file.c_str(), 0, &shfi, sizeof(shfi), SHGFI_SYSICONINDEX);
+			EXPECT_NE(0U, res);
+		}
+
+		auto end = std::chrono::steady_clock::now();
+
+		std::cout << "Cold: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+			<< " ms" << std::endl;
+
+		// Fill the cache in the same way the icon retrieval tasks
+		// would.
+		for (const auto &file : files)
+		{
+			IconLocation location;
+			UINT flags;
+			HRESULT hr = GetIconLocationForPath(file, location, flags);
+
+			if (SUCCEEDED(hr) && (flags & GIL_NOTFILENAME) == 0)
+			{
+				iconCache.Insert(file, false, location,
+					(flags & GIL_PERCLASS) == GIL_PERCLASS && (flags & GIL_PERINSTANCE) == 0);
+			}
+		}
+
+		EXPECT_TRUE(iconCache.Save());
+
+		std::cout << "Extension entries: " << iconCache.GetNumExtensionEntries()
+			<< ", path entries: " << iconCache.GetNumPathEntries()
+			<< ", file size: " << boost::filesystem::file_size(cacheFile) << " bytes" << std::endl;
+	}
+
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		// Loading the file is included in the time, since that
+		// happens as part of the first lookup.
+		IconCache iconCache(cacheFile, NUM_FILES, resolveIconIndex);
+		int numFound = 0;
+
+		for (const auto &file : files)
+		{
+			if (iconCache.Lookup(file, false))
+			{
+				numFound++;
+			}
+		}
+
+		auto end = std::chrono::steady_clock::now();
+
+		std::cout << "Warm: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+			<< " ms (" << numFound << " of " << NUM_FILES << " icons found)" << std::endl;
+	}
+
+	boost::filesystem::remove_all(folder);
+
+	CoUninitialize();
+}
@@ -0,0 +1,156 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Explorer++/ShellBrowser/ItemFilter.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+TEST(TestItemFilter, TestSetItemVisible)
+{
+	ItemFilter itemFilter;
+
+	itemFilter.setItemVisible(0, true);
+	itemFilter.setItemVisible(5, false);
+	itemFilter.setItemVisible(2, true);
+
+	EXPECT_EQ(3, itemFilter.getNumItems());
+	EXPECT_EQ(2, itemFilter.getNumVisibleItems());
+	EXPECT_TRUE(itemFilter.isItemVisible(0));
+	EXPECT_FALSE(itemFilter.isItemVisible(5));
+	EXPECT_TRUE(itemFilter.containsItem(5));
+	EXPECT_FALSE(itemFilter.containsItem(1));
+	EXPECT_FALSE(itemFilter.containsItem(100));
+
+	itemFilter.setItemVisible(5, true);
+	itemFilter.setItemVisible(0, false);
+
+	EXPECT_EQ(3, itemFilter.getNumItems());
+	EXPECT_EQ(2, itemFilter.getNumVisibleItems());
+
+	itemFilter.removeItem(5);
+	itemFilter.removeItem(1);
+
+	EXPECT_EQ(2, itemFilter.getNumItems());
+	EXPECT_EQ(1, itemFilter.getNumVisibleItems());
+	EXPECT_FALSE(itemFilter.containsItem(5));
+
+	itemFilter.clear();
+
+	EXPECT_EQ(0, itemFilter.getNumItems());
+	EXPECT_FALSE(itemFilter.containsItem(0));
+}
+
+TEST(TestItemFilter, TestUpdate)
+{
+	ItemFilter itemFilter;
+
+	for (int i = 0; i < 10; i++)
+	{
+		itemFilter.setItemVisible(i, true);
+	}
+
+	auto diff = itemFilter.update(ItemFilter::Scope::AllItems, [] (int internalIndex) {
+		return internalIndex % 2 == 0;
+	});
+
+	EXPECT_EQ(std::vector<int>({ 1, 3, 5, 7, 9 }), diff.hiddenItems);
+	EXPECT_TRUE(diff.shownItems.empty());
+	EXPECT_EQ(5, itemFilter.getNumVisibleItems());
+
+	diff = itemFilter.update(ItemFilter::Scope::AllItems, [] (int internalIndex) {
+		return internalIndex < 5;
+	});
+
+	EXPECT_EQ(std::vector<int>({ 6, 8 }), diff.hiddenItems);
+	EXPECT_EQ(std::vector<int>({ 1, 3 }), diff.shownItems);
+	EXPECT_EQ(5, itemFilter.getNumVisibleItems());
+}
+
+TEST(TestItemFilter, TestNarrowingOnlyTestsVisibleItems)
+{
+	ItemFilter itemFilter;
+
+	for (int i = 0; i < 10; i++)
+	{
+		itemFilter.setItemVisible(i, i < 4);
+	}
+
+	std::vector<int> testedItems;
+
+	auto diff = itemFilter.update(ItemFilter::Scope::VisibleItems, [&testedItems] (int internalIndex) {
+		testedItems.push_back(internalIndex);
+		return internalIndex < 2;
+	});
+
+	EXPECT_EQ(std::vector<int>({ 0, 1, 2, 3 }), testedItems);
+	EXPECT_EQ(std::vector<int>({ 2, 3 }), diff.hiddenItems);
+	EXPECT_TRUE(diff.shownItems.empty());
+}
+
+TEST(TestItemFilter, TestWideningOnlyTestsHiddenItems)
+{
+	ItemFilter itemFilter;
+
+	for (int i = 0; i < 10; i++)
+	{
+		itemFilter.setItemVisible(i, i < 4);
+	}
+
+	itemFilter.removeItem(9);
+
+	std::vector<int> testedItems;
+
+	auto diff = itemFilter.update(ItemFilter::Scope::HiddenItems, [&testedItems] (int internalIndex) {
+		testedItems.push_back(internalIndex);
+		return internalIndex < 6;
+	});
+
+	EXPECT_EQ(std::vector<int>({ 4, 5, 6, 7, 8 }), testedItems);
+	EXPECT_EQ(std::vector<int>({ 4, 5 }), diff.shownItems);
+	EXPECT_TRUE(diff.hiddenItems.empty());
+	EXPECT_EQ(6, itemFilter.getNumVisibleItems());
+}
+
+// Simulates typing a filter, one character at a time, in a folder with
+// 100,000 items. Each keystroke narrows the filter, so only the items
+// that matched the previous filter need to be tested. This is disabled
+// by default; run it with
+// --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+TEST(TestItemFilter, DISABLED_BenchmarkTypeFilter)
+{
+	const int NUM_ITEMS = 100000;
+	const std::wstring FILTER_TEXT = L"12345";
+
+	std::vector<std::wstring> names;
+	ItemFilter itemFilter;
+
+	for (int i = 0; i < NUM_ITEMS; i++)
+	{
+		names.push_back(L"File " + std::to_wstring(i * 7) + L".txt");
+		itemFilter.setItemVisible(i, true);
+	}
+
+	for (size_t length = 1; length <= FILTER_TEXT.size(); length++)
+	{
+		std::wstring filter = FILTER_TEXT.substr(0, length);
+		int numTested = 0;
+
+		auto start = std::chrono::steady_clock::now();
+
+		auto diff = itemFilter.update(ItemFilter::Scope::VisibleItems,
+			[&names, &filter, &numTested] (int internalIndex) {
+			numTested++;
+			return names[internalIndex].find(filter) != std::wstring::npos;
+		});
+
+		auto end = std::chrono::steady_clock::now();
+
+		std::wcout << L"\"" << filter << L"\": "
+			<< std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << L" us, "
+			<< numTested << L" items tested, " << diff.hiddenItems.size() << L" hidden" << std::endl;
+	}
+}
@@ -0,0 +1,82 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Explorer++/ShellBrowser/ItemResultBatch.h"
+
+namespace
+{
+	struct TestResult
+	{
+		int generation;
+		int value;
+	};
+}
+
+TEST(TestItemResultBatch, TestSingleNotificationPerDrain)
+{
+	ResultNotifier notifier;
+
+	// Only the first result in a burst should trigger a notification.
+	EXPECT_TRUE(notifier.onResultAdded());
+	EXPECT_FALSE(notifier.onResultAdded());
+	EXPECT_FALSE(notifier.onResultAdded());
+
+	notifier.onDrainStarted();
+
+	// A result that arrives once draining has started may have been
+	// missed, so the consumer needs to be notified again.
+	EXPECT_TRUE(notifier.onResultAdded());
+	EXPECT_FALSE(notifier.onResultAdded());
+}
+
+TEST(TestItemResultBatch, TestTakeCurrentResults)
+{
+	MPSCQueue<TestResult> queue;
+	queue.Push({ 1, 10 });
+	queue.Push({ 2, 20 });
+	queue.Push({ 1, 11 });
+	queue.Push({ 2, 21 });
+
+	auto results = TakeCurrentResults(queue, 2);
+
+	ASSERT_EQ(2U, results.size());
+	EXPECT_EQ(20, results[0].value);
+	EXPECT_EQ(21, results[1].value);
+
+	// Stale results are removed from the queue as well.
+	EXPECT_TRUE(queue.IsEmpty());
+	EXPECT_TRUE(TakeCurrentResults(queue, 1).empty());
+}
+
+TEST(TestItemResultBatch, TestTakeCurrentResultsAllStale)
+{
+	MPSCQueue<TestResult> queue;
+	queue.Push({ 1, 10 });
+	queue.Push({ 1, 11 });
+
+	EXPECT_TRUE(TakeCurrentResults(queue, 2).empty());
+	EXPECT_TRUE(queue.IsEmpty());
+}
+
+TEST(TestItemResultBatch, TestUpdatedRowRange)
+{
+	UpdatedRowRange updatedRows;
+	EXPECT_TRUE(updatedRows.isEmpty());
+
+	// Results for items that aren't shown don't update any row.
+	updatedRows.addRow(boost::none);
+	EXPECT_TRUE(updatedRows.isEmpty());
+
+	updatedRows.addRow(5);
+	EXPECT_FALSE(updatedRows.isEmpty());
+	EXPECT_EQ(5, updatedRows.getFirstRow());
+	EXPECT_EQ(5, updatedRows.getLastRow());
+
+	updatedRows.addRow(8);
+	updatedRows.addRow(0);
+	updatedRows.addRow(3);
+	EXPECT_EQ(0, updatedRows.getFirstRow());
+	EXPECT_EQ(8, updatedRows.getLastRow());
+}
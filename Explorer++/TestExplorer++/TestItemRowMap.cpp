@@ -0,0 +1,96 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Explorer++/ShellBrowser/ItemRowMap.h"
+#include <random>
+
+TEST(TestItemRowMap, TestInsertAndRemove)
+{
+	ItemRowMap itemRows;
+
+	itemRows.insertItem(0, 10);
+	itemRows.insertItem(1, 11);
+	itemRows.insertItem(0, 12);
+
+	EXPECT_EQ(3, itemRows.size());
+	EXPECT_EQ(boost::optional<int>(0), itemRows.getRow(12));
+	EXPECT_EQ(boost::optional<int>(1), itemRows.getRow(10));
+	EXPECT_EQ(boost::optional<int>(2), itemRows.getRow(11));
+
+	itemRows.removeRow(1);
+
+	EXPECT_EQ(boost::none, itemRows.getRow(10));
+	EXPECT_EQ(boost::optional<int>(1), itemRows.getRow(11));
+	EXPECT_EQ(11, itemRows.getInternalIndex(1));
+
+	itemRows.clear();
+
+	EXPECT_EQ(0, itemRows.size());
+	EXPECT_EQ(boost::none, itemRows.getRow(11));
+}
+
+TEST(TestItemRowMap, TestSetRows)
+{
+	ItemRowMap itemRows;
+
+	itemRows.insertItem(0, 1);
+	itemRows.insertItem(1, 2);
+	itemRows.insertItem(2, 3);
+
+	itemRows.setRows({ 3, 1, 2 });
+
+	EXPECT_EQ(boost::optional<int>(0), itemRows.getRow(3));
+	EXPECT_EQ(boost::optional<int>(1), itemRows.getRow(1));
+	EXPECT_EQ(boost::optional<int>(2), itemRows.getRow(2));
+}
+
+// Performs a long sequence of random insertions and removals, checking
+// that every lookup agrees with a simple vector of rows.
+TEST(TestItemRowMap, TestRandomOperations)
+{
+	ItemRowMap itemRows;
+	std::vector<int> expectedRows;
+	std::mt19937 generator(1);
+	int nextInternalIndex = 0;
+
+	for (int i = 0; i < 10000; i++)
+	{
+		switch (generator() % 3)
+		{
+		case 0:
+		{
+			int row = generator() % (expectedRows.size() + 1);
+			expectedRows.insert(expectedRows.begin() + row, nextInternalIndex);
+			itemRows.insertItem(row, nextInternalIndex);
+			nextInternalIndex++;
+		}
+			break;
+
+		case 1:
+			if (!expectedRows.empty())
+			{
+				int row = generator() % expectedRows.size();
+				expectedRows.erase(expectedRows.begin() + row);
+				itemRows.removeRow(row);
+			}
+			break;
+
+		case 2:
+			if (!expectedRows.empty())
+			{
+				int row = generator() % expectedRows.size();
+				EXPECT_EQ(boost::optional<int>(row), itemRows.getRow(expectedRows[row]));
+			}
+			break;
+		}
+	}
+
+	ASSERT_EQ(static_cast<int>(expectedRows.size()), itemRows.size());
+
+	for (int row = 0; row < itemRows.size(); row++)
+	{
+		EXPECT_EQ(boost::optional<int>(row), itemRows.getRow(expectedRows[row]));
+	}
+}
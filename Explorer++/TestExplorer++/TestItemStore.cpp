@@ -0,0 +1,190 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Explorer++/ShellBrowser/ItemStore.h"
+#include "../Helper/Macros.h"
+#include <ShlObj.h>
+#include <strsafe.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// Builds a single-level PIDL whose item data is the supplied
+	// value. The contents don't need to be meaningful, as the store
+	// only ever copies PIDLs.
+	std::vector<BYTE> BuildPidl(UINT value)
+	{
+		USHORT itemSize = sizeof(USHORT) + sizeof(value);
+
+		std::vector<BYTE> pidl(itemSize + sizeof(USHORT), 0);
+		memcpy(pidl.data(), &itemSize, sizeof(itemSize));
+		memcpy(pidl.data() + sizeof(USHORT), &value, sizeof(value));
+
+		return pidl;
+	}
+
+	WIN32_FIND_DATA BuildFindData(const std::wstring &fileName, ULONGLONG size, DWORD attributes)
+	{
+		WIN32_FIND_DATA wfd = {};
+		wfd.dwFileAttributes = attributes;
+		wfd.nFileSizeLow = static_cast<DWORD>(size);
+		wfd.nFileSizeHigh = static_cast<DWORD>(size >> 32);
+		wfd.ftLastWriteTime.dwLowDateTime = static_cast<DWORD>(size * 3);
+		StringCchCopy(wfd.cFileName, SIZEOF_ARRAY(wfd.cFileName), fileName.c_str());
+
+		return wfd;
+	}
+
+	void AddSyntheticItem(ItemStore &itemStore, int id)
+	{
+		std::wstring fileName = L"File " + std::to_wstring(id) + L".txt";
+		WIN32_FIND_DATA wfd = BuildFindData(fileName, (static_cast<ULONGLONG>(id) * 7919) % 100000,
+			(id % 10 == 0) ? FILE_ATTRIBUTE_HIDDEN : FILE_ATTRIBUTE_NORMAL);
+		std::vector<BYTE> pidl = BuildPidl(id);
+
+		itemStore.addItem(id, wfd, fileName.c_str(), reinterpret_cast<LPCITEMIDLIST>(pidl.data()),
+			reinterpret_cast<LPCITEMIDLIST>(pidl.data()));
+	}
+}
+
+TEST(TestItemStore, TestAddAndRetrieve)
+{
+	ItemStore itemStore;
+	EXPECT_TRUE(itemStore.empty());
+
+	WIN32_FIND_DATA wfd = BuildFindData(L"file.txt", 0x100000002ULL, FILE_ATTRIBUTE_ARCHIVE);
+	StringCchCopy(wfd.cAlternateFileName, SIZEOF_ARRAY(wfd.cAlternateFileName), L"FILE~1.TXT");
+	std::vector<BYTE> pidlComplete = BuildPidl(1);
+	std::vector<BYTE> pidlRelative = BuildPidl(2);
+
+	itemStore.addItem(5, wfd, L"file", reinterpret_cast<LPCITEMIDLIST>(pidlComplete.data()),
+		reinterpret_cast<LPCITEMIDLIST>(pidlRelative.data()));
+
+	EXPECT_FALSE(itemStore.empty());
+	EXPECT_TRUE(itemStore.containsItem(5));
+	EXPECT_FALSE(itemStore.containsItem(4));
+
+	EXPECT_EQ(static_cast<DWORD>(FILE_ATTRIBUTE_ARCHIVE), itemStore.getAttributes(5));
+	EXPECT_EQ(0x100000002ULL, itemStore.getSize(5));
+	EXPECT_EQ(wfd.ftLastWriteTime.dwLowDateTime, itemStore.getLastWriteTime(5).dwLowDateTime);
+	EXPECT_STREQ(L"file.txt", itemStore.getFileName(5));
+	EXPECT_STREQ(L"FILE~1.TXT", itemStore.getAlternateFileName(5));
+	EXPECT_STREQ(L"file", itemStore.getDisplayName(5));
+	EXPECT_EQ(nullptr, itemStore.getDrive(5));
+
+	EXPECT_EQ(pidlComplete.size(), ILGetSize(itemStore.getPidlComplete(5)));
+	EXPECT_EQ(0, memcmp(pidlComplete.data(), itemStore.getPidlComplete(5), pidlComplete.size()));
+	EXPECT_EQ(0, memcmp(pidlRelative.data(), itemStore.getPidlRelative(5), pidlRelative.size()));
+
+	WIN32_FIND_DATA storedFindData = itemStore.getFindData(5);
+	EXPECT_EQ(wfd.nFileSizeLow, storedFindData.nFileSizeLow);
+	EXPECT_EQ(wfd.nFileSizeHigh, storedFindData.nFileSizeHigh);
+	EXPECT_STREQ(wfd.cFileName, storedFindData.cFileName);
+	EXPECT_STREQ(wfd.cAlternateFileName, storedFindData.cAlternateFileName);
+}
+
+TEST(TestItemStore, TestUpdateAndRemove)
+{
+	ItemStore itemStore;
+
+	for (int i = 0; i < 3; i++)
+	{
+		AddSyntheticItem(itemStore, i);
+	}
+
+	itemStore.setFileName(1, L"renamed.txt");
+	itemStore.setDisplayName(1, L"renamed");
+	itemStore.setSize(1, 42);
+	itemStore.setRelativeSort(1, 7);
+	itemStore.setDrive(2, L"C:\\");
+
+	EXPECT_STREQ(L"renamed.txt", itemStore.getFileName(1));
+	EXPECT_STREQ(L"renamed", itemStore.getDisplayName(1));
+	EXPECT_EQ(42ULL, itemStore.getSize(1));
+	EXPECT_EQ(7, itemStore.getRelativeSort(1));
+	EXPECT_STREQ(L"C:\\", itemStore.getDrive(2));
+
+	itemStore.removeItem(1);
+
+	EXPECT_FALSE(itemStore.containsItem(1));
+	EXPECT_THROW(itemStore.getFileName(1), std::out_of_range);
+	EXPECT_EQ(std::vector<int>({ 0, 2 }), itemStore.getItemIds());
+
+	itemStore.clear();
+
+	EXPECT_TRUE(itemStore.empty());
+	EXPECT_TRUE(itemStore.getItemIds().empty());
+}
+
+TEST(TestItemStore, TestStringsShared)
+{
+	ItemStore itemStore;
+	AddSyntheticItem(itemStore, 0);
+
+	// The display name is the same as the file name, so only a single
+	// copy should be stored.
+	EXPECT_EQ(itemStore.getFileName(0), itemStore.getDisplayName(0));
+}
+
+// Reports the memory used per item and the time taken to scan a
+// single field across a large synthetic folder. This is disabled by
+// default; run it with
+// --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+TEST(TestItemStore, DISABLED_BenchmarkMemoryAndScan)
+{
+	const int NUM_ITEMS = 1000000;
+
+	ItemStore itemStore;
+
+	for (int i = 0; i < NUM_ITEMS; i++)
+	{
+		AddSyntheticItem(itemStore, i);
+	}
+
+	// Previously, each item held (at least) a full WIN32_FIND_DATA
+	// structure and a MAX_PATH display name buffer.
+	std::cout << "Bytes per item: " << itemStore.getMemoryUsage() / NUM_ITEMS
+		<< " (fixed buffers alone previously used "
+		<< sizeof(WIN32_FIND_DATA) + MAX_PATH * sizeof(TCHAR) << ")" << std::endl;
+
+	auto start = std::chrono::steady_clock::now();
+
+	int numHidden = 0;
+
+	for (int i = 0; i < NUM_ITEMS; i++)
+	{
+		if (itemStore.getAttributes(i) & FILE_ATTRIBUTE_HIDDEN)
+		{
+			numHidden++;
+		}
+	}
+
+	auto end = std::chrono::steady_clock::now();
+
+	std::cout << "Attribute filter scan: "
+		<< std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+		<< " us" << std::endl;
+
+	EXPECT_EQ(NUM_ITEMS / 10, numHidden);
+
+	std::vector<int> ids(NUM_ITEMS);
+	std::iota(ids.begin(), ids.end(), 0);
+
+	start = std::chrono::steady_clock::now();
+	std::sort(ids.begin(), ids.end(), [&itemStore] (int id1, int id2) {
+		return itemStore.getSize(id1) < itemStore.getSize(id2);
+	});
+	end = std::chrono::steady_clock::now();
+
+	std::cout << "Size sort: "
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+		<< " ms" << std::endl;
+}
@@ -0,0 +1,80 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Explorer++/ShellBrowser/ListViewGroupSet.h"
+
+TEST(TestListViewGroupSet, TestAddItem)
+{
+	ListViewGroupSet groups;
+
+	EXPECT_EQ(std::make_pair(0, true), groups.addItem(L"Folder"));
+	EXPECT_EQ(std::make_pair(1, true), groups.addItem(L"Text Document"));
+	EXPECT_EQ(std::make_pair(0, false), groups.addItem(L"Folder"));
+
+	const ListViewGroupSet::Group *group = groups.getGroup(0);
+	ASSERT_NE(nullptr, group);
+	EXPECT_EQ(L"Folder", group->header);
+	EXPECT_EQ(2, group->numItems);
+
+	EXPECT_EQ(nullptr, groups.getGroup(2));
+	EXPECT_EQ(nullptr, groups.getGroup(-1));
+}
+
+TEST(TestListViewGroupSet, TestHeadersMatchedCaseInsensitively)
+{
+	ListViewGroupSet groups;
+
+	EXPECT_EQ(std::make_pair(0, true), groups.addItem(L"Text Document"));
+	EXPECT_EQ(std::make_pair(0, false), groups.addItem(L"TEXT DOCUMENT"));
+	EXPECT_EQ(std::make_pair(0, false), groups.addItem(L"text document"));
+
+	// The header of the first item added is the one kept.
+	EXPECT_EQ(L"Text Document", groups.getGroup(0)->header);
+	EXPECT_EQ(3, groups.getGroup(0)->numItems);
+}
+
+TEST(TestListViewGroupSet, TestTakeChangedGroups)
+{
+	ListViewGroupSet groups;
+
+	groups.addItem(L"A");
+	groups.addItem(L"B");
+	groups.addItem(L"A");
+
+	auto changedGroups = groups.takeChangedGroups();
+	ASSERT_EQ(2U, changedGroups.size());
+	EXPECT_EQ(0, changedGroups[0].id);
+	EXPECT_EQ(2, changedGroups[0].numItems);
+	EXPECT_EQ(1, changedGroups[1].id);
+	EXPECT_EQ(1, changedGroups[1].numItems);
+
+	// Nothing has changed since the counts were last taken.
+	EXPECT_TRUE(groups.takeChangedGroups().empty());
+
+	groups.addItem(L"B");
+	groups.addItem(L"C");
+
+	changedGroups = groups.takeChangedGroups();
+	ASSERT_EQ(2U, changedGroups.size());
+	EXPECT_EQ(1, changedGroups[0].id);
+	EXPECT_EQ(2, changedGroups[0].numItems);
+	EXPECT_EQ(2, changedGroups[1].id);
+	EXPECT_EQ(1, changedGroups[1].numItems);
+}
+
+TEST(TestListViewGroupSet, TestClear)
+{
+	ListViewGroupSet groups;
+
+	groups.addItem(L"A");
+	groups.addItem(L"B");
+	groups.clear();
+
+	EXPECT_EQ(nullptr, groups.getGroup(0));
+	EXPECT_TRUE(groups.takeChangedGroups().empty());
+
+	// Ids start again from zero.
+	EXPECT_EQ(std::make_pair(0, true), groups.addItem(L"B"));
+}
@@ -0,0 +1,72 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Explorer++/ShellBrowser/ItemRowMap.h"
+#include "../Explorer++/ShellBrowser/OwnerDataSelection.h"
+
+namespace
+{
+	ItemRowMap BuildItemRows(const std::vector<int> &internalIndices)
+	{
+		ItemRowMap itemRows;
+		itemRows.setRows(internalIndices);
+		return itemRows;
+	}
+}
+
+TEST(TestOwnerDataSelection, TestSelectionFollowsItems)
+{
+	ItemRowMap itemRows = BuildItemRows({ 10, 11, 12, 13 });
+
+	// Items 11 and 13 are selected, with item 13 focused.
+	OwnerDataSelection selection(itemRows, { 1, 3 }, 3);
+	EXPECT_TRUE(selection.hasSelection());
+
+	// Reversing the rows (e.g. by changing the sort direction) should
+	// move the selection along with the items.
+	itemRows.setRows({ 13, 12, 11, 10 });
+
+	EXPECT_EQ(std::vector<int>({ 2, 0 }), selection.getSelectedRows(itemRows));
+	EXPECT_EQ(boost::optional<int>(0), selection.getFocusedRow(itemRows));
+}
+
+TEST(TestOwnerDataSelection, TestInsertedRows)
+{
+	ItemRowMap itemRows = BuildItemRows({ 10, 11 });
+
+	OwnerDataSelection selection(itemRows, { 0 }, 1);
+
+	itemRows.insertItem(0, 20);
+	itemRows.insertItem(0, 21);
+
+	EXPECT_EQ(std::vector<int>({ 2 }), selection.getSelectedRows(itemRows));
+	EXPECT_EQ(boost::optional<int>(3), selection.getFocusedRow(itemRows));
+}
+
+TEST(TestOwnerDataSelection, TestRemovedItems)
+{
+	ItemRowMap itemRows = BuildItemRows({ 10, 11, 12 });
+
+	OwnerDataSelection selection(itemRows, { 0, 2 }, 0);
+
+	// Item 10 is filtered out.
+	itemRows.removeRow(0);
+
+	EXPECT_EQ(std::vector<int>({ 1 }), selection.getSelectedRows(itemRows));
+	EXPECT_EQ(boost::none, selection.getFocusedRow(itemRows));
+}
+
+TEST(TestOwnerDataSelection, TestNoSelection)
+{
+	ItemRowMap itemRows = BuildItemRows({ 10, 11 });
+
+	OwnerDataSelection selection(itemRows, {}, boost::none);
+	EXPECT_FALSE(selection.hasSelection());
+
+	itemRows.setRows({ 11, 10 });
+
+	EXPECT_TRUE(selection.getSelectedRows(itemRows).empty());
+	EXPECT_EQ(boost::none, selection.getFocusedRow(itemRows));
+}
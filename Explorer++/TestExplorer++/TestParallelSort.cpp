@@ -0,0 +1,134 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Explorer++/ShellBrowser/ParallelSort.h"
+#include "../Explorer++/ShellBrowser/SortKey.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace
+{
+	std::vector<SortKey> BuildSyntheticSortKeys(int numItems)
+	{
+		std::mt19937 generator(12345);
+		std::uniform_int_distribution<int> folderDistribution(0, 9);
+		std::uniform_int_distribution<ULONGLONG> sizeDistribution(0, 1ULL << 32);
+
+		std::vector<SortKey> sortKeys;
+		sortKeys.reserve(numItems);
+
+		for (int i = 0; i < numItems; i++)
+		{
+			SortKey sortKey;
+			sortKey.internalIndex = i;
+			sortKey.isFolder = (folderDistribution(generator) == 0);
+			sortKey.number = sizeDistribution(generator);
+			sortKey.displayNameCollationKey = GetCollationKey(L"File " + std::to_wstring(generator()) + L".txt");
+			sortKeys.push_back(std::move(sortKey));
+		}
+
+		return sortKeys;
+	}
+
+	void ShuffleSortKeys(std::vector<SortKey> &sortKeys)
+	{
+		std::mt19937 generator(54321);
+		std::shuffle(sortKeys.begin(), sortKeys.end(), generator);
+	}
+}
+
+TEST(TestParallelSort, TestMatchesSequentialSort)
+{
+	std::mt19937 generator(1);
+
+	for (int numThreads = 1; numThreads <= 8; numThreads++)
+	{
+		ctpl::thread_pool threadPool(numThreads);
+
+		for (int numItems : { 0, 1, 2, 7, 100, 10001 })
+		{
+			std::vector<unsigned int> items;
+
+			for (int i = 0; i < numItems; i++)
+			{
+				items.push_back(generator() % 1000);
+			}
+
+			std::vector<unsigned int> expected = items;
+			std::sort(expected.begin(), expected.end());
+
+			ParallelSort(threadPool, items.begin(), items.end(), std::less<unsigned int>());
+			EXPECT_EQ(expected, items);
+		}
+	}
+}
+
+TEST(TestParallelSort, TestSortKeys)
+{
+	ctpl::thread_pool threadPool(4);
+
+	for (bool foldersFirst : { true, false })
+	{
+		for (bool ascending : { true, false })
+		{
+			std::vector<SortKey> sortKeys = BuildSyntheticSortKeys(5000);
+
+			ParallelSort(threadPool, sortKeys.begin(), sortKeys.end(),
+				[foldersFirst, ascending] (const SortKey &sortKey1, const SortKey &sortKey2) {
+				return CompareSortKeys(sortKey1, sortKey2, foldersFirst, ascending) < 0;
+			});
+
+			for (size_t i = 1; i < sortKeys.size(); i++)
+			{
+				EXPECT_LE(CompareSortKeys(sortKeys[i - 1], sortKeys[i], foldersFirst, ascending), 0);
+			}
+
+			// The entire comparison (including the folder check) is
+			// reversed when sorting in descending order, so folders
+			// come first when ascending and last when descending.
+			if (foldersFirst)
+			{
+				auto firstOfSecondGroup = std::find_if(sortKeys.begin(), sortKeys.end(), [ascending] (const SortKey &sortKey) {
+					return sortKey.isFolder != ascending;
+				});
+
+				EXPECT_TRUE(std::none_of(firstOfSecondGroup, sortKeys.end(), [ascending] (const SortKey &sortKey) {
+					return sortKey.isFolder == ascending;
+				}));
+			}
+		}
+	}
+}
+
+// Times a resort of a large synthetic folder at various thread counts.
+// This is disabled by default; run it with
+// --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+TEST(TestParallelSort, DISABLED_BenchmarkResort)
+{
+	std::vector<SortKey> sortKeys = BuildSyntheticSortKeys(1000000);
+
+	auto compareSortKeys = [] (const SortKey &sortKey1, const SortKey &sortKey2) {
+		return CompareSortKeys(sortKey1, sortKey2, true, true) < 0;
+	};
+
+	for (int numThreads : { 1, 2, 4, 8 })
+	{
+		ctpl::thread_pool threadPool(numThreads);
+
+		ShuffleSortKeys(sortKeys);
+
+		auto start = std::chrono::steady_clock::now();
+		ParallelSort(threadPool, sortKeys.begin(), sortKeys.end(), compareSortKeys);
+		auto end = std::chrono::steady_clock::now();
+
+		std::cout << numThreads << " thread(s): "
+			<< std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+			<< " ms" << std::endl;
+
+		EXPECT_TRUE(std::is_sorted(sortKeys.begin(), sortKeys.end(), compareSortKeys));
+	}
+}
@@ -0,0 +1,72 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Explorer++/ShellBrowser/SortKey.h"
+
+namespace
+{
+	SortKey BuildSortKey(bool isFolder, int precedence, ULONGLONG number, const std::wstring &text,
+		const std::wstring &displayName)
+	{
+		SortKey sortKey;
+		sortKey.isFolder = isFolder;
+		sortKey.precedence = precedence;
+		sortKey.number = number;
+		sortKey.collationKey = GetCollationKey(text);
+		sortKey.displayNameCollationKey = GetCollationKey(displayName);
+		return sortKey;
+	}
+}
+
+TEST(TestSortKey, TestFoldersFirst)
+{
+	SortKey folder = BuildSortKey(true, 0, 100, L"", L"b");
+	SortKey file = BuildSortKey(false, 0, 1, L"", L"a");
+
+	EXPECT_LT(CompareSortKeys(folder, file, true, true), 0);
+	EXPECT_GT(CompareSortKeys(file, folder, true, true), 0);
+
+	// The entire comparison is reversed when sorting in descending
+	// order.
+	EXPECT_GT(CompareSortKeys(folder, file, true, false), 0);
+
+	// When folders aren't sorted separately (e.g. in the recycle bin),
+	// only the remaining fields are compared.
+	EXPECT_GT(CompareSortKeys(folder, file, false, true), 0);
+}
+
+TEST(TestSortKey, TestFieldOrder)
+{
+	SortKey sortKey1 = BuildSortKey(false, 0, 100, L"b", L"b");
+	SortKey sortKey2 = BuildSortKey(false, 1, 1, L"a", L"a");
+	EXPECT_LT(CompareSortKeys(sortKey1, sortKey2, true, true), 0);
+
+	sortKey1 = BuildSortKey(false, 0, 1, L"b", L"b");
+	sortKey2 = BuildSortKey(false, 0, 2, L"a", L"a");
+	EXPECT_LT(CompareSortKeys(sortKey1, sortKey2, true, true), 0);
+
+	sortKey1 = BuildSortKey(false, 0, 1, L"a", L"b");
+	sortKey2 = BuildSortKey(false, 0, 1, L"b", L"a");
+	EXPECT_LT(CompareSortKeys(sortKey1, sortKey2, true, true), 0);
+
+	// Items that are otherwise equal are sorted by display name.
+	sortKey1 = BuildSortKey(false, 0, 1, L"a", L"b");
+	sortKey2 = BuildSortKey(false, 0, 1, L"a", L"a");
+	EXPECT_GT(CompareSortKeys(sortKey1, sortKey2, true, true), 0);
+
+	sortKey2 = BuildSortKey(false, 0, 1, L"a", L"b");
+	EXPECT_EQ(0, CompareSortKeys(sortKey1, sortKey2, true, true));
+}
+
+TEST(TestSortKey, TestCollationKey)
+{
+	// Runs of digits should be compared numerically.
+	EXPECT_LT(GetCollationKey(L"file2").compare(GetCollationKey(L"file10")), 0);
+
+	// Case should be ignored.
+	EXPECT_EQ(GetCollationKey(L"Document.TXT"), GetCollationKey(L"document.txt"));
+
+	EXPECT_LT(GetCollationKey(L"").compare(GetCollationKey(L"a")), 0);
+}
@@ -0,0 +1,113 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Explorer++/Tab.h"
+#include <ShlObj.h>
+#include <memory>
+
+namespace
+{
+	PIDLPointer GetDesktopPidl()
+	{
+		PIDLIST_ABSOLUTE pidl = nullptr;
+		HRESULT hr = SHGetKnownFolderIDList(FOLDERID_Desktop, 0, nullptr, &pidl);
+		EXPECT_TRUE(SUCCEEDED(hr));
+		return PIDLPointer(pidl);
+	}
+
+	std::unique_ptr<Tab::PendingLoad> BuildPendingLoad()
+	{
+		auto pendingLoad = std::make_unique<Tab::PendingLoad>();
+		pendingLoad->pidlDirectory = GetDesktopPidl();
+		pendingLoad->folderSettings.viewMode = ViewMode::Details;
+		pendingLoad->folderSettings.sortMode = SortMode::DateModified;
+		pendingLoad->folderSettings.sortAscending = FALSE;
+		return pendingLoad;
+	}
+}
+
+TEST(TestTab, TestNoPendingLoad)
+{
+	Tab tab(1);
+
+	EXPECT_FALSE(tab.IsLoaded());
+	EXPECT_EQ(nullptr, tab.GetPendingLoad());
+	EXPECT_EQ(nullptr, tab.ReleasePendingLoad());
+	EXPECT_EQ(nullptr, tab.GetShellBrowser());
+}
+
+TEST(TestTab, TestPendingLoadAccessors)
+{
+	Tab tab(1);
+
+	int numLoads = 0;
+	tab.SetPendingLoad(BuildPendingLoad(), [&numLoads] {
+		numLoads++;
+	});
+
+	EXPECT_FALSE(tab.IsLoaded());
+
+	const Tab::PendingLoad *pendingLoad = tab.GetPendingLoad();
+	ASSERT_NE(nullptr, pendingLoad);
+
+	// The directory and settings should come from the pending load,
+	// without the tab being loaded.
+	PIDLPointer desktopPidl = GetDesktopPidl();
+	EXPECT_TRUE(ILIsEqual(desktopPidl.get(), pendingLoad->pidlDirectory.get()));
+	EXPECT_TRUE(ILIsEqual(desktopPidl.get(), tab.GetDirectory().get()));
+
+	FolderSettings folderSettings = tab.GetFolderSettings();
+	EXPECT_TRUE(folderSettings.viewMode == +ViewMode::Details);
+	EXPECT_TRUE(folderSettings.sortMode == +SortMode::DateModified);
+	EXPECT_EQ(FALSE, folderSettings.sortAscending);
+
+	EXPECT_EQ(0, numLoads);
+}
+
+TEST(TestTab, TestGetShellBrowserLoadsTab)
+{
+	Tab tab(1);
+
+	int numLoads = 0;
+	std::unique_ptr<Tab::PendingLoad> releasedLoad;
+
+	tab.SetPendingLoad(BuildPendingLoad(), [&tab, &numLoads, &releasedLoad] {
+		numLoads++;
+		releasedLoad = tab.ReleasePendingLoad();
+	});
+
+	// The load callback doesn't set a shell browser here, which mirrors
+	// the case where the tab can't be loaded.
+	EXPECT_EQ(nullptr, tab.GetShellBrowser());
+	EXPECT_EQ(1, numLoads);
+
+	ASSERT_NE(nullptr, releasedLoad);
+	EXPECT_EQ(nullptr, tab.GetPendingLoad());
+
+	// Releasing the pending load also clears the callback, so the tab
+	// isn't loaded a second time.
+	EXPECT_EQ(nullptr, tab.GetShellBrowser());
+	EXPECT_EQ(1, numLoads);
+}
+
+TEST(TestTab, TestReleasePendingLoad)
+{
+	Tab tab(1);
+
+	int numLoads = 0;
+	tab.SetPendingLoad(BuildPendingLoad(), [&numLoads] {
+		numLoads++;
+	});
+
+	auto pendingLoad = tab.ReleasePendingLoad();
+	ASSERT_NE(nullptr, pendingLoad);
+	EXPECT_TRUE(pendingLoad->folderSettings.viewMode == +ViewMode::Details);
+
+	EXPECT_EQ(nullptr, tab.GetPendingLoad());
+	EXPECT_EQ(nullptr, tab.ReleasePendingLoad());
+
+	EXPECT_EQ(nullptr, tab.GetShellBrowser());
+	EXPECT_EQ(0, numLoads);
+}
@@ -0,0 +1,63 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "../Helper/ChecksumManifest.h"
+#include <boost/optional/optional_io.hpp>
+#include <sstream>
+
+TEST(ChecksumManifest, RoundTrip)
+{
+	ChecksumManifest manifest = {
+		{ L"document.txt.part1", 0xCBF43926 },
+		{ L"file with spaces.part2", 0x0000ABCD },
+		{ L"\u00E9t\u00E9.part3", 0xFFFFFFFF }
+	};
+
+	std::stringstream stream;
+	WriteChecksumManifest(stream, manifest);
+
+	EXPECT_EQ(0U, stream.str().find("document.txt.part1 CBF43926\r\n"));
+
+	auto loaded = ReadChecksumManifest(stream);
+	ASSERT_EQ(manifest.size(), loaded.size());
+
+	for (size_t i = 0; i < manifest.size(); i++)
+	{
+		EXPECT_EQ(manifest[i].filename, loaded[i].filename);
+		EXPECT_EQ(manifest[i].checksum, loaded[i].checksum);
+	}
+}
+
+TEST(ChecksumManifest, Read)
+{
+	std::istringstream stream(
+		"; Generated by another program\n"
+		"\n"
+		"a.bin 0000001f\n"
+		"missing-checksum\n"
+		"bad.bin 1234567G\n"
+		"short.bin 1234\n"
+		"b.bin DEADBEEF");
+
+	auto manifest = ReadChecksumManifest(stream);
+	ASSERT_EQ(2U, manifest.size());
+
+	EXPECT_EQ(L"a.bin", manifest[0].filename);
+	EXPECT_EQ(0x1FU, manifest[0].checksum);
+	EXPECT_EQ(L"b.bin", manifest[1].filename);
+	EXPECT_EQ(0xDEADBEEFU, manifest[1].checksum);
+}
+
+TEST(ChecksumManifest, FindChecksum)
+{
+	ChecksumManifest manifest = {
+		{ L"Document.txt.part1", 1 },
+		{ L"document.txt.part2", 2 }
+	};
+
+	EXPECT_EQ(boost::optional<std::uint32_t>(1), FindChecksum(manifest, L"document.TXT.part1"));
+	EXPECT_EQ(boost::optional<std::uint32_t>(2), FindChecksum(manifest, L"document.txt.part2"));
+	EXPECT_EQ(boost::none, FindChecksum(manifest, L"document.txt.part3"));
+}
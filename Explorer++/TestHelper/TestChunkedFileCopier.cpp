@@ -0,0 +1,357 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "../Helper/ChunkedFileCopier.h"
+#include "../Helper/FileWrappers.h"
+#include "../Helper/Macros.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	std::vector<unsigned char> MakeData(size_t size, unsigned int seed)
+	{
+		std::vector<unsigned char> data(size);
+
+		for (size_t i = 0; i < size; i++)
+		{
+			data[i] = static_cast<unsigned char>((i * 31 + seed) ^ (i >> 8));
+		}
+
+		return data;
+	}
+
+	std::vector<unsigned char> ReadFileContents(const std::wstring &path)
+	{
+		HFilePtr file = CreateFilePtr(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		EXPECT_TRUE(file);
+
+		LARGE_INTEGER fileSize;
+		EXPECT_TRUE(GetFileSizeEx(file.get(), &fileSize));
+
+		std::vector<unsigned char> data(static_cast<size_t>(fileSize.QuadPart));
+
+		if (!data.empty())
+		{
+			DWORD bytesRead;
+			EXPECT_TRUE(ReadFile(file.get(), data.data(), static_cast<DWORD>(data.size()), &bytesRead, NULL));
+			EXPECT_EQ(data.size(), bytesRead);
+		}
+
+		return data;
+	}
+}
+
+class ChunkedFileCopierTest : public ::testing::Test
+{
+protected:
+
+	void TearDown()
+	{
+		for (const auto &path : m_files)
+		{
+			DeleteFile(path.c_str());
+		}
+	}
+
+	std::wstring GetTempFilePath()
+	{
+		TCHAR szTempPath[MAX_PATH];
+		DWORD dwRet = GetTempPath(SIZEOF_ARRAY(szTempPath), szTempPath);
+		EXPECT_NE(0U, dwRet);
+
+		TCHAR szTempFileName[MAX_PATH];
+		UINT uRet = GetTempFileName(szTempPath, _T("cfc"), 0, szTempFileName);
+		EXPECT_NE(0U, uRet);
+
+		m_files.push_back(szTempFileName);
+
+		return szTempFileName;
+	}
+
+	std::wstring CreateTestFile(const std::vector<unsigned char> &data)
+	{
+		std::wstring path = GetTempFilePath();
+
+		HFilePtr file = CreateFilePtr(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+			FILE_ATTRIBUTE_NORMAL, NULL);
+		EXPECT_TRUE(file);
+
+		if (!data.empty())
+		{
+			DWORD bytesWritten;
+			EXPECT_TRUE(WriteFile(file.get(), data.data(), static_cast<DWORD>(data.size()), &bytesWritten, NULL));
+			EXPECT_EQ(data.size(), bytesWritten);
+		}
+
+		return path;
+	}
+
+	HFilePtr OpenForReading(const std::wstring &path, DWORD flags)
+	{
+		return CreateFilePtr(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | flags, NULL);
+	}
+
+	HFilePtr OpenForWriting(const std::wstring &path, DWORD flags)
+	{
+		return CreateFilePtr(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+			FILE_ATTRIBUTE_NORMAL | flags, NULL);
+	}
+
+	void TestCopy(DWORD flags)
+	{
+		ChunkedFileCopier copier(4096);
+		ASSERT_TRUE(copier.IsValid());
+
+		// Several full chunks, followed by a partial chunk.
+		auto data = MakeData(copier.GetBufferSize() * 3 + copier.GetBufferSize() / 2, 1);
+		std::wstring inputPath = CreateTestFile(data);
+		std::wstring outputPath = GetTempFilePath();
+
+		std::vector<std::uint64_t> progress;
+
+		{
+			HFilePtr inputFile = OpenForReading(inputPath, flags);
+			ASSERT_TRUE(inputFile);
+			HFilePtr outputFile = OpenForWriting(outputPath, flags);
+			ASSERT_TRUE(outputFile);
+
+			ChunkedFileCopier::Options options;
+			options.computeChecksum = true;
+
+			auto result = copier.Copy(inputFile.get(), 0, data.size(), outputFile.get(), 0, options,
+				[&progress] (std::uint64_t bytesCopied) {
+				progress.push_back(bytesCopied);
+				return true;
+			});
+
+			EXPECT_EQ(ChunkedFileCopier::Status::Succeeded, result.status);
+			EXPECT_EQ(data.size(), result.bytesCopied);
+			EXPECT_EQ(ChunkedFileCopier::UpdateCrc32(0, data.data(), data.size()), result.checksum);
+		}
+
+		std::vector<std::uint64_t> expectedProgress = { copier.GetBufferSize(), copier.GetBufferSize() * 2,
+			copier.GetBufferSize() * 3, data.size() };
+		EXPECT_EQ(expectedProgress, progress);
+
+		EXPECT_EQ(data, ReadFileContents(outputPath));
+	}
+
+	std::vector<std::wstring> m_files;
+};
+
+TEST_F(ChunkedFileCopierTest, OverlappedHandles)
+{
+	TestCopy(FILE_FLAG_OVERLAPPED);
+}
+
+TEST_F(ChunkedFileCopierTest, SynchronousHandles)
+{
+	TestCopy(0);
+}
+
+/* Appends two files to a single output file, in the same way
+that parts are merged. */
+TEST_F(ChunkedFileCopierTest, Append)
+{
+	ChunkedFileCopier copier(4096);
+	ASSERT_TRUE(copier.IsValid());
+
+	auto data1 = MakeData(copier.GetBufferSize() + 100, 1);
+	auto data2 = MakeData(copier.GetBufferSize() * 2, 2);
+	std::wstring inputPath1 = CreateTestFile(data1);
+	std::wstring inputPath2 = CreateTestFile(data2);
+	std::wstring outputPath = GetTempFilePath();
+
+	{
+		HFilePtr outputFile = OpenForWriting(outputPath, FILE_FLAG_OVERLAPPED);
+		ASSERT_TRUE(outputFile);
+
+		std::uint64_t outputOffset = 0;
+
+		for (const auto &inputPath : { inputPath1, inputPath2 })
+		{
+			HFilePtr inputFile = OpenForReading(inputPath, FILE_FLAG_OVERLAPPED);
+			ASSERT_TRUE(inputFile);
+
+			// The length is larger than the file; copying should
+			// stop at the end of the file.
+			auto result = copier.Copy(inputFile.get(), 0, UINT64_MAX, outputFile.get(), outputOffset,
+				ChunkedFileCopier::Options(), nullptr);
+			EXPECT_EQ(ChunkedFileCopier::Status::Succeeded, result.status);
+
+			outputOffset += result.bytesCopied;
+		}
+
+		EXPECT_EQ(data1.size() + data2.size(), outputOffset);
+	}
+
+	auto expected = data1;
+	expected.insert(expected.end(), data2.begin(), data2.end());
+	EXPECT_EQ(expected, ReadFileContents(outputPath));
+}
+
+TEST_F(ChunkedFileCopierTest, Range)
+{
+	ChunkedFileCopier copier(4096);
+	ASSERT_TRUE(copier.IsValid());
+
+	auto data = MakeData(copier.GetBufferSize() * 4, 3);
+	std::wstring inputPath = CreateTestFile(data);
+	std::wstring outputPath = GetTempFilePath();
+
+	const size_t offset = copier.GetBufferSize() + 10;
+	const size_t length = copier.GetBufferSize() * 2 - 20;
+
+	{
+		HFilePtr inputFile = OpenForReading(inputPath, FILE_FLAG_OVERLAPPED);
+		ASSERT_TRUE(inputFile);
+		HFilePtr outputFile = OpenForWriting(outputPath, FILE_FLAG_OVERLAPPED);
+		ASSERT_TRUE(outputFile);
+
+		auto result = copier.Copy(inputFile.get(), offset, length, outputFile.get(), 0,
+			ChunkedFileCopier::Options(), nullptr);
+		EXPECT_EQ(ChunkedFileCopier::Status::Succeeded, result.status);
+		EXPECT_EQ(length, result.bytesCopied);
+	}
+
+	std::vector<unsigned char> expected(data.begin() + offset, data.begin() + offset + length);
+	EXPECT_EQ(expected, ReadFileContents(outputPath));
+}
+
+TEST_F(ChunkedFileCopierTest, Cancel)
+{
+	ChunkedFileCopier copier(4096);
+	ASSERT_TRUE(copier.IsValid());
+
+	auto data = MakeData(copier.GetBufferSize() * 4, 4);
+	std::wstring inputPath = CreateTestFile(data);
+	std::wstring outputPath = GetTempFilePath();
+
+	HFilePtr inputFile = OpenForReading(inputPath, FILE_FLAG_OVERLAPPED);
+	ASSERT_TRUE(inputFile);
+	HFilePtr outputFile = OpenForWriting(outputPath, FILE_FLAG_OVERLAPPED);
+	ASSERT_TRUE(outputFile);
+
+	auto result = copier.Copy(inputFile.get(), 0, data.size(), outputFile.get(), 0,
+		ChunkedFileCopier::Options(), [] (std::uint64_t bytesCopied) {
+		UNREFERENCED_PARAMETER(bytesCopied);
+		return false;
+	});
+
+	EXPECT_EQ(ChunkedFileCopier::Status::Cancelled, result.status);
+	EXPECT_EQ(copier.GetBufferSize(), result.bytesCopied);
+}
+
+TEST_F(ChunkedFileCopierTest, VerifyChecksum)
+{
+	ChunkedFileCopier copier(4096);
+	ASSERT_TRUE(copier.IsValid());
+
+	auto data = MakeData(copier.GetBufferSize() * 2 + 1, 5);
+	std::wstring inputPath = CreateTestFile(data);
+	std::uint32_t checksum = ChunkedFileCopier::UpdateCrc32(0, data.data(), data.size());
+
+	for (std::uint32_t expectedChecksum : { checksum, checksum + 1 })
+	{
+		HFilePtr inputFile = OpenForReading(inputPath, FILE_FLAG_OVERLAPPED);
+		ASSERT_TRUE(inputFile);
+		HFilePtr outputFile = OpenForWriting(GetTempFilePath(), FILE_FLAG_OVERLAPPED);
+		ASSERT_TRUE(outputFile);
+
+		ChunkedFileCopier::Options options;
+		options.computeChecksum = true;
+		options.verifyChecksum = true;
+		options.expectedChecksum = expectedChecksum;
+
+		auto result = copier.Copy(inputFile.get(), 0, data.size(), outputFile.get(), 0, options, nullptr);
+		EXPECT_EQ(expectedChecksum == checksum ? ChunkedFileCopier::Status::Succeeded
+			: ChunkedFileCopier::Status::ChecksumMismatch, result.status);
+		EXPECT_EQ(data.size(), result.bytesCopied);
+	}
+}
+
+TEST(ChunkedFileCopier, Crc32)
+{
+	const char data[] = "123456789";
+
+	EXPECT_EQ(0U, ChunkedFileCopier::UpdateCrc32(0, data, 0));
+	EXPECT_EQ(0xCBF43926U, ChunkedFileCopier::UpdateCrc32(0, data, 9));
+
+	// Computing the checksum in pieces should give the same
+	// result.
+	std::uint32_t crc = ChunkedFileCopier::UpdateCrc32(0, data, 5);
+	EXPECT_EQ(0xCBF43926U, ChunkedFileCopier::UpdateCrc32(crc, data + 5, 4));
+}
+
+/* Merges a set of synthetic parts (several GB in total) into a
+single file and reports the throughput. Needs enough free space
+in the temporary directory for the parts and the output. Run with
+--gtest_also_run_disabled_tests --gtest_filter=*Benchmark*. */
+TEST_F(ChunkedFileCopierTest, DISABLED_BenchmarkMerge)
+{
+	const int NUM_PARTS = 5;
+	const std::uint64_t PART_SIZE = 1024ULL * 1024 * 1024;
+	const DWORD WRITE_SIZE = 16 * 1024 * 1024;
+
+	auto block = MakeData(WRITE_SIZE, 6);
+	std::vector<std::wstring> partPaths;
+
+	for (int i = 0; i < NUM_PARTS; i++)
+	{
+		std::wstring partPath = GetTempFilePath();
+		HFilePtr partFile = OpenForWriting(partPath, 0);
+		ASSERT_TRUE(partFile);
+
+		for (std::uint64_t written = 0; written < PART_SIZE; written += WRITE_SIZE)
+		{
+			DWORD bytesWritten;
+			ASSERT_TRUE(WriteFile(partFile.get(), block.data(), WRITE_SIZE, &bytesWritten, NULL));
+		}
+
+		partPaths.push_back(partPath);
+	}
+
+	for (bool computeChecksum : { false, true })
+	{
+		ChunkedFileCopier copier;
+		ASSERT_TRUE(copier.IsValid());
+
+		ChunkedFileCopier::Options options;
+		options.computeChecksum = computeChecksum;
+
+		HFilePtr outputFile = OpenForWriting(GetTempFilePath(), FILE_FLAG_OVERLAPPED);
+		ASSERT_TRUE(outputFile);
+
+		std::uint64_t outputOffset = 0;
+		auto start = std::chrono::steady_clock::now();
+
+		for (const auto &partPath : partPaths)
+		{
+			HFilePtr inputFile = OpenForReading(partPath, FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN);
+			ASSERT_TRUE(inputFile);
+
+			auto result = copier.Copy(inputFile.get(), 0, UINT64_MAX, outputFile.get(), outputOffset,
+				options, nullptr);
+			ASSERT_EQ(ChunkedFileCopier::Status::Succeeded, result.status);
+
+			outputOffset += result.bytesCopied;
+		}
+
+		FlushFileBuffers(outputFile.get());
+
+		auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - start).count();
+		double megabytes = static_cast<double>(outputOffset) / (1024 * 1024);
+
+		std::cout << "Merged " << NUM_PARTS << " parts (" << megabytes << " MB"
+			<< (computeChecksum ? ", with checksum" : "") << ") in " << elapsed << "ms ("
+			<< (elapsed > 0 ? megabytes * 1000 / elapsed : 0) << " MB/s)" << std::endl;
+	}
+}
@@ -0,0 +1,105 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "../Helper/DirectoryChangeJournal.h"
+
+namespace
+{
+	void ExpectChange(const DirectoryChange &change, const std::wstring &fileName, DWORD action)
+	{
+		EXPECT_EQ(fileName, change.fileName);
+		EXPECT_EQ(action, change.action);
+	}
+}
+
+TEST(DirectoryChangeJournal, MergesChangesToSameFile)
+{
+	DirectoryChangeJournal journal;
+
+	journal.AddChange(L"file1", FILE_ACTION_ADDED);
+	journal.AddChange(L"file2", FILE_ACTION_MODIFIED);
+	journal.AddChange(L"file1", FILE_ACTION_MODIFIED);
+	journal.AddChange(L"file2", FILE_ACTION_MODIFIED);
+	journal.AddChange(L"file3", FILE_ACTION_MODIFIED);
+	journal.AddChange(L"file3", FILE_ACTION_REMOVED);
+
+	DirectoryChangeSet changeSet = journal.TakeChanges();
+
+	EXPECT_FALSE(changeSet.rescanRequired);
+	ASSERT_EQ(3U, changeSet.changes.size());
+	ExpectChange(changeSet.changes[0], L"file1", FILE_ACTION_ADDED);
+	ExpectChange(changeSet.changes[1], L"file2", FILE_ACTION_MODIFIED);
+	ExpectChange(changeSet.changes[2], L"file3", FILE_ACTION_REMOVED);
+
+	EXPECT_TRUE(journal.IsEmpty());
+}
+
+TEST(DirectoryChangeJournal, AddedThenRemoved)
+{
+	DirectoryChangeJournal journal;
+
+	// The file may already be shown, so the removal is retained.
+	journal.AddChange(L"file", FILE_ACTION_ADDED);
+	journal.AddChange(L"file", FILE_ACTION_MODIFIED);
+	journal.AddChange(L"file", FILE_ACTION_REMOVED);
+
+	DirectoryChangeSet changeSet = journal.TakeChanges();
+
+	ASSERT_EQ(1U, changeSet.changes.size());
+	ExpectChange(changeSet.changes[0], L"file", FILE_ACTION_REMOVED);
+}
+
+TEST(DirectoryChangeJournal, RemovedThenAdded)
+{
+	DirectoryChangeJournal journal;
+
+	journal.AddChange(L"file", FILE_ACTION_REMOVED);
+	journal.AddChange(L"file", FILE_ACTION_ADDED);
+	journal.AddChange(L"file", FILE_ACTION_MODIFIED);
+
+	DirectoryChangeSet changeSet = journal.TakeChanges();
+
+	ASSERT_EQ(2U, changeSet.changes.size());
+	ExpectChange(changeSet.changes[0], L"file", FILE_ACTION_REMOVED);
+	ExpectChange(changeSet.changes[1], L"file", FILE_ACTION_ADDED);
+}
+
+TEST(DirectoryChangeJournal, RenamesAreNotMerged)
+{
+	DirectoryChangeJournal journal;
+
+	journal.AddChange(L"old", FILE_ACTION_MODIFIED);
+	journal.AddChange(L"old", FILE_ACTION_RENAMED_OLD_NAME);
+	journal.AddChange(L"new", FILE_ACTION_RENAMED_NEW_NAME);
+	journal.AddChange(L"new", FILE_ACTION_MODIFIED);
+	journal.AddChange(L"old", FILE_ACTION_ADDED);
+
+	DirectoryChangeSet changeSet = journal.TakeChanges();
+
+	ASSERT_EQ(5U, changeSet.changes.size());
+	ExpectChange(changeSet.changes[0], L"old", FILE_ACTION_MODIFIED);
+	ExpectChange(changeSet.changes[1], L"old", FILE_ACTION_RENAMED_OLD_NAME);
+	ExpectChange(changeSet.changes[2], L"new", FILE_ACTION_RENAMED_NEW_NAME);
+	ExpectChange(changeSet.changes[3], L"new", FILE_ACTION_MODIFIED);
+	ExpectChange(changeSet.changes[4], L"old", FILE_ACTION_ADDED);
+}
+
+TEST(DirectoryChangeJournal, Rescan)
+{
+	DirectoryChangeJournal journal;
+
+	journal.AddChange(L"file1", FILE_ACTION_ADDED);
+	journal.SetRescanRequired();
+	journal.AddChange(L"file2", FILE_ACTION_ADDED);
+
+	EXPECT_FALSE(journal.IsEmpty());
+
+	DirectoryChangeSet changeSet = journal.TakeChanges();
+
+	EXPECT_TRUE(changeSet.rescanRequired);
+	EXPECT_TRUE(changeSet.changes.empty());
+
+	EXPECT_TRUE(journal.IsEmpty());
+}
@@ -0,0 +1,106 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "../Helper/DirectoryFindDataReader.h"
+#include "../Helper/FileWrappers.h"
+#include "../Helper/Macros.h"
+#include <string>
+#include <vector>
+
+class DirectoryFindDataReaderTest : public ::testing::Test
+{
+protected:
+
+	void SetUp()
+	{
+		TCHAR szTempPath[MAX_PATH];
+		ASSERT_NE(0U, GetTempPath(SIZEOF_ARRAY(szTempPath), szTempPath));
+
+		TCHAR szDirectory[MAX_PATH];
+		ASSERT_NE(0U, GetTempFileName(szTempPath, _T("fdr"), 0, szDirectory));
+
+		/* GetTempFileName() creates a file with the unique name,
+		which is replaced with a directory. */
+		ASSERT_TRUE(DeleteFile(szDirectory));
+		ASSERT_TRUE(CreateDirectory(szDirectory, NULL));
+
+		m_directory = szDirectory;
+
+		for (int i = 0; i < NUM_FILES; i++)
+		{
+			std::wstring fileName = L"File" + std::to_wstring(i) + L".txt";
+
+			HFilePtr file = CreateFilePtr((m_directory + L"\\" + fileName).c_str(), GENERIC_WRITE,
+				0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+			ASSERT_TRUE(file);
+
+			std::string data(i, 'x');
+			DWORD bytesWritten;
+			ASSERT_TRUE(WriteFile(file.get(), data.data(), static_cast<DWORD>(data.size()), &bytesWritten, NULL));
+
+			m_fileNames.push_back(fileName);
+		}
+	}
+
+	void TearDown()
+	{
+		for (const auto &fileName : m_fileNames)
+		{
+			DeleteFile((m_directory + L"\\" + fileName).c_str());
+		}
+
+		RemoveDirectory(m_directory.c_str());
+	}
+
+	static const int NUM_FILES = 20;
+
+	std::wstring m_directory;
+	std::vector<std::wstring> m_fileNames;
+};
+
+TEST_F(DirectoryFindDataReaderTest, TakeInAnyOrder)
+{
+	DirectoryFindDataReader reader(m_directory);
+
+	for (int i = NUM_FILES - 1; i >= 0; i--)
+	{
+		auto findData = reader.TakeFindData(m_fileNames[i]);
+		ASSERT_TRUE(findData);
+		EXPECT_EQ(m_fileNames[i], findData->cFileName);
+		EXPECT_EQ(static_cast<DWORD>(i), findData->nFileSizeLow);
+	}
+}
+
+TEST_F(DirectoryFindDataReaderTest, TakeOnce)
+{
+	DirectoryFindDataReader reader(m_directory);
+
+	EXPECT_TRUE(reader.TakeFindData(m_fileNames[5]));
+	EXPECT_FALSE(reader.TakeFindData(m_fileNames[5]));
+
+	EXPECT_FALSE(reader.TakeFindData(L"Missing.txt"));
+
+	/* Looking for a missing item reads the rest of the
+	directory, but the other items can still be taken. */
+	EXPECT_TRUE(reader.TakeFindData(m_fileNames[0]));
+	EXPECT_TRUE(reader.TakeFindData(m_fileNames[NUM_FILES - 1]));
+}
+
+TEST_F(DirectoryFindDataReaderTest, DotEntries)
+{
+	DirectoryFindDataReader reader(m_directory);
+
+	EXPECT_FALSE(reader.TakeFindData(L"."));
+	EXPECT_FALSE(reader.TakeFindData(L".."));
+}
+
+TEST(DirectoryFindDataReader, MissingDirectory)
+{
+	TCHAR szTempPath[MAX_PATH];
+	ASSERT_NE(0U, GetTempPath(SIZEOF_ARRAY(szTempPath), szTempPath));
+
+	DirectoryFindDataReader reader(std::wstring(szTempPath) + L"DirectoryFindDataReaderMissing");
+	EXPECT_FALSE(reader.TakeFindData(L"File.txt"));
+}
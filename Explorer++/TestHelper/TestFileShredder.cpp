@@ -0,0 +1,285 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "../Helper/FileShredder.h"
+#include "../Helper/FileWrappers.h"
+#include "../Helper/Macros.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	std::vector<unsigned char> MakeData(size_t size, unsigned int seed)
+	{
+		std::vector<unsigned char> data(size);
+
+		for (size_t i = 0; i < size; i++)
+		{
+			data[i] = static_cast<unsigned char>((i * 31 + seed) ^ (i >> 8));
+		}
+
+		return data;
+	}
+
+	std::vector<unsigned char> ReadFileContents(HANDLE file)
+	{
+		LARGE_INTEGER distance;
+		distance.QuadPart = 0;
+		EXPECT_TRUE(SetFilePointerEx(file, distance, NULL, FILE_BEGIN));
+
+		LARGE_INTEGER fileSize;
+		EXPECT_TRUE(GetFileSizeEx(file, &fileSize));
+
+		std::vector<unsigned char> data(static_cast<size_t>(fileSize.QuadPart));
+
+		if (!data.empty())
+		{
+			DWORD bytesRead;
+			EXPECT_TRUE(ReadFile(file, data.data(), static_cast<DWORD>(data.size()), &bytesRead, NULL));
+			EXPECT_EQ(data.size(), bytesRead);
+		}
+
+		return data;
+	}
+
+	bool FileExists(const std::wstring &path)
+	{
+		return GetFileAttributes(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+	}
+}
+
+class FileShredderTest : public ::testing::Test
+{
+protected:
+
+	void TearDown()
+	{
+		for (const auto &path : m_files)
+		{
+			DeleteFile(path.c_str());
+		}
+	}
+
+	std::wstring GetTempFilePath()
+	{
+		TCHAR szTempPath[MAX_PATH];
+		DWORD dwRet = GetTempPath(SIZEOF_ARRAY(szTempPath), szTempPath);
+		EXPECT_NE(0U, dwRet);
+
+		TCHAR szTempFileName[MAX_PATH];
+		UINT uRet = GetTempFileName(szTempPath, _T("fsh"), 0, szTempFileName);
+		EXPECT_NE(0U, uRet);
+
+		m_files.push_back(szTempFileName);
+
+		return szTempFileName;
+	}
+
+	std::wstring CreateTestFile(const std::vector<unsigned char> &data)
+	{
+		std::wstring path = GetTempFilePath();
+
+		HFilePtr file = CreateFilePtr(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+			FILE_ATTRIBUTE_NORMAL, NULL);
+		EXPECT_TRUE(file);
+
+		if (!data.empty())
+		{
+			DWORD bytesWritten;
+			EXPECT_TRUE(WriteFile(file.get(), data.data(), static_cast<DWORD>(data.size()), &bytesWritten, NULL));
+			EXPECT_EQ(data.size(), bytesWritten);
+		}
+
+		return path;
+	}
+
+	HFilePtr OpenForOverwriting(const std::wstring &path)
+	{
+		return CreateFilePtr(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL, NULL);
+	}
+
+private:
+
+	std::vector<std::wstring> m_files;
+};
+
+TEST_F(FileShredderTest, OnePass)
+{
+	FileShredder shredder({ FileShredder::Pass::Fill(0x00) }, false, 4096);
+
+	// Several full blocks, followed by a partial block.
+	auto data = MakeData(4096 * 3 + 100, 1);
+	HFilePtr file = OpenForOverwriting(CreateTestFile(data));
+	ASSERT_TRUE(file);
+
+	EXPECT_EQ(FileShredder::Status::Succeeded, shredder.Overwrite(file.get(), data.size()));
+	EXPECT_EQ(std::vector<unsigned char>(data.size(), 0x00), ReadFileContents(file.get()));
+}
+
+TEST_F(FileShredderTest, ThreePassWithVerification)
+{
+	FileShredder shredder({ FileShredder::Pass::Fill(0x00), FileShredder::Pass::Fill(0xFF),
+		FileShredder::Pass::Random() }, true, 4096);
+
+	auto data = MakeData(4096 * 2 + 4096 / 2, 2);
+	HFilePtr file = OpenForOverwriting(CreateTestFile(data));
+	ASSERT_TRUE(file);
+
+	EXPECT_EQ(FileShredder::Status::Succeeded, shredder.Overwrite(file.get(), data.size()));
+
+	// The last pass is random, so the contents should match neither
+	// the original data, nor the earlier passes.
+	auto contents = ReadFileContents(file.get());
+	ASSERT_EQ(data.size(), contents.size());
+	EXPECT_NE(data, contents);
+	EXPECT_NE(std::vector<unsigned char>(data.size(), 0xFF), contents);
+}
+
+TEST_F(FileShredderTest, ShredFile)
+{
+	FileShredder shredder({ FileShredder::Pass::Fill(0xFF), FileShredder::Pass::Random() }, true);
+
+	std::wstring path = CreateTestFile(MakeData(10000, 3));
+	EXPECT_EQ(FileShredder::Status::Succeeded, shredder.ShredFile(path));
+	EXPECT_FALSE(FileExists(path));
+
+	EXPECT_EQ(FileShredder::Status::OpenFailed, shredder.ShredFile(path));
+
+	TCHAR szTempPath[MAX_PATH];
+	ASSERT_NE(0U, GetTempPath(SIZEOF_ARRAY(szTempPath), szTempPath));
+	EXPECT_EQ(FileShredder::Status::NotAFile, shredder.ShredFile(szTempPath));
+}
+
+TEST_F(FileShredderTest, ShredFiles)
+{
+	std::vector<std::wstring> paths;
+
+	for (unsigned int i = 0; i < 8; i++)
+	{
+		paths.push_back(CreateTestFile(MakeData(5000 + i * 1000, i)));
+	}
+
+	// A file that doesn't exist shouldn't stop the others from
+	// being shredded.
+	std::wstring missingPath = GetTempFilePath();
+	ASSERT_TRUE(DeleteFile(missingPath.c_str()));
+	paths.insert(paths.begin() + 3, missingPath);
+
+	auto statuses = FileShredder::ShredFiles(paths, { FileShredder::Pass::Random() }, false, 3);
+	ASSERT_EQ(paths.size(), statuses.size());
+
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		auto expectedStatus = (paths[i] == missingPath) ? FileShredder::Status::OpenFailed
+			: FileShredder::Status::Succeeded;
+		EXPECT_EQ(expectedStatus, statuses[i]);
+		EXPECT_FALSE(FileExists(paths[i]));
+	}
+}
+
+TEST(FileShredderRandomGenerator, Sequence)
+{
+	FileShredder::RandomGenerator::State seed = { 1, 2, 3, 4 };
+
+	// Reference values for xoshiro256**.
+	FileShredder::RandomGenerator generator(seed);
+	EXPECT_EQ(11520U, generator.Next());
+	EXPECT_EQ(0U, generator.Next());
+	EXPECT_EQ(1509978240U, generator.Next());
+
+	// The same seed should always give the same data, regardless of
+	// whether the size is a multiple of the word size.
+	std::vector<unsigned char> data1(16);
+	FileShredder::RandomGenerator(seed).Fill(data1.data(), data1.size());
+
+	std::vector<unsigned char> data2(13);
+	FileShredder::RandomGenerator(seed).Fill(data2.data(), data2.size());
+
+	EXPECT_TRUE(std::equal(data2.begin(), data2.end(), data1.begin()));
+
+	auto randomSeed = FileShredder::RandomGenerator::GenerateSeed();
+	EXPECT_NE(randomSeed, FileShredder::RandomGenerator::GenerateSeed());
+}
+
+/* Reports the throughput of the overwrite passes for a large
+file, compared with writing a byte at a time (the previous
+implementation), which is only run over a small file, as it's
+several orders of magnitude slower. Needs around 1GB of free
+space in the temporary directory. Run with
+--gtest_also_run_disabled_tests --gtest_filter=*Benchmark*. */
+TEST_F(FileShredderTest, DISABLED_BenchmarkOverwrite)
+{
+	const std::uint64_t FILE_SIZE = 1024ULL * 1024 * 1024;
+	const DWORD BASELINE_FILE_SIZE = 4 * 1024 * 1024;
+
+	auto reportThroughput = [] (const char *description, std::uint64_t bytes,
+		std::chrono::steady_clock::time_point start) {
+		auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - start).count();
+		double megabytes = static_cast<double>(bytes) / (1024 * 1024);
+
+		std::cout << description << ": " << megabytes << " MB in " << elapsed << "ms ("
+			<< (elapsed > 0 ? megabytes * 1000 / elapsed : 0) << " MB/s)" << std::endl;
+	};
+
+	{
+		HFilePtr file = OpenForOverwriting(CreateTestFile({}));
+		ASSERT_TRUE(file);
+
+		unsigned char value = 0x00;
+		auto start = std::chrono::steady_clock::now();
+
+		for (DWORD i = 0; i < BASELINE_FILE_SIZE; i++)
+		{
+			DWORD bytesWritten;
+			ASSERT_TRUE(WriteFile(file.get(), &value, 1, &bytesWritten, NULL));
+		}
+
+		FlushFileBuffers(file.get());
+		reportThroughput("Byte at a time", BASELINE_FILE_SIZE, start);
+	}
+
+	std::wstring path = GetTempFilePath();
+
+	{
+		HFilePtr file = OpenForOverwriting(path);
+		ASSERT_TRUE(file);
+
+		LARGE_INTEGER size;
+		size.QuadPart = FILE_SIZE;
+		ASSERT_TRUE(SetFilePointerEx(file.get(), size, NULL, FILE_BEGIN));
+		ASSERT_TRUE(SetEndOfFile(file.get()));
+	}
+
+	struct Configuration
+	{
+		const char *description;
+		FileShredder::PassScheme passes;
+		bool verify;
+	};
+
+	const Configuration configurations[] = {
+		{ "Fill pass", { FileShredder::Pass::Fill(0x00) }, false },
+		{ "Random pass", { FileShredder::Pass::Random() }, false },
+		{ "Random pass, verified", { FileShredder::Pass::Random() }, true }
+	};
+
+	for (const auto &configuration : configurations)
+	{
+		FileShredder shredder(configuration.passes, configuration.verify);
+
+		HFilePtr file = CreateFilePtr(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING,
+			FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH, NULL);
+		ASSERT_TRUE(file);
+
+		auto start = std::chrono::steady_clock::now();
+		ASSERT_EQ(FileShredder::Status::Succeeded, shredder.Overwrite(file.get(), FILE_SIZE));
+		reportThroughput(configuration.description, FILE_SIZE, start);
+	}
+}
@@ -0,0 +1,116 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "../Helper/FolderSizeService.h"
+#include "../Helper/iDirectoryMonitor.h"
+#include "../Helper/Macros.h"
+#include "Helper.h"
+#include <chrono>
+#include <future>
+#include <thread>
+
+class FolderSizeServiceTest : public ::testing::Test
+{
+protected:
+
+	void SetUp()
+	{
+		HRESULT hr = CreateDirectoryMonitor(&m_directoryMonitor);
+		ASSERT_TRUE(SUCCEEDED(hr));
+
+		m_folderSizeService = std::make_unique<FolderSizeService>(4, m_directoryMonitor);
+
+		TCHAR szFullFileName[MAX_PATH];
+		GetTestResourceFilePath(L"FolderSize", szFullFileName, SIZEOF_ARRAY(szFullFileName));
+		m_path = szFullFileName;
+	}
+
+	void TearDown()
+	{
+		m_folderSizeService.reset();
+		m_directoryMonitor->Release();
+	}
+
+	void CheckFolderSize(const FolderSizeService::FolderSize &folderSize)
+	{
+		EXPECT_EQ(2, folderSize.numFolders);
+		EXPECT_EQ(6, folderSize.numFiles);
+		EXPECT_EQ(18432ULL, folderSize.size);
+	}
+
+	IDirectoryMonitor *m_directoryMonitor;
+	std::unique_ptr<FolderSizeService> m_folderSizeService;
+	std::wstring m_path;
+};
+
+TEST_F(FolderSizeServiceTest, Calculate)
+{
+	auto folderSize = m_folderSizeService->CalculateFolderSize(m_path);
+	ASSERT_TRUE(folderSize.is_initialized());
+	CheckFolderSize(*folderSize);
+}
+
+TEST_F(FolderSizeServiceTest, Cached)
+{
+	EXPECT_FALSE(m_folderSizeService->GetCachedFolderSize(m_path).is_initialized());
+
+	auto folderSize = m_folderSizeService->CalculateFolderSize(m_path);
+	ASSERT_TRUE(folderSize.is_initialized());
+
+	auto cachedFolderSize = m_folderSizeService->GetCachedFolderSize(m_path);
+	ASSERT_TRUE(cachedFolderSize.is_initialized());
+	CheckFolderSize(*cachedFolderSize);
+
+	/* Cached results are passed back before
+	CalculateFolderSizeAsync() returns. */
+	bool called = false;
+	m_folderSizeService->CalculateFolderSizeAsync(m_path,
+		[this, &called] (const FolderSizeService::FolderSize &folderSize, bool complete) {
+		EXPECT_TRUE(complete);
+		CheckFolderSize(folderSize);
+		called = true;
+	});
+	EXPECT_TRUE(called);
+}
+
+TEST_F(FolderSizeServiceTest, Invalidate)
+{
+	auto folderSize = m_folderSizeService->CalculateFolderSize(m_path);
+	ASSERT_TRUE(folderSize.is_initialized());
+
+	m_folderSizeService->InvalidateFolder(m_path);
+	EXPECT_FALSE(m_folderSizeService->GetCachedFolderSize(m_path).is_initialized());
+
+	folderSize = m_folderSizeService->CalculateFolderSize(m_path);
+	ASSERT_TRUE(folderSize.is_initialized());
+	CheckFolderSize(*folderSize);
+}
+
+TEST_F(FolderSizeServiceTest, DestroyDuringCalculation)
+{
+	/* The Windows directory is large enough that calculating
+	its size takes far longer than the delay below. */
+	TCHAR windowsDirectory[MAX_PATH];
+	UINT res = GetWindowsDirectory(windowsDirectory, SIZEOF_ARRAY(windowsDirectory));
+	ASSERT_NE(0U, res);
+
+	FolderSizeService *folderSizeService = m_folderSizeService.get();
+	auto calculation = std::async(std::launch::async, [folderSizeService, windowsDirectory] {
+		return folderSizeService->CalculateFolderSize(windowsDirectory);
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+	/* Any outstanding directories should be abandoned, rather
+	than the destructor waiting for the calculation to finish. */
+	auto startTime = std::chrono::steady_clock::now();
+	m_folderSizeService.reset();
+	auto duration = std::chrono::steady_clock::now() - startTime;
+
+	EXPECT_LT(duration, std::chrono::seconds(2));
+
+	ASSERT_EQ(std::future_status::ready, calculation.wait_for(std::chrono::seconds(2)));
+	EXPECT_FALSE(calculation.get().is_initialized());
+}
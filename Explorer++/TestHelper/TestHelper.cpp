@@ -78,6 +78,23 @@ TEST(GetVersionInfoString, Simple)
 	TestVersionInfoString(szDLL, L"ProductVersion", L"1.18.23.4728");
 }
 
+TEST(GetVersionInfoStrings, Multiple)
+{
+	TCHAR szDLL[MAX_PATH];
+	GetTestResourceFilePath(L"VersionInfo.dll", szDLL, SIZEOF_ARRAY(szDLL));
+
+	std::vector<boost::optional<std::wstring>> output;
+	BOOL bRet = GetVersionInfoStrings(szDLL, { L"CompanyName", L"NotPresent", L"ProductVersion" }, output);
+	ASSERT_EQ(TRUE, bRet);
+	ASSERT_EQ(3U, output.size());
+
+	/* As above, this relies on the users default language been
+	English. */
+	EXPECT_EQ(std::wstring(L"Test company"), output[0]);
+	EXPECT_FALSE(output[1]);
+	EXPECT_EQ(std::wstring(L"1.18.23.4728"), output[2]);
+}
+
 class HardLinkTest : public ::testing::Test
 {
 public:
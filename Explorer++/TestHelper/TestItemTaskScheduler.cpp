@@ -0,0 +1,301 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "../Helper/ItemTaskScheduler.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Occupies the scheduler's only worker until release() is
+	// called, so that tasks queued in the meantime stay queued.
+	class WorkerBlocker
+	{
+	public:
+
+		explicit WorkerBlocker(ItemTaskScheduler &scheduler)
+		{
+			auto released = m_released.get_future().share();
+			std::promise<void> started;
+			auto startedFuture = started.get_future();
+
+			auto startedPtr = std::make_shared<std::promise<void>>(std::move(started));
+
+			m_future = *scheduler.QueueTask({ -1, -1 }, [released, startedPtr] {
+				startedPtr->set_value();
+				released.wait();
+			});
+
+			startedFuture.wait();
+		}
+
+		void release()
+		{
+			m_released.set_value();
+			m_future.wait();
+		}
+
+	private:
+
+		std::promise<void> m_released;
+		std::future<void> m_future;
+	};
+}
+
+TEST(ItemTaskScheduler, RunsTask)
+{
+	ItemTaskScheduler scheduler(1);
+
+	auto future = scheduler.QueueTask({ 1, 2 }, [] {
+		return 42;
+	});
+
+	ASSERT_TRUE(future.is_initialized());
+	EXPECT_EQ(42, future->get());
+}
+
+TEST(ItemTaskScheduler, Deduplicates)
+{
+	ItemTaskScheduler scheduler(1);
+	WorkerBlocker blocker(scheduler);
+
+	auto first = scheduler.QueueTask({ 1, 2 }, [] {});
+	auto duplicate = scheduler.QueueTask({ 1, 2 }, [] {});
+	auto otherColumn = scheduler.QueueTask({ 1, 3 }, [] {});
+	auto otherItem = scheduler.QueueTask({ 2, 2 }, [] {});
+
+	EXPECT_TRUE(first.is_initialized());
+	EXPECT_FALSE(duplicate.is_initialized());
+	EXPECT_TRUE(otherColumn.is_initialized());
+	EXPECT_TRUE(otherItem.is_initialized());
+	EXPECT_EQ(3U, scheduler.GetNumQueuedTasks());
+
+	blocker.release();
+	first->wait();
+
+	// The result is available slightly before the worker marks
+	// the task as finished.
+	for (int i = 0; i < 1000 && scheduler.IsTaskPending({ 1, 2 }); i++)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	// Once the task has finished, it can be queued again.
+	EXPECT_FALSE(scheduler.IsTaskPending({ 1, 2 }));
+	EXPECT_TRUE(scheduler.QueueTask({ 1, 2 }, [] {}).is_initialized());
+}
+
+TEST(ItemTaskScheduler, NewestFirst)
+{
+	ItemTaskScheduler scheduler(1);
+	WorkerBlocker blocker(scheduler);
+
+	std::vector<int> order;
+	std::vector<std::future<void>> futures;
+
+	for (int i = 0; i < 5; i++)
+	{
+		futures.push_back(*scheduler.QueueTask({ i, 0 }, [&order, i] {
+			order.push_back(i);
+		}));
+	}
+
+	blocker.release();
+
+	for (auto &future : futures)
+	{
+		future.wait();
+	}
+
+	std::vector<int> expected = { 4, 3, 2, 1, 0 };
+	EXPECT_EQ(expected, order);
+}
+
+TEST(ItemTaskScheduler, CancelTasks)
+{
+	ItemTaskScheduler scheduler(1);
+	WorkerBlocker blocker(scheduler);
+
+	std::vector<std::future<void>> futures;
+
+	for (int i = 0; i < 10; i++)
+	{
+		futures.push_back(*scheduler.QueueTask({ i, 0 }, [] {}));
+	}
+
+	auto cancelledTasks = scheduler.CancelTasks([] (const ItemTaskScheduler::TaskKey &key) {
+		return key.itemId >= 5;
+	});
+
+	ASSERT_EQ(5U, cancelledTasks.size());
+
+	for (const auto &cancelledTask : cancelledTasks)
+	{
+		EXPECT_GE(cancelledTask.itemId, 5);
+		EXPECT_FALSE(scheduler.IsTaskPending(cancelledTask));
+	}
+
+	EXPECT_EQ(5U, scheduler.GetNumQueuedTasks());
+
+	blocker.release();
+
+	for (int i = 0; i < 10; i++)
+	{
+		if (i < 5)
+		{
+			EXPECT_NO_THROW(futures[i].get());
+		}
+		else
+		{
+			EXPECT_THROW(futures[i].get(), std::future_error);
+		}
+	}
+}
+
+TEST(ItemTaskScheduler, CancelAllTasks)
+{
+	ItemTaskScheduler scheduler(1);
+	WorkerBlocker blocker(scheduler);
+
+	scheduler.QueueTask({ 1, 0 }, [] {});
+	scheduler.QueueTask({ 2, 0 }, [] {});
+
+	auto cancelledTasks = scheduler.CancelAllTasks();
+	EXPECT_EQ(2U, cancelledTasks.size());
+	EXPECT_EQ(0U, scheduler.GetNumQueuedTasks());
+
+	// The running task no longer blocks its key.
+	EXPECT_FALSE(scheduler.IsTaskPending({ -1, -1 }));
+
+	blocker.release();
+}
+
+TEST(ItemTaskScheduler, Owners)
+{
+	ItemTaskScheduler scheduler(1);
+	WorkerBlocker blocker(scheduler);
+
+	// Keys only need to be unique within an owner.
+	auto first = scheduler.QueueTask(1, { 1, 0 }, [] {});
+	auto second = scheduler.QueueTask(2, { 1, 0 }, [] {});
+	auto third = scheduler.QueueTask(2, { 2, 0 }, [] {});
+
+	ASSERT_TRUE(first.is_initialized());
+	ASSERT_TRUE(second.is_initialized());
+	ASSERT_TRUE(third.is_initialized());
+	EXPECT_FALSE(scheduler.QueueTask(1, { 1, 0 }, [] {}).is_initialized());
+
+	auto cancelledTasks = scheduler.CancelTasks(1, [] (const ItemTaskScheduler::TaskKey &key) {
+		return key.itemId == 1;
+	});
+	ASSERT_EQ(1U, cancelledTasks.size());
+	EXPECT_FALSE(scheduler.IsTaskPending(1, { 1, 0 }));
+	EXPECT_TRUE(scheduler.IsTaskPending(2, { 1, 0 }));
+
+	// Cancelling the tasks of one owner leaves the rest alone,
+	// including the blocking task (which belongs to the default
+	// owner).
+	EXPECT_EQ(2U, scheduler.CancelAllTasks(2).size());
+	EXPECT_TRUE(scheduler.IsTaskPending({ -1, -1 }));
+	EXPECT_EQ(0U, scheduler.GetNumQueuedTasks());
+
+	blocker.release();
+
+	EXPECT_THROW(first->get(), std::future_error);
+	EXPECT_THROW(second->get(), std::future_error);
+	EXPECT_THROW(third->get(), std::future_error);
+}
+
+TEST(ItemTaskScheduler, PriorityOwner)
+{
+	ItemTaskScheduler scheduler(1);
+	WorkerBlocker blocker(scheduler);
+
+	std::vector<int> order;
+	std::vector<std::future<void>> futures;
+
+	for (int i = 0; i < 6; i++)
+	{
+		int ownerId = (i % 2 == 0) ? 1 : 2;
+
+		futures.push_back(*scheduler.QueueTask(ownerId, { i, 0 }, [&order, i] {
+			order.push_back(i);
+		}));
+	}
+
+	scheduler.SetPriorityOwner(1);
+	blocker.release();
+
+	for (auto &future : futures)
+	{
+		future.wait();
+	}
+
+	std::vector<int> expected = { 4, 2, 0, 5, 3, 1 };
+	EXPECT_EQ(expected, order);
+}
+
+TEST(ItemTaskScheduler, Stats)
+{
+	ItemTaskScheduler scheduler(1);
+
+	{
+		WorkerBlocker blocker(scheduler);
+
+		scheduler.QueueTask(1, { 1, 0 }, [] {});
+		scheduler.QueueTask(2, { 1, 0 }, [] {});
+
+		auto stats = scheduler.GetStats();
+		EXPECT_EQ(1, stats.numWorkers);
+		EXPECT_EQ(0, stats.numIdleWorkers);
+		EXPECT_EQ(2U, stats.numQueuedTasks);
+		EXPECT_EQ(2U, stats.peakQueuedTasks);
+
+		blocker.release();
+	}
+
+	for (int i = 0; i < 1000 && scheduler.GetStats().numTasksRun < 3; i++)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	auto stats = scheduler.GetStats();
+	EXPECT_EQ(0U, stats.numQueuedTasks);
+	EXPECT_EQ(2U, stats.peakQueuedTasks);
+	EXPECT_EQ(3U, stats.numTasksRun);
+}
+
+TEST(ItemTaskScheduler, ThreadCallbacks)
+{
+	std::atomic<int> numStarted(0);
+	std::atomic<int> numStopped(0);
+
+	{
+		ItemTaskScheduler scheduler(4, [&numStarted] {
+			numStarted++;
+		}, [&numStopped] {
+			numStopped++;
+		});
+
+		std::vector<std::future<void>> futures;
+
+		for (int i = 0; i < 100; i++)
+		{
+			futures.push_back(*scheduler.QueueTask({ i, 0 }, [] {}));
+		}
+
+		for (auto &future : futures)
+		{
+			future.wait();
+		}
+	}
+
+	EXPECT_GE(numStarted, 1);
+	EXPECT_LE(numStarted, 4);
+	EXPECT_EQ(numStarted.load(), numStopped.load());
+}
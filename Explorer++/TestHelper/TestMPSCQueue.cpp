@@ -0,0 +1,79 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "../Helper/MPSCQueue.h"
+#include <memory>
+#include <thread>
+#include <vector>
+
+TEST(MPSCQueue, Order)
+{
+	MPSCQueue<int> queue;
+	EXPECT_TRUE(queue.IsEmpty());
+
+	EXPECT_TRUE(queue.Push(1));
+	EXPECT_FALSE(queue.Push(2));
+	EXPECT_FALSE(queue.Push(3));
+	EXPECT_FALSE(queue.IsEmpty());
+
+	std::vector<int> expected = { 1, 2, 3 };
+	EXPECT_EQ(expected, queue.PopAll());
+	EXPECT_TRUE(queue.IsEmpty());
+	EXPECT_TRUE(queue.PopAll().empty());
+
+	EXPECT_TRUE(queue.Push(4));
+}
+
+TEST(MPSCQueue, MoveOnly)
+{
+	MPSCQueue<std::unique_ptr<int>> queue;
+	queue.Push(std::make_unique<int>(42));
+
+	auto items = queue.PopAll();
+	ASSERT_EQ(1U, items.size());
+	EXPECT_EQ(42, *items[0]);
+}
+
+TEST(MPSCQueue, MultipleProducers)
+{
+	const int NUM_PRODUCERS = 4;
+	const int NUM_ITEMS_PER_PRODUCER = 10000;
+
+	MPSCQueue<int> queue;
+	std::vector<std::thread> producers;
+
+	for (int i = 0; i < NUM_PRODUCERS; i++)
+	{
+		producers.emplace_back([&queue, i] {
+			for (int j = 0; j < NUM_ITEMS_PER_PRODUCER; j++)
+			{
+				queue.Push(i * NUM_ITEMS_PER_PRODUCER + j);
+			}
+		});
+	}
+
+	// Items from each producer should arrive in the order that
+	// producer pushed them, however the batches are split.
+	std::vector<int> lastItems(NUM_PRODUCERS, -1);
+	int numItems = 0;
+
+	while (numItems < NUM_PRODUCERS * NUM_ITEMS_PER_PRODUCER)
+	{
+		for (int item : queue.PopAll())
+		{
+			int producer = item / NUM_ITEMS_PER_PRODUCER;
+			EXPECT_GT(item, lastItems[producer]);
+			lastItems[producer] = item;
+			numItems++;
+		}
+	}
+
+	for (auto &producer : producers)
+	{
+		producer.join();
+	}
+
+	EXPECT_TRUE(queue.IsEmpty());
+}
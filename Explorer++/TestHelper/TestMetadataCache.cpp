@@ -0,0 +1,138 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "../Helper/MetadataCache.h"
+#include <sstream>
+
+namespace
+{
+	const unsigned int PROPERTY_OWNER = 1;
+	const unsigned int PROPERTY_VERSION = 2;
+	const unsigned int PROPERTY_HARD_LINKS = 3;
+
+	MetadataCache::FileKey MakeKey(const std::wstring &path)
+	{
+		return { path, 1024, 5000 };
+	}
+
+	void CheckText(const std::wstring &expected, const boost::optional<MetadataCache::Value> &actual)
+	{
+		ASSERT_TRUE(actual);
+		const std::wstring *text = boost::get<std::wstring>(&*actual);
+		ASSERT_NE(nullptr, text);
+		EXPECT_EQ(expected, *text);
+	}
+}
+
+TEST(MetadataCache, InsertAndLookup)
+{
+	MetadataCache cache({}, 10);
+
+	EXPECT_FALSE(cache.Lookup(MakeKey(L"C:\\a.exe"), PROPERTY_OWNER));
+
+	cache.Insert(MakeKey(L"C:\\a.exe"), PROPERTY_OWNER, std::wstring(L"Administrators"), false);
+	cache.Insert(MakeKey(L"C:\\a.exe"), PROPERTY_HARD_LINKS, std::uint64_t(2), false);
+	CheckText(L"Administrators", cache.Lookup(MakeKey(L"C:\\a.exe"), PROPERTY_OWNER));
+
+	// Values keep their original type.
+	auto hardLinks = cache.Lookup(MakeKey(L"C:\\a.exe"), PROPERTY_HARD_LINKS);
+	ASSERT_TRUE(hardLinks);
+	EXPECT_EQ(2U, boost::get<std::uint64_t>(*hardLinks));
+
+	// Paths are compared case-insensitively.
+	CheckText(L"Administrators", cache.Lookup(MakeKey(L"c:\\A.EXE"), PROPERTY_OWNER));
+
+	EXPECT_FALSE(cache.Lookup(MakeKey(L"C:\\a.exe"), PROPERTY_VERSION));
+
+	auto stats = cache.GetStats();
+	EXPECT_EQ(3U, stats.hits);
+	EXPECT_EQ(2U, stats.misses);
+	EXPECT_EQ(2U, stats.numEntries);
+}
+
+TEST(MetadataCache, FileChanged)
+{
+	MetadataCache cache({}, 10);
+
+	cache.Insert(MakeKey(L"C:\\a.exe"), PROPERTY_OWNER, std::wstring(L"Administrators"), false);
+
+	auto key = MakeKey(L"C:\\a.exe");
+	key.lastWriteTime++;
+	EXPECT_FALSE(cache.Lookup(key, PROPERTY_OWNER));
+
+	// The stale entry should have been removed.
+	EXPECT_EQ(0U, cache.GetStats().numEntries);
+	EXPECT_FALSE(cache.Lookup(MakeKey(L"C:\\a.exe"), PROPERTY_OWNER));
+}
+
+TEST(MetadataCache, Invalidate)
+{
+	MetadataCache cache({}, 10);
+
+	cache.Insert(MakeKey(L"C:\\a.exe"), PROPERTY_OWNER, std::wstring(L"Administrators"), false);
+	cache.Insert(MakeKey(L"C:\\a.exe"), PROPERTY_VERSION, std::wstring(L"1.0"), true);
+	cache.Insert(MakeKey(L"C:\\b.exe"), PROPERTY_OWNER, std::wstring(L"Users"), false);
+
+	cache.Invalidate(L"C:\\A.exe");
+
+	EXPECT_FALSE(cache.Lookup(MakeKey(L"C:\\a.exe"), PROPERTY_OWNER));
+	EXPECT_FALSE(cache.Lookup(MakeKey(L"C:\\a.exe"), PROPERTY_VERSION));
+	CheckText(L"Users", cache.Lookup(MakeKey(L"C:\\b.exe"), PROPERTY_OWNER));
+	EXPECT_EQ(1U, cache.GetStats().numEntries);
+}
+
+TEST(MetadataCache, EvictsLeastRecentlyUsed)
+{
+	MetadataCache cache({}, 2);
+
+	cache.Insert(MakeKey(L"C:\\a.exe"), PROPERTY_OWNER, std::wstring(L"a"), false);
+	cache.Insert(MakeKey(L"C:\\b.exe"), PROPERTY_OWNER, std::wstring(L"b"), false);
+
+	// a.exe is now more recently used than b.exe.
+	EXPECT_TRUE(cache.Lookup(MakeKey(L"C:\\a.exe"), PROPERTY_OWNER));
+
+	cache.Insert(MakeKey(L"C:\\c.exe"), PROPERTY_OWNER, std::wstring(L"c"), false);
+
+	EXPECT_TRUE(cache.Lookup(MakeKey(L"C:\\a.exe"), PROPERTY_OWNER));
+	EXPECT_FALSE(cache.Lookup(MakeKey(L"C:\\b.exe"), PROPERTY_OWNER));
+	CheckText(L"c", cache.Lookup(MakeKey(L"C:\\c.exe"), PROPERTY_OWNER));
+	EXPECT_EQ(2U, cache.GetStats().numEntries);
+}
+
+TEST(MetadataCache, SaveAndLoad)
+{
+	std::stringstream stream;
+
+	{
+		MetadataCache cache({}, 10);
+		cache.Insert(MakeKey(L"C:\\a.exe"), PROPERTY_VERSION, std::wstring(L"1.0"), true);
+		cache.Insert(MakeKey(L"C:\\b.exe"), PROPERTY_HARD_LINKS, std::uint64_t(3), true);
+		cache.Insert(MakeKey(L"C:\\c.exe"), PROPERTY_OWNER, std::wstring(L"Users"), false);
+		cache.Save(stream);
+	}
+
+	MetadataCache cache({}, 10);
+	EXPECT_TRUE(cache.Load(stream));
+
+	// Only the persistent entries should have been saved.
+	EXPECT_EQ(2U, cache.GetStats().numEntries);
+	CheckText(L"1.0", cache.Lookup(MakeKey(L"C:\\a.exe"), PROPERTY_VERSION));
+
+	auto hardLinks = cache.Lookup(MakeKey(L"C:\\b.exe"), PROPERTY_HARD_LINKS);
+	ASSERT_TRUE(hardLinks);
+	EXPECT_EQ(3U, boost::get<std::uint64_t>(*hardLinks));
+
+	EXPECT_FALSE(cache.Lookup(MakeKey(L"C:\\c.exe"), PROPERTY_OWNER));
+}
+
+TEST(MetadataCache, LoadInvalidData)
+{
+	MetadataCache cache({}, 10);
+	cache.Insert(MakeKey(L"C:\\a.exe"), PROPERTY_OWNER, std::wstring(L"Users"), false);
+
+	std::stringstream stream("not a cache file");
+	EXPECT_FALSE(cache.Load(stream));
+	EXPECT_EQ(0U, cache.GetStats().numEntries);
+}
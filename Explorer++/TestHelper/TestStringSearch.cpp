@@ -0,0 +1,207 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "../Helper/Macros.h"
+#include "../Helper/StringHelper.h"
+#include "../Helper/StringSearch.h"
+#include "../Helper/WildcardMatcher.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	/* Simple reference implementations, which the vectorised
+	versions are checked against. */
+	bool FoldAsciiCaseReference(const std::wstring &str, std::wstring &output)
+	{
+		output = str;
+
+		for (auto &ch : output)
+		{
+			if (ch >= 0x80)
+			{
+				return false;
+			}
+
+			if (ch >= 'A' && ch <= 'Z')
+			{
+				ch = static_cast<wchar_t>(ch + ('a' - 'A'));
+			}
+		}
+
+		return true;
+	}
+
+	/* Builds a string from a small alphabet, so that partial
+	matches are common. */
+	std::wstring GenerateString(std::mt19937 &generator, size_t length)
+	{
+		const wchar_t characters[] = { L'a', L'b', L'A', L'B', L'.', L'Z', L'[', L'@', L'`', L'{' };
+		std::uniform_int_distribution<size_t> distribution(0, SIZEOF_ARRAY(characters) - 1);
+
+		std::wstring str;
+
+		for (size_t i = 0; i < length; i++)
+		{
+			str += characters[distribution(generator)];
+		}
+
+		return str;
+	}
+}
+
+TEST(StringSearch, FoldAsciiCase)
+{
+	std::mt19937 generator(1);
+
+	for (size_t length = 0; length < 40; length++)
+	{
+		std::wstring str = GenerateString(generator, length);
+
+		std::wstring expected;
+		ASSERT_TRUE(FoldAsciiCaseReference(str, expected));
+
+		std::wstring output(length, '\0');
+		EXPECT_TRUE(FoldAsciiCase(str.c_str(), length, &output[0]));
+		EXPECT_EQ(expected, output);
+
+		/* The string can also be folded in place. */
+		EXPECT_TRUE(FoldAsciiCase(str.c_str(), length, &str[0]));
+		EXPECT_EQ(expected, str);
+	}
+}
+
+TEST(StringSearch, FoldAsciiCaseNonAscii)
+{
+	std::mt19937 generator(2);
+
+	/* A non-ASCII character should be detected wherever it
+	appears, including in the part of the string that's
+	processed one unit at a time. */
+	for (size_t length = 1; length < 40; length++)
+	{
+		for (size_t position = 0; position < length; position++)
+		{
+			for (wchar_t ch : { L'\x80', L'\xE9', L'\x0416', L'\xFF21' })
+			{
+				std::wstring str = GenerateString(generator, length);
+				str[position] = ch;
+
+				std::wstring output(length, '\0');
+				EXPECT_FALSE(FoldAsciiCase(str.c_str(), length, &output[0]));
+			}
+		}
+	}
+}
+
+TEST(StringSearch, FindSubstring)
+{
+	std::mt19937 generator(3);
+
+	for (size_t length = 0; length < 40; length++)
+	{
+		for (size_t substringLength = 0; substringLength < 12; substringLength++)
+		{
+			for (int i = 0; i < 10; i++)
+			{
+				std::wstring str = GenerateString(generator, length);
+				std::wstring substring = GenerateString(generator, substringLength);
+
+				/* Ensure there's a match sometimes, including right
+				at the end of the string. */
+				if (i % 2 == 0 && substringLength <= length)
+				{
+					size_t position = (i == 0) ? length - substringLength : (length - substringLength) / 2;
+					str.replace(position, substringLength, substring);
+				}
+
+				size_t expected = str.find(substring);
+				const wchar_t *result = FindSubstring(str.c_str(), length, substring.c_str(), substringLength);
+
+				if (expected == std::wstring::npos)
+				{
+					EXPECT_EQ(nullptr, result);
+				}
+				else
+				{
+					EXPECT_EQ(str.c_str() + expected, result);
+				}
+			}
+		}
+	}
+}
+
+/* Compares CheckWildcardMatch (which builds a new matcher
+for each call) against a single reused matcher, across 1M
+filenames. This is disabled by default; run it with
+--gtest_also_run_disabled_tests --gtest_filter=*Benchmark* */
+TEST(StringSearch, DISABLED_Benchmark)
+{
+	const int NUM_NAMES = 1000000;
+
+	const wchar_t *stems[] = { L"IMG_", L"DSC", L"Quarterly Report ", L"invoice-", L"Screenshot 2019-06-",
+		L"setup_v", L"Meeting Notes ", L"track", L"New Text Document (", L"backup_" };
+	const wchar_t *extensions[] = { L".jpg", L".JPG", L".pdf", L".docx", L".png", L".exe",
+		L".mp3", L".txt", L".zip", L".xlsx" };
+
+	std::mt19937 generator(4);
+	std::uniform_int_distribution<size_t> stemDistribution(0, SIZEOF_ARRAY(stems) - 1);
+	std::uniform_int_distribution<size_t> extensionDistribution(0, SIZEOF_ARRAY(extensions) - 1);
+	std::uniform_int_distribution<int> numberDistribution(0, 99999);
+
+	std::vector<std::wstring> names;
+	names.reserve(NUM_NAMES);
+
+	for (int i = 0; i < NUM_NAMES; i++)
+	{
+		names.push_back(stems[stemDistribution(generator)] + std::to_wstring(numberDistribution(generator))
+			+ extensions[extensionDistribution(generator)]);
+	}
+
+	const wchar_t *patterns[] = { L"*.jpg", L"*report*", L"img_1*", L"*notes*.txt" };
+
+	for (auto pattern : patterns)
+	{
+		int numMatches = 0;
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (const auto &name : names)
+		{
+			if (CheckWildcardMatch(pattern, name.c_str(), FALSE))
+			{
+				numMatches++;
+			}
+		}
+
+		auto end = std::chrono::steady_clock::now();
+
+		std::wcout << pattern << L": CheckWildcardMatch " << numMatches << L" matches in "
+			<< std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+			<< L"ms";
+
+		WildcardMatcher wildcardMatcher(pattern, false);
+		numMatches = 0;
+
+		start = std::chrono::steady_clock::now();
+
+		for (const auto &name : names)
+		{
+			if (wildcardMatcher.Matches(name.c_str(), name.size()))
+			{
+				numMatches++;
+			}
+		}
+
+		end = std::chrono::steady_clock::now();
+
+		std::wcout << L", WildcardMatcher " << numMatches << L" matches in "
+			<< std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+			<< L"ms" << std::endl;
+	}
+}
@@ -0,0 +1,153 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "../Helper/ThumbnailCache.h"
+#include <vector>
+
+namespace
+{
+	const int MAX_WIDTH = 8;
+	const int MAX_HEIGHT = 8;
+
+	ThumbnailCache::Key MakeKey(const std::wstring &path)
+	{
+		return { path, 1024, 5000, MAX_WIDTH, MAX_HEIGHT };
+	}
+
+	/* Creates a synthetic bitmap, with every pixel derived from
+	the seed value. */
+	ThumbnailCache::Bitmap MakeBitmap(int width, int height, std::uint32_t seed)
+	{
+		ThumbnailCache::Bitmap bitmap;
+		bitmap.width = width;
+		bitmap.height = height;
+
+		for (int i = 0; i < width * height; i++)
+		{
+			bitmap.pixels.push_back(seed + i);
+		}
+
+		return bitmap;
+	}
+
+	void CheckBitmap(const ThumbnailCache::Bitmap &expected, const boost::optional<ThumbnailCache::Bitmap> &actual)
+	{
+		ASSERT_TRUE(actual);
+		EXPECT_EQ(expected.width, actual->width);
+		EXPECT_EQ(expected.height, actual->height);
+		EXPECT_EQ(expected.pixels, actual->pixels);
+	}
+}
+
+TEST(ThumbnailCache, InsertAndLookup)
+{
+	std::vector<unsigned char> storage(ThumbnailCache::GetStorageSize(MAX_WIDTH, MAX_HEIGHT, 4));
+	ThumbnailCache cache(storage.data(), storage.size(), MAX_WIDTH, MAX_HEIGHT);
+
+	EXPECT_FALSE(cache.Lookup(MakeKey(L"C:\\a.jpg")));
+
+	auto bitmap = MakeBitmap(8, 6, 100);
+	EXPECT_TRUE(cache.Insert(MakeKey(L"C:\\a.jpg"), bitmap));
+	CheckBitmap(bitmap, cache.Lookup(MakeKey(L"C:\\a.jpg")));
+
+	// The same path, at a different size, is a separate entry.
+	auto key = MakeKey(L"C:\\a.jpg");
+	key.requestedWidth = 4;
+	EXPECT_FALSE(cache.Lookup(key));
+
+	auto stats = cache.GetStats();
+	EXPECT_EQ(1U, stats.hits);
+	EXPECT_EQ(2U, stats.misses);
+	EXPECT_EQ(1U, stats.numEntries);
+	EXPECT_EQ(4U, stats.capacity);
+}
+
+TEST(ThumbnailCache, FileChanged)
+{
+	std::vector<unsigned char> storage(ThumbnailCache::GetStorageSize(MAX_WIDTH, MAX_HEIGHT, 4));
+	ThumbnailCache cache(storage.data(), storage.size(), MAX_WIDTH, MAX_HEIGHT);
+
+	EXPECT_TRUE(cache.Insert(MakeKey(L"C:\\a.jpg"), MakeBitmap(8, 8, 0)));
+
+	auto key = MakeKey(L"C:\\a.jpg");
+	key.lastWriteTime++;
+	EXPECT_FALSE(cache.Lookup(key));
+
+	// The stale entry should have been removed.
+	EXPECT_EQ(0U, cache.GetStats().numEntries);
+	EXPECT_FALSE(cache.Lookup(MakeKey(L"C:\\a.jpg")));
+}
+
+TEST(ThumbnailCache, EvictsLeastRecentlyUsed)
+{
+	std::vector<unsigned char> storage(ThumbnailCache::GetStorageSize(MAX_WIDTH, MAX_HEIGHT, 2));
+	ThumbnailCache cache(storage.data(), storage.size(), MAX_WIDTH, MAX_HEIGHT);
+
+	EXPECT_TRUE(cache.Insert(MakeKey(L"C:\\a.jpg"), MakeBitmap(8, 8, 1)));
+	EXPECT_TRUE(cache.Insert(MakeKey(L"C:\\b.jpg"), MakeBitmap(8, 8, 2)));
+
+	// a.jpg is now more recently used than b.jpg.
+	EXPECT_TRUE(cache.Lookup(MakeKey(L"C:\\a.jpg")));
+
+	EXPECT_TRUE(cache.Insert(MakeKey(L"C:\\c.jpg"), MakeBitmap(8, 8, 3)));
+
+	EXPECT_TRUE(cache.Lookup(MakeKey(L"C:\\a.jpg")));
+	EXPECT_FALSE(cache.Lookup(MakeKey(L"C:\\b.jpg")));
+	CheckBitmap(MakeBitmap(8, 8, 3), cache.Lookup(MakeKey(L"C:\\c.jpg")));
+
+	auto stats = cache.GetStats();
+	EXPECT_EQ(1U, stats.evictions);
+	EXPECT_EQ(2U, stats.numEntries);
+}
+
+TEST(ThumbnailCache, Persistence)
+{
+	std::vector<unsigned char> storage(ThumbnailCache::GetStorageSize(MAX_WIDTH, MAX_HEIGHT, 2));
+
+	{
+		ThumbnailCache cache(storage.data(), storage.size(), MAX_WIDTH, MAX_HEIGHT);
+		EXPECT_TRUE(cache.Insert(MakeKey(L"C:\\a.jpg"), MakeBitmap(8, 8, 1)));
+		EXPECT_TRUE(cache.Insert(MakeKey(L"C:\\b.jpg"), MakeBitmap(4, 2, 2)));
+		EXPECT_TRUE(cache.Lookup(MakeKey(L"C:\\a.jpg")));
+	}
+
+	{
+		ThumbnailCache cache(storage.data(), storage.size(), MAX_WIDTH, MAX_HEIGHT);
+		EXPECT_EQ(2U, cache.GetStats().numEntries);
+		CheckBitmap(MakeBitmap(4, 2, 2), cache.Lookup(MakeKey(L"C:\\b.jpg")));
+
+		// The order in which the entries were used should also
+		// have been kept.
+		EXPECT_TRUE(cache.Insert(MakeKey(L"C:\\c.jpg"), MakeBitmap(8, 8, 3)));
+		EXPECT_FALSE(cache.Lookup(MakeKey(L"C:\\a.jpg")));
+		EXPECT_TRUE(cache.Lookup(MakeKey(L"C:\\b.jpg")));
+	}
+
+	{
+		// Entries written with different maximum dimensions can't
+		// be used.
+		ThumbnailCache cache(storage.data(), storage.size(), MAX_WIDTH / 2, MAX_HEIGHT / 2);
+		EXPECT_EQ(0U, cache.GetStats().numEntries);
+	}
+}
+
+TEST(ThumbnailCache, RejectsOversizedEntries)
+{
+	std::vector<unsigned char> storage(ThumbnailCache::GetStorageSize(MAX_WIDTH, MAX_HEIGHT, 2));
+	ThumbnailCache cache(storage.data(), storage.size(), MAX_WIDTH, MAX_HEIGHT);
+
+	EXPECT_FALSE(cache.Insert(MakeKey(L"C:\\a.jpg"), MakeBitmap(MAX_WIDTH + 1, 1, 0)));
+	EXPECT_FALSE(cache.Insert(MakeKey(std::wstring(ThumbnailCache::MAX_PATH_LENGTH + 1, 'a')), MakeBitmap(1, 1, 0)));
+	EXPECT_EQ(0U, cache.GetStats().numEntries);
+}
+
+TEST(ThumbnailCache, NoStorage)
+{
+	ThumbnailCache cache(nullptr, 0, MAX_WIDTH, MAX_HEIGHT);
+
+	EXPECT_FALSE(cache.Insert(MakeKey(L"C:\\a.jpg"), MakeBitmap(1, 1, 0)));
+	EXPECT_FALSE(cache.Lookup(MakeKey(L"C:\\a.jpg")));
+	EXPECT_EQ(0U, cache.GetStats().capacity);
+}
@@ -0,0 +1,139 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "../Helper/WildcardMatcher.h"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+TEST(WildcardMatcher, Literal)
+{
+	WildcardMatcher wildcardMatcher(L"Test.txt", true);
+	EXPECT_TRUE(wildcardMatcher.Matches(L"Test.txt"));
+	EXPECT_FALSE(wildcardMatcher.Matches(L"test.txt"));
+	EXPECT_FALSE(wildcardMatcher.Matches(L"Test.txt2"));
+	EXPECT_FALSE(wildcardMatcher.Matches(L"Test.tx"));
+}
+
+TEST(WildcardMatcher, PrefixAndSuffix)
+{
+	WildcardMatcher suffixMatcher(L"*.cpp", true);
+	EXPECT_TRUE(suffixMatcher.Matches(L"Main.cpp"));
+	EXPECT_TRUE(suffixMatcher.Matches(L".cpp"));
+	EXPECT_FALSE(suffixMatcher.Matches(L"Main.cpp.bak"));
+	EXPECT_FALSE(suffixMatcher.Matches(L"cpp"));
+
+	WildcardMatcher prefixMatcher(L"Bookmark_*", true);
+	EXPECT_TRUE(prefixMatcher.Matches(L"Bookmark_1"));
+	EXPECT_TRUE(prefixMatcher.Matches(L"Bookmark_"));
+	EXPECT_FALSE(prefixMatcher.Matches(L"BookmarkFolder_1"));
+}
+
+TEST(WildcardMatcher, Wildcards)
+{
+	EXPECT_TRUE(WildcardMatcher(L"*", true).Matches(L""));
+	EXPECT_TRUE(WildcardMatcher(L"*", true).Matches(L"abc"));
+	EXPECT_TRUE(WildcardMatcher(L"a**c", true).Matches(L"abbc"));
+	EXPECT_TRUE(WildcardMatcher(L"a*b*c", true).Matches(L"abbbcbc"));
+	EXPECT_FALSE(WildcardMatcher(L"a*b*c", true).Matches(L"abbbcb"));
+	EXPECT_TRUE(WildcardMatcher(L"*a?c*", true).Matches(L"xxabcxx"));
+	EXPECT_FALSE(WildcardMatcher(L"a?", true).Matches(L"a"));
+	EXPECT_FALSE(WildcardMatcher(L"", true).Matches(L"a"));
+	EXPECT_TRUE(WildcardMatcher(L"", true).Matches(L""));
+}
+
+TEST(WildcardMatcher, CaseInsensitive)
+{
+	WildcardMatcher wildcardMatcher(L"*.TXT", false);
+	EXPECT_TRUE(wildcardMatcher.Matches(L"test.txt"));
+	EXPECT_TRUE(wildcardMatcher.Matches(L"TEST.Txt"));
+	EXPECT_FALSE(wildcardMatcher.Matches(L"test.text"));
+}
+
+TEST(WildcardMatcher, MultiplePatterns)
+{
+	WildcardMatcher wildcardMatcher(L"*.h: *.cpp", true);
+	EXPECT_TRUE(wildcardMatcher.Matches(L"Main.h"));
+	EXPECT_TRUE(wildcardMatcher.Matches(L"Main.cpp"));
+	EXPECT_FALSE(wildcardMatcher.Matches(L"Main.c"));
+
+	EXPECT_FALSE(WildcardMatcher(L"::", true).Matches(L"Main.cpp"));
+}
+
+TEST(WildcardMatcher, RepeatedSegments)
+{
+	/* Would require exponential backtracking
+	with a naive recursive matcher. */
+	std::wstring str(10000, 'a');
+	EXPECT_FALSE(WildcardMatcher(L"*a*a*a*a*a*a*a*a*a*a*b", true).Matches(str.c_str()));
+
+	str += 'b';
+	EXPECT_TRUE(WildcardMatcher(L"*a*a*a*a*a*a*a*a*a*a*b", true).Matches(str.c_str()));
+}
+
+TEST(WildcardMatcher, IsSubsetOf)
+{
+	auto isSubsetOf = [] (const wchar_t *pattern, const wchar_t *otherPattern) {
+		return WildcardMatcher(pattern, true).IsSubsetOf(WildcardMatcher(otherPattern, true));
+	};
+
+	EXPECT_TRUE(isSubsetOf(L"*abc*", L"*ab*"));
+	EXPECT_TRUE(isSubsetOf(L"*ab*", L"*ab*"));
+	EXPECT_TRUE(isSubsetOf(L"file.txt", L"*.txt"));
+	EXPECT_TRUE(isSubsetOf(L"a?c", L"a?c"));
+	EXPECT_TRUE(isSubsetOf(L"abc", L"a?c"));
+	EXPECT_TRUE(isSubsetOf(L"a*c", L"*"));
+	EXPECT_TRUE(isSubsetOf(L"*.cpp", L"*.h: *.cpp"));
+
+	// Adding a character to the end of a pattern that doesn't end
+	// with a '*' can match strings that weren't matched before.
+	EXPECT_FALSE(isSubsetOf(L"*.cp", L"*.c"));
+	EXPECT_FALSE(isSubsetOf(L"*ab*", L"*abc*"));
+	EXPECT_FALSE(isSubsetOf(L"a*c", L"a?c"));
+	EXPECT_FALSE(isSubsetOf(L"*.h: *.cpp", L"*.cpp"));
+
+	WildcardMatcher caseSensitiveMatcher(L"*ABC*", true);
+	WildcardMatcher caseInsensitiveMatcher(L"*ab*", false);
+	EXPECT_TRUE(caseSensitiveMatcher.IsSubsetOf(caseInsensitiveMatcher));
+	EXPECT_FALSE(WildcardMatcher(L"*abc*", false).IsSubsetOf(WildcardMatcher(L"*ab*", true)));
+}
+
+TEST(WildcardMatcher, DISABLED_Benchmark)
+{
+	const int NUM_NAMES = 100000;
+
+	std::vector<std::wstring> names;
+	names.reserve(NUM_NAMES);
+
+	for (int i = 0; i < NUM_NAMES; i++)
+	{
+		names.push_back(L"File Name " + std::to_wstring(i) + ((i % 3 == 0) ? L".cpp" : L".txt"));
+	}
+
+	const wchar_t *patterns[] = { L"*.cpp", L"file*", L"*name*1?3*", L"*.h: *.cpp" };
+
+	for (auto pattern : patterns)
+	{
+		WildcardMatcher wildcardMatcher(pattern, false);
+		int numMatches = 0;
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (const auto &name : names)
+		{
+			if (wildcardMatcher.Matches(name.c_str(), name.size()))
+			{
+				numMatches++;
+			}
+		}
+
+		auto end = std::chrono::steady_clock::now();
+
+		std::wcout << pattern << L": " << numMatches << L" matches in "
+			<< std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()
+			<< L"us" << std::endl;
+	}
+}